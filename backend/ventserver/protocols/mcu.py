@@ -36,6 +36,9 @@ MESSAGE_CLASSES: Mapping[int, Type[betterproto.Message]] = {
     8: mcu_pb.ExpectedLogEvent,
     9: mcu_pb.NextLogEvents,
     10: mcu_pb.ActiveLogEvents,
+    13: mcu_pb.MemoryUsage,
+    14: mcu_pb.RecorderChunk,
+    15: mcu_pb.RecorderChunkRequest,
     254: mcu_pb.Ping,
     255: mcu_pb.Announcement
 }
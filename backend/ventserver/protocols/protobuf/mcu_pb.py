@@ -215,3 +215,27 @@ class AlarmMute(betterproto.Message):
 class AlarmMuteRequest(betterproto.Message):
     active: bool = betterproto.bool_field(1)
     remaining: float = betterproto.float_field(2)
+
+
+@dataclass
+class MemoryUsage(betterproto.Message):
+    time: int = betterproto.uint32_field(1)
+    stack_high_water: int = betterproto.uint32_field(2)
+    heap_free: int = betterproto.uint32_field(3)
+
+
+@dataclass
+class RecorderChunk(betterproto.Message):
+    time: int = betterproto.uint32_field(1)
+    start: int = betterproto.uint32_field(2)
+    end: int = betterproto.uint32_field(3)
+    index: int = betterproto.uint32_field(4)
+    last: bool = betterproto.bool_field(5)
+    data: bytes = betterproto.bytes_field(6)
+
+
+@dataclass
+class RecorderChunkRequest(betterproto.Message):
+    start: int = betterproto.uint32_field(1)
+    end: int = betterproto.uint32_field(2)
+    index: int = betterproto.uint32_field(3)
@@ -65,13 +65,17 @@ class AlarmsManager {
   AlarmStatus get_active();
 
  private:
+  static const uint32_t top_bit = 0x80000000;
+
   std::array<uint32_t, static_cast<int>(AlarmStatus::no_alarm)> alarms_cnt_{};
+  uint32_t active_mask_ = 0;  // alarms with a count, from the most significant bit
   AlarmStatus active_ = AlarmStatus::no_alarm;
 
   Driver::Indicators::AlarmDevice &led_;
   Driver::Indicators::AlarmDevice &auditory_;
 
   void update_active();
+  static uint32_t alarm_bit(int index) { return top_bit >> static_cast<uint32_t>(index); }
 };
 
 }  // namespace Pufferfish
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * AlarmEvaluator.h
+ *
+ * Checks measurements against the alarm limits, raising and clearing patient
+ * alarms
+ */
+
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/Application/States.h"
+#include "Pufferfish/Statuses.h"
+
+namespace Pufferfish::Application {
+
+// Measurements which are checked against alarm limits
+enum class AlarmInput : uint8_t { fio2 = 0, spo2, hr, rr };
+
+/**
+ * One alarm condition: the alarm is raised once its input has stayed beyond
+ * one of its limits for the persistence duration, and cleared as soon as the
+ * input comes back inside the limit by at least the hysteresis
+ */
+struct AlarmRule {
+  LogEventCode code;
+  AlarmStatus priority;
+  AlarmInput input;
+  bool upper;            // true to check the upper limit, false for the lower limit
+  float hysteresis;      // in units of the input
+  uint32_t persistence;  // ms
+};
+
+// A change in an alarm's state
+struct AlarmTransition {
+  LogEventCode code;
+  AlarmStatus priority;
+  bool active;
+};
+
+/**
+ * Evaluates alarm rules only when their inputs or limits change, or while
+ * their persistence timers run, so a step without changes costs a few
+ * comparisons. Rules are ordered by priority, and each rule is a bit of the
+ * active and pending bitmasks, from the most significant bit down, so the
+ * highest-priority alarm is found with count-leading-zeros. Detection only
+ * depends on the measurements and on how often update() is called, never on
+ * the backend.
+ */
+class AlarmEvaluator {
+ public:
+  static const size_t input_count = 4;
+  static const size_t rule_count = 8;
+  using Rules = std::array<AlarmRule, rule_count>;
+
+  // In order of decreasing priority
+  static constexpr Rules default_rules{{
+      {LogEventCode_spo2_too_low, AlarmStatus::high_priority, AlarmInput::spo2, false, 1, 5000},
+      {LogEventCode_fio2_too_low, AlarmStatus::high_priority, AlarmInput::fio2, false, 1, 3000},
+      {LogEventCode_hr_too_low, AlarmStatus::medium_priority, AlarmInput::hr, false, 2, 5000},
+      {LogEventCode_hr_too_high, AlarmStatus::medium_priority, AlarmInput::hr, true, 2, 5000},
+      {LogEventCode_rr_too_low, AlarmStatus::medium_priority, AlarmInput::rr, false, 1, 5000},
+      {LogEventCode_rr_too_high, AlarmStatus::medium_priority, AlarmInput::rr, true, 1, 5000},
+      {LogEventCode_fio2_too_high, AlarmStatus::low_priority, AlarmInput::fio2, true, 1, 3000},
+      {LogEventCode_spo2_too_high, AlarmStatus::low_priority, AlarmInput::spo2, true, 1, 5000},
+  }};
+
+  explicit AlarmEvaluator(const Rules &rules = default_rules);
+
+  /**
+   * Takes the latest alarm limits; a limit which isn't set disables its rules
+   * and clears their alarms
+   * @param alarm_limits the alarm limits
+   */
+  void input(const AlarmLimits &alarm_limits);
+
+  // Takes the latest FiO2, SpO2 and HR
+  void input(const SensorMeasurements &sensor_measurements);
+
+  // Takes the latest RR
+  void input(const CycleMeasurements &cycle_measurements);
+
+  /**
+   * Evaluates the rules whose inputs or limits changed since the previous
+   * call, and the rules whose persistence timers are running
+   * @param current_time the current time, in ms
+   */
+  void update(uint32_t current_time);
+
+  /**
+   * Pops the next alarm raised or cleared by the most recent update(), raised
+   * alarms first, each in order of decreasing priority
+   * @param transition[out] the change in the alarm's state
+   * @return true if a transition was popped, false if there are none left
+   */
+  bool output(AlarmTransition &transition);
+
+  /**
+   * @param code[out] the code of the highest-priority active alarm
+   * @return true if any alarm is active
+   */
+  bool highest(LogEventCode &code) const;
+
+  // Bitmask of the active alarms, with the first rule in the most significant bit
+  [[nodiscard]] uint32_t active() const { return active_; }
+
+ private:
+  static const uint32_t top_bit = 0x80000000;
+  static_assert(rule_count <= sizeof(uint32_t) * CHAR_BIT, "Rules must fit in a bitmask");
+
+  struct Limit {
+    bool set;
+    Range range;
+  };
+
+  const Rules rules_;
+  std::array<uint32_t, input_count> input_rules_{};  // bitmask of the rules of each input
+  std::array<float, input_count> values_{};
+  std::array<Limit, input_count> limits_{};
+  std::array<uint32_t, rule_count> pending_since_{};  // ms
+  uint8_t received_ = 0;                              // bitmask of inputs received
+  uint8_t changed_ = 0;                               // bitmask of inputs changed
+  uint32_t active_ = 0;
+  uint32_t pending_ = 0;
+  uint32_t raised_ = 0;
+  uint32_t cleared_ = 0;
+
+  void input_value(AlarmInput input, float value);
+  void input_limit(AlarmInput input, bool set, const Range &range);
+  void evaluate(size_t rule, uint32_t current_time);
+  static uint32_t rule_bit(size_t rule) { return top_bit >> rule; }
+  static uint8_t input_bit(AlarmInput input) {
+    return static_cast<uint8_t>(1U << static_cast<uint8_t>(input));
+  }
+};
+
+}  // namespace Pufferfish::Application
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * SettingsEvents.h
+ *
+ * Detects changes of the parameters and alarm limits as log events
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/Application/States.h"
+
+namespace Pufferfish::Application {
+
+/**
+ * Compares the parameters and alarm limits against their previous values,
+ * and reports each setting which changed as a log event with its old and new
+ * values. If a setting changes again before its event is output, the event
+ * keeps its original old value and takes the newest value.
+ */
+class SettingsEvents {
+ public:
+  static const size_t code_count =
+      LogEventCode_hr_alarm_limits_changed - LogEventCode_ventilation_operation_changed + 1;
+
+  /**
+   * Takes the latest settings. The first call only takes them as the
+   * baseline, so that settings restored at startup are not reported.
+   * @param current_time the current time, in ms
+   * @param parameters the parameters
+   * @param alarm_limits the alarm limits
+   */
+  void input(uint32_t current_time, const Parameters &parameters, const AlarmLimits &alarm_limits);
+
+  /**
+   * Pops the next change, in order of event code
+   * @param event[out] the change, without an id
+   * @return true if a change was popped, false if there are none left
+   */
+  bool output(LogEvent &event);
+
+ private:
+  std::array<LogEvent, code_count> events_{};
+  uint8_t pending_ = 0;  // bitmask of the events waiting to be output
+  bool initialized_ = false;
+  Parameters parameters_{};
+  AlarmLimits alarm_limits_{};
+
+  static uint8_t bit(LogEventCode code);
+  [[nodiscard]] bool pending(LogEventCode code) const;
+  LogEvent &change(uint32_t current_time, LogEventCode code, LogEventType type);
+  void input_float(uint32_t current_time, LogEventCode code, float previous, float value);
+  void input_range(
+      uint32_t current_time,
+      LogEventCode code,
+      bool previous_set,
+      const Range &previous,
+      bool set,
+      const Range &range);
+};
+
+}  // namespace Pufferfish::Application
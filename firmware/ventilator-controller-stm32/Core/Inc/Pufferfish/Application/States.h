@@ -22,7 +22,12 @@ enum class MessageTypes : uint8_t {
   parameters = 4,
   parameters_request = 5,
   alarm_limits = 6,
-  alarm_limits_request = 7
+  alarm_limits_request = 7,
+  expected_log_event = 8,
+  next_log_events = 9,
+  memory_usage = 13,
+  recorder_chunk = 14,
+  recorder_chunk_request = 15
 };
 
 // MessageTypeValues should include all defined values of MessageTypes
@@ -34,7 +39,12 @@ using MessageTypeValues = Util::EnumValues<
     MessageTypes::parameters,
     MessageTypes::parameters_request,
     MessageTypes::alarm_limits,
-    MessageTypes::alarm_limits_request>;
+    MessageTypes::alarm_limits_request,
+    MessageTypes::expected_log_event,
+    MessageTypes::next_log_events,
+    MessageTypes::memory_usage,
+    MessageTypes::recorder_chunk,
+    MessageTypes::recorder_chunk_request>;
 
 // Since nanopb is running dynamically, we cannot have extensive compile-time type-checking.
 // It's not clear how we might use variants to replace this union, since the nanopb functions
@@ -53,6 +63,17 @@ struct StateSegments {
   ParametersRequest parameters_request;
   AlarmLimits alarm_limits;
   AlarmLimitsRequest alarm_limits_request;
+
+  // Event Log
+  ExpectedLogEvent expected_log_event;
+  NextLogEvents next_log_events;
+
+  // Diagnostics
+  MemoryUsage memory_usage;
+
+  // Black-box Recorder
+  RecorderChunk recorder_chunk;
+  RecorderChunkRequest recorder_chunk_request;
 };
 
 class States {
@@ -62,9 +83,17 @@ class States {
   enum class OutputStatus { ok = 0, invalid_type };
 
   [[nodiscard]] const ParametersRequest &parameters_request() const;
+  ParametersRequest &parameters_request();
   Parameters &parameters();
+  AlarmLimitsRequest &alarm_limits_request();
+  AlarmLimits &alarm_limits();
   SensorMeasurements &sensor_measurements();
   CycleMeasurements &cycle_measurements();
+  [[nodiscard]] const ExpectedLogEvent &expected_log_event() const;
+  NextLogEvents &next_log_events();
+  MemoryUsage &memory_usage();
+  RecorderChunk &recorder_chunk();
+  [[nodiscard]] const RecorderChunkRequest &recorder_chunk_request() const;
 
   InputStatus input(const StateSegment &input);
   OutputStatus output(MessageTypes type, StateSegment &output) const;
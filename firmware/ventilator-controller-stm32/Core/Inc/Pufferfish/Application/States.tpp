@@ -18,6 +18,11 @@ union StateSegmentUnion {
   ParametersRequest parameters_request;
   AlarmLimits alarm_limits;
   AlarmLimitsRequest alarm_limits_request;
+  ExpectedLogEvent expected_log_event;
+  NextLogEvents next_log_events;
+  MemoryUsage memory_usage;
+  RecorderChunk recorder_chunk;
+  RecorderChunkRequest recorder_chunk_request;
 };
 
 }  // namespace Pufferfish::Application
@@ -87,12 +87,11 @@ typedef struct _ExpectedLogEvent {
     uint32_t id;
 } ExpectedLogEvent;
 
-typedef struct _NextLogEvents {
-    uint32_t next_expected;
-    uint32_t total;
-    uint32_t remaining;
-    pb_callback_t elements;
-} NextLogEvents;
+typedef struct _MemoryUsage {
+    uint32_t time;
+    uint32_t stack_high_water;
+    uint32_t heap_free;
+} MemoryUsage;
 
 typedef struct _Parameters {
     uint32_t time;
@@ -130,6 +129,22 @@ typedef struct _Range {
     uint32_t upper;
 } Range;
 
+typedef PB_BYTES_ARRAY_T(208) RecorderChunk_data_t;
+typedef struct _RecorderChunk {
+    uint32_t time;
+    uint32_t start;
+    uint32_t end;
+    uint32_t index;
+    bool last;
+    RecorderChunk_data_t data;
+} RecorderChunk;
+
+typedef struct _RecorderChunkRequest {
+    uint32_t start;
+    uint32_t end;
+    uint32_t index;
+} RecorderChunkRequest;
+
 typedef struct _ScreenStatus {
     bool lock;
 } ScreenStatus;
@@ -230,6 +245,14 @@ typedef struct _LogEvent {
     VentilationMode new_mode;
 } LogEvent;
 
+typedef struct _NextLogEvents {
+    uint32_t next_expected;
+    uint32_t total;
+    uint32_t remaining;
+    pb_size_t elements_count;
+    LogEvent elements[2];
+} NextLogEvents;
+
 
 /* Helper constants for enums */
 #define _VentilationMode_MIN VentilationMode_hfnc
@@ -261,12 +284,15 @@ extern "C" {
 #define Announcement_init_default                {0, {0, {0}}}
 #define LogEvent_init_default                    {0, 0, _LogEventCode_MIN, _LogEventType_MIN, false, Range_init_default, 0, 0, 0, 0, 0, 0, false, Range_init_default, false, Range_init_default, _VentilationMode_MIN, _VentilationMode_MIN}
 #define ExpectedLogEvent_init_default            {0}
-#define NextLogEvents_init_default               {0, 0, 0, {{NULL}, NULL}}
+#define NextLogEvents_init_default               {0, 0, 0, 0, {LogEvent_init_default, LogEvent_init_default}}
 #define ActiveLogEvents_init_default             {{{NULL}, NULL}}
 #define BatteryPower_init_default                {0, 0}
 #define ScreenStatus_init_default                {0}
 #define AlarmMute_init_default                   {0, 0}
 #define AlarmMuteRequest_init_default            {0, 0}
+#define MemoryUsage_init_default                 {0, 0, 0}
+#define RecorderChunk_init_default               {0, 0, 0, 0, 0, {0, {0}}}
+#define RecorderChunkRequest_init_default        {0, 0, 0}
 #define Range_init_zero                          {0, 0}
 #define AlarmLimits_init_zero                    {0, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero}
 #define AlarmLimitsRequest_init_zero             {0, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero, false, Range_init_zero}
@@ -278,12 +304,15 @@ extern "C" {
 #define Announcement_init_zero                   {0, {0, {0}}}
 #define LogEvent_init_zero                       {0, 0, _LogEventCode_MIN, _LogEventType_MIN, false, Range_init_zero, 0, 0, 0, 0, 0, 0, false, Range_init_zero, false, Range_init_zero, _VentilationMode_MIN, _VentilationMode_MIN}
 #define ExpectedLogEvent_init_zero               {0}
-#define NextLogEvents_init_zero                  {0, 0, 0, {{NULL}, NULL}}
+#define NextLogEvents_init_zero                  {0, 0, 0, 0, {LogEvent_init_zero, LogEvent_init_zero}}
 #define ActiveLogEvents_init_zero                {{{NULL}, NULL}}
 #define BatteryPower_init_zero                   {0, 0}
 #define ScreenStatus_init_zero                   {0}
 #define AlarmMute_init_zero                      {0, 0}
 #define AlarmMuteRequest_init_zero               {0, 0}
+#define MemoryUsage_init_zero                    {0, 0, 0}
+#define RecorderChunk_init_zero                  {0, 0, 0, 0, 0, {0, {0}}}
+#define RecorderChunkRequest_init_zero           {0, 0, 0}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define ActiveLogEvents_id_tag                   1
@@ -303,6 +332,9 @@ extern "C" {
 #define CycleMeasurements_ip_tag                 6
 #define CycleMeasurements_ve_tag                 7
 #define ExpectedLogEvent_id_tag                  1
+#define MemoryUsage_time_tag                     1
+#define MemoryUsage_stack_high_water_tag         2
+#define MemoryUsage_heap_free_tag                3
 #define NextLogEvents_next_expected_tag          1
 #define NextLogEvents_total_tag                  2
 #define NextLogEvents_remaining_tag              3
@@ -331,6 +363,15 @@ extern "C" {
 #define Ping_id_tag                              2
 #define Range_lower_tag                          1
 #define Range_upper_tag                          2
+#define RecorderChunk_time_tag                   1
+#define RecorderChunk_start_tag                  2
+#define RecorderChunk_end_tag                    3
+#define RecorderChunk_index_tag                  4
+#define RecorderChunk_last_tag                   5
+#define RecorderChunk_data_tag                   6
+#define RecorderChunkRequest_start_tag           1
+#define RecorderChunkRequest_end_tag             2
+#define RecorderChunkRequest_index_tag           3
 #define ScreenStatus_lock_tag                    1
 #define SensorMeasurements_time_tag              1
 #define SensorMeasurements_cycle_tag             2
@@ -553,8 +594,8 @@ X(a, STATIC,   SINGULAR, UINT32,   id,                1)
 X(a, STATIC,   SINGULAR, UINT32,   next_expected,     1) \
 X(a, STATIC,   SINGULAR, UINT32,   total,             2) \
 X(a, STATIC,   SINGULAR, UINT32,   remaining,         3) \
-X(a, CALLBACK, REPEATED, MESSAGE,  elements,          4)
-#define NextLogEvents_CALLBACK pb_default_field_callback
+X(a, STATIC,   REPEATED, MESSAGE,  elements,          4)
+#define NextLogEvents_CALLBACK NULL
 #define NextLogEvents_DEFAULT NULL
 #define NextLogEvents_elements_MSGTYPE LogEvent
 
@@ -586,6 +627,30 @@ X(a, STATIC,   SINGULAR, FLOAT,    remaining,         2)
 #define AlarmMuteRequest_CALLBACK NULL
 #define AlarmMuteRequest_DEFAULT NULL
 
+#define MemoryUsage_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   time,              1) \
+X(a, STATIC,   SINGULAR, UINT32,   stack_high_water,  2) \
+X(a, STATIC,   SINGULAR, UINT32,   heap_free,         3)
+#define MemoryUsage_CALLBACK NULL
+#define MemoryUsage_DEFAULT NULL
+
+#define RecorderChunk_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   time,              1) \
+X(a, STATIC,   SINGULAR, UINT32,   start,             2) \
+X(a, STATIC,   SINGULAR, UINT32,   end,               3) \
+X(a, STATIC,   SINGULAR, UINT32,   index,             4) \
+X(a, STATIC,   SINGULAR, BOOL,     last,              5) \
+X(a, STATIC,   SINGULAR, BYTES,    data,              6)
+#define RecorderChunk_CALLBACK NULL
+#define RecorderChunk_DEFAULT NULL
+
+#define RecorderChunkRequest_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   start,             1) \
+X(a, STATIC,   SINGULAR, UINT32,   end,               2) \
+X(a, STATIC,   SINGULAR, UINT32,   index,             3)
+#define RecorderChunkRequest_CALLBACK NULL
+#define RecorderChunkRequest_DEFAULT NULL
+
 extern const pb_msgdesc_t Range_msg;
 extern const pb_msgdesc_t AlarmLimits_msg;
 extern const pb_msgdesc_t AlarmLimitsRequest_msg;
@@ -603,6 +668,9 @@ extern const pb_msgdesc_t BatteryPower_msg;
 extern const pb_msgdesc_t ScreenStatus_msg;
 extern const pb_msgdesc_t AlarmMute_msg;
 extern const pb_msgdesc_t AlarmMuteRequest_msg;
+extern const pb_msgdesc_t MemoryUsage_msg;
+extern const pb_msgdesc_t RecorderChunk_msg;
+extern const pb_msgdesc_t RecorderChunkRequest_msg;
 
 /* Defines for backwards compatibility with code written before nanopb-0.4.0 */
 #define Range_fields &Range_msg
@@ -622,6 +690,9 @@ extern const pb_msgdesc_t AlarmMuteRequest_msg;
 #define ScreenStatus_fields &ScreenStatus_msg
 #define AlarmMute_fields &AlarmMute_msg
 #define AlarmMuteRequest_fields &AlarmMuteRequest_msg
+#define MemoryUsage_fields &MemoryUsage_msg
+#define RecorderChunk_fields &RecorderChunk_msg
+#define RecorderChunkRequest_fields &RecorderChunkRequest_msg
 
 /* Maximum encoded size of messages (where known) */
 #define Range_size                               12
@@ -635,12 +706,15 @@ extern const pb_msgdesc_t AlarmMuteRequest_msg;
 #define Announcement_size                        72
 #define LogEvent_size                            88
 #define ExpectedLogEvent_size                    6
-/* NextLogEvents_size depends on runtime parameters */
+#define NextLogEvents_size                       198
 /* ActiveLogEvents_size depends on runtime parameters */
 #define BatteryPower_size                        8
 #define ScreenStatus_size                        2
 #define AlarmMute_size                           7
 #define AlarmMuteRequest_size                    7
+#define MemoryUsage_size                         18
+#define RecorderChunk_size                       237
+#define RecorderChunkRequest_size                18
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -768,6 +842,27 @@ struct MessageDescriptor<AlarmMuteRequest> {
         return &AlarmMuteRequest_msg;
     }
 };
+template <>
+struct MessageDescriptor<MemoryUsage> {
+    static PB_INLINE_CONSTEXPR const pb_size_t fields_array_length = 3;
+    static PB_INLINE_CONSTEXPR const pb_msgdesc_t* fields() {
+        return &MemoryUsage_msg;
+    }
+};
+template <>
+struct MessageDescriptor<RecorderChunk> {
+    static PB_INLINE_CONSTEXPR const pb_size_t fields_array_length = 6;
+    static PB_INLINE_CONSTEXPR const pb_msgdesc_t* fields() {
+        return &RecorderChunk_msg;
+    }
+};
+template <>
+struct MessageDescriptor<RecorderChunkRequest> {
+    static PB_INLINE_CONSTEXPR const pb_size_t fields_array_length = 3;
+    static PB_INLINE_CONSTEXPR const pb_msgdesc_t* fields() {
+        return &RecorderChunkRequest_msg;
+    }
+};
 }  // namespace nanopb
 
 #endif  /* __cplusplus */
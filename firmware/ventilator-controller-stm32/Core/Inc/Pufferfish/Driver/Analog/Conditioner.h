@@ -0,0 +1,105 @@
+/// Conditioner.h
+/// Multi-channel signal conditioning pipeline between sensor acquisition
+/// and control, run as one block per control step.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "Filters.h"
+
+namespace Pufferfish::Driver::Analog {
+
+/**
+ * Conditions one sample of every channel per call, passing each channel
+ * through spike rejection, a median filter, a biquad cascade and an FIR
+ * filter, in that order. Every stage can be configured per channel, and the
+ * median filter can be skipped; the cost of a call is fixed by the template
+ * parameters, at about channel_count * (4 * biquad_stages + fir_taps +
+ * median_window) multiply-adds and comparisons, whatever the input. The
+ * first sample after construction or reset() primes every stage with its
+ * value, so that the output starts without a transient.
+ */
+template <size_t channel_count, size_t biquad_stages, size_t fir_taps, size_t median_window>
+class Conditioner {
+ public:
+  using Samples = std::array<float, channel_count>;
+
+  struct ChannelConfig {
+    float max_step = SpikeRejector::no_limit;
+    uint32_t max_rejections = 0;
+    bool median = false;
+    typename BiquadCascade<biquad_stages>::Coefficients biquads = identity_biquads();
+    typename FIRFilter<fir_taps>::Taps fir = identity_fir<fir_taps>();
+  };
+  using Config = std::array<ChannelConfig, channel_count>;
+
+  explicit Conditioner(const Config &config);
+
+  /**
+   * Conditions one sample of every channel
+   * @param samples the raw samples, in channel order
+   * @param conditioned[out] the conditioned samples, in channel order
+   */
+  void transform(const Samples &samples, Samples &conditioned);
+
+  /**
+   * Primes every stage again with the next samples, e.g. after a sensor
+   * has been restarted
+   */
+  void reset();
+
+  /**
+   * @param channel the index of the channel
+   * @return the number of samples of the channel rejected as spikes
+   */
+  [[nodiscard]] uint32_t rejected(size_t channel) const;
+
+ private:
+  static constexpr typename BiquadCascade<biquad_stages>::Coefficients identity_biquads();
+
+  struct Channel {
+    explicit Channel(const ChannelConfig &config)
+        : median(config.median),
+          spikes(config.max_step, config.max_rejections),
+          biquads(config.biquads),
+          fir(config.fir) {}
+
+    const bool median;
+    SpikeRejector spikes;
+    MedianFilter<median_window> medians;
+    BiquadCascade<biquad_stages> biquads;
+    FIRFilter<fir_taps> fir;
+  };
+
+  std::array<Channel, channel_count> channels_;
+  bool primed_ = false;
+
+  template <size_t... indices>
+  static std::array<Channel, channel_count> make_channels(
+      const Config &config, std::index_sequence<indices...> /*indices*/);
+};
+
+}  // namespace Pufferfish::Driver::Analog
+
+#include "Conditioner.tpp"
@@ -0,0 +1,99 @@
+/// Conditioner.tpp
+/// Multi-channel signal conditioning pipeline between sensor acquisition
+/// and control, run as one block per control step.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Conditioner.h"
+
+namespace Pufferfish::Driver::Analog {
+
+template <size_t channel_count, size_t biquad_stages, size_t fir_taps, size_t median_window>
+Conditioner<channel_count, biquad_stages, fir_taps, median_window>::Conditioner(
+    const Config &config)
+    : channels_(make_channels(config, std::make_index_sequence<channel_count>{})) {}
+
+template <size_t channel_count, size_t biquad_stages, size_t fir_taps, size_t median_window>
+void Conditioner<channel_count, biquad_stages, fir_taps, median_window>::transform(
+    const Samples &samples, Samples &conditioned) {
+  if (!primed_) {
+    for (size_t i = 0; i < channel_count; ++i) {
+      Channel &channel = channels_[i];
+      channel.spikes.reset(samples[i]);
+      channel.medians.reset(samples[i]);
+      channel.biquads.reset(samples[i]);
+      channel.fir.reset(samples[i]);
+    }
+    primed_ = true;
+  }
+
+  // Each stage runs over all channels before the next stage
+  for (size_t i = 0; i < channel_count; ++i) {
+    conditioned[i] = channels_[i].spikes.input(samples[i]);
+  }
+  for (size_t i = 0; i < channel_count; ++i) {
+    if (channels_[i].median) {
+      conditioned[i] = channels_[i].medians.input(conditioned[i]);
+    }
+  }
+  for (size_t i = 0; i < channel_count; ++i) {
+    conditioned[i] = channels_[i].biquads.input(conditioned[i]);
+  }
+  for (size_t i = 0; i < channel_count; ++i) {
+    conditioned[i] = channels_[i].fir.input(conditioned[i]);
+  }
+}
+
+template <size_t channel_count, size_t biquad_stages, size_t fir_taps, size_t median_window>
+void Conditioner<channel_count, biquad_stages, fir_taps, median_window>::reset() {
+  primed_ = false;
+}
+
+template <size_t channel_count, size_t biquad_stages, size_t fir_taps, size_t median_window>
+uint32_t Conditioner<channel_count, biquad_stages, fir_taps, median_window>::rejected(
+    size_t channel) const {
+  if (channel >= channel_count) {
+    return 0;
+  }
+
+  return channels_[channel].spikes.rejected();
+}
+
+template <size_t channel_count, size_t biquad_stages, size_t fir_taps, size_t median_window>
+constexpr typename BiquadCascade<biquad_stages>::Coefficients
+Conditioner<channel_count, biquad_stages, fir_taps, median_window>::identity_biquads() {
+  typename BiquadCascade<biquad_stages>::Coefficients coefficients{};
+  for (BiquadCoefficients &stage : coefficients) {
+    stage = identity_biquad;
+  }
+  return coefficients;
+}
+
+template <size_t channel_count, size_t biquad_stages, size_t fir_taps, size_t median_window>
+template <size_t... indices>
+std::array<
+    typename Conditioner<channel_count, biquad_stages, fir_taps, median_window>::Channel,
+    channel_count>
+Conditioner<channel_count, biquad_stages, fir_taps, median_window>::make_channels(
+    const Config &config, std::index_sequence<indices...> /*indices*/) {
+  return {{Channel(config[indices])...}};
+}
+
+}  // namespace Pufferfish::Driver::Analog
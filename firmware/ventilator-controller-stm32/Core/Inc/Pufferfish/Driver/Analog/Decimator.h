@@ -0,0 +1,90 @@
+/// Decimator.h
+/// Per-channel averaging and decimation of interleaved ADC scan samples,
+/// fed from DMA completion interrupts and read from the main loop.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/Statuses.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Analog {
+
+/**
+ * Averages every channel of a multi-channel ADC scan over a configurable
+ * number of scan sequences, publishing one fresh value per channel each
+ * time that channel's window fills up. Samples are input from a single
+ * interrupt context and outputs are read from the main loop; each published
+ * value is a single word, so it can be read without disabling interrupts.
+ */
+template <size_t channel_count>
+class Decimator {
+ public:
+  using Decimations = std::array<uint32_t, channel_count>;
+
+  /**
+   * @param decimations for each channel, the number of scan sequences to
+   * average into each published value; 0 is treated as 1
+   */
+  explicit Decimator(const Decimations &decimations);
+
+  /**
+   * Inputs a block of samples, to be called from the DMA interrupt
+   * @param samples scan sequences, each with one sample per channel in
+   * channel order
+   * @param sequences the number of scan sequences in the block
+   */
+  void input(const uint16_t *samples, size_t sequences);
+
+  /**
+   * Outputs the most recently published value of a channel
+   * @param channel the index of the channel in the scan sequence
+   * @param value[out] the average of the most recent window; only valid on
+   * success
+   * @return ok if a value has been published, error otherwise
+   */
+  ADCStatus output(size_t channel, uint32_t &value) const;
+
+  /**
+   * Counts the values published for a channel, so that callers can tell
+   * whether a value is fresh
+   * @param channel the index of the channel in the scan sequence
+   * @return the number of values published so far, wrapping around
+   */
+  [[nodiscard]] uint32_t published(size_t channel) const;
+
+ private:
+  Decimations decimations_;
+  std::array<uint32_t, channel_count> sums_{};
+  std::array<uint32_t, channel_count> counts_{};
+  std::array<volatile uint32_t, channel_count> values_{};
+  std::array<volatile uint32_t, channel_count> published_{};
+  std::array<volatile bool, channel_count> ready_{};
+};
+
+}  // namespace Analog
+}  // namespace Driver
+}  // namespace Pufferfish
+
+#include "Decimator.tpp"
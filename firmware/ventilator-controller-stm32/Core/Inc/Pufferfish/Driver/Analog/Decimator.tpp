@@ -0,0 +1,81 @@
+/// Decimator.tpp
+/// Per-channel averaging and decimation of interleaved ADC scan samples,
+/// fed from DMA completion interrupts and read from the main loop.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+
+#include "Decimator.h"
+
+namespace Pufferfish::Driver::Analog {
+
+template <size_t channel_count>
+Decimator<channel_count>::Decimator(const Decimations &decimations) : decimations_(decimations) {
+  for (auto &decimation : decimations_) {
+    if (decimation == 0) {
+      decimation = 1;
+    }
+  }
+}
+
+template <size_t channel_count>
+void Decimator<channel_count>::input(const uint16_t *samples, size_t sequences) {
+  for (size_t sequence = 0; sequence < sequences; ++sequence) {
+    for (size_t channel = 0; channel < channel_count; ++channel) {
+      sums_[channel] += samples[sequence * channel_count + channel];
+      ++counts_[channel];
+      if (counts_[channel] < decimations_[channel]) {
+        continue;
+      }
+
+      // Round to the nearest integer
+      values_[channel] = (sums_[channel] + decimations_[channel] / 2) / decimations_[channel];
+      // The value must be written before the main loop can see that it was published
+      std::atomic_signal_fence(std::memory_order_release);
+      published_[channel] = published_[channel] + 1;
+      ready_[channel] = true;
+      sums_[channel] = 0;
+      counts_[channel] = 0;
+    }
+  }
+}
+
+template <size_t channel_count>
+ADCStatus Decimator<channel_count>::output(size_t channel, uint32_t &value) const {
+  if (channel >= channel_count || !ready_[channel]) {
+    return ADCStatus::error;
+  }
+
+  std::atomic_signal_fence(std::memory_order_acquire);
+  value = values_[channel];
+  return ADCStatus::ok;
+}
+
+template <size_t channel_count>
+uint32_t Decimator<channel_count>::published(size_t channel) const {
+  if (channel >= channel_count) {
+    return 0;
+  }
+
+  return published_[channel];
+}
+
+}  // namespace Pufferfish::Driver::Analog
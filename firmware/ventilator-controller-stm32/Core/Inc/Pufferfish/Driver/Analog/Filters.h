@@ -0,0 +1,206 @@
+/// Filters.h
+/// Fixed-cost digital filters for conditioning sensor signals one sample at
+/// a time: biquad IIR cascades, FIR filters, running medians and spike
+/// rejection.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace Pufferfish::Driver::Analog {
+
+/**
+ * Coefficients of one second-order IIR section, normalized so that a0 = 1:
+ * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2].
+ * Note that CMSIS-DSP's biquad functions take a1 and a2 negated.
+ */
+struct BiquadCoefficients {
+  float b0;
+  float b1;
+  float b2;
+  float a1;
+  float a2;
+};
+
+static constexpr BiquadCoefficients identity_biquad{1, 0, 0, 0, 0};
+
+/**
+ * Designs a second-order low-pass section (RBJ audio EQ cookbook)
+ * @param cutoff the -3 dB frequency for the default q, in Hz
+ * @param sample_rate the sampling rate, in Hz
+ * @param q the quality factor; 1/sqrt(2) gives a Butterworth response
+ * @return the coefficients, with unity gain at DC
+ */
+BiquadCoefficients lowpass_biquad(
+    float cutoff, float sample_rate, float q = 0.70710678F);
+
+/**
+ * A cascade of second-order IIR sections in transposed direct form II, the
+ * form used by CMSIS-DSP's arm_biquad_cascade_df2T_f32, which has the best
+ * numerical behavior in single precision. Costs 4 multiply-adds per section
+ * per sample.
+ */
+template <size_t stages>
+class BiquadCascade {
+ public:
+  using Coefficients = std::array<BiquadCoefficients, stages>;
+
+  explicit BiquadCascade(const Coefficients &coefficients) : coefficients_(coefficients) {}
+
+  /**
+   * Filters one sample
+   * @param sample the input sample
+   * @return the output sample
+   */
+  float input(float sample);
+
+  /**
+   * Sets the state to the steady state for a constant input, so that the
+   * filter starts without a transient
+   * @param value the constant input
+   */
+  void reset(float value);
+
+ private:
+  const Coefficients coefficients_;
+  std::array<std::array<float, 2>, stages> states_{};
+};
+
+/**
+ * Designs a linear-phase low-pass FIR filter by windowing a sinc with a
+ * Hamming window; its delay is (taps - 1) / 2 samples
+ * @param cutoff the cutoff frequency, in Hz
+ * @param sample_rate the sampling rate, in Hz
+ * @return the taps, normalized for unity gain at DC
+ */
+template <size_t taps>
+std::array<float, taps> lowpass_fir(float cutoff, float sample_rate);
+
+/**
+ * @return the taps of an FIR filter which passes its input through unchanged
+ */
+template <size_t taps>
+constexpr std::array<float, taps> identity_fir();
+
+/**
+ * An FIR filter whose delay line is stored twice over, so that each sample
+ * is a single contiguous dot product, as in CMSIS-DSP's arm_fir_f32, with no
+ * wraparound inside the loop. Costs one multiply-add per tap per sample.
+ */
+template <size_t taps>
+class FIRFilter {
+ public:
+  static_assert(taps > 0, "FIR filter needs at least one tap");
+
+  using Taps = std::array<float, taps>;
+
+  explicit FIRFilter(const Taps &coefficients) : coefficients_(coefficients) {}
+
+  /**
+   * Filters one sample
+   * @param sample the input sample
+   * @return the output sample
+   */
+  float input(float sample);
+
+  /**
+   * Fills the delay line with a constant input
+   * @param value the constant input
+   */
+  void reset(float value);
+
+ private:
+  const Taps coefficients_;
+  std::array<float, 2 * taps> delay_{};
+  size_t newest_ = 0;
+};
+
+/**
+ * The median of the most recent samples, which removes isolated outliers
+ * without smearing steps. Samples are kept both in arrival order and in
+ * sorted order, so each sample costs at most one pass over the window.
+ */
+template <size_t window>
+class MedianFilter {
+ public:
+  static_assert(window % 2 == 1, "Median filter window must be odd");
+
+  /**
+   * Adds a sample to the window
+   * @param sample the input sample
+   * @return the median of the window
+   */
+  float input(float sample);
+
+  /**
+   * Fills the window with a constant input
+   * @param value the constant input
+   */
+  void reset(float value);
+
+ private:
+  std::array<float, window> samples_{};  // in arrival order
+  std::array<float, window> sorted_{};
+  size_t oldest_ = 0;
+};
+
+/**
+ * Holds the previous sample in place of any sample which jumps by more than
+ * max_step from it, for at most max_rejections consecutive samples; a jump
+ * which persists for longer is accepted as a real change.
+ */
+class SpikeRejector {
+ public:
+  static constexpr float no_limit = std::numeric_limits<float>::infinity();
+
+  explicit SpikeRejector(float max_step = no_limit, uint32_t max_rejections = 0)
+      : max_step_(max_step), max_rejections_(max_rejections) {}
+
+  /**
+   * @param sample the input sample
+   * @return the sample, or the previous accepted sample if rejected
+   */
+  float input(float sample);
+
+  /**
+   * Accepts the next sample unconditionally
+   * @param value the value to hold until the next sample
+   */
+  void reset(float value);
+
+  /**
+   * @return the total number of samples rejected
+   */
+  [[nodiscard]] uint32_t rejected() const { return rejected_; }
+
+ private:
+  const float max_step_;
+  const uint32_t max_rejections_;
+  float previous_ = 0;
+  uint32_t consecutive_ = 0;
+  uint32_t rejected_ = 0;
+};
+
+}  // namespace Pufferfish::Driver::Analog
+
+#include "Filters.tpp"
@@ -0,0 +1,146 @@
+/// Filters.tpp
+/// Fixed-cost digital filters for conditioning sensor signals one sample at
+/// a time: biquad IIR cascades, FIR filters, running medians and spike
+/// rejection.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cmath>
+
+#include "Filters.h"
+
+namespace Pufferfish::Driver::Analog {
+
+// BiquadCascade
+
+template <size_t stages>
+float BiquadCascade<stages>::input(float sample) {
+  float value = sample;
+  for (size_t i = 0; i < stages; ++i) {
+    const BiquadCoefficients &c = coefficients_[i];
+    std::array<float, 2> &state = states_[i];
+    float output = c.b0 * value + state[0];
+    state[0] = c.b1 * value - c.a1 * output + state[1];
+    state[1] = c.b2 * value - c.a2 * output;
+    value = output;
+  }
+  return value;
+}
+
+template <size_t stages>
+void BiquadCascade<stages>::reset(float value) {
+  float input = value;
+  for (size_t i = 0; i < stages; ++i) {
+    const BiquadCoefficients &c = coefficients_[i];
+    float output = input * (c.b0 + c.b1 + c.b2) / (1 + c.a1 + c.a2);
+    states_[i][1] = c.b2 * input - c.a2 * output;
+    states_[i][0] = c.b1 * input - c.a1 * output + states_[i][1];
+    input = output;
+  }
+}
+
+// FIR design
+
+template <size_t taps>
+std::array<float, taps> lowpass_fir(float cutoff, float sample_rate) {
+  static constexpr float pi = 3.14159265F;
+
+  std::array<float, taps> coefficients{};
+  const float normalized_cutoff = 2 * cutoff / sample_rate;  // fraction of Nyquist
+  const float center = static_cast<float>(taps - 1) / 2;
+  float sum = 0;
+  for (size_t i = 0; i < taps; ++i) {
+    float offset = static_cast<float>(i) - center;
+    float sinc = offset == 0 ? normalized_cutoff
+                             : std::sin(pi * normalized_cutoff * offset) / (pi * offset);
+    float hamming =
+        taps == 1 ? 1 : 0.54F - 0.46F * std::cos(2 * pi * static_cast<float>(i) / (taps - 1));
+    coefficients[i] = sinc * hamming;
+    sum += coefficients[i];
+  }
+  for (float &coefficient : coefficients) {
+    coefficient /= sum;
+  }
+  return coefficients;
+}
+
+template <size_t taps>
+constexpr std::array<float, taps> identity_fir() {
+  std::array<float, taps> coefficients{};
+  coefficients[0] = 1;
+  return coefficients;
+}
+
+// FIRFilter
+
+template <size_t taps>
+float FIRFilter<taps>::input(float sample) {
+  newest_ = newest_ == 0 ? taps - 1 : newest_ - 1;
+  delay_[newest_] = sample;
+  delay_[newest_ + taps] = sample;
+
+  // delay_[newest_ + i] holds the sample from i steps ago
+  const float *history = &delay_[newest_];
+  float output = 0;
+  for (size_t i = 0; i < taps; ++i) {
+    output += coefficients_[i] * history[i];
+  }
+  return output;
+}
+
+template <size_t taps>
+void FIRFilter<taps>::reset(float value) {
+  delay_.fill(value);
+}
+
+// MedianFilter
+
+template <size_t window>
+float MedianFilter<window>::input(float sample) {
+  float removed = samples_[oldest_];
+  samples_[oldest_] = sample;
+  oldest_ = (oldest_ + 1) % window;
+
+  // Remove the oldest sample from the sorted window, then slide the new
+  // sample into place from wherever the gap was left
+  size_t gap = 0;
+  while (gap < window - 1 && sorted_[gap] != removed) {
+    ++gap;
+  }
+  while (gap > 0 && sorted_[gap - 1] > sample) {
+    sorted_[gap] = sorted_[gap - 1];
+    --gap;
+  }
+  while (gap < window - 1 && sorted_[gap + 1] < sample) {
+    sorted_[gap] = sorted_[gap + 1];
+    ++gap;
+  }
+  sorted_[gap] = sample;
+  return sorted_[window / 2];
+}
+
+template <size_t window>
+void MedianFilter<window>::reset(float value) {
+  samples_.fill(value);
+  sorted_.fill(value);
+  oldest_ = 0;
+}
+
+}  // namespace Pufferfish::Driver::Analog
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * AlarmLimitsService.h
+ *
+ * Servicing of alarm limits requests into the alarm limits which are in
+ * effect, for each ventilation mode
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "Pufferfish/Application/States.h"
+
+namespace Pufferfish::Driver::BreathingCircuit {
+
+class AlarmLimitsService {
+ public:
+  virtual void transform(
+      const AlarmLimitsRequest &alarm_limits_request, AlarmLimits &alarm_limits) = 0;
+
+ protected:
+  static constexpr uint32_t fio2_floor = 21;     // %
+  static constexpr uint32_t fio2_ceiling = 100;  // %
+  static constexpr uint32_t spo2_floor = 0;      // %
+  static constexpr uint32_t spo2_ceiling = 100;  // %
+  static constexpr uint32_t hr_floor = 0;        // bpm
+  static constexpr uint32_t hr_ceiling = 200;    // bpm
+
+  /**
+   * Takes on the requested range if it is given and lies within the floor
+   * and ceiling, and otherwise keeps the current range
+   */
+  static void transform_range(
+      bool has_request,
+      const Range &request,
+      uint32_t floor,
+      uint32_t ceiling,
+      bool &has_response,
+      Range &response);
+
+  // Services the limits which apply to every mode
+  static void transform_common(
+      const AlarmLimitsRequest &alarm_limits_request, AlarmLimits &alarm_limits);
+};
+
+class PCACAlarmLimits : public AlarmLimitsService {
+ public:
+  void transform(
+      const AlarmLimitsRequest &alarm_limits_request, AlarmLimits &alarm_limits) override;
+
+ private:
+  static constexpr uint32_t rr_floor = 0;      // b/min
+  static constexpr uint32_t rr_ceiling = 100;  // b/min
+};
+
+class HFNCAlarmLimits : public AlarmLimitsService {
+ public:
+  void transform(
+      const AlarmLimitsRequest &alarm_limits_request, AlarmLimits &alarm_limits) override;
+};
+
+class AlarmLimitsServices {
+ public:
+  void transform(
+      const Parameters &parameters,
+      const AlarmLimitsRequest &alarm_limits_request,
+      AlarmLimits &alarm_limits);
+
+  /**
+   * The limits in effect from boot until the first request, matching the
+   * defaults which the frontend requests
+   * @return the default alarm limits
+   */
+  static AlarmLimits default_alarm_limits();
+
+ private:
+  static constexpr Range default_fio2 = {21, 100};  // %
+  static constexpr Range default_spo2 = {21, 100};  // %
+  static constexpr Range default_hr = {0, 200};     // bpm
+  static constexpr Range default_rr = {0, 100};     // b/min
+
+  AlarmLimitsService *active_service_ = nullptr;
+  PCACAlarmLimits pc_ac_;
+  HFNCAlarmLimits hfnc_;
+};
+
+}  // namespace Pufferfish::Driver::BreathingCircuit
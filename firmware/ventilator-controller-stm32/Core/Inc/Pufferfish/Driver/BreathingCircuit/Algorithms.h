@@ -13,20 +13,43 @@
 
 namespace Pufferfish::Driver::BreathingCircuit {
 
+struct PIGains {
+  float p;  // actuation / error
+  float i;  // actuation / (error * step)
+};
+
+/**
+ * A PI controller with an optional feed-forward term, so that the PI only
+ * needs to correct the residual error of an open-loop estimate of the
+ * actuation. The integral is kept in units of actuation, so gains can be
+ * changed between steps without a jump in the output, and it stops winding
+ * up while the actuation is saturated.
+ */
 class PI {
  public:
+  static constexpr PIGains default_gains{0.00001, 0.0002};
+
+  explicit PI(const PIGains &gains = default_gains) : gains_(gains) {}
+
   void transform(float measurement, float setpoint, float &actuation);
 
+  /**
+   * @param measurement the measured value
+   * @param setpoint the target value
+   * @param feedforward the open-loop estimate of the actuation for the setpoint
+   * @param actuation[out] the feed-forward plus the PI correction, from 0 to 1
+   */
+  void transform(float measurement, float setpoint, float feedforward, float &actuation);
+
+  void set_gains(const PIGains &gains);
+
  private:
   static constexpr float out_max = 1;
   static constexpr float out_min = 0;
-  static constexpr float p_gain = 0.00001;
-  static constexpr float i_gain = 0.0002;
-  static constexpr float i_max = out_max / i_gain;
-  static constexpr float i_min = out_min / i_gain;
 
+  PIGains gains_;
   float error_ = 0;
-  float error_integral_ = 0;
+  float integral_ = 0;  // actuation
 };
 
 }  // namespace Pufferfish::Driver::BreathingCircuit
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * BreathAnalyzer.h
+ *
+ * Streaming computation of breath cycle measurements from airway flow and
+ * pressure samples
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "Pufferfish/Application/States.h"
+
+namespace Pufferfish::Driver::BreathingCircuit {
+
+/**
+ * Segments the stream of airway flow and pressure samples into breaths and
+ * measures each breath as it goes, with constant work and memory per sample:
+ * volume is integrated incrementally, and peak, end-expiratory and mean
+ * pressures are tracked as running values. A breath starts when the flow
+ * rises above insp_flow_threshold and the breath's inspiration ends when
+ * the flow falls below exp_flow_threshold; flow between the two thresholds,
+ * or a phase shorter than min_phase_duration, never changes the phase. At
+ * the start of each breath, the measurements of the previous breath become
+ * available:
+ * - vt: volume inspired during the breath, in mL
+ * - rr: breaths per minute, from the duration of the breath
+ * - peep: pressure at the end of expiration, in cm H2O
+ * - pip: peak pressure during the breath, in cm H2O
+ * - ip: mean pressure during inspiration, in cm H2O
+ * - ve: minute ventilation in L/min, averaged over about the last minute
+ */
+class BreathAnalyzer {
+ public:
+  enum class Phase { unknown = 0, inspiratory, expiratory };
+
+  static constexpr float insp_flow_threshold = 2;   // L/min
+  static constexpr float exp_flow_threshold = -2;   // L/min
+  static const uint32_t min_phase_duration = 100;   // ms
+  static const uint32_t max_sample_interval = 100;  // ms
+  static const uint32_t peep_time_constant = 50;    // ms
+  static const uint32_t ve_window = 60000;          // ms
+
+  /**
+   * Adds the next sample. Samples whose time doesn't advance are ignored;
+   * after a gap longer than max_sample_interval, the breath in progress is
+   * discarded and segmentation starts over.
+   * @param time the time of the sample, in ms
+   * @param flow the airway flow, in L/min, positive towards the patient
+   * @param paw the airway pressure, in cm H2O
+   */
+  void input(uint32_t time, float flow, float paw);
+
+  /**
+   * Outputs the measurements of the most recent complete breath, once
+   * @param cycle_measurements the measurements, set only if a breath has
+   * completed since the previous call
+   * @return true if a breath has completed since the previous call
+   */
+  bool output(CycleMeasurements &cycle_measurements);
+
+  /**
+   * Forgets all breaths, e.g. when ventilation stops
+   */
+  void reset();
+
+  [[nodiscard]] Phase phase() const { return phase_; }
+
+  /**
+   * @return the net volume delivered since the current breath started, in mL
+   */
+  [[nodiscard]] float volume() const { return volume_; }
+
+ private:
+  static constexpr float ms_per_min = 60000;
+  static constexpr float ml_per_l = 1000;
+
+  // Sampling
+  bool sampled_ = false;
+  uint32_t previous_time_ = 0;  // ms
+  float previous_flow_ = 0;     // L/min
+
+  // Segmentation
+  Phase phase_ = Phase::unknown;
+  uint32_t phase_start_time_ = 0;   // ms
+  bool breath_started_ = false;
+  uint32_t breath_start_time_ = 0;  // ms
+
+  // Running values of the current breath
+  float volume_ = 0;             // mL
+  float insp_volume_ = 0;        // mL
+  float peak_paw_ = 0;           // cm H2O
+  float insp_paw_integral_ = 0;  // cm H2O * ms
+  uint32_t insp_duration_ = 0;   // ms
+  float end_exp_paw_ = 0;        // cm H2O
+
+  // Measurements across breaths
+  bool ve_initialized_ = false;
+  float ve_ = 0;  // L/min
+  bool available_ = false;
+  CycleMeasurements measurements_{};
+
+  void start_breath(uint32_t time, float paw);
+  void start_expiration(uint32_t time, float paw);
+  void accumulate(uint32_t interval, float flow, float paw);
+};
+
+}  // namespace Pufferfish::Driver::BreathingCircuit
@@ -9,71 +9,256 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 
 #include "Controller.h"
 #include "ParametersService.h"
+#include "Pufferfish/Driver/Analog/Conditioner.h"
+#include "Pufferfish/Driver/I2C/HoneywellABP.h"
 #include "Pufferfish/Driver/I2C/SFM3019/Sensor.h"
-#include "Pufferfish/HAL/Interfaces/PWM.h"
+#include "Pufferfish/Driver/ValveBank.h"
+#include "Pufferfish/HAL/Interfaces/Time.h"
+#include "Pufferfish/Util/DoubleBuffer.h"
+#include "Pufferfish/Util/ValueQueue.h"
 
 namespace Pufferfish::Driver::BreathingCircuit {
 
+// Telemetry from the most recent control step
+struct ControlTelemetry {
+  uint32_t step_time;  // ms
+  SensorVars sensor_vars;
+  ActuatorSetpoints actuator_setpoints;
+  ActuatorVars actuator_vars;
+};
+
+/**
+ * A control loop which takes one step on each call to update(), at the
+ * fixed rate of whatever calls it, e.g. a timer interrupt. Parameters come in
+ * and telemetry goes out through double buffers, so the main loop may call
+ * input() and output() at any time without disabling interrupts. The
+ * telemetry of every step also goes into a queue, so that the main loop can
+ * process each step exactly once with take_step(). Each loop
+ * only drives its own valves while its mode is selected, and closes them
+ * once when the mode changes away from it.
+ */
 class ControlLoop {
  public:
+  /**
+   * Takes one control step, to be called at a fixed rate
+   * @param current_time the current time, in ms
+   */
   virtual void update(uint32_t current_time) = 0;
 
+  /**
+   * Publishes new parameters for the next control steps, from the main loop
+   * @param parameters the new parameters
+   */
+  void input(const Parameters &parameters);
+
+  /**
+   * Copies the telemetry of the most recent control step, from the main loop
+   * @param telemetry the telemetry of the most recent step
+   */
+  void output(ControlTelemetry &telemetry) const;
+
+  /**
+   * Takes the telemetry of the oldest control step which has not been taken
+   * yet, from the main loop. Steps are only dropped if the main loop falls
+   * more than step_queue_size steps behind.
+   * @param step[out] the telemetry of the oldest untaken step
+   * @return true if a step was taken, false if every step has been taken
+   */
+  bool take_step(ControlTelemetry &step);
+
+  // About 1/8 s of steps at 1 kHz
+  static const HAL::AtomicSize step_queue_size = 128;
+
  protected:
-  static const uint32_t update_interval = 2;  // ms
+  Util::DoubleBuffer<Parameters> parameters_;
 
-  void advance_step_time(uint32_t current_time);
-  [[nodiscard]] uint32_t step_duration(uint32_t current_time) const;
-  [[nodiscard]] bool update_needed(uint32_t current_time) const;
+  /**
+   * Publishes the telemetry of a control step, from the control step
+   * @param step the telemetry of the step
+   */
+  void publish(const ControlTelemetry &step);
 
  private:
-  uint32_t previous_step_time_ = 0;  // ms
+  Util::DoubleBuffer<ControlTelemetry> telemetry_;
+  Util::ValueQueue<ControlTelemetry, step_queue_size> steps_;
 };
 
 class HFNCControlLoop : public ControlLoop {
  public:
+  // Indices of the valves in the valve bank
+  static const size_t valve_air = 0;
+  static const size_t valve_o2 = 1;
+
+  // Conditioning of the air and O2 flows, in that order, before control
+  static const size_t flow_air = 0;
+  static const size_t flow_o2 = 1;
+  using FlowConditioner = Analog::Conditioner<2, 1, 1, 3>;
+
   HFNCControlLoop(
-      const Parameters &parameters,
-      SensorMeasurements &sensor_measurements,
       Driver::I2C::SFM3019::Sensor &sfm3019_air,
       Driver::I2C::SFM3019::Sensor &sfm3019_o2,
-      HAL::PWM &valve_air,
-      HAL::PWM &valve_o2)
-      : parameters_(parameters),
-        sensor_measurements_(sensor_measurements),
+      ValveBank &valves,
+      const FlowConditioner::Config &flow_conditioning = default_flow_conditioning())
+      : flow_conditioner_(flow_conditioning),
         sfm3019_air_(sfm3019_air),
         sfm3019_o2_(sfm3019_o2),
-        valve_air_(valve_air),
-        valve_o2_(valve_o2) {}
+        valves_(valves) {}
 
   void update(uint32_t current_time) override;
 
-  [[nodiscard]] SensorVars &sensor_vars();
-  [[nodiscard]] const SensorVars &sensor_vars() const;
-  [[nodiscard]] const ActuatorSetpoints &actuator_setpoints() const;
-  [[nodiscard]] const ActuatorVars &actuator_vars() const;
+  using ControlLoop::input;
+  using ControlLoop::output;
+
+  /**
+   * Publishes new valve tables for feed-forward, from the main loop
+   * @param characterization the tables of both valves
+   */
+  void input(const ValveCharacterization &characterization);
+
+  /**
+   * Applies stored valve tables right away, from the main loop before the
+   * control steps start
+   * @param characterization the tables of both valves
+   * @return true if both tables are usable, false otherwise, in which case
+   * the valves are driven by their PIs alone
+   */
+  bool restore(const ValveCharacterization &characterization);
+
+  /**
+   * Publishes new gains for both valves' PIs, from the main loop
+   * @param gains the gains
+   */
+  void input(const PIGains &gains);
+
+  /**
+   * Starts a calibration of both valves at the next control step, from the
+   * main loop. The calibration runs instead of the controller, whatever the
+   * ventilation mode, and its result replaces the valve tables.
+   */
+  void calibrate();
+
+  /**
+   * @return true from a call to calibrate() until the calibration finishes
+   */
+  [[nodiscard]] bool calibrating() const;
+
+  /**
+   * Copies out the result of a calibration, from the main loop. A
+   * calibration which measured unusable tables is never output, so it is
+   * not worth persisting.
+   * @param characterization[out] the measured tables, only set if a
+   * calibration has finished with usable tables since the previous call
+   * @return true if a calibration has finished with usable tables since the
+   * previous call
+   */
+  bool output(ValveCharacterization &characterization);
+
+  /**
+   * Rejects flow readings which jump by more than 20 L/min in one step, then
+   * takes the median of 3 steps and low-passes at 100 Hz, for a total delay
+   * of about 3 control steps
+   * @return the default flow conditioning for a 1 kHz control loop
+   */
+  static FlowConditioner::Config default_flow_conditioning();
 
  private:
-  const Parameters &parameters_;
-  SensorMeasurements &sensor_measurements_;
+  static constexpr float control_rate = 1000;  // Hz
+  static constexpr float flow_max_step = 20;   // L/min
+  static constexpr float flow_cutoff = 100;    // Hz
+  static const uint32_t flow_max_rejections = 2;
 
+  FlowConditioner flow_conditioner_;
+  FlowConditioner::Samples raw_flows_{};
+  FlowConditioner::Samples flows_{};
   HFNCController controller_;
+  ValveCalibration calibration_;
+  Util::DoubleBuffer<ValveCharacterization> characterization_;
+  uint32_t characterization_writes_ = 0;
+  Util::DoubleBuffer<PIGains> gains_;
+  uint32_t gains_writes_ = 0;
+  Util::DoubleBuffer<ValveCharacterization> calibration_result_;
+  uint32_t calibration_result_reads_ = 0;
+  volatile bool calibration_requested_ = false;
+  volatile bool calibrating_ = false;
+  bool active_ = false;  // whether the previous step drove the valves
+  Parameters parameters_step_{};
+  SensorMeasurements sensor_measurements_{};
+  ControlTelemetry step_{};
 
-  // SensorVars
-  SensorVars sensor_vars_{};
   Driver::I2C::SFM3019::Sensor &sfm3019_air_;
   Driver::I2C::SFM3019::Sensor &sfm3019_o2_;
+  ValveBank &valves_;
+};
+
+/**
+ * Runs PC-AC breaths from the airway pressure, timed from a microsecond
+ * timebase so that the phases of each breath don't drift with the rate of
+ * whatever calls update()
+ */
+class PCACControlLoop : public ControlLoop {
+ public:
+  // Indices of the valves in the valve bank, apart from the HFNC valves
+  static const size_t valve_inspiratory = 2;
+  static const size_t valve_expiratory = 3;
+
+  using PressureConditioner = Analog::Conditioner<1, 1, 1, 3>;
+
+  PCACControlLoop(
+      Driver::I2C::HoneywellABP &paw_sensor,
+      ValveBank &valves,
+      HAL::Time &time,
+      const PressureConditioner::Config &pressure_conditioning = default_pressure_conditioning())
+      : pressure_conditioner_(pressure_conditioning),
+        paw_sensor_(paw_sensor),
+        valves_(valves),
+        time_(time) {}
+
+  void update(uint32_t current_time) override;
+
+  using ControlLoop::input;
+
+  /**
+   * Publishes new gains for the valves' PIs, from the main loop
+   * @param inspiratory the gains of the inspiratory valve
+   * @param expiratory the gains of the expiratory valve
+   */
+  void input(const PIGains &inspiratory, const PIGains &expiratory);
+
+  /**
+   * Rejects pressure readings which jump by more than 10 cm H2O in one step,
+   * then takes the median of 3 steps and low-passes at 100 Hz
+   * @return the default pressure conditioning for a 1 kHz control loop
+   */
+  static PressureConditioner::Config default_pressure_conditioning();
+
+ private:
+  static constexpr float control_rate = 1000;        // Hz
+  static constexpr float pressure_max_step = 10;     // cm H2O
+  static constexpr float pressure_cutoff = 100;      // Hz
+  static constexpr float cm_h2o_per_psi = 70.307;    // cm H2O / psi
+  static const uint32_t pressure_max_rejections = 2;
 
-  // Setpoints
-  ActuatorSetpoints actuator_setpoints_{};
+  PressureConditioner pressure_conditioner_;
+  PressureConditioner::Samples raw_paw_{};
+  PressureConditioner::Samples paw_{};
+  PCACController controller_;
+  Util::DoubleBuffer<std::array<PIGains, 2>> gains_;
+  uint32_t gains_writes_ = 0;
+  bool active_ = false;       // whether the previous step drove the valves
+  bool paw_reading_ = false;  // whether a paw read is in progress
+  Parameters parameters_step_{};
+  SensorMeasurements sensor_measurements_{};
+  ControlTelemetry step_{};
 
-  // ActuatorVars
-  ActuatorVars actuator_vars_{};
-  HAL::PWM &valve_air_;
-  HAL::PWM &valve_o2_;
+  Driver::I2C::HoneywellABP &paw_sensor_;
+  ValveBank &valves_;
+  HAL::Time &time_;
 };
 
 }  // namespace Pufferfish::Driver::BreathingCircuit
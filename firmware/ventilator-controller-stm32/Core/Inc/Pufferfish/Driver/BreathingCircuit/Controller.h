@@ -13,6 +13,7 @@
 
 #include "Algorithms.h"
 #include "Pufferfish/Application/States.h"
+#include "ValveCharacterization.h"
 
 namespace Pufferfish::Driver::BreathingCircuit {
 
@@ -20,16 +21,20 @@ struct SensorVars {
   float flow_air;  // L/min
   float flow_o2;   // L/min
   uint32_t po2;    // dPa
+  float paw;       // cm H2O
 };
 
 struct ActuatorSetpoints {
   float flow_air;
   float flow_o2;
+  float paw;  // cm H2O
 };
 
 struct ActuatorVars {
   float valve_air_opening;
   float valve_o2_opening;
+  float valve_inspiratory_opening;
+  float valve_expiratory_opening;
 };
 
 static const uint8_t fio2_min = 21;
@@ -56,9 +61,81 @@ class HFNCController : public Controller {
       ActuatorSetpoints &actuator_setpoints,
       ActuatorVars &actuator_vars) override;
 
+  /**
+   * Adds a feed-forward term to each valve's opening from its table, once
+   * both are characterized, so that the PIs only correct the residual
+   * @param characterization the tables of both valves
+   * @return true if both tables are usable, false otherwise, in which case
+   * the valves are driven by their PIs alone
+   */
+  bool set_characterization(const ValveCharacterization &characterization);
+
+  void set_gains(const PIGains &gains);
+
  private:
+  // Each flow setpoint is expected to be reached through a first-order lag
+  // of the valve and the flow sensor's conditioning, so the PIs track that
+  // lag instead of integrating the error of the feed-forward's transient
+  static constexpr float reference_time_constant = 20;  // steps
+  static constexpr float reference_response = 1 / (reference_time_constant + 1);
+
   PI valve_o2_{};
   PI valve_air_{};
+  ValveTable valve_air_table_;
+  ValveTable valve_o2_table_;
+  float flow_air_reference_ = 0;  // L/min
+  float flow_o2_reference_ = 0;   // L/min
+};
+
+/**
+ * Pressure-controlled assist/control: each breath starts an inspiratory phase
+ * which holds the airway at PIP through the inspiratory valve, followed by an
+ * expiratory phase which releases the airway down to PEEP through the
+ * expiratory valve, against a bias flow. The phases are timed from RR and I:E, which only take
+ * effect at the start of each breath. Each pressure setpoint is approached
+ * along a first-order reference, which sets the pressure rise time, and each
+ * valve's PI keeps its integral across breaths, so the opening which holds
+ * each pressure is learned over the first few breaths.
+ */
+class PCACController : public Controller {
+ public:
+  enum class Phase : uint8_t { idle = 0, inspiratory, expiratory };
+
+  static constexpr PIGains default_inspiratory_gains{0.16, 0.0008};
+  static constexpr PIGains default_expiratory_gains{0.4, 0.002};
+
+  /**
+   * @param current_time the current time, in us
+   */
+  void transform(
+      uint32_t current_time,
+      const Parameters &parameters,
+      const SensorVars &sensor_vars,
+      const SensorMeasurements &sensor_measurements,
+      ActuatorSetpoints &actuator_setpoints,
+      ActuatorVars &actuator_vars) override;
+
+  void set_gains(const PIGains &inspiratory, const PIGains &expiratory);
+
+  [[nodiscard]] Phase phase() const { return phase_; }
+
+ private:
+  static constexpr float minute_duration = 60000000;    // us
+  static constexpr float reference_time_constant = 40;  // steps
+  // During expiration the inspiratory valve passes a small bias flow, just
+  // above its cracking point, against which the expiratory valve holds PEEP
+  static constexpr float expiratory_bias_opening = 0.25;
+  static constexpr float reference_response = 1 / (reference_time_constant + 1);
+
+  PI valve_inspiratory_{default_inspiratory_gains};
+  PI valve_expiratory_{default_expiratory_gains};
+  Phase phase_ = Phase::idle;
+  uint32_t cycle_start_time_ = 0;      // us
+  uint32_t cycle_period_ = 0;          // us
+  uint32_t inspiratory_duration_ = 0;  // us
+  float paw_reference_ = 0;            // cm H2O
+
+  void start_cycle(uint32_t current_time, const Parameters &parameters);
 };
 
 }  // namespace Pufferfish::Driver::BreathingCircuit
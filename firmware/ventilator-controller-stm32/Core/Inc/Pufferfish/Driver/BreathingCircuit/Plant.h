@@ -0,0 +1,152 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Plant.h
+ *
+ * Fixed-step models of the valves, circuit and patient of the HFNC and PC-AC
+ * breathing circuits, for closing the control loops in simulation
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace Pufferfish::Driver::BreathingCircuit {
+
+// Physical constants of the simulated valves, circuit and patient
+struct PlantParameters {
+  float valve_max_flow = 120;             // L/min, with a valve fully open
+  float valve_cracking_opening = 0.2;     // opening below which a valve passes no gas
+  float valve_time_constant = 0.015;      // s
+  float circuit_volume = 0.6;             // L, between the valves and the cannula
+  float cannula_resistance = 0.002;       // cm H2O / (L/min)^2
+  float rr = 20;                          // b/min, of spontaneous breathing
+  float ie_ratio = 0.5;                   // inspiratory:expiratory duration
+  float peak_inspiratory_flow = 35;       // L/min, of the patient's demand
+};
+
+// State of the plant after the most recent step
+struct PlantVars {
+  float flow_air;       // L/min, through the air valve
+  float flow_o2;        // L/min, through the O2 valve
+  float patient_flow;   // L/min, inspiratory demand of the patient
+  float paw;            // cm H2O, at the cannula
+  float fio2;           // % O2, of the gas in the circuit
+  float inspired_fio2;  // % O2, inhaled including any entrained room air
+};
+
+/**
+ * A lumped model of the HFNC breathing circuit, advanced by a fixed time step
+ * so that its behavior only depends on the sequence of valve openings and
+ * never on how long the simulation takes to run. Each valve passes a flow
+ * proportional to its opening above a cracking point, lagged by a first-order
+ * response; the gas mixes in the circuit volume, and a spontaneously
+ * breathing patient entrains room air whenever their demand exceeds the
+ * delivered flow.
+ */
+class HFNCPlant {
+ public:
+  static const uint32_t default_step_duration = 1000;  // us
+
+  explicit HFNCPlant(
+      const PlantParameters &parameters = PlantParameters{},
+      uint32_t step_duration_us = default_step_duration);
+
+  /**
+   * Advances the plant by one time step
+   * @param valve_air_opening opening of the air valve, from 0 to 1
+   * @param valve_o2_opening opening of the O2 valve, from 0 to 1
+   */
+  void update(float valve_air_opening, float valve_o2_opening);
+
+  [[nodiscard]] const PlantVars &vars() const;
+
+  /**
+   * @return the simulated time since the plant started, in us
+   */
+  [[nodiscard]] uint64_t elapsed_us() const;
+
+ private:
+  static constexpr float s_per_min = 60;
+  static constexpr float us_per_s = 1000000;
+  static constexpr float pi = 3.14159265F;
+
+  const PlantParameters parameters_;
+  const float step_duration_;  // s
+  const uint32_t step_duration_us_;
+
+  PlantVars vars_;
+  float breath_phase_ = 0;  // fraction of the current breath which has elapsed
+  uint64_t elapsed_us_ = 0;
+
+  [[nodiscard]] float valve_flow(float opening) const;
+  void transform_valve(float opening, float &flow) const;
+  void transform_circuit();
+  void transform_patient();
+};
+
+// Physical constants of the simulated PC-AC valves, circuit and patient
+struct PCACPlantParameters {
+  float valve_max_flow = 120;          // L/min, with the inspiratory valve fully open
+  float valve_cracking_opening = 0.2;  // opening below which a valve passes no gas
+  float valve_time_constant = 0.015;   // s
+  float expiratory_conductance = 10;   // L/min / cm H2O, with the expiratory valve fully open
+  float leak_conductance = 0.2;        // L/min / cm H2O, around the patient interface
+  float compliance = 0.02;             // L / cm H2O, of the circuit and lungs together
+};
+
+// State of the PC-AC plant after the most recent step
+struct PCACPlantVars {
+  float flow_inspiratory;  // L/min, through the inspiratory valve
+  float flow_expiratory;   // L/min, through the expiratory valve and the leak
+  float paw;               // cm H2O
+};
+
+/**
+ * A single-compartment model of a sealed breathing circuit and the patient's
+ * lungs, filled through an inspiratory valve and emptied through an
+ * expiratory valve and a fixed leak. The inspiratory valve passes a flow
+ * proportional to its opening above a cracking point, and the expiratory
+ * valve a flow proportional to the airway pressure and to its opening above
+ * a cracking point; both are lagged by a first-order response.
+ */
+class PCACPlant {
+ public:
+  static const uint32_t default_step_duration = 1000;  // us
+
+  explicit PCACPlant(
+      const PCACPlantParameters &parameters = PCACPlantParameters{},
+      uint32_t step_duration_us = default_step_duration);
+
+  /**
+   * Advances the plant by one time step
+   * @param valve_inspiratory_opening opening of the inspiratory valve, from 0 to 1
+   * @param valve_expiratory_opening opening of the expiratory valve, from 0 to 1
+   */
+  void update(float valve_inspiratory_opening, float valve_expiratory_opening);
+
+  [[nodiscard]] const PCACPlantVars &vars() const;
+
+  /**
+   * @return the simulated time since the plant started, in us
+   */
+  [[nodiscard]] uint64_t elapsed_us() const;
+
+ private:
+  static constexpr float s_per_min = 60;
+  static constexpr float us_per_s = 1000000;
+
+  const PCACPlantParameters parameters_;
+  const float step_duration_;  // s
+  const uint32_t step_duration_us_;
+
+  PCACPlantVars vars_{};
+  float inspiratory_fraction_ = 0;  // of the inspiratory valve's maximum flow
+  float expiratory_fraction_ = 0;   // of the expiratory valve's maximum conductance
+  uint64_t elapsed_us_ = 0;
+
+  [[nodiscard]] float valve_fraction(float opening) const;
+  void transform_valve(float opening, float &fraction) const;
+};
+
+}  // namespace Pufferfish::Driver::BreathingCircuit
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * ValveCharacterization.h
+ *
+ * Tables of the flow through each proportional valve against its opening,
+ * the calibration routine which measures them, and their persistent format
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Pufferfish::Driver::BreathingCircuit {
+
+struct SensorVars;
+struct ActuatorVars;
+
+/**
+ * The steady-state flow through a valve at evenly spaced openings from 0 to
+ * 1, interpolated linearly in between. Flow must not decrease with opening,
+ * so the inverse lookup from a target flow to an opening is well defined;
+ * it takes a binary search over the points.
+ */
+class ValveTable {
+ public:
+  static const size_t point_count = 17;
+  using Flows = std::array<float, point_count>;  // L/min
+
+  /**
+   * Replaces the table. Any point below the point before it is raised to
+   * match it, to remove measurement noise from the flat region below the
+   * valve's cracking point.
+   * @param flows the flow at each opening i / (point_count - 1), in L/min
+   * @return true if the table is usable, false if the valve never passed
+   * any flow, in which case the table is cleared
+   */
+  bool set(const Flows &flows);
+
+  void clear();
+
+  [[nodiscard]] bool characterized() const { return characterized_; }
+
+  [[nodiscard]] const Flows &flows() const { return flows_; }
+
+  /**
+   * @param opening the valve opening, from 0 to 1
+   * @return the flow expected at the opening, in L/min
+   */
+  [[nodiscard]] float flow(float opening) const;
+
+  /**
+   * @param flow the target flow, in L/min
+   * @return the smallest opening expected to pass the flow, from 0 to 1,
+   * or 0 if the valve isn't characterized
+   */
+  [[nodiscard]] float opening(float flow) const;
+
+ private:
+  static constexpr float min_flow_span = 1;  // L/min
+  static constexpr float max_index = point_count - 1;
+
+  Flows flows_{};
+  bool characterized_ = false;
+};
+
+// Tables of both valves of the HFNC breathing circuit
+struct ValveCharacterization {
+  ValveTable::Flows air;
+  ValveTable::Flows o2;
+};
+
+/**
+ * Measures the tables of both valves at once, each against its own flow
+ * sensor, by holding both valves at each table opening in turn until the
+ * flow settles, then averaging the flow. Call transform() once per control
+ * step instead of the controller while running() is true; the whole
+ * routine takes point_count * (settle_steps + average_steps) steps, with
+ * the valves closed at the end.
+ */
+class ValveCalibration {
+ public:
+  static const uint32_t settle_steps = 150;
+  static const uint32_t average_steps = 50;
+
+  void start();
+
+  [[nodiscard]] bool running() const { return running_; }
+
+  /**
+   * Takes one step of the calibration
+   * @param sensor_vars the flows measured in this step
+   * @param actuator_vars[out] the valve openings for the next step
+   * @return true if the calibration finished in this step
+   */
+  bool transform(const SensorVars &sensor_vars, ActuatorVars &actuator_vars);
+
+  /**
+   * @return the tables measured by the most recent complete calibration
+   */
+  [[nodiscard]] const ValveCharacterization &characterization() const {
+    return characterization_;
+  }
+
+ private:
+  bool running_ = false;
+  size_t point_ = 0;
+  uint32_t step_ = 0;
+  float sum_air_ = 0;
+  float sum_o2_ = 0;
+  ValveCharacterization characterization_{};
+
+  [[nodiscard]] float opening() const;
+};
+
+/**
+ * Characterizations are persisted as a version byte followed by each
+ * table's flows, air then O2, as big-endian uint16s in units of
+ * flow_resolution
+ */
+class ValveCharacterizationFormat {
+ public:
+  static const uint8_t version = 1;
+  static constexpr float flow_resolution = 0.01;  // L/min
+  static const size_t size = 1 + 2 * ValveTable::point_count * sizeof(uint16_t);
+
+  /**
+   * @param characterization the characterization
+   * @param buffer[out] the encoded characterization, of the given size
+   */
+  static void write(const ValveCharacterization &characterization, uint8_t *buffer);
+
+  /**
+   * @param buffer the encoded characterization
+   * @param length the length of the encoded characterization
+   * @param characterization[out] the characterization, only set on success
+   * @return true on success, false if the length or version doesn't match
+   */
+  static bool read(
+      const uint8_t *buffer, size_t length, ValveCharacterization &characterization);
+};
+
+}  // namespace Pufferfish::Driver::BreathingCircuit
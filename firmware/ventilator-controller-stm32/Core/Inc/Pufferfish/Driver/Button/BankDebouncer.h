@@ -0,0 +1,104 @@
+/// BankDebouncer.h
+/// Parallel debouncing of a bank of membrane buttons sampled as a bitmask
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "Button.h"
+#include "Pufferfish/HAL/Types.h"
+#include "Pufferfish/Statuses.h"
+#include "Pufferfish/Util/RingBuffer.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Button {
+
+/**
+ * A debounced edge of one button in a bank
+ */
+struct ButtonEvent {
+  uint8_t button;  /// bit index of the button in the bank's samples
+  EdgeState edge;  /// rising_edge when pressed, falling_edge when released
+};
+
+/**
+ * Debounces up to 32 buttons at once with a two-bit vertical counter.
+ * Each bit of a sample is one button (1 = active). A button's debounced
+ * state only changes after its input has differed from that state on
+ * debounce_samples consecutive calls to input(), and each change is
+ * queued as a ButtonEvent. input() takes constant time regardless of how
+ * many buttons there are, and is meant to be called from a periodic timer
+ * interrupt; state() and output() may be called from the main loop.
+ */
+template <HAL::AtomicSize event_buffer_size>
+class BankDebouncer {
+ public:
+  static const uint8_t max_buttons = 32;
+  static const uint8_t debounce_samples = 4;
+
+  /**
+   * Debounces one sample of all buttons and queues any resulting edges
+   * @param samples the current input of each button, one bit per button
+   */
+  void input(uint32_t samples);
+
+  /**
+   * Pops the oldest queued edge
+   * @param event the edge, left unmodified if none is queued
+   * @return ok if an edge was popped, empty otherwise
+   */
+  BufferStatus output(ButtonEvent &event);
+
+  /**
+   * @return the debounced state of all buttons, one bit per button
+   */
+  [[nodiscard]] uint32_t state() const { return state_; }
+
+  /**
+   * @param button the bit index of the button
+   * @return true if the button is debounced as pressed
+   */
+  [[nodiscard]] bool pressed(uint8_t button) const { return (state_ >> button) & 1U; }
+
+  /**
+   * @return the number of edges dropped because the queue was full
+   */
+  [[nodiscard]] uint32_t dropped() const { return dropped_; }
+
+ private:
+  static const uint8_t edge_bit = 1;
+
+  void push(uint8_t button, bool pressed);
+
+  // Bit i of the two counters together hold how many consecutive samples
+  // button i has differed from its debounced state
+  uint32_t count_low_ = 0;
+  uint32_t count_high_ = 0;
+  volatile uint32_t state_ = 0;
+  volatile uint32_t dropped_ = 0;
+  volatile Util::RingBuffer<event_buffer_size> events_;
+};
+
+}  // namespace Button
+}  // namespace Driver
+}  // namespace Pufferfish
+
+#include "BankDebouncer.tpp"
@@ -0,0 +1,70 @@
+/// BankDebouncer.tpp
+/// Parallel debouncing of a bank of membrane buttons sampled as a bitmask
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "BankDebouncer.h"
+
+namespace Pufferfish::Driver::Button {
+
+template <HAL::AtomicSize event_buffer_size>
+void BankDebouncer<event_buffer_size>::input(uint32_t samples) {
+  uint32_t state = state_;
+  uint32_t changed = samples ^ state;
+
+  // Count up every button which differs from its state and reset the rest;
+  // a count which wraps around to zero has been stable for long enough
+  count_high_ = (count_high_ ^ count_low_) & changed;
+  count_low_ = ~count_low_ & changed;
+  uint32_t toggled = changed & ~(count_low_ | count_high_);
+  if (toggled == 0) {
+    return;
+  }
+
+  state ^= toggled;
+  state_ = state;
+  while (toggled != 0) {
+    auto button = static_cast<uint8_t>(__builtin_ctz(toggled));
+    push(button, ((state >> button) & 1U) != 0);
+    toggled &= toggled - 1;
+  }
+}
+
+template <HAL::AtomicSize event_buffer_size>
+BufferStatus BankDebouncer<event_buffer_size>::output(ButtonEvent &event) {
+  uint8_t encoded = 0;
+  if (events_.read(encoded) != BufferStatus::ok) {
+    return BufferStatus::empty;
+  }
+
+  event.button = encoded >> edge_bit;
+  event.edge = (encoded & 1U) != 0 ? EdgeState::rising_edge : EdgeState::falling_edge;
+  return BufferStatus::ok;
+}
+
+template <HAL::AtomicSize event_buffer_size>
+void BankDebouncer<event_buffer_size>::push(uint8_t button, bool pressed) {
+  auto encoded = static_cast<uint8_t>((button << edge_bit) | (pressed ? 1U : 0U));
+  if (events_.write(encoded) != BufferStatus::ok) {
+    dropped_ = dropped_ + 1;
+  }
+}
+
+}  // namespace Pufferfish::Driver::Button
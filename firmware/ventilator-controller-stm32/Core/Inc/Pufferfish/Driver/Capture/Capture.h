@@ -0,0 +1,199 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Capture.h
+ *
+ * Captures timestamped UART and I2C traffic and streams it to a trace output
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/HAL/Interfaces/BufferedUART.h"
+#include "Pufferfish/HAL/Interfaces/I2CDevice.h"
+#include "Pufferfish/HAL/Interfaces/Time.h"
+#include "Pufferfish/HAL/Interfaces/TraceOutput.h"
+#include "Pufferfish/HAL/Types.h"
+#include "Pufferfish/Statuses.h"
+#include "Records.h"
+
+namespace Pufferfish::Driver::Capture {
+
+/**
+ * An abstract destination of records
+ */
+class RecordSink {
+ public:
+  virtual void input(const Record &record) = 0;
+};
+
+/**
+ * An abstract source of records
+ */
+class RecordSource {
+ public:
+  /**
+   * @param record[out] the oldest record, left unmodified if none is queued
+   * @return ok if a record was popped, empty otherwise
+   */
+  virtual BufferStatus output(Record &record) = 0;
+};
+
+/**
+ * A queue of records from one context to another, e.g. from an interrupt
+ * to the main loop. Records may only be input from one context at a time.
+ * input() copies the record in constant time and never blocks; if the
+ * queue is full, the record is dropped and counted instead.
+ */
+template <HAL::AtomicSize slots>
+class RecordBuffer : public RecordSink, public RecordSource {
+ public:
+  void input(const Record &record) override;
+  BufferStatus output(Record &record) override;
+
+  /**
+   * @return the number of records dropped because the queue was full
+   */
+  [[nodiscard]] uint32_t dropped() const { return dropped_; }
+
+ private:
+  std::array<Record, slots> records_{};
+  volatile HAL::AtomicSize newest_ = 0;  // next slot to be filled
+  volatile HAL::AtomicSize oldest_ = 0;  // next slot to be drained
+  volatile uint32_t dropped_ = 0;
+};
+
+/**
+ * Records the bytes read from and written to a UART. Consecutive bytes in
+ * the same direction are batched into one record, which is closed once it
+ * is full or once batch_window has elapsed since its first byte, so a
+ * record's time is accurate to within the batch window.
+ */
+class UARTCapture {
+ public:
+  static const uint32_t batch_window = 1000;  // us
+
+  UARTCapture(Channel channel, RecordSink &sink, HAL::Time &time)
+      : channel_(static_cast<uint8_t>(channel)), sink_(sink), time_(time) {}
+
+  /**
+   * Records bytes transferred through the UART
+   * @param kind uart_rx for bytes read, uart_tx for bytes written
+   * @param bytes the bytes
+   * @param size the number of bytes
+   */
+  void input(RecordKind kind, const uint8_t *bytes, size_t size);
+
+  /**
+   * Closes any record whose batch window has elapsed; call this
+   * regularly from the same context as the UART's reads and writes
+   */
+  void update();
+
+ private:
+  const uint8_t channel_;
+  RecordSink &sink_;
+  HAL::Time &time_;
+  Record rx_{};
+  Record tx_{};
+
+  void append(Record &record, const uint8_t *bytes, size_t size, uint32_t current_time);
+  void close(Record &record);
+};
+
+/**
+ * A BufferedUART which passes everything through to another one, recording
+ * all bytes which were actually read or written with a UARTCapture
+ */
+class CapturedUART : public HAL::BufferedUART {
+ public:
+  CapturedUART(volatile HAL::BufferedUART &uart, UARTCapture &capture)
+      : uart_(uart), capture_(capture) {}
+
+  BufferStatus read(uint8_t &read_byte) volatile override;
+  BufferStatus write(uint8_t write_byte) volatile override;
+  BufferStatus write(
+      const uint8_t *write_bytes,
+      HAL::AtomicSize write_size,
+      HAL::AtomicSize &written_size) volatile override;
+  BufferStatus write_block(uint8_t write_byte, uint32_t timeout) volatile override;
+  BufferStatus write_block(
+      const uint8_t *write_bytes,
+      HAL::AtomicSize write_size,
+      uint32_t timeout,
+      HAL::AtomicSize &written_size) volatile override;
+
+ private:
+  volatile HAL::BufferedUART &uart_;
+  UARTCapture &capture_;
+};
+
+/**
+ * An I2CDevice which passes everything through to another one, recording
+ * each transaction, its status and its data as one record. Data beyond
+ * Record::max_data_size bytes is not recorded. A background read is
+ * recorded once it finishes, with the time it was started.
+ */
+class CapturedI2CDevice : public HAL::I2CDevice {
+ public:
+  CapturedI2CDevice(HAL::I2CDevice &dev, Channel channel, RecordSink &sink, HAL::Time &time)
+      : dev_(dev), channel_(static_cast<uint8_t>(channel)), sink_(sink), time_(time) {}
+
+  I2CDeviceStatus read(uint8_t *buf, size_t count) override;
+  I2CDeviceStatus write(uint8_t *buf, size_t count) override;
+  I2CDeviceStatus start_read(uint8_t *buf, size_t count) override;
+  I2CDeviceStatus finish_read() override;
+
+ private:
+  HAL::I2CDevice &dev_;
+  const uint8_t channel_;
+  RecordSink &sink_;
+  HAL::Time &time_;
+  uint8_t *pending_buf_ = nullptr;
+  size_t pending_count_ = 0;
+  uint32_t pending_time_ = 0;
+
+  void record(
+      RecordKind kind, uint32_t time, I2CDeviceStatus status, const uint8_t *buf, size_t count);
+};
+
+/**
+ * Streams records from several sources to a trace output as frames (see
+ * RecordSender), taking from the sources in turn. While the output is
+ * disabled, queued records are discarded, so that a debug probe which
+ * attaches later only sees fresh traffic. Call update() regularly from the
+ * main loop.
+ */
+template <size_t source_count>
+class TraceWriter {
+ public:
+  using Sources = std::array<RecordSource *, source_count>;
+
+  static const size_t max_frames_per_update = 16;
+
+  TraceWriter(const Sources &sources, HAL::TraceOutput &output)
+      : sources_(sources), output_(output) {}
+
+  /**
+   * Writes as many frames as the output takes without waiting
+   */
+  void update();
+
+ private:
+  const Sources sources_;
+  HAL::TraceOutput &output_;
+  const RecordSender sender_;
+  Serial::Backend::FrameProps::ChunkBuffer frame_;
+  size_t sent_ = 0;
+  size_t next_source_ = 0;
+
+  bool next_frame();
+  void discard();
+};
+
+}  // namespace Pufferfish::Driver::Capture
+
+#include "Capture.tpp"
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Capture.tpp
+ *
+ * Captures timestamped UART and I2C traffic and streams it to a trace output
+ */
+
+#pragma once
+
+#include <atomic>
+
+#include "Capture.h"
+
+namespace Pufferfish::Driver::Capture {
+
+// RecordBuffer
+
+template <HAL::AtomicSize slots>
+void RecordBuffer<slots>::input(const Record &record) {
+  HAL::AtomicSize newest = newest_;
+  HAL::AtomicSize next = (newest + 1) % slots;
+  if (next == oldest_) {
+    dropped_ = dropped_ + 1;
+    return;
+  }
+
+  records_[newest] = record;
+  // The record must be complete before the consumer can see it
+  std::atomic_signal_fence(std::memory_order_release);
+  newest_ = next;
+}
+
+template <HAL::AtomicSize slots>
+BufferStatus RecordBuffer<slots>::output(Record &record) {
+  HAL::AtomicSize oldest = oldest_;
+  if (oldest == newest_) {
+    return BufferStatus::empty;
+  }
+
+  std::atomic_signal_fence(std::memory_order_acquire);
+  record = records_[oldest];
+  std::atomic_signal_fence(std::memory_order_release);
+  oldest_ = (oldest + 1) % slots;
+  return BufferStatus::ok;
+}
+
+// TraceWriter
+
+template <size_t source_count>
+void TraceWriter<source_count>::update() {
+  if (!output_.enabled()) {
+    discard();
+    return;
+  }
+
+  for (size_t i = 0; i < max_frames_per_update; ++i) {
+    if (sent_ >= frame_.size() && !next_frame()) {
+      return;
+    }
+
+    sent_ += output_.write(frame_.buffer() + sent_, frame_.size() - sent_);
+    if (sent_ < frame_.size()) {
+      return;  // the output is full
+    }
+  }
+}
+
+template <size_t source_count>
+bool TraceWriter<source_count>::next_frame() {
+  Record record{};
+  for (size_t i = 0; i < source_count; ++i) {
+    RecordSource &source = *sources_[next_source_];
+    next_source_ = (next_source_ + 1) % source_count;
+    if (source.output(record) != BufferStatus::ok) {
+      continue;
+    }
+
+    if (sender_.transform(record, frame_) == IndexStatus::ok) {
+      sent_ = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+template <size_t source_count>
+void TraceWriter<source_count>::discard() {
+  Record record{};
+  for (RecordSource *source : sources_) {
+    while (source->output(record) == BufferStatus::ok) {
+    }
+  }
+  frame_.clear();
+  sent_ = 0;
+}
+
+}  // namespace Pufferfish::Driver::Capture
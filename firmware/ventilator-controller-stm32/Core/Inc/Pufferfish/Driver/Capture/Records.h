@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Records.h
+ *
+ * Timestamped records of UART and I2C traffic, and their serialization
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/Driver/Serial/Backend/Frames.h"
+#include "Pufferfish/Statuses.h"
+#include "Pufferfish/Util/Vector.h"
+
+namespace Pufferfish::Driver::Capture {
+
+// The kind of I/O operation captured in a record
+enum class RecordKind : uint8_t {
+  uart_rx = 0,    // bytes read out of a UART's receive buffer
+  uart_tx = 1,    // bytes written into a UART's transmit buffer
+  i2c_read = 2,   // an I2C read transaction and the bytes it returned
+  i2c_write = 3,  // an I2C write transaction and the bytes it sent
+};
+
+// Channels of the ventilator's captures, so that captures are self-describing
+enum class Channel : uint8_t {
+  backend = 0,
+  fdo2 = 1,
+  nonin_oem = 2,
+  sfm3019_air = 3,
+  sfm3019_o2 = 4,
+};
+
+static const size_t max_channels = 8;
+
+struct Record {
+  static constexpr size_t max_data_size = 32;
+
+  uint32_t time = 0;  // us, when the operation started
+  uint8_t channel = 0;
+  RecordKind kind = RecordKind::uart_rx;
+  uint8_t status = 0;  // BufferStatus or I2CDeviceStatus of the operation
+  uint8_t size = 0;    // number of bytes of data
+  std::array<uint8_t, max_data_size> data{};
+};
+
+/**
+ * Serializes records into COBS-encoded, zero-delimited frames, so that a
+ * reader can resynchronize with a capture stream at any frame boundary.
+ *
+ * Layout of a record:
+ *   [0, 4)   time, in us, big-endian
+ *   [4]      channel
+ *   [5]      kind
+ *   [6]      status
+ *   [7]      size
+ *   [8, ...) data
+ */
+class RecordSender {
+ public:
+  static const size_t header_size = 8;
+  static const size_t max_size = header_size + Record::max_data_size;
+
+  /**
+   * @param record the record to serialize
+   * @param output_buffer[out] the frame, including its delimiter
+   * @return ok on success, out_of_bounds if the record is malformed
+   */
+  IndexStatus transform(
+      const Record &record, Serial::Backend::FrameProps::ChunkBuffer &output_buffer) const;
+
+ private:
+  const Serial::Backend::FrameSender frame_sender_;
+};
+
+/**
+ * Parses records out of a stream of frames
+ */
+class RecordReceiver {
+ public:
+  enum class Status { ok = 0, waiting, invalid_frame, invalid_record };
+
+  /**
+   * Takes the next byte of the stream
+   * @param new_byte the byte
+   * @return output_ready once a frame may be parsed with output()
+   */
+  Serial::Backend::FrameProps::InputStatus input(uint8_t new_byte);
+
+  /**
+   * Parses the most recently completed frame
+   * @param record[out] the record, only valid on success
+   * @return ok on success, error code otherwise
+   */
+  Status output(Record &record);
+
+ private:
+  Serial::Backend::FrameReceiver frame_receiver_;
+};
+
+}  // namespace Pufferfish::Driver::Capture
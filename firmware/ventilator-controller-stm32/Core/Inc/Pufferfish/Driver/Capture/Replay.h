@@ -0,0 +1,119 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Replay.h
+ *
+ * Replays captured UART and I2C traffic into the HAL mocks
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/HAL/Mock/MockBufferedUART.h"
+#include "Pufferfish/HAL/Mock/MockI2CDevice.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "Records.h"
+
+namespace Pufferfish::Driver::Capture {
+
+/**
+ * Extends a 32-bit capture time to 64 bits, assuming it is within about 35
+ * minutes of the previous time, so that records which are slightly out of
+ * order on either side of a wraparound still sort correctly
+ * @param previous_time the previous extended time, in us
+ * @param time the 32-bit time, in us
+ * @return the extended time closest to previous_time, in us
+ */
+uint64_t unwrap_time(uint64_t previous_time, uint32_t time);
+
+/**
+ * An abstract mock which takes back the recorded input of one channel
+ */
+class ReplayTarget {
+ public:
+  virtual void replay(const Record &record) = 0;
+};
+
+/**
+ * Feeds the bytes of uart_rx records into a mock UART's receive buffer, as
+ * if they had just arrived; other records are outputs and are ignored
+ */
+template <HAL::AtomicSize rx_buffer_size, HAL::AtomicSize tx_buffer_size>
+class UARTReplayTarget : public ReplayTarget {
+ public:
+  using UART = HAL::MockBufferedUART<rx_buffer_size, tx_buffer_size>;
+
+  explicit UARTReplayTarget(volatile UART &uart) : uart_(uart) {}
+
+  void replay(const Record &record) override;
+
+  /**
+   * @return the number of bytes dropped because the receive buffer was full
+   */
+  [[nodiscard]] uint32_t dropped() const { return dropped_; }
+
+ private:
+  volatile UART &uart_;
+  uint32_t dropped_ = 0;
+};
+
+/**
+ * Queues the data and status of i2c_read records as the responses of a mock
+ * I2C device's next reads; other records are outputs and are ignored
+ */
+class I2CReplayTarget : public ReplayTarget {
+ public:
+  explicit I2CReplayTarget(HAL::MockI2CDevice &dev) : dev_(dev) {}
+
+  void replay(const Record &record) override;
+
+ private:
+  HAL::MockI2CDevice &dev_;
+};
+
+/**
+ * Replays records, which must be sorted by time, into the targets attached
+ * to their channels, setting the mock time to each record's time first.
+ * Whatever runs the drivers under test should do so between records, to
+ * see the traffic with its original timing.
+ */
+class Replayer {
+ public:
+  explicit Replayer(HAL::MockTime &time) : time_(time) {}
+
+  /**
+   * @param channel the channel of the records to replay into the target
+   * @param target the target
+   */
+  void attach(Channel channel, ReplayTarget &target);
+
+  /**
+   * Advances the mock time to the record's time, then replays the record
+   * @param record the record
+   */
+  void input(const Record &record);
+
+  /**
+   * @return the time of the most recent record, extended to 64 bits, in us
+   */
+  [[nodiscard]] uint64_t time() const { return time_us_; }
+
+  /**
+   * @return the number of records for channels with no target attached
+   */
+  [[nodiscard]] uint32_t unattached() const { return unattached_; }
+
+ private:
+  HAL::MockTime &time_;
+  std::array<ReplayTarget *, max_channels> targets_{};
+  uint64_t time_us_ = 0;
+  bool started_ = false;
+  uint32_t unattached_ = 0;
+};
+
+}  // namespace Pufferfish::Driver::Capture
+
+#include "Replay.tpp"
@@ -0,0 +1,30 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Replay.tpp
+ *
+ * Replays captured UART and I2C traffic into the HAL mocks
+ */
+
+#pragma once
+
+#include "Replay.h"
+
+namespace Pufferfish::Driver::Capture {
+
+// UARTReplayTarget
+
+template <HAL::AtomicSize rx_buffer_size, HAL::AtomicSize tx_buffer_size>
+void UARTReplayTarget<rx_buffer_size, tx_buffer_size>::replay(const Record &record) {
+  if (record.kind != RecordKind::uart_rx) {
+    return;
+  }
+
+  for (size_t i = 0; i < record.size; ++i) {
+    if (uart_.set_read(record.data[i]) != BufferStatus::ok) {
+      ++dropped_;
+    }
+  }
+}
+
+}  // namespace Pufferfish::Driver::Capture
@@ -33,6 +33,13 @@ class ExtendedI2CDevice : public HAL::I2CDevice {
   I2CDeviceStatus read(uint8_t *buf, size_t count) override;
   I2CDeviceStatus write(uint8_t *buf, size_t count) override;
 
+  /**
+   * Starts a read in the background once the slot is selected. Selecting a
+   * slot blocks, unless the mux is already on it.
+   */
+  I2CDeviceStatus start_read(uint8_t *buf, size_t count) override;
+  I2CDeviceStatus finish_read() override;
+
  private:
   I2CDevice &dev_;
   I2CMux &mux_;
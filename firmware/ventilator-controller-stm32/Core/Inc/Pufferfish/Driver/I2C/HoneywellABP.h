@@ -9,8 +9,10 @@
 
 #pragma once
 
+#include <array>
+
 #include "Pufferfish/Driver/Testable.h"
-#include "Pufferfish/HAL/HAL.h"
+#include "Pufferfish/HAL/Interfaces/I2CDevice.h"
 #include "Pufferfish/Types.h"
 
 namespace Pufferfish {
@@ -69,11 +71,26 @@ class HoneywellABP : public Testable {
    */
   I2CDeviceStatus read_sample(ABPSample &sample);
 
+  /**
+   * Starts a reading of the pressure which completes in the background
+   * @return ok if the read was started, error code otherwise
+   */
+  I2CDeviceStatus start_sample();
+
+  /**
+   * Collects the reading started by start_sample
+   * @param sample[out] the sensor reading; only valid on success
+   * @return ok on success, busy if the read has not finished yet, error code
+   * otherwise
+   */
+  I2CDeviceStatus finish_sample(ABPSample &sample);
+
   I2CDeviceStatus test() override;
   I2CDeviceStatus reset() override;
 
  private:
   Pufferfish::HAL::I2CDevice &dev_;
+  std::array<uint8_t, 2> data_{};  // filled in the background by start_sample
 
   // pressure range (refer to datasheet)
   const float pmin;  // minimum pressure
@@ -83,6 +100,8 @@ class HoneywellABP : public Testable {
   const uint16_t output_min = 0x0666;  // 10% of 2^14
   const uint16_t output_max = 0x399A;  // 90% of 2^14
   const PressureUnit unit;
+
+  void decode(const std::array<uint8_t, 2> &data, ABPSample &sample) const;
 };
 
 }  // namespace I2C
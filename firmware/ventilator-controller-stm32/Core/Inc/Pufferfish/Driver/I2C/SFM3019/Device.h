@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <array>
 #include <climits>
 
 #include "Pufferfish/Driver/I2C/SensirionDevice.h"
@@ -27,6 +28,9 @@ static const uint16_t default_i2c_addr = 0x2e;
  */
 class Device {
  public:
+  // Flow, temperature and status words, each followed by its CRC
+  using RawSample = std::array<uint8_t, 3 * 3>;
+
   explicit Device(HAL::I2CDevice &dev, HAL::I2CDevice &global_dev, GasType gas)
       : crc8_(crc_params), sensirion_(dev, crc8_), global_(global_dev, crc8_), gas(gas) {}
 
@@ -36,6 +40,14 @@ class Device {
    */
   I2CDeviceStatus start_measure();
 
+  /**
+   * Starts a flow measurement on every SFM3019 on the bus at once with an
+   * I2C general call, so that all of their measurements are synchronized.
+   * All of them will measure the gas type of this device.
+   * @return ok on success, error code otherwise
+   */
+  I2CDeviceStatus start_measure_all();
+
   /**
    * Stops the flow measurement
    * @return ok on success, error code otherwise
@@ -76,6 +88,35 @@ class Device {
    */
   I2CDeviceStatus read_sample(Sample &sample, int16_t scale_factor, int16_t offset);
 
+  /**
+   * Reads out the flow rate, temperature and status word from the sensor in
+   * a single transaction, checking the CRC of each word
+   * @param sample[out] the sensor reading; only valid on success
+   * @return ok on success, error code otherwise
+   */
+  I2CDeviceStatus read_full_sample(Sample &sample, int16_t scale_factor, int16_t offset);
+
+  /**
+   * Starts reading out a sample in the background, so that it can be
+   * collected by finish_sample() once the transfer is done
+   * @param raw[out] the buffer for the transfer, which must stay valid until
+   * finish_sample() stops returning busy
+   * @param full whether to also read out the temperature and status words
+   * @return ok if the read was started, error code otherwise
+   */
+  I2CDeviceStatus start_sample(RawSample &raw, bool full);
+
+  /**
+   * Collects a sample started by start_sample(), checking the CRC of each word
+   * @param raw the buffer given to start_sample()
+   * @param full as given to start_sample()
+   * @param sample[out] the sensor reading; only valid on success
+   * @return ok on success, busy while the transfer is in progress, error
+   * code otherwise
+   */
+  I2CDeviceStatus finish_sample(
+      const RawSample &raw, bool full, Sample &sample, int16_t scale_factor, int16_t offset);
+
   /**
    * Causes a global I2C device reset
    * @return ok on success, error code otherwise
@@ -84,11 +125,15 @@ class Device {
 
  private:
   static constexpr HAL::CRC8Parameters crc_params = {0x31, 0xff, false, false, 0x00};
+  static constexpr float temperature_scale = 200;
 
   HAL::SoftCRC8 crc8_;
   SensirionDevice sensirion_;
   SensirionDevice global_;
   const GasType gas;
+
+  static void decode(
+      const uint8_t *buffer, bool full, Sample &sample, int16_t scale_factor, int16_t offset);
 };
 
 }  // namespace Pufferfish::Driver::I2C::SFM3019
@@ -21,22 +21,53 @@ namespace Pufferfish::Driver::I2C::SFM3019 {
 /**
  * State management for Sensirion SFM3019 flow sensor, without I/O.
  * This is basically a Moore machine, so the state consists of the
- * next action to take, along with the current time.
+ * next action to take, along with the current time. Every wait is
+ * timestamped rather than blocking, and an action which failed is retried
+ * after a backoff delay which doubles on each consecutive failure.
  */
 class StateMachine {
  public:
-  enum class Action { initialize, wait_warmup, check_range, measure, wait_measurement };
-
-  [[nodiscard]] Action update(uint32_t current_time_us);
+  enum class Action {
+    reset,
+    wait_power_up,
+    read_product_id,
+    request_conversion,
+    wait_conversion,
+    read_conversion,
+    set_averaging,
+    start_measure,
+    wait_warmup,
+    check_range,
+    wait_retry,
+    measure,
+    wait_measurement
+  };
+
+  /**
+   * Advances the state machine
+   * @param current_time_us the current time, in us
+   * @param succeeded whether the previously returned action succeeded; a
+   * failed setup action is retried after a backoff delay
+   * @return the next action to take
+   */
+  [[nodiscard]] Action update(uint32_t current_time_us, bool succeeded = true);
 
  private:
+  static const uint32_t power_up_duration_us = 2000;     // us
+  static const uint32_t conversion_duration_us = 20;     // us
   static const uint32_t warming_up_duration_us = 30000;  // us
   static const uint32_t measuring_duration_us = 500;     // us
+  static const uint32_t initial_backoff_us = 1000;       // us
+  static const uint32_t max_backoff_us = 16000;          // us
 
-  Action next_action_ = Action::initialize;
+  Action next_action_ = Action::reset;
+  Action retry_action_ = Action::reset;
+  uint32_t backoff_us_ = initial_backoff_us;
   uint32_t wait_start_time_us_ = 0;
   uint32_t current_time_us_ = 0;
 
+  static Action following(Action action);
+  static Action restart_point(Action action);
   void start_waiting();
   [[nodiscard]] bool finished_waiting(uint32_t timeout_us) const;
 };
@@ -46,18 +77,49 @@ class StateMachine {
  */
 class Sensor : public Initializable {
  public:
-  Sensor(Device &device, bool resetter, HAL::Time &time)
-      : resetter(resetter), device_(device), time_(time) {}
-
+  /**
+   * @param resetter whether this sensor should issue the global reset
+   * @param synchronized whether to start measurement with a general call, so
+   * that every SFM3019 on the bus starts measuring at the same time; the
+   * last sensor to start re-synchronizes all the others
+   * @param full_samples whether to also read out temperature and status words
+   * with each flow measurement, in the same transaction
+   */
+  Sensor(
+      Device &device,
+      bool resetter,
+      HAL::Time &time,
+      bool synchronized = false,
+      bool full_samples = false)
+      : resetter(resetter),
+        synchronized(synchronized),
+        full_samples(full_samples),
+        device_(device),
+        time_(time) {}
+
+  /**
+   * Runs one step of setup, with at most one I2C transaction and without
+   * ever waiting, so that several sensors can be set up concurrently
+   * @return ok once measurements are in range, setup while in progress,
+   * failed after too many retries
+   */
   InitializableState setup() override;
   InitializableState output(float &flow);
 
+  /**
+   * Collects the sample whose read was started by the previous call, and
+   * starts reading the next one in the background, so that calls at a fixed
+   * rate each output a fresh sample without waiting for the bus. Samples are
+   * timestamped with the time their read was started.
+   * @param sample[out] the latest sample
+   * @return ok while measuring, failed after too many failed reads
+   */
+  InitializableState output(Sample &sample);
+
  private:
   using Action = StateMachine::Action;
 
-  static const uint32_t power_up_delay = 2;  // ms
   static const uint32_t product_number = 0x04020611;
-  static const uint32_t read_conv_delay_us = 20;  // us
   static const int16_t scale_factor = 170;
   static const int16_t offset = -24576;
   static const uint16_t flow_unit =
@@ -69,21 +131,27 @@ class Sensor : public Initializable {
   static const size_t max_retries_measure = 8;  // max retries between valid outputs
 
   const bool resetter;
+  const bool synchronized;
+  const bool full_samples;
 
   Device &device_;
   StateMachine fsm_;
-  Action next_action_ = Action::initialize;
+  Action next_action_ = Action::reset;
   size_t retry_count_ = 0;
 
   uint32_t pn_ = 0;
   ConversionFactors conversion_{};
   Sample sample_{};
+  Device::RawSample raw_{};
+  bool reading_ = false;
+  uint32_t read_time_us_ = 0;
 
   HAL::Time &time_;
 
-  InitializableState initialize(uint32_t current_time);
-  InitializableState check_range(uint32_t current_time_us);
-  InitializableState measure(uint32_t current_time_us, float &flow);
+  bool run_setup_action();
+  bool read_sample(uint32_t current_time_us);
+  bool start_reading(uint32_t current_time_us);
+  bool finish_reading();
 };
 
 }  // namespace Pufferfish::Driver::I2C::SFM3019
@@ -83,6 +83,11 @@ constexpr uint16_t make_flow_unit(UnitPrefix prefix, TimeBase time, Unit unit) n
 struct Sample {
   int16_t raw_flow;
   float flow;
+  // Only read out in full samples
+  int16_t raw_temperature;
+  float temperature;  // deg C
+  uint16_t status;
+  uint32_t time_us;  // us, when the sample was read out
 };
 
 struct ConversionFactors {
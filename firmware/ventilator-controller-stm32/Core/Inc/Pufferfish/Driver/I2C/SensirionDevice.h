@@ -34,6 +34,26 @@ class SensirionDevice {
   template <size_t size>
   I2CDeviceStatus read(std::array<uint8_t, size> &buf);
 
+  /**
+   * Starts reading words with their CRCs in the background
+   * @param buf_with_crc[out] the buffer for the words and their CRCs, which
+   * must stay valid until finish_read() stops returning busy
+   * @param count number of bytes to read, 3 for each word
+   * @return ok if the read was started, error code otherwise
+   */
+  I2CDeviceStatus start_read(uint8_t *buf_with_crc, size_t count);
+
+  /**
+   * Checks on the read started by start_read(), and once it is done,
+   * performs the CRC check
+   * @param buf_with_crc the buffer given to start_read()
+   * @param buf[out] the buffer for the data output, 2 bytes for each word
+   * @param size number of bytes of data, which must be an even number
+   * @return ok on success, busy while the read is in progress, error code
+   * otherwise
+   */
+  I2CDeviceStatus finish_read(const uint8_t *buf_with_crc, uint8_t *buf, size_t size);
+
   /**
    * Writes a single-byte command to the device
    * @param byte_command the command to be sent
@@ -61,6 +81,8 @@ class SensirionDevice {
  private:
   HAL::I2CDevice &dev_;
   HAL::CRC8 &crc8_;
+
+  I2CDeviceStatus unpack(const uint8_t *buf_with_crc, uint8_t *buf, size_t size);
 };
 
 }  // namespace Pufferfish::Driver::I2C
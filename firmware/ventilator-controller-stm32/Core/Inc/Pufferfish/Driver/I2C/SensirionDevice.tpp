@@ -19,18 +19,8 @@ I2CDeviceStatus SensirionDevice::read(std::array<uint8_t, size> &buf) {
   if (ret != I2CDeviceStatus::ok) {
     return ret;
   }
-  for (size_t word_start = 0; word_start < buf_with_crc.size(); word_start += 3) {
-    uint8_t expected_crc = crc8_.compute(buf_with_crc.data() + word_start, sizeof(uint16_t));
-    uint8_t received_crc = buf_with_crc[word_start + sizeof(uint16_t)];
-    if (expected_crc != received_crc) {
-      return I2CDeviceStatus::crc_check_failed;
-    }
 
-    buf[2 * word_start / 3] = buf_with_crc[word_start];
-    buf[2 * word_start / 3 + sizeof(uint8_t)] = buf_with_crc[word_start + sizeof(uint8_t)];
-  }
-
-  return I2CDeviceStatus::ok;
+  return unpack(buf_with_crc.data(), buf.data(), size);
 }
 
 }  // namespace Pufferfish::Driver::I2C
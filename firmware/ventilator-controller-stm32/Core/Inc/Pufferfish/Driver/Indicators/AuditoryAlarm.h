@@ -10,12 +10,32 @@
 #pragma once
 
 #include "AlarmDevice.h"
-#include "Pufferfish/HAL/HAL.h"
+#include "Pufferfish/HAL/Interfaces/DigitalOutput.h"
+#include "Pufferfish/HAL/Interfaces/PulseOutput.h"
 
 namespace Pufferfish {
 namespace Driver {
 namespace Indicators {
 
+/**
+ * Outputs of the regulatory and non-regulatory buzzers for an alarm
+ */
+struct AuditoryParameters {
+  bool out_high;
+  bool out_med;
+  bool out_low;
+  uint32_t buzzer_pulse_period;
+  uint32_t buzzer_pulse_duty;
+};
+
+/**
+ * Looks up the buzzer outputs for an alarm
+ * @param a an alarm to be output
+ * @param parameters the outputs for the alarm, left unmodified if it is invalid
+ * @return invalidAlarm if `a` is not a valid alarm, ok otherwise
+ */
+AlarmManagerStatus auditory_parameters(AlarmStatus a, AuditoryParameters &parameters);
+
 /**
  * Drives both regulatory and non-regulatory buzzer
  */
@@ -39,25 +59,49 @@ class AuditoryAlarm : public AlarmDevice {
   AlarmManagerStatus set_alarm(AlarmStatus a) override;
 
  private:
-  struct Parameters {
-    bool out_high;
-    bool out_med;
-    bool out_low;
-    uint32_t buzzer_pulse_period;
-    uint32_t buzzer_pulse_duty;
-  };
-
   HAL::DigitalOutput &reg_high_;
   HAL::DigitalOutput &reg_med_;
   HAL::DigitalOutput &reg_low_;
   HAL::DigitalOutput &buzzer_;
 
   bool reset_ = false;
-  Parameters parameters_{false, false, false, 0, 0};
+  AuditoryParameters parameters_{false, false, false, 0, 0};
   bool buzzer_switching_ = false;
   uint32_t last_cycle_ = 0;
 };
 
+/**
+ * Drives both regulatory and non-regulatory buzzer, with the buzzer pattern
+ * generated by a hardware pulse output. All outputs only change in
+ * set_alarm(), so update() has nothing to do. The buzzer is held on for each
+ * pulse, rather than toggled at the update rate as in AuditoryAlarm.
+ */
+class TimedAuditoryAlarm : public AlarmDevice {
+ public:
+  /**
+   * Constructs a new TimedAuditoryAlarm object
+   * @param regHigh output for the regulatory high alarm pin
+   * @param regMed  output for the regulatory medium alarm pin
+   * @param regLow  output for the regulatory low alarm pin
+   * @param buzzer  pulse output for the general purpose buzzer pin
+   */
+  TimedAuditoryAlarm(
+      HAL::DigitalOutput &reg_high,
+      HAL::DigitalOutput &reg_med,
+      HAL::DigitalOutput &reg_low,
+      HAL::PulseOutput &buzzer)
+      : reg_high_(reg_high), reg_med_(reg_med), reg_low_(reg_low), buzzer_(buzzer) {}
+
+  AlarmManagerStatus update(uint32_t current_time) override;
+  AlarmManagerStatus set_alarm(AlarmStatus a) override;
+
+ private:
+  HAL::DigitalOutput &reg_high_;
+  HAL::DigitalOutput &reg_med_;
+  HAL::DigitalOutput &reg_low_;
+  HAL::PulseOutput &buzzer_;
+};
+
 }  // namespace Indicators
 }  // namespace Driver
 }  // namespace Pufferfish
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "Pufferfish/Driver/Indicators/DigitalFunction.h"
+#include "Pufferfish/HAL/Interfaces/PulseOutput.h"
 
 namespace Pufferfish {
 namespace Driver {
@@ -33,6 +34,14 @@ class PWMGenerator : public DigitalFunctionGenerator {
    */
   void start(uint32_t current_time) override;
 
+  /**
+   * @brief  programs the pulse into a hardware pulse output, which then
+   *         generates it on its own with no calls to input()
+   * @param  output the pulse output to generate the pulse
+   * @return ok on success, error code otherwise
+   */
+  [[nodiscard]] TimerStatus start(HAL::PulseOutput &output) const;
+
   /**
    * @brief update method updates the mSwitching private variable based on
    *        period and duty cycle for the provided currentTime
@@ -0,0 +1,89 @@
+/// Initializer.h
+/// This file has an orchestrator which sets up several devices concurrently.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "Initializable.h"
+
+namespace Pufferfish {
+namespace Driver {
+
+/**
+ * Runs the setup of several Initializables concurrently: each update()
+ * gives one setup step to every device which is not done yet, so the waits
+ * of all devices overlap, and setup takes as long as the slowest device
+ * rather than the sum of all of them. The time each device took to finish
+ * setup is kept for diagnostics.
+ */
+template <size_t size>
+class Initializer {
+ public:
+  using Initializables = std::array<std::reference_wrapper<Initializable>, size>;
+
+  explicit Initializer(const Initializables &devices) : devices_(devices) {}
+
+  /**
+   * Runs one setup step on every device which has not finished setup
+   * @param current_time the current time, in ms
+   * @return failed if any device has failed, setup if any device is still
+   * in setup, ok once all devices are done
+   */
+  InitializableState update(uint32_t current_time);
+
+  /**
+   * Returns the latest setup state of a device
+   * @param index the index of the device
+   * @return the setup state of the device
+   */
+  [[nodiscard]] InitializableState state(size_t index) const;
+
+  /**
+   * Returns how long a device took to finish setup, or how long it has
+   * been in setup so far
+   * @param index the index of the device
+   * @return the setup duration of the device, in ms
+   */
+  [[nodiscard]] uint32_t duration(size_t index) const;
+
+  /**
+   * Returns how long setup of all devices took, or has taken so far
+   * @return the setup duration, in ms
+   */
+  [[nodiscard]] uint32_t duration() const;
+
+ private:
+  const Initializables &devices_;
+  std::array<InitializableState, size> states_{};
+  std::array<uint32_t, size> durations_{};
+  std::array<bool, size> finished_{};
+  bool started_ = false;
+  uint32_t start_time_ = 0;
+  uint32_t current_time_ = 0;
+};
+
+}  // namespace Driver
+}  // namespace Pufferfish
+
+#include "Initializer.tpp"
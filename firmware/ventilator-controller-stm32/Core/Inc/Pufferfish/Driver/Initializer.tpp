@@ -0,0 +1,96 @@
+/// Initializer.tpp
+/// This file has methods for an orchestrator which sets up several devices
+/// concurrently.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Initializer.h"
+
+namespace Pufferfish {
+namespace Driver {
+
+template <size_t size>
+InitializableState Initializer<size>::update(uint32_t current_time) {
+  if (!started_) {
+    started_ = true;
+    start_time_ = current_time;
+    states_.fill(InitializableState::setup);
+  }
+  current_time_ = current_time;
+
+  bool any_failed = false;
+  bool any_setup = false;
+  for (size_t i = 0; i < size; ++i) {
+    if (states_.at(i) != InitializableState::ok) {
+      // Failed devices are tried again, since they may recover
+      states_.at(i) = devices_.at(i).get().setup();
+    }
+
+    const InitializableState state = states_.at(i);
+    if (state == InitializableState::setup) {
+      finished_.at(i) = false;
+      any_setup = true;
+      continue;
+    }
+    if (!finished_.at(i)) {
+      finished_.at(i) = true;
+      durations_.at(i) = current_time - start_time_;
+    }
+    if (state == InitializableState::failed) {
+      any_failed = true;
+    }
+  }
+
+  if (any_failed) {
+    return InitializableState::failed;
+  }
+  if (any_setup) {
+    return InitializableState::setup;
+  }
+  return InitializableState::ok;
+}
+
+template <size_t size>
+InitializableState Initializer<size>::state(size_t index) const {
+  return states_.at(index);
+}
+
+template <size_t size>
+uint32_t Initializer<size>::duration(size_t index) const {
+  if (finished_.at(index)) {
+    return durations_.at(index);
+  }
+  return current_time_ - start_time_;
+}
+
+template <size_t size>
+uint32_t Initializer<size>::duration() const {
+  uint32_t longest = 0;
+  for (size_t i = 0; i < size; ++i) {
+    const uint32_t device_duration = duration(i);
+    if (device_duration > longest) {
+      longest = device_duration;
+    }
+  }
+  return longest;
+}
+
+}  // namespace Driver
+}  // namespace Pufferfish
@@ -0,0 +1,147 @@
+/// AsyncFlash.h
+/// This file has a non-blocking program/erase engine for SPI flash memory.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "SPIFlash.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace SPI {
+
+/**
+ * Queues page programs and sector erases on an SPIFlash and runs them one
+ * at a time without ever waiting: each call to update() polls the BUSY bit
+ * once, and starts the next queued operation as soon as the chip is ready.
+ *
+ * Block protection is handled with the individual block locks. WPS is set
+ * once, the lock range of the next operation is unlocked only if it is not
+ * already the unlocked one, and it is locked again when the queue drains,
+ * so a multi-page write costs a single unlock/lock pair.
+ */
+class AsyncFlash {
+ public:
+  enum class Status {
+    ok = 0,   /// success
+    busy,     /// not enough room in the queue, or queued operations pending
+    invalid,  /// invalid address or size
+    error     /// the flash chip returned an error
+  };
+
+  static const size_t queue_depth = 8;  // operations, each up to one page
+
+  explicit AsyncFlash(SPIFlash &flash) : flash_(flash) {}
+
+  /**
+   * Queues a write of any length, split into page programs. The data is
+   * copied, so the caller's buffer may be reused right away; either all of
+   * it is queued or none of it is.
+   * @param addr address to write data
+   * @param data data to be written
+   * @param size amount of data to be written
+   * @return ok on success, busy if the queue does not have enough room,
+   * error code otherwise
+   */
+  Status program(uint32_t addr, const uint8_t *data, size_t size);
+
+  /**
+   * Queues an erase of the 4 KB sector containing an address
+   * @param addr address in the sector to be erased
+   * @return ok on success, busy if the queue is full, error code otherwise
+   */
+  Status erase_sector(uint32_t addr);
+
+  /**
+   * Polls the operation in progress, if any, and starts the next queued
+   * operation once the chip is ready. Call this regularly from the main loop.
+   * @return ok on success, error if the chip returned an error, in which
+   * case the failed operation is dropped
+   */
+  Status update();
+
+  /**
+   * Runs update() until all queued operations are complete. This blocks.
+   * @return ok on success, error code otherwise
+   */
+  Status flush();
+
+  /**
+   * Reads data once all queued operations are complete, so that the data
+   * read reflects them. This never waits for them: check idle() first, or
+   * call flush() where blocking is acceptable.
+   * @param addr address to read data
+   * @param data[out] output of the data
+   * @param size amount of data to be read
+   * @return ok on success, busy if queued operations are not complete yet,
+   * error code otherwise
+   */
+  Status read(uint32_t addr, uint8_t *data, size_t size);
+
+  /**
+   * Checks whether all queued operations are complete
+   * @return true if nothing is queued or in progress, false otherwise
+   */
+  [[nodiscard]] bool idle() const;
+
+  /**
+   * Returns the number of free entries in the operation queue; a program
+   * needs one entry per page it touches, and an erase needs one entry
+   * @return the number of free queue entries
+   */
+  [[nodiscard]] size_t available() const;
+
+ private:
+  enum class OperationType : uint8_t { program = 0, erase_sector };
+
+  struct Operation {
+    OperationType type = OperationType::program;
+    uint32_t address = 0;
+    uint16_t size = 0;
+    std::array<uint8_t, SPIFlash::page_size> data{};
+  };
+
+  enum class Phase {
+    ready = 0,   /// no operation in progress
+    protecting,  /// WPS is being written
+    operating    /// the operation at the head of the queue is in progress
+  };
+
+  static const uint32_t no_range = UINT32_MAX;
+
+  SPIFlash &flash_;
+  std::array<Operation, queue_depth> queue_{};
+  size_t head_ = 0;
+  size_t count_ = 0;
+  Phase phase_ = Phase::ready;
+  bool wps_set_ = false;
+  uint32_t unlocked_range_ = no_range;
+
+  Operation &push();
+  void pop();
+  Status start_next();
+};
+
+}  // namespace SPI
+}  // namespace Driver
+}  // namespace Pufferfish
@@ -0,0 +1,97 @@
+/// FlashReader.h
+/// This file has a streaming sequential reader for SPI flash memory.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "SPIFlash.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace SPI {
+
+/**
+ * Reads a range of flash memory front to back in caller-sized chunks, over
+ * a single Fast Read stream: the instruction and address are only sent
+ * once, and each chunk is received straight into the caller's buffer. The
+ * flash can't be used for anything else while the reader is open.
+ */
+class FlashReader {
+ public:
+  explicit FlashReader(SPIFlash &flash) : flash_(flash) {}
+
+  /**
+   * Opens the reader on a range of flash memory
+   * @param addr address of the start of the range
+   * @param length the number of bytes in the range
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus open(uint32_t addr, size_t length);
+
+  /**
+   * Starts reading the next chunk of the range in the background; the
+   * buffer must not be touched until poll() stops returning busy
+   * @param data[out] output of the data
+   * @param size the size of the output buffer
+   * @param count[out] the number of bytes which will be read, which is zero
+   * once the end of the range has been reached
+   * @return ok on success, busy if the previous chunk is still being read,
+   * error code otherwise
+   */
+  SPIDeviceStatus start_next(uint8_t *data, size_t size, size_t &count);
+
+  /**
+   * Checks on the chunk started by start_next()
+   * @return busy while the chunk is being read, ok once it is complete,
+   * error code otherwise
+   */
+  SPIDeviceStatus poll();
+
+  /**
+   * Reads the next chunk of the range. This blocks until it is complete.
+   * @param data[out] output of the data
+   * @param size the size of the output buffer
+   * @param count[out] the number of bytes read, which is zero once the end
+   * of the range has been reached
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus next(uint8_t *data, size_t size, size_t &count);
+
+  /**
+   * Closes the reader, releasing the flash
+   */
+  void close();
+
+  [[nodiscard]] bool is_open() const { return open_; }
+  [[nodiscard]] uint32_t address() const { return address_; }
+  [[nodiscard]] size_t remaining() const { return remaining_; }
+
+ private:
+  SPIFlash &flash_;
+  bool open_ = false;
+  uint32_t address_ = 0;
+  size_t remaining_ = 0;
+};
+
+}  // namespace SPI
+}  // namespace Driver
+}  // namespace Pufferfish
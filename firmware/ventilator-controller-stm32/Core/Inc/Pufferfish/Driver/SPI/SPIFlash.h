@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include "Pufferfish/HAL/Interfaces/SPIDevice.h"
 #include "Pufferfish/HAL/Interfaces/Time.h"
 
@@ -32,6 +34,13 @@ namespace SPI {
  */
 class SPIFlash {
  public:
+  static const uint32_t capacity = 0x200000;  // bytes (16 Mbit)
+  static const size_t page_size = 256;         // bytes per page program
+  static const size_t sector_size = 4096;      // bytes per sector erase
+  static const size_t block_size = 65536;      // bytes per 64 KB block
+  static const uint8_t busy_bit = 0x01;        // BUSY in status register 1
+  static const uint8_t wps_bit = 0x04;         // WPS in status register 3
+
   /**
    * @brief Constructor for SPI Flash memory
    * @param spi STM32 HAL handler for the SPI port
@@ -69,21 +78,68 @@ class SPIFlash {
   SPIDeviceStatus disable_write();
 
   /**
-   * @brief Write bytes of data into SPI device
+   * @brief Write bytes of data into SPI device with a page program; the
+   * data must not cross a page boundary
    * @param addr address to write data
    * @param input data to be written
-   * @param size amount of data to be transmit
+   * @param size amount of data to be transmit, at most page_size
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus write_byte(uint32_t addr, const uint8_t *input, size_t size);
+
+  /**
+   * @brief Read bytes of data from SPI device with Fast Read (0Bh). The data
+   * is received directly into the output in a single transfer, with DMA if
+   * the SPI device supports it; this blocks until the read is complete.
+   * @param addr address to read data
+   * @param data output of the data
+   * @param size amount of data to be receive, of any length
    * @return ok on success, error code otherwise
    */
-  SPIDeviceStatus write_byte(uint32_t addr, const uint8_t *input, uint8_t size);
+  SPIDeviceStatus read(uint32_t addr, uint8_t *data, size_t size);
 
   /**
-   * @brief Read bytes of data from SPI device
+   * @brief Start reading bytes of data from SPI device with Fast Read (0Bh)
+   * and return without waiting for the data; completion is found by polling
+   * read_status, and the output must not be touched until then
    * @param addr address to read data
+   * @param data output of the data
+   * @param size amount of data to be receive, of any length
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus start_read(uint32_t addr, uint8_t *data, size_t size);
+
+  /**
+   * @brief Check on a read started by start_read or continue_stream; once a
+   * read started by start_read is complete, CS is released
+   * @return busy while the read is in progress, ok once it is complete,
+   * error code otherwise
+   */
+  SPIDeviceStatus read_status();
+
+  /**
+   * @brief Open a Fast Read stream: the instruction and address are sent
+   * once, and CS is held low so that continue_stream can read on from
+   * where the last chunk ended, at the full SPI line rate. No other
+   * instruction may be issued until the stream is closed.
+   * @param addr address to start reading from
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus open_stream(uint32_t addr);
+
+  /**
+   * @brief Start reading the next bytes of an open stream; completion is
+   * found by polling read_status
+   * @param data output of the data
    * @param size amount of data to be receive
    * @return ok on success, error code otherwise
    */
-  SPIDeviceStatus read_byte(uint32_t addr, uint8_t *data, uint8_t size);
+  SPIDeviceStatus continue_stream(uint8_t *data, size_t size);
+
+  /**
+   * @brief Close an open stream, releasing CS
+   */
+  void close_stream();
 
   /**
    * @brief Lock the block based on address - To protect the memory
@@ -230,9 +286,63 @@ class SPIFlash {
    */
   SPIDeviceStatus reset_device();
 
+  /**
+   * @brief Starts a page program and returns without waiting for it to
+   * complete. The device must not be busy, the page must be unlocked, and
+   * the data must not cross a page boundary; completion is found by polling
+   * the BUSY bit with read_status_register1.
+   * @param addr address to write data
+   * @param input data to be written
+   * @param size amount of data to be transmit, at most page_size
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus start_program(uint32_t addr, const uint8_t *input, size_t size);
+
+  /**
+   * @brief Starts a sector or block erase and returns without waiting for
+   * it to complete. The device must not be busy and the range must be
+   * unlocked; completion is found by polling the BUSY bit.
+   * @param instruction sector_erase_4kb, block_erase_32kb or block_erase_64kb
+   * @param addr address in the range to be erased
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus start_erase(SPIInstruction instruction, uint32_t addr);
+
+  /**
+   * @brief Starts a write of status register 3 with the given value and
+   * returns without waiting for it to complete
+   * @param input the new value of the register
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus start_write_status_register3(uint8_t input);
+
+  /**
+   * @brief Locks or unlocks the block based on address, with no status
+   * checks. Only effective while WPS is 1.
+   * @param addr address of the block
+   * @param lock true to lock the block, false to unlock it
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus set_individual_block_lock(uint32_t addr, bool lock);
+
+  /**
+   * @brief Returns the start of the smallest range covered by an individual
+   * block lock: sectors in the top and bottom blocks, and whole blocks
+   * elsewhere
+   * @param addr an address in the range
+   * @return the first address of the range
+   */
+  static uint32_t lock_range(uint32_t addr);
+
  private:
+  enum class ReadMode { idle = 0, single, stream };
+
   HAL::SPIDevice &spi_;
   HAL::Time &time_;
+  ReadMode read_mode_ = ReadMode::idle;
+
+  SPIDeviceStatus write_command(SPIInstruction instruction, uint32_t addr);
+  SPIDeviceStatus erase(SPIInstruction instruction, uint32_t addr, uint32_t erase_delay);
 };
 
 }  // namespace SPI
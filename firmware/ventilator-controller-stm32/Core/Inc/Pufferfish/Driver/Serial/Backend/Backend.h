@@ -31,7 +31,15 @@ static const auto message_descriptors = Util::make_array<Util::ProtobufDescripto
     Util::get_protobuf_descriptor<Parameters>(),                 // 4
     Util::get_protobuf_descriptor<ParametersRequest>(),          // 5
     Util::get_protobuf_descriptor<AlarmLimits>(),                // 6
-    Util::get_protobuf_descriptor<AlarmLimitsRequest>()          // 7
+    Util::get_protobuf_descriptor<AlarmLimitsRequest>(),         // 7
+    Util::get_protobuf_descriptor<ExpectedLogEvent>(),           // 8
+    Util::get_protobuf_descriptor<NextLogEvents>(),              // 9
+    Util::get_protobuf_descriptor<Util::UnrecognizedMessage>(),  // 10
+    Util::get_protobuf_descriptor<Util::UnrecognizedMessage>(),  // 11
+    Util::get_protobuf_descriptor<Util::UnrecognizedMessage>(),  // 12
+    Util::get_protobuf_descriptor<MemoryUsage>(),                // 13
+    Util::get_protobuf_descriptor<RecorderChunk>(),              // 14
+    Util::get_protobuf_descriptor<RecorderChunkRequest>()        // 15
 );
 
 // State Synchronization
@@ -49,6 +57,10 @@ static const auto state_sync_schedule = Util::make_array<const StateOutputSchedu
     StateOutputScheduleEntry{10, Application::MessageTypes::parameters_request},
     StateOutputScheduleEntry{10, Application::MessageTypes::cycle_measurements});
 
+// Diagnostics which change slowly, interleaved with the schedule above
+static const auto slow_state_sync_schedule = Util::make_array<const StateOutputScheduleEntry>(
+    StateOutputScheduleEntry{1000, Application::MessageTypes::memory_usage});
+
 // Backend
 using CRCElementProps =
     Protocols::CRCElementProps<Driver::Serial::Backend::FrameProps::payload_max_size>;
@@ -137,9 +149,20 @@ class Backend {
       : receiver_(crc32c),
         sender_(crc32c),
         states_(states),
-        synchronizer_(states, state_sync_schedule) {}
+        synchronizer_(states, state_sync_schedule),
+        slow_synchronizer_(states, slow_state_sync_schedule) {}
 
   static constexpr bool accept_message(Application::MessageTypes type) noexcept;
+
+  /**
+   * Returns the type of the message which answers a request, which is only
+   * sent once for each request received, ahead of the state schedules
+   * @param type the type of the request
+   * @return the type of the answer, or unknown if the type is not a request
+   * with an answer
+   */
+  static constexpr Application::MessageTypes reply_type(Application::MessageTypes type) noexcept;
+
   Status input(uint8_t new_byte);
   void update_clock(uint32_t current_time);
   Status output(FrameProps::ChunkBuffer &output_buffer);
@@ -150,11 +173,18 @@ class Backend {
       Application::StateSegment,
       Application::MessageTypes,
       state_sync_schedule.size()>;
+  using SlowStateSynchronizer = Protocols::StateSynchronizer<
+      Application::States,
+      Application::StateSegment,
+      Application::MessageTypes,
+      slow_state_sync_schedule.size()>;
 
   BackendReceiver receiver_;
   BackendSender sender_;
   Application::States &states_;
   BackendStateSynchronizer synchronizer_;
+  SlowStateSynchronizer slow_synchronizer_;
+  Application::MessageTypes reply_ = Application::MessageTypes::unknown;
 };
 
 }  // namespace Pufferfish::Driver::Serial::Backend
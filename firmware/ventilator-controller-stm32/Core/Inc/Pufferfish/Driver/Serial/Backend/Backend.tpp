@@ -181,28 +181,54 @@ Backend::Status Backend::input(uint8_t new_byte) {
       return Status::invalid;
   }
 
+  if (reply_type(message.payload.tag) != Application::MessageTypes::unknown) {
+    reply_ = reply_type(message.payload.tag);
+  }
   return Status::ok;
 }
 
 void Backend::update_clock(uint32_t current_time) {
   synchronizer_.input(current_time);
+  slow_synchronizer_.input(current_time);
 }
 
 constexpr bool Backend::accept_message(Application::MessageTypes type) noexcept {
   return type == Application::MessageTypes::parameters_request ||
-         type == Application::MessageTypes::alarm_limits_request;
+         type == Application::MessageTypes::alarm_limits_request ||
+         type == Application::MessageTypes::expected_log_event ||
+         type == Application::MessageTypes::recorder_chunk_request;
+}
+
+constexpr Application::MessageTypes Backend::reply_type(Application::MessageTypes type) noexcept {
+  switch (type) {
+    case Application::MessageTypes::expected_log_event:
+      return Application::MessageTypes::next_log_events;
+    case Application::MessageTypes::recorder_chunk_request:
+      return Application::MessageTypes::recorder_chunk;
+    default:
+      return Application::MessageTypes::unknown;
+  }
 }
 
 Backend::Status Backend::output(FrameProps::ChunkBuffer &output_buffer) {
-  // Output from state synchronization
   Application::StateSegment state_segment;
-  switch (synchronizer_.output(state_segment)) {
-    case BackendStateSynchronizer::OutputStatus::ok:
-      break;
-    case BackendStateSynchronizer::OutputStatus::invalid_type:
+  if (reply_ != Application::MessageTypes::unknown) {
+    // Output of the answer to the most recent request
+    Application::MessageTypes type = reply_;
+    reply_ = Application::MessageTypes::unknown;
+    if (states_.output(type, state_segment) != Application::States::OutputStatus::ok) {
       return Status::invalid;
-    case BackendStateSynchronizer::OutputStatus::waiting:
-      return Status::waiting;
+    }
+  } else if (slow_synchronizer_.output(state_segment) != SlowStateSynchronizer::OutputStatus::ok) {
+    // Output from state synchronization, whenever no slow state is due
+    switch (synchronizer_.output(state_segment)) {
+      case BackendStateSynchronizer::OutputStatus::ok:
+        break;
+      case BackendStateSynchronizer::OutputStatus::invalid_type:
+        return Status::invalid;
+      case BackendStateSynchronizer::OutputStatus::waiting:
+        return Status::waiting;
+    }
   }
 
   switch (sender_.transform(state_segment, output_buffer)) {
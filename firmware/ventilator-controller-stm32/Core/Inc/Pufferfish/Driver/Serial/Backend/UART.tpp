@@ -13,10 +13,6 @@ namespace Pufferfish::Driver::Serial::Backend {
 
 // UARTBackend
 
-void UARTBackend::setup_irq() {
-  uart_.setup_irq();
-}
-
 void UARTBackend::receive() {
   while (true) {  // repeat until UART read buffer is empty or output is available
     uint8_t receive = 0;
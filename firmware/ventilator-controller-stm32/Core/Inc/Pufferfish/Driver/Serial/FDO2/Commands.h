@@ -46,7 +46,13 @@ constexpr size_t max_frame_len(size_t num_fields) noexcept {
 
 namespace Responses {
 
-enum class ParseStatus { ok = 0, missing_arg, unexpected_arg, invalid_arg_delimiter };
+enum class ParseStatus {
+  ok = 0,
+  missing_arg,
+  unexpected_arg,
+  invalid_arg_delimiter,
+  invalid_arg
+};
 
 static const size_t mraw_num_fields = 8;
 // Note: this is optimized for MOXY, RDUM and WRUM may not fit as they require up to ~778 bytes
@@ -109,8 +115,6 @@ using ChunkBuffer = Util::Vector<char, max_len>;
 struct Vers {};
 struct Logo {};
 struct Bcst {
-  static constexpr const char *args_format = "%d";
-
   uint16_t interval;
 };
 
@@ -59,9 +59,19 @@ class Device {
     timed_out  /// Operation timed out
   };
 
-  static const uint16_t broadcast_interval = 100;  // ms
+  static const uint16_t default_broadcast_interval = 100;  // ms
 
-  explicit Device(volatile HAL::BufferedUART &uart) : uart_(uart) {}
+  /**
+   * @param broadcast_interval the interval between measurement broadcasts
+   * requested by start_broadcast, in ms; a shorter interval gives fresher
+   * measurements
+   */
+  explicit Device(
+      volatile HAL::BufferedUART &uart,
+      uint16_t broadcast_interval = default_broadcast_interval)
+      : broadcast_interval_(broadcast_interval), uart_(uart) {}
+
+  [[nodiscard]] uint16_t broadcast_interval() const { return broadcast_interval_; }
 
   /**
    * Starts broadcast
@@ -70,8 +80,8 @@ class Device {
   Status start_broadcast();
 
   /**
-   * Receives the next response
-   * @param sample[out] the sensor reading; only valid on success
+   * Receives the next complete response, if one is available
+   * @param response[out] the response; only valid on success
    * @return ok on success, error code otherwise
    */
   Status receive(Response &response);
@@ -89,6 +99,7 @@ class Device {
   Status request_version();
 
  private:
+  const uint16_t broadcast_interval_;
   volatile HAL::BufferedUART &uart_;
   ResponseReceiver responses_;
   RequestSender requests_;
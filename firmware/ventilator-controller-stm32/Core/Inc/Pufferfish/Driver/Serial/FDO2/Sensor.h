@@ -18,6 +18,11 @@
 
 namespace Pufferfish::Driver::Serial::FDO2 {
 
+/**
+ * State management for FDO2 sensor setup, without I/O. A request which
+ * times out is sent again after a backoff delay which doubles on each
+ * consecutive timeout.
+ */
 class StateMachine {
  public:
   enum class Action {
@@ -25,6 +30,7 @@ class StateMachine {
     check_version,
     start_broadcast,
     check_broadcast,
+    wait_retry,
     wait_measurement
   };
 
@@ -32,13 +38,18 @@ class StateMachine {
 
  private:
   static const uint32_t response_timeout = 50;  // ms
+  static const uint32_t initial_backoff = 10;   // ms
+  static const uint32_t max_backoff = 320;      // ms
 
   Action next_action_ = Action::request_version;
+  Action retry_action_ = Action::request_version;
+  uint32_t backoff_ = initial_backoff;
   uint32_t request_time_ = 0;
   uint32_t current_time_ = 0;
 
   void start_request();
-  [[nodiscard]] bool timed_out() const;
+  void start_retry(Action action);
+  [[nodiscard]] bool timed_out(uint32_t timeout) const;
 };
 
 /**
@@ -49,13 +60,34 @@ class Sensor : public Initializable {
   explicit Sensor(Device &device, HAL::Time &time) : device_(device), time_(time) {}
 
   InitializableState setup() override;
+
+  /**
+   * Drains all responses received since the previous call, keeping the most
+   * recent measurement and counting error responses
+   * @param po2[out] the most recent pO2 measurement; only written once a
+   * measurement has been received
+   * @return ok while measuring, failed if setup has not finished
+   */
   InitializableState output(uint32_t &po2);
 
+  /**
+   * Drains all responses received since the previous call, like output(po2)
+   * @param mraw[out] the most recent measurement
+   * @param received_time[out] the time the measurement was received, in ms
+   * @return ok once a measurement has been received, setup while waiting for
+   * the first measurement, failed if setup has not finished
+   */
+  InitializableState output(Responses::Mraw &mraw, uint32_t &received_time);
+
+  // Number of error responses received from the sensor
+  [[nodiscard]] size_t error_count() const { return error_count_; }
+  // Code of the most recent error response
+  [[nodiscard]] int32_t last_error() const { return last_error_; }
+
  private:
   using Action = StateMachine::Action;
 
   static constexpr Responses::Vers expected_vers{8, 1, 341, 15};
-  static constexpr Responses::Bcst expected_bcst{Device::broadcast_interval};
   static const size_t max_retries_setup = 100;  // max retries for all setup steps combined
 
   Device &device_;
@@ -64,6 +96,13 @@ class Sensor : public Initializable {
   Action next_action_ = Action::request_version;
   size_t retry_count_ = 0;
 
+  bool measured_ = false;
+  Responses::Mraw mraw_{};
+  uint32_t mraw_time_ = 0;
+  size_t error_count_ = 0;
+  int32_t last_error_ = 0;
+
+  void receive_all(uint32_t current_time);
   bool get_response(CommandTypes type, Response &response);
   InitializableState check_version(uint32_t current_time);
   InitializableState check_broadcast(uint32_t current_time);
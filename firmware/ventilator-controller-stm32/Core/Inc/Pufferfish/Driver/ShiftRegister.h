@@ -18,9 +18,15 @@
 namespace Pufferfish {
 namespace Driver {
 
+/**
+ * Driver for a serial-in, parallel-out shift register with an output latch.
+ * Channels are shifted out one pin edge per step() without any waiting, so
+ * steps should be driven by a timer interrupt at the baud period; update()
+ * only starts a new sequence when the channels have changed.
+ */
 class ShiftRegister {
  public:
-  static const int baud_rate = 20;
+  static const int baud_rate = 20;  // us between pin edges
   static const uint8_t num_channels = 8;
 
   ShiftRegister(
@@ -37,7 +43,29 @@ class ShiftRegister {
 
   void set_channel(uint8_t chan, bool out);
   [[nodiscard]] bool get_channel(uint8_t chan) const;
-  void update();
+
+  /**
+   * Starts shifting out the channels if they have changed since they were
+   * last shifted out, or were never shifted out, and no sequence is in
+   * progress; never blocks
+   * @return true if a sequence was started, in which case step() must be
+   * called once per baud period until it returns false
+   */
+  bool update();
+
+  /**
+   * Performs the next pin edge of the sequence in progress; may be called
+   * from an interrupt
+   * @return true if the sequence has more edges, false once it is done
+   */
+  bool step();
+
+  /**
+   * Checks whether a sequence is in progress
+   * @return true if step() still needs to be called
+   */
+  [[nodiscard]] bool busy() const { return busy_; }
+
   void clear();
 
  private:
@@ -47,7 +75,17 @@ class ShiftRegister {
   HAL::DigitalOutput &serial_clear_;
   HAL::Time &time_;
 
+  // Edges of a sequence: reset, then data, clock high and clock low for
+  // each channel, then latch high and latch low
+  static const uint8_t edges_per_channel = 3;
+  static const uint8_t sequence_edges = 1 + edges_per_channel * num_channels + 2;
+
   uint8_t output_reg_ = 0;
+  uint8_t shifted_reg_ = 0;
+  uint8_t sequence_reg_ = 0;
+  uint8_t edge_ = 0;
+  bool synced_ = false;  // whether shifted_reg_ is what the register outputs
+  volatile bool busy_ = false;
 };
 
 }  // namespace Driver
@@ -0,0 +1,266 @@
+/// EventLog.h
+/// This file has a persistent log of LogEvents on SPI flash.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "LogStore.h"
+#include "Pufferfish/Application/mcu_pb.h"
+#include "Pufferfish/HAL/Types.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Storage {
+
+/**
+ * Keeps every LogEvent, such as alarms and setting changes, in the ring log
+ * keys of a LogStore, so that the event history survives a reset and the
+ * backend only has to fetch events it has not seen yet.
+ *
+ * Each event gets the next id of a sequence which continues across resets,
+ * and is encoded into a fixed-size record in a RAM staging ring. input()
+ * reserves its slot with a single compare-and-swap, so it takes bounded
+ * time and may be called from the main loop and from interrupt handlers
+ * which preempt each other; if the flash falls too far behind, new events
+ * are dropped rather than waiting. update() appends at most one staged
+ * event per call to the store.
+ *
+ * Every checkpoint_stride-th event, and the first event after each reset,
+ * is indexed in RAM with its id, time and position in the store, so a
+ * query by id or by time only reads the records after the nearest
+ * checkpoint before it. Times are in ms since the reset at which each
+ * event was logged, so queries by time only cover events since the last
+ * reset.
+ *
+ * Layout of a record:
+ *   [0, 4)   id
+ *   [4, 8)   time, in ms
+ *   8        code
+ *   9        type
+ *   10       flags: has_alarm_limits, has_old_range, has_new_range,
+ *            old_bool and new_bool, from the least significant bit
+ *   11       old_mode
+ *   12       new_mode
+ *   [13, 16) reserved, always 0
+ *   [16, 24) old_float and new_float, as IEEE 754 bits
+ *   [24, 32) old_uint32 and new_uint32
+ *   [32, 56) lower and upper bounds of alarm_limits, old_range and
+ *            new_range
+ * All fields are big-endian.
+ *
+ * Events are streamed to the backend with serve(), which answers an
+ * ExpectedLogEvent with a NextLogEvents holding the stored events from the
+ * expected id on, reading at most one event per call.
+ */
+template <size_t sector_count>
+class EventLog {
+ public:
+  using Store = LogStore<sector_count>;
+  using Status = typename Store::Status;
+
+  /**
+   * The position and bounds of an iteration over stored events, from oldest
+   * to newest
+   */
+  struct Query {
+    typename Store::Cursor cursor{};
+    uint32_t first_id = 0;    // events before this id are skipped
+    uint32_t start_time = 0;  // events before this time are skipped, in ms
+    bool by_time = false;
+  };
+
+  static constexpr uint8_t record_key = Store::indexed_keys;
+  static constexpr size_t record_size = 56;
+  static constexpr HAL::AtomicSize staging_slots = 32;
+  static constexpr size_t checkpoint_count = 128;
+  static constexpr size_t records_per_sector = (Store::sector_size - Store::sector_header_size) /
+                                           (Store::record_header_size + record_size);
+  // Checkpoints are spread over as many events as the store can hold
+  static constexpr uint32_t checkpoint_stride =
+      (sector_count * records_per_sector + checkpoint_count - 1) / checkpoint_count;
+  static constexpr size_t max_served_events =
+      sizeof(NextLogEvents::elements) / sizeof(NextLogEvents::elements[0]);
+
+  static_assert(record_size <= Store::max_payload_size, "Events must fit in a record");
+  static_assert(
+      std::atomic<HAL::AtomicSize>::is_always_lock_free,
+      "Reserving a staging slot must not take a lock");
+
+  explicit EventLog(Store &store) : store_(store) {}
+
+  /**
+   * Scans the stored events to continue their ids and to rebuild the
+   * checkpoints. Call this once after the store is mounted, before any
+   * event is input. This blocks for flash reads.
+   * @return ok on success, even if nothing was stored yet, error code
+   * otherwise
+   */
+  Status load();
+
+  /**
+   * Logs an event. This never blocks, and may be called from interrupt
+   * handlers.
+   * @param event the event; its id is ignored
+   * @return true if the event was staged, false if it was dropped because
+   * the flash has fallen behind
+   */
+  bool input(const LogEvent &event);
+
+  /**
+   * Appends the oldest staged event to the store, if any. Call this
+   * regularly from the main loop, along with the store's update().
+   * @return ok on success, or if the append must be retried later, error
+   * code otherwise
+   */
+  Status update();
+
+  /**
+   * Starts a query at an event id
+   * @param id the id of the first event to return
+   * @param query[out] the query
+   */
+  void find(uint32_t id, Query &query) const;
+
+  /**
+   * Starts a query at a time since the last reset
+   * @param time the earliest time of the events to return, in ms
+   * @param query[out] the query
+   */
+  void find_time(uint32_t time, Query &query) const;
+
+  /**
+   * Reads the next stored event of a query. This reads at most
+   * checkpoint_stride records to skip to the start of a new query.
+   * @param query the query
+   * @param event[out] the event
+   * @return ok on success, not_found after the newest stored event, error
+   * code otherwise
+   */
+  Status next(Query &query, LogEvent &event);
+
+  /**
+   * Advances the answer to a fetch request, only when no flash operations
+   * are queued, so that reading never waits for them. The answer is
+   * restarted whenever the expected id changes or another event is stored.
+   * Call this regularly from the main loop.
+   * @param expected the id of the next event the backend expects
+   * @param next_events[out] the stored events from the expected id on, once
+   * they have been read; if the expected id is beyond the stored events,
+   * next_expected is the number of stored events, so the backend can
+   * start over
+   * @return ok on success, error code otherwise
+   */
+  Status serve(const ExpectedLogEvent &expected, NextLogEvents &next_events);
+
+  /**
+   * Returns the number of events ever logged, which is also the id of the
+   * next event
+   * @return the number of events
+   */
+  [[nodiscard]] uint32_t total() const { return head_.load(std::memory_order_relaxed); }
+
+  /**
+   * Returns the number of events which have left the staging ring, which is
+   * also the id of the next event to be appended to the store
+   * @return the number of flushed events
+   */
+  [[nodiscard]] uint32_t flushed() const { return tail_; }
+
+  /**
+   * Returns the number of events dropped because the flash fell behind
+   * @return the number of dropped events
+   */
+  [[nodiscard]] uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  using Record = std::array<uint8_t, record_size>;
+
+  static const size_t time_offset = 4;
+  static const size_t code_offset = 8;
+  static const size_t type_offset = 9;
+  static const size_t flags_offset = 10;
+  static const size_t old_mode_offset = 11;
+  static const size_t new_mode_offset = 12;
+  static const size_t old_float_offset = 16;
+  static const size_t new_float_offset = 20;
+  static const size_t old_uint32_offset = 24;
+  static const size_t new_uint32_offset = 28;
+  static const size_t alarm_limits_offset = 32;
+  static const size_t old_range_offset = 40;
+  static const size_t new_range_offset = 48;
+  static const uint8_t has_alarm_limits_flag = 1U << 0U;
+  static const uint8_t has_old_range_flag = 1U << 1U;
+  static const uint8_t has_new_range_flag = 1U << 2U;
+  static const uint8_t old_bool_flag = 1U << 3U;
+  static const uint8_t new_bool_flag = 1U << 4U;
+
+  struct Slot {
+    Record record{};
+    volatile HAL::AtomicSize committed = 0;  // id of the event in the record, plus one
+  };
+
+  struct Checkpoint {
+    uint32_t id = 0;
+    uint32_t time = 0;
+    typename Store::Cursor cursor{};
+  };
+
+  Store &store_;
+
+  // Staging ring: input() reserves slots at head_, update() drains them from
+  // tail_; event ids are the positions of their slots in this sequence
+  std::array<Slot, staging_slots> slots_{};
+  std::atomic<HAL::AtomicSize> head_{0};
+  volatile HAL::AtomicSize tail_ = 0;
+  std::atomic<uint32_t> dropped_{0};
+  uint32_t boot_id_ = 0;  // id of the first event since the last reset
+
+  // Checkpoint ring, in order of increasing id
+  std::array<Checkpoint, checkpoint_count> checkpoints_{};
+  size_t checkpoints_start_ = 0;
+  size_t checkpoints_size_ = 0;
+
+  // Fetch
+  Record buffer_{};
+  Query serve_query_{};
+  NextLogEvents answer_{};
+  bool serving_ = false;
+  bool served_ = false;
+  uint32_t serve_id_ = 0;
+  uint32_t serve_flushed_ = 0;
+
+  static void encode(const LogEvent &event, uint32_t id, Record &record);
+  static void decode(const Record &record, LogEvent &event);
+  static void write_range(const Range &range, uint8_t *buffer);
+  static void read_range(const uint8_t *buffer, Range &range);
+  void checkpoint(uint32_t id, uint32_t time, const typename Store::Cursor &cursor);
+  [[nodiscard]] const Checkpoint &checkpoint_at(size_t index) const;
+  void finish(NextLogEvents &next_events);
+};
+
+}  // namespace Storage
+}  // namespace Driver
+}  // namespace Pufferfish
+
+#include "EventLog.tpp"
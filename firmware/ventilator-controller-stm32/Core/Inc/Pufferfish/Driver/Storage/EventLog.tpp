@@ -0,0 +1,375 @@
+/// EventLog.tpp
+/// This file has methods for a persistent log of LogEvents on SPI flash.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstring>
+
+#include "EventLog.h"
+#include "Pufferfish/Util/Endian.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Storage {
+
+// EventLog
+
+template <size_t sector_count>
+typename EventLog<sector_count>::Status EventLog<sector_count>::load() {
+  if (!store_.mounted()) {
+    return Status::unmounted;
+  }
+
+  checkpoints_start_ = 0;
+  checkpoints_size_ = 0;
+  bool found = false;
+  uint32_t last_id = 0;
+  typename Store::Cursor cursor;
+  store_.begin(cursor);
+  while (true) {
+    // The cursor before next() leads back to the record next() returns
+    const typename Store::Cursor position = cursor;
+    typename Store::Record record;
+    Status status = store_.next(cursor, record);
+    if (status == Status::not_found) {
+      break;
+    }
+    if (status != Status::ok) {
+      return status;
+    }
+    if (record.key != record_key || record.length != record_size) {
+      continue;
+    }
+
+    status = store_.read(record, buffer_.data(), buffer_.size());
+    if (status == Status::invalid) {
+      continue;
+    }
+    if (status != Status::ok) {
+      return status;
+    }
+
+    uint32_t id = 0;
+    uint32_t time = 0;
+    Util::read_ntoh(buffer_.data(), id);
+    Util::read_ntoh(buffer_.data() + time_offset, time);
+    if (id % checkpoint_stride == 0) {
+      checkpoint(id, time, position);
+    }
+    last_id = id;
+    found = true;
+  }
+
+  const uint32_t next_id = found ? last_id + 1 : 0;
+  head_.store(next_id, std::memory_order_relaxed);
+  tail_ = next_id;
+  boot_id_ = next_id;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+bool EventLog<sector_count>::input(const LogEvent &event) {
+  // An interrupt may reserve slots between the load and the swap, in which
+  // case the swap fails and the check is repeated
+  HAL::AtomicSize id = head_.load(std::memory_order_relaxed);
+  do {
+    if (id - tail_ >= staging_slots) {
+      // The flash has fallen behind, and waiting for it is not an option
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  } while (!head_.compare_exchange_weak(id, id + 1, std::memory_order_relaxed));
+
+  Slot &slot = slots_.at(id % staging_slots);
+  encode(event, id, slot.record);
+  // The record must be complete before update() can see it
+  std::atomic_signal_fence(std::memory_order_release);
+  slot.committed = id + 1;
+  return true;
+}
+
+template <size_t sector_count>
+typename EventLog<sector_count>::Status EventLog<sector_count>::update() {
+  const HAL::AtomicSize id = tail_;
+  if (id == head_.load(std::memory_order_relaxed)) {
+    return Status::ok;
+  }
+  const Slot &slot = slots_.at(id % staging_slots);
+  if (slot.committed != id + 1) {
+    // The slot is reserved, but the input() filling it was preempted
+    return Status::ok;
+  }
+  std::atomic_signal_fence(std::memory_order_acquire);
+
+  typename Store::Cursor position;
+  Status status = store_.append(record_key, slot.record.data(), slot.record.size(), position);
+  if (status == Status::full || status == Status::busy) {
+    // tail_ stays on this event for the next update(), while input() keeps
+    // staging new events until the ring fills
+    return Status::ok;
+  }
+  if (status == Status::ok) {
+    if (id % checkpoint_stride == 0 || id == boot_id_) {
+      uint32_t time = 0;
+      Util::read_ntoh(slot.record.data() + time_offset, time);
+      checkpoint(id, time, position);
+    }
+  } else {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::atomic_signal_fence(std::memory_order_release);
+  tail_ = id + 1;
+  return status;
+}
+
+template <size_t sector_count>
+void EventLog<sector_count>::find(uint32_t id, Query &query) const {
+  query = Query{};
+  query.first_id = id;
+
+  // Find the first checkpoint after the id; the one before it is the start
+  size_t low = 0;
+  size_t high = checkpoints_size_;
+  while (low < high) {
+    const size_t middle = (low + high) / 2;
+    if (checkpoint_at(middle).id <= id) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (low == 0) {
+    store_.begin(query.cursor);
+  } else {
+    query.cursor = checkpoint_at(low - 1).cursor;
+  }
+}
+
+template <size_t sector_count>
+void EventLog<sector_count>::find_time(uint32_t time, Query &query) const {
+  find(boot_id_, query);
+  query.by_time = true;
+  query.start_time = time;
+
+  // Times only increase since the reset, so the checkpoints after the first
+  // event since the reset are also in order of time
+  size_t low = 0;
+  size_t high = checkpoints_size_;
+  while (low < high) {
+    const size_t middle = (low + high) / 2;
+    if (checkpoint_at(middle).id < boot_id_) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  const size_t first = low;
+  high = checkpoints_size_;
+  while (low < high) {
+    const size_t middle = (low + high) / 2;
+    if (checkpoint_at(middle).time <= time) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (low > first) {
+    query.cursor = checkpoint_at(low - 1).cursor;
+  }
+}
+
+template <size_t sector_count>
+typename EventLog<sector_count>::Status EventLog<sector_count>::next(
+    Query &query, LogEvent &event) {
+  while (true) {
+    typename Store::Record record;
+    Status status = store_.next(query.cursor, record);
+    if (status != Status::ok) {
+      return status;
+    }
+    if (record.key != record_key || record.length != record_size) {
+      continue;
+    }
+
+    status = store_.read(record, buffer_.data(), buffer_.size());
+    if (status == Status::invalid) {
+      // The record was corrupted, or reclaimed since the cursor passed it
+      continue;
+    }
+    if (status != Status::ok) {
+      return status;
+    }
+
+    decode(buffer_, event);
+    if (event.id < query.first_id || (query.by_time && event.time < query.start_time)) {
+      continue;
+    }
+    return Status::ok;
+  }
+}
+
+template <size_t sector_count>
+typename EventLog<sector_count>::Status EventLog<sector_count>::serve(
+    const ExpectedLogEvent &expected, NextLogEvents &next_events) {
+  const uint32_t flushed = tail_;
+  const bool same_request = serving_ && expected.id == serve_id_ && flushed == serve_flushed_;
+  if (same_request && served_) {
+    return Status::ok;
+  }
+
+  if (!same_request) {
+    find(expected.id, serve_query_);
+    serving_ = true;
+    served_ = false;
+    serve_id_ = expected.id;
+    serve_flushed_ = flushed;
+    answer_.elements_count = 0;
+  }
+  if (!store_.idle()) {
+    return Status::ok;
+  }
+
+  LogEvent event{};
+  Status status = next(serve_query_, event);
+  if (status == Status::not_found) {
+    finish(next_events);
+    return Status::ok;
+  }
+  if (status != Status::ok) {
+    return status;
+  }
+
+  answer_.elements[answer_.elements_count] = event;
+  ++answer_.elements_count;
+  if (answer_.elements_count == max_served_events) {
+    finish(next_events);
+  }
+  return Status::ok;
+}
+
+template <size_t sector_count>
+void EventLog<sector_count>::encode(const LogEvent &event, uint32_t id, Record &record) {
+  uint8_t flags = 0;
+  flags |= event.has_alarm_limits ? has_alarm_limits_flag : 0U;
+  flags |= event.has_old_range ? has_old_range_flag : 0U;
+  flags |= event.has_new_range ? has_new_range_flag : 0U;
+  flags |= event.old_bool ? old_bool_flag : 0U;
+  flags |= event.new_bool ? new_bool_flag : 0U;
+
+  uint32_t old_float = 0;
+  uint32_t new_float = 0;
+  std::memcpy(&old_float, &event.old_float, sizeof(old_float));
+  std::memcpy(&new_float, &event.new_float, sizeof(new_float));
+
+  record.fill(0);
+  Util::write_hton(id, record.data());
+  Util::write_hton(event.time, record.data() + time_offset);
+  record[code_offset] = static_cast<uint8_t>(event.code);
+  record[type_offset] = static_cast<uint8_t>(event.type);
+  record[flags_offset] = flags;
+  record[old_mode_offset] = static_cast<uint8_t>(event.old_mode);
+  record[new_mode_offset] = static_cast<uint8_t>(event.new_mode);
+  Util::write_hton(old_float, record.data() + old_float_offset);
+  Util::write_hton(new_float, record.data() + new_float_offset);
+  Util::write_hton(event.old_uint32, record.data() + old_uint32_offset);
+  Util::write_hton(event.new_uint32, record.data() + new_uint32_offset);
+  write_range(event.alarm_limits, record.data() + alarm_limits_offset);
+  write_range(event.old_range, record.data() + old_range_offset);
+  write_range(event.new_range, record.data() + new_range_offset);
+}
+
+template <size_t sector_count>
+void EventLog<sector_count>::decode(const Record &record, LogEvent &event) {
+  uint32_t old_float = 0;
+  uint32_t new_float = 0;
+  Util::read_ntoh(record.data(), event.id);
+  Util::read_ntoh(record.data() + time_offset, event.time);
+  event.code = static_cast<LogEventCode>(record[code_offset]);
+  event.type = static_cast<LogEventType>(record[type_offset]);
+  const uint8_t flags = record[flags_offset];
+  event.has_alarm_limits = (flags & has_alarm_limits_flag) != 0;
+  event.has_old_range = (flags & has_old_range_flag) != 0;
+  event.has_new_range = (flags & has_new_range_flag) != 0;
+  event.old_bool = (flags & old_bool_flag) != 0;
+  event.new_bool = (flags & new_bool_flag) != 0;
+  event.old_mode = static_cast<VentilationMode>(record[old_mode_offset]);
+  event.new_mode = static_cast<VentilationMode>(record[new_mode_offset]);
+  Util::read_ntoh(record.data() + old_float_offset, old_float);
+  Util::read_ntoh(record.data() + new_float_offset, new_float);
+  std::memcpy(&event.old_float, &old_float, sizeof(old_float));
+  std::memcpy(&event.new_float, &new_float, sizeof(new_float));
+  Util::read_ntoh(record.data() + old_uint32_offset, event.old_uint32);
+  Util::read_ntoh(record.data() + new_uint32_offset, event.new_uint32);
+  read_range(record.data() + alarm_limits_offset, event.alarm_limits);
+  read_range(record.data() + old_range_offset, event.old_range);
+  read_range(record.data() + new_range_offset, event.new_range);
+}
+
+template <size_t sector_count>
+void EventLog<sector_count>::write_range(const Range &range, uint8_t *buffer) {
+  Util::write_hton(range.lower, buffer);
+  Util::write_hton(range.upper, buffer + sizeof(uint32_t));
+}
+
+template <size_t sector_count>
+void EventLog<sector_count>::read_range(const uint8_t *buffer, Range &range) {
+  Util::read_ntoh(buffer, range.lower);
+  Util::read_ntoh(buffer + sizeof(uint32_t), range.upper);
+}
+
+template <size_t sector_count>
+void EventLog<sector_count>::checkpoint(
+    uint32_t id, uint32_t time, const typename Store::Cursor &cursor) {
+  if (checkpoints_size_ == checkpoint_count) {
+    // The oldest checkpoint's events are the first to be reclaimed anyway
+    checkpoints_start_ = (checkpoints_start_ + 1) % checkpoint_count;
+    --checkpoints_size_;
+  }
+
+  Checkpoint &entry = checkpoints_.at((checkpoints_start_ + checkpoints_size_) % checkpoint_count);
+  entry.id = id;
+  entry.time = time;
+  entry.cursor = cursor;
+  ++checkpoints_size_;
+}
+
+template <size_t sector_count>
+const typename EventLog<sector_count>::Checkpoint &EventLog<sector_count>::checkpoint_at(
+    size_t index) const {
+  return checkpoints_.at((checkpoints_start_ + index) % checkpoint_count);
+}
+
+template <size_t sector_count>
+void EventLog<sector_count>::finish(NextLogEvents &next_events) {
+  const pb_size_t count = answer_.elements_count;
+  // Without any stored events from the expected id on, the backend is told
+  // to expect the next event to be stored
+  answer_.next_expected = count > 0 ? answer_.elements[count - 1].id + 1 : serve_flushed_;
+  answer_.total = serve_flushed_;
+  answer_.remaining =
+      serve_flushed_ > answer_.next_expected ? serve_flushed_ - answer_.next_expected : 0;
+  next_events = answer_;
+  served_ = true;
+}
+
+}  // namespace Storage
+}  // namespace Driver
+}  // namespace Pufferfish
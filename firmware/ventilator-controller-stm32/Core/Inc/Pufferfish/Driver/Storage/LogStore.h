@@ -0,0 +1,288 @@
+/// LogStore.h
+/// This file has a log-structured, wear-leveled record store on SPI flash.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/Driver/SPI/AsyncFlash.h"
+#include "Pufferfish/HAL/Interfaces/CRCChecker.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Storage {
+
+/**
+ * A log-structured record store over a range of 4 KB flash sectors.
+ *
+ * Records are only ever appended, at the write head of the active sector,
+ * and are queued on an AsyncFlash, so appending never erases or waits for
+ * the flash chip. Sectors are activated in order of increasing
+ * sequence number, picking the erased sector with the lowest erase count,
+ * and the oldest sector is reclaimed by update() once too few erased sectors
+ * remain: the newest record of each indexed key is copied forward, and all
+ * other records in it are dropped with the sector. Keys below indexed_keys
+ * thus behave like persistent variables, and other keys like a ring log.
+ *
+ * Flash layout of a sector:
+ *   [0, 4)   magic
+ *   [4, 8)   erase count
+ *   [8, 12)  CRC-32C of bytes [0, 8), written right after each erase
+ *   [12, 16) sequence number, written when the sector is activated
+ *   [16, 20) bitwise complement of the sequence number
+ *   [20, ...) records, each one a header followed by its payload:
+ *     [0, 4) CRC-32C of the rest of the header and the payload
+ *     [4, 6) payload length
+ *     6      key
+ *     7      reserved, always 0
+ * All fields are big-endian. Every write is checked by a CRC or a
+ * complement on mount, so a write or erase torn by a power failure is
+ * detected and its sector is sealed or erased again, losing at most the
+ * record being written.
+ */
+template <size_t sector_count>
+class LogStore {
+ public:
+  enum class Status {
+    ok = 0,       /// success
+    full,         /// no erased sector is available for new records yet
+    busy,         /// the flash operation queue is full; retry after update()
+    invalid,      /// invalid key, length or buffer size, or a corrupted record
+    not_found,    /// no such record, or no more records
+    flash_error,  /// the flash chip returned an error
+    unmounted     /// the store has not been mounted
+  };
+
+  /**
+   * The location and header fields of a stored record
+   */
+  struct Record {
+    uint32_t address = 0;  // flash address of the record header
+    uint16_t length = 0;   // payload length, in bytes
+    uint8_t key = 0;
+  };
+
+  /**
+   * The position of an iteration over all records, from oldest to newest
+   */
+  struct Cursor {
+    uint32_t sequence = 0;
+    uint16_t sector = UINT16_MAX;
+    uint16_t offset = 0;
+  };
+
+  static const size_t sector_size = SPI::SPIFlash::sector_size;
+  static const size_t page_size = SPI::SPIFlash::page_size;
+  static const size_t sector_header_size = 20;
+  static const size_t record_header_size = 8;
+  static const size_t max_payload_size = page_size - record_header_size;
+  static const uint8_t indexed_keys = 8;
+  static const uint8_t invalid_key = 0xFF;
+
+  // The active sector, a sector being compacted, and an erased sector for
+  // the copied records must always be available
+  static_assert(sector_count >= 4, "LogStore needs at least 4 sectors");
+  // All indexed records must fit in a single sector when compacted
+  static_assert(
+      indexed_keys * page_size <= sector_size - sector_header_size,
+      "Indexed records must fit in one sector");
+
+  /**
+   * @param flash the SPI flash chip holding the store
+   * @param crc32c a CRC-32C calculator
+   * @param base_address the flash address of the first sector, which must be
+   * sector-aligned
+   */
+  LogStore(SPI::AsyncFlash &flash, HAL::CRC32 &crc32c, uint32_t base_address)
+      : flash_(flash), crc32c_(crc32c), base_address_(base_address) {}
+
+  /**
+   * Erases every sector of the store, keeping their erase counts, and mounts
+   * the empty store. This blocks for every sector erase.
+   * @return ok on success, error code otherwise
+   */
+  Status format();
+
+  /**
+   * Scans all sector headers and records to rebuild the in-memory state.
+   * Sectors with torn headers are queued for erasure by update(), and the
+   * newest sector is sealed if anything follows its last valid record.
+   * This blocks until queued flash operations complete, and for every read.
+   * @return ok on success, error code otherwise
+   */
+  Status mount();
+
+  /**
+   * Appends a record at the write head
+   * @param key the key of the record; must not be invalid_key
+   * @param payload the payload of the record
+   * @param length the payload length, at most max_payload_size
+   * @return ok on success, full if update() must reclaim a sector first,
+   * busy if update() must drain the flash operation queue first, error code
+   * otherwise
+   */
+  Status append(uint8_t key, const uint8_t *payload, size_t length);
+
+  /**
+   * Appends a record at the write head, reporting where it was written
+   * @param key the key of the record; must not be invalid_key
+   * @param payload the payload of the record
+   * @param length the payload length, at most max_payload_size
+   * @param position[out] a cursor from which next() returns the new record,
+   * only set on success
+   * @return as for append() without a position
+   */
+  Status append(uint8_t key, const uint8_t *payload, size_t length, Cursor &position);
+
+  /**
+   * Advances queued flash operations and, once they are complete, performs
+   * one step of background maintenance: erasing a sector, or copying one
+   * record forward out of the sector being compacted. Call this regularly
+   * from the main loop.
+   * @return ok on success, error code otherwise
+   */
+  Status update();
+
+  /**
+   * Reads the newest record of an indexed key
+   * @param key the key of the record, less than indexed_keys
+   * @param payload[out] the payload of the record
+   * @param capacity the size of the payload buffer
+   * @param length[out] the payload length
+   * @return ok on success, not_found if there is no such record, busy if
+   * queued flash operations are not complete yet, error code otherwise
+   */
+  Status read_latest(uint8_t key, uint8_t *payload, size_t capacity, size_t &length);
+
+  /**
+   * Starts an iteration over all records, from oldest to newest. Records
+   * dropped by update() during the iteration are skipped.
+   * @param cursor[out] the position of the iteration
+   */
+  void begin(Cursor &cursor) const;
+
+  /**
+   * Advances an iteration to the next record
+   * @param cursor the position of the iteration
+   * @param record[out] the location and header fields of the record
+   * @return ok on success, not_found after the last record, busy if queued
+   * flash operations are not complete yet, error code otherwise
+   */
+  Status next(Cursor &cursor, Record &record);
+
+  /**
+   * Reads and verifies the payload of a record
+   * @param record the record, as returned by next()
+   * @param payload[out] the payload of the record
+   * @param capacity the size of the payload buffer
+   * @return ok on success, busy if queued flash operations are not complete
+   * yet, error code otherwise
+   */
+  Status read(const Record &record, uint8_t *payload, size_t capacity);
+
+  [[nodiscard]] bool mounted() const { return mounted_; }
+
+  /**
+   * Checks whether all queued flash operations are complete, so that reads
+   * will not be refused as busy
+   * @return true if the flash operation queue is drained, false otherwise
+   */
+  [[nodiscard]] bool idle() const { return flash_.idle(); }
+
+  /**
+   * Returns the number of erased sectors ready for activation
+   * @return the number of erased sectors
+   */
+  [[nodiscard]] size_t free_sectors() const;
+
+ private:
+  enum class SectorState : uint8_t {
+    dirty = 0,  /// must be erased before use
+    free,       /// erased, with its erase count written
+    used        /// activated, holding records
+  };
+
+  struct Sector {
+    SectorState state = SectorState::dirty;
+    uint32_t erase_count = 0;
+    uint32_t sequence = 0;
+    uint16_t end = 0;     // offset after the last valid record
+    bool sealed = false;  // no more records may be appended
+  };
+
+  enum class Compaction { idle = 0, copying, erasing };
+
+  static const uint32_t sector_magic = 0x50464C53;  // "PFLS"
+  static const uint16_t no_sector = UINT16_MAX;
+  static const uint32_t no_address = UINT32_MAX;
+  static const uint32_t unknown_erase_count = UINT32_MAX;
+  static const size_t erase_count_offset = 4;
+  static const size_t header_crc_offset = 8;
+  static const size_t sequence_offset = 12;
+  static const size_t sequence_check_offset = 16;
+  static const size_t length_offset = 4;
+  static const size_t key_offset = 6;
+  static const size_t reserved_offset = 7;
+  // Erased sectors kept back from append() so compaction can always proceed
+  static const size_t free_sector_reserve = 1;
+  // Compaction of the oldest sector starts below this many erased sectors
+  static const size_t compaction_threshold = 2;
+  // Flash queue entries needed by append(): a sector activation, and a
+  // record which may straddle a page boundary
+  static const size_t append_queue_entries = 3;
+
+  SPI::AsyncFlash &flash_;
+  HAL::CRC32 &crc32c_;
+  const uint32_t base_address_;
+
+  std::array<Sector, sector_count> sectors_{};
+  std::array<uint32_t, indexed_keys> latest_{};
+  std::array<uint8_t, page_size> buffer_{};
+  bool mounted_ = false;
+  uint16_t active_ = no_sector;
+  uint32_t next_sequence_ = 0;
+  Compaction compaction_ = Compaction::idle;
+  uint16_t victim_ = no_sector;
+  uint16_t victim_offset_ = 0;
+
+  [[nodiscard]] uint32_t sector_address(uint16_t sector) const;
+  [[nodiscard]] uint16_t oldest_used() const;
+  [[nodiscard]] uint16_t next_used(uint32_t sequence) const;
+
+  static Status to_status(SPI::AsyncFlash::Status status);
+  Status read_flash(uint32_t address, uint8_t *data, size_t size);
+  Status program(uint32_t address, const uint8_t *data, size_t size);
+  Status read_headers();
+  Status scan(uint16_t sector);
+  Status check_blank_tail(uint16_t sector);
+  Status load_record(uint32_t address, Record &record);
+  Status erase(uint16_t sector);
+  Status activate(bool for_compaction);
+  Status write_record(size_t size);
+  Status compact_step();
+};
+
+}  // namespace Storage
+}  // namespace Driver
+}  // namespace Pufferfish
+
+#include "LogStore.tpp"
@@ -0,0 +1,652 @@
+/// LogStore.tpp
+/// This file has methods for a log-structured, wear-leveled record store on
+/// SPI flash.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "LogStore.h"
+#include "Pufferfish/Util/Endian.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Storage {
+
+// LogStore
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::format() {
+  Status status = to_status(flash_.flush());
+  if (status == Status::ok) {
+    status = read_headers();
+  }
+  if (status != Status::ok) {
+    return status;
+  }
+
+  for (uint16_t sector = 0; sector < sector_count; ++sector) {
+    status = erase(sector);
+    if (status == Status::ok) {
+      status = to_status(flash_.flush());
+    }
+    if (status != Status::ok) {
+      return status;
+    }
+  }
+  return mount();
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::mount() {
+  mounted_ = false;
+  active_ = no_sector;
+  next_sequence_ = 0;
+  compaction_ = Compaction::idle;
+  victim_ = no_sector;
+  latest_.fill(static_cast<uint32_t>(no_address));
+
+  Status status = to_status(flash_.flush());
+  if (status != Status::ok) {
+    return status;
+  }
+  status = read_headers();
+  if (status != Status::ok) {
+    return status;
+  }
+
+  // Replay the records of all used sectors from oldest to newest, so that
+  // the index ends up pointing at the newest record of each key
+  uint16_t newest = no_sector;
+  for (uint16_t sector = oldest_used(); sector != no_sector;
+       sector = next_used(sectors_[sector].sequence)) {
+    status = scan(sector);
+    if (status != Status::ok) {
+      return status;
+    }
+    newest = sector;
+    next_sequence_ = sectors_[sector].sequence + 1;
+  }
+
+  if (newest != no_sector) {
+    status = check_blank_tail(newest);
+    if (status != Status::ok) {
+      return status;
+    }
+    if (!sectors_[newest].sealed) {
+      active_ = newest;
+    }
+  }
+
+  mounted_ = true;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::append(
+    uint8_t key, const uint8_t *payload, size_t length) {
+  Cursor position;
+  return append(key, payload, length, position);
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::append(
+    uint8_t key, const uint8_t *payload, size_t length, Cursor &position) {
+  if (!mounted_) {
+    return Status::unmounted;
+  }
+  if (key == invalid_key || length > max_payload_size) {
+    return Status::invalid;
+  }
+  if (flash_.available() < append_queue_entries) {
+    return Status::busy;
+  }
+
+  const size_t size = record_header_size + length;
+  if (active_ == no_sector || sectors_[active_].sealed ||
+      sectors_[active_].end + size > sector_size) {
+    Status status = activate(false);
+    if (status != Status::ok) {
+      return status;
+    }
+  }
+
+  for (size_t i = 0; i < length; ++i) {
+    buffer_[record_header_size + i] = payload[i];
+  }
+  Util::write_hton(static_cast<uint16_t>(length), buffer_.data() + length_offset);
+  buffer_[key_offset] = key;
+  buffer_[reserved_offset] = 0;
+  Util::write_hton(
+      crc32c_.compute(buffer_.data() + length_offset, size - length_offset), buffer_.data());
+  Cursor written;
+  written.sequence = sectors_[active_].sequence;
+  written.sector = active_;
+  written.offset = sectors_[active_].end;
+  Status status = write_record(size);
+  if (status == Status::ok) {
+    position = written;
+  }
+  return status;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::update() {
+  if (!mounted_) {
+    return Status::unmounted;
+  }
+
+  if (flash_.update() != SPI::AsyncFlash::Status::ok) {
+    // A queued write to the write head may have been lost
+    if (active_ != no_sector) {
+      sectors_[active_].sealed = true;
+    }
+    return Status::flash_error;
+  }
+  // Maintenance only reads the flash once all queued writes have landed, so
+  // it never waits for them
+  if (!flash_.idle()) {
+    return Status::ok;
+  }
+
+  switch (compaction_) {
+    case Compaction::copying:
+      return compact_step();
+    case Compaction::erasing: {
+      Status status = erase(victim_);
+      if (status != Status::ok) {
+        return status;
+      }
+      compaction_ = Compaction::idle;
+      victim_ = no_sector;
+      return Status::ok;
+    }
+    case Compaction::idle:
+      break;
+  }
+
+  // Sectors with torn headers are erased one per call
+  for (uint16_t sector = 0; sector < sector_count; ++sector) {
+    if (sectors_[sector].state == SectorState::dirty) {
+      return erase(sector);
+    }
+  }
+
+  if (free_sectors() >= compaction_threshold) {
+    return Status::ok;
+  }
+
+  const uint16_t oldest = oldest_used();
+  if (oldest == no_sector || oldest == active_) {
+    return Status::ok;
+  }
+
+  compaction_ = Compaction::copying;
+  victim_ = oldest;
+  victim_offset_ = sector_header_size;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::read_latest(
+    uint8_t key, uint8_t *payload, size_t capacity, size_t &length) {
+  if (!mounted_) {
+    return Status::unmounted;
+  }
+  if (key >= indexed_keys) {
+    return Status::invalid;
+  }
+  if (latest_[key] == no_address) {
+    return Status::not_found;
+  }
+
+  Record record;
+  Status status = load_record(latest_[key], record);
+  if (status != Status::ok) {
+    return (status == Status::not_found) ? Status::invalid : status;
+  }
+  if (record.length > capacity) {
+    return Status::invalid;
+  }
+
+  for (size_t i = 0; i < record.length; ++i) {
+    payload[i] = buffer_[record_header_size + i];
+  }
+  length = record.length;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+void LogStore<sector_count>::begin(Cursor &cursor) const {
+  cursor.sector = oldest_used();
+  cursor.offset = sector_header_size;
+  if (cursor.sector != no_sector) {
+    cursor.sequence = sectors_[cursor.sector].sequence;
+  }
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::next(
+    Cursor &cursor, Record &record) {
+  if (!mounted_) {
+    return Status::unmounted;
+  }
+
+  while (cursor.sector != no_sector) {
+    const Sector &sector = sectors_[cursor.sector];
+    // The sector may have been reclaimed since the cursor entered it
+    const bool valid = sector.state == SectorState::used && sector.sequence == cursor.sequence;
+    if (valid && cursor.offset < sector.end) {
+      const uint32_t address = sector_address(cursor.sector) + cursor.offset;
+      Status status = read_flash(address, buffer_.data(), record_header_size);
+      if (status != Status::ok) {
+        return status;
+      }
+
+      uint16_t length = 0;
+      Util::read_ntoh(buffer_.data() + length_offset, length);
+      if (length <= max_payload_size) {
+        record.address = address;
+        record.length = length;
+        record.key = buffer_[key_offset];
+        cursor.offset += record_header_size + length;
+        return Status::ok;
+      }
+    }
+
+    cursor.sector = next_used(cursor.sequence);
+    cursor.offset = sector_header_size;
+    if (cursor.sector != no_sector) {
+      cursor.sequence = sectors_[cursor.sector].sequence;
+    }
+  }
+  return Status::not_found;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::read(
+    const Record &record, uint8_t *payload, size_t capacity) {
+  if (!mounted_) {
+    return Status::unmounted;
+  }
+  if (record.length > capacity) {
+    return Status::invalid;
+  }
+
+  Record loaded;
+  Status status = load_record(record.address, loaded);
+  if (status == Status::not_found ||
+      (status == Status::ok && (loaded.key != record.key || loaded.length != record.length))) {
+    return Status::invalid;
+  }
+  if (status != Status::ok) {
+    return status;
+  }
+
+  for (size_t i = 0; i < loaded.length; ++i) {
+    payload[i] = buffer_[record_header_size + i];
+  }
+  return Status::ok;
+}
+
+template <size_t sector_count>
+size_t LogStore<sector_count>::free_sectors() const {
+  size_t count = 0;
+  for (const Sector &sector : sectors_) {
+    if (sector.state == SectorState::free) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+template <size_t sector_count>
+uint32_t LogStore<sector_count>::sector_address(uint16_t sector) const {
+  return base_address_ + static_cast<uint32_t>(sector) * sector_size;
+}
+
+template <size_t sector_count>
+uint16_t LogStore<sector_count>::oldest_used() const {
+  uint16_t oldest = no_sector;
+  for (uint16_t sector = 0; sector < sector_count; ++sector) {
+    if (sectors_[sector].state == SectorState::used &&
+        (oldest == no_sector || sectors_[sector].sequence < sectors_[oldest].sequence)) {
+      oldest = sector;
+    }
+  }
+  return oldest;
+}
+
+template <size_t sector_count>
+uint16_t LogStore<sector_count>::next_used(uint32_t sequence) const {
+  uint16_t next = no_sector;
+  for (uint16_t sector = 0; sector < sector_count; ++sector) {
+    if (sectors_[sector].state == SectorState::used && sectors_[sector].sequence > sequence &&
+        (next == no_sector || sectors_[sector].sequence < sectors_[next].sequence)) {
+      next = sector;
+    }
+  }
+  return next;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::to_status(
+    SPI::AsyncFlash::Status status) {
+  switch (status) {
+    case SPI::AsyncFlash::Status::ok:
+      return Status::ok;
+    case SPI::AsyncFlash::Status::busy:
+      return Status::busy;
+    case SPI::AsyncFlash::Status::invalid:
+      return Status::invalid;
+    case SPI::AsyncFlash::Status::error:
+      break;
+  }
+  return Status::flash_error;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::read_flash(
+    uint32_t address, uint8_t *data, size_t size) {
+  return to_status(flash_.read(address, data, size));
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::program(
+    uint32_t address, const uint8_t *data, size_t size) {
+  return to_status(flash_.program(address, data, size));
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::read_headers() {
+  uint32_t max_erase_count = 0;
+  for (uint16_t index = 0; index < sector_count; ++index) {
+    Status status = read_flash(sector_address(index), buffer_.data(), sector_header_size);
+    if (status != Status::ok) {
+      return status;
+    }
+
+    Sector &sector = sectors_[index];
+    sector = Sector{};
+    sector.erase_count = unknown_erase_count;
+
+    uint32_t magic = 0;
+    uint32_t header_crc = 0;
+    Util::read_ntoh(buffer_.data(), magic);
+    Util::read_ntoh(buffer_.data() + header_crc_offset, header_crc);
+    if (magic != sector_magic || header_crc != crc32c_.compute(buffer_.data(), header_crc_offset)) {
+      // Never formatted, or torn by a power failure during an erase
+      continue;
+    }
+
+    Util::read_ntoh(buffer_.data() + erase_count_offset, sector.erase_count);
+    if (sector.erase_count > max_erase_count) {
+      max_erase_count = sector.erase_count;
+    }
+
+    uint32_t sequence = 0;
+    uint32_t sequence_check = 0;
+    Util::read_ntoh(buffer_.data() + sequence_offset, sequence);
+    Util::read_ntoh(buffer_.data() + sequence_check_offset, sequence_check);
+    if (sequence == UINT32_MAX && sequence_check == UINT32_MAX) {
+      sector.state = SectorState::free;
+    } else if (sequence == static_cast<uint32_t>(~sequence_check)) {
+      sector.state = SectorState::used;
+      sector.sequence = sequence;
+      sector.end = sector_header_size;
+    }
+  }
+
+  // Sectors without a readable erase count are assumed to be as worn as the
+  // most-worn sector, so they are not favored by wear leveling
+  for (Sector &sector : sectors_) {
+    if (sector.erase_count == unknown_erase_count) {
+      sector.erase_count = max_erase_count;
+    }
+  }
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::scan(uint16_t sector) {
+  Sector &info = sectors_[sector];
+  while (info.end + record_header_size <= sector_size) {
+    const uint32_t address = sector_address(sector) + info.end;
+    Record record;
+    Status status = load_record(address, record);
+    if (status == Status::not_found) {
+      return Status::ok;
+    }
+    if (status == Status::invalid) {
+      // A torn or corrupted record; nothing after it can be trusted
+      info.sealed = true;
+      return Status::ok;
+    }
+    if (status != Status::ok) {
+      return status;
+    }
+
+    if (record.key < indexed_keys) {
+      latest_[record.key] = address;
+    }
+    info.end += record_header_size + record.length;
+  }
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::check_blank_tail(
+    uint16_t sector) {
+  // A record torn before its header was written would leave a blank header
+  // in front of programmed bytes, which must not be programmed over
+  Sector &info = sectors_[sector];
+  for (size_t offset = info.end; offset < sector_size; offset += page_size) {
+    size_t chunk = sector_size - offset;
+    if (chunk > page_size) {
+      chunk = page_size;
+    }
+    Status status = read_flash(sector_address(sector) + offset, buffer_.data(), chunk);
+    if (status != Status::ok) {
+      return status;
+    }
+    for (size_t i = 0; i < chunk; ++i) {
+      if (buffer_[i] != UINT8_MAX) {
+        info.sealed = true;
+        return Status::ok;
+      }
+    }
+  }
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::load_record(
+    uint32_t address, Record &record) {
+  Status status = read_flash(address, buffer_.data(), record_header_size);
+  if (status != Status::ok) {
+    return status;
+  }
+
+  bool blank = true;
+  for (size_t i = 0; i < record_header_size; ++i) {
+    blank = blank && buffer_[i] == UINT8_MAX;
+  }
+  if (blank) {
+    return Status::not_found;
+  }
+
+  uint32_t crc = 0;
+  Util::read_ntoh(buffer_.data(), crc);
+  Util::read_ntoh(buffer_.data() + length_offset, record.length);
+  record.key = buffer_[key_offset];
+  record.address = address;
+  const size_t offset = (address - base_address_) % sector_size;
+  if (record.key == invalid_key || record.length > max_payload_size ||
+      offset + record_header_size + record.length > sector_size) {
+    return Status::invalid;
+  }
+
+  status = read_flash(address + record_header_size, buffer_.data() + record_header_size,
+                      record.length);
+  if (status != Status::ok) {
+    return status;
+  }
+  if (crc != crc32c_.compute(buffer_.data() + length_offset,
+                             record_header_size - length_offset + record.length)) {
+    return Status::invalid;
+  }
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::erase(uint16_t sector) {
+  Sector &info = sectors_[sector];
+  if (info.state == SectorState::used) {
+    for (uint32_t &address : latest_) {
+      if (address != no_address && address >= sector_address(sector) &&
+          address < sector_address(sector) + sector_size) {
+        address = no_address;
+      }
+    }
+  }
+  if (active_ == sector) {
+    active_ = no_sector;
+  }
+  info.state = SectorState::dirty;
+
+  Status status = to_status(flash_.erase_sector(sector_address(sector)));
+  if (status != Status::ok) {
+    return status;
+  }
+
+  // Persist the erase count right away, leaving the sequence number erased.
+  // The flash runs queued operations in order, so the sector can be used as
+  // soon as they are queued
+  ++info.erase_count;
+  Util::write_hton(sector_magic, buffer_.data());
+  Util::write_hton(info.erase_count, buffer_.data() + erase_count_offset);
+  Util::write_hton(
+      crc32c_.compute(buffer_.data(), header_crc_offset), buffer_.data() + header_crc_offset);
+  status = program(sector_address(sector), buffer_.data(), sequence_offset);
+  if (status != Status::ok) {
+    return status;
+  }
+
+  info.state = SectorState::free;
+  info.sequence = 0;
+  info.end = 0;
+  info.sealed = false;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::activate(bool for_compaction) {
+  const size_t available = free_sectors();
+  if (available == 0 || (!for_compaction && available <= free_sector_reserve)) {
+    return Status::full;
+  }
+
+  // Pick the least-worn erased sector, preferring those right after the
+  // current one on ties so that sectors are used round-robin
+  const uint16_t start = (active_ == no_sector) ? 0 : (active_ + 1) % sector_count;
+  uint16_t chosen = no_sector;
+  for (uint16_t i = 0; i < sector_count; ++i) {
+    const uint16_t sector = (start + i) % sector_count;
+    if (sectors_[sector].state == SectorState::free &&
+        (chosen == no_sector || sectors_[sector].erase_count < sectors_[chosen].erase_count)) {
+      chosen = sector;
+    }
+  }
+
+  // buffer_ may hold a record being copied forward, so it is not used here
+  Sector &info = sectors_[chosen];
+  std::array<uint8_t, sector_header_size - sequence_offset> sequence{};
+  Util::write_hton(next_sequence_, sequence.data());
+  Util::write_hton(static_cast<uint32_t>(~next_sequence_), sequence.data() + sizeof(uint32_t));
+  Status status = program(sector_address(chosen) + sequence_offset, sequence.data(), sequence.size());
+  if (status != Status::ok) {
+    info.state = SectorState::dirty;
+    return status;
+  }
+
+  info.state = SectorState::used;
+  info.sequence = next_sequence_;
+  info.end = sector_header_size;
+  info.sealed = false;
+  ++next_sequence_;
+  active_ = chosen;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::write_record(size_t size) {
+  Sector &info = sectors_[active_];
+  const uint32_t address = sector_address(active_) + info.end;
+  Status status = program(address, buffer_.data(), size);
+  if (status != Status::ok) {
+    return status;
+  }
+
+  const uint8_t key = buffer_[key_offset];
+  if (key < indexed_keys) {
+    latest_[key] = address;
+  }
+  info.end += size;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename LogStore<sector_count>::Status LogStore<sector_count>::compact_step() {
+  if (victim_offset_ >= sectors_[victim_].end) {
+    compaction_ = Compaction::erasing;
+    return Status::ok;
+  }
+
+  const uint32_t address = sector_address(victim_) + victim_offset_;
+  Record record;
+  Status status = load_record(address, record);
+  if (status == Status::not_found || status == Status::invalid) {
+    compaction_ = Compaction::erasing;
+    return Status::ok;
+  }
+  if (status != Status::ok) {
+    return status;
+  }
+
+  const size_t size = record_header_size + record.length;
+  if (record.key < indexed_keys && latest_[record.key] == address) {
+    // The record is still live, so it is copied verbatim to the write head
+    if (active_ == no_sector || sectors_[active_].sealed ||
+        sectors_[active_].end + size > sector_size) {
+      status = activate(true);
+      if (status != Status::ok) {
+        return status;
+      }
+    }
+    status = write_record(size);
+    if (status != Status::ok) {
+      return status;
+    }
+  }
+  victim_offset_ += size;
+  return Status::ok;
+}
+
+}  // namespace Storage
+}  // namespace Driver
+}  // namespace Pufferfish
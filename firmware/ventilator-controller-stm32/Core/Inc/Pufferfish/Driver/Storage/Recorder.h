@@ -0,0 +1,206 @@
+/// Recorder.h
+/// This file has a black-box recorder of breathing circuit waveforms on SPI
+/// flash.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "LogStore.h"
+#include "Pufferfish/Application/mcu_pb.h"
+#include "Pufferfish/HAL/Types.h"
+#include "Pufferfish/Util/Varint.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Storage {
+
+/**
+ * Continuously records flow, airway pressure, FiO2 and valve openings at the
+ * control loop rate, along with event codes such as alarms, into the ring
+ * log keys of a LogStore, so that the last few minutes before a fault can
+ * be read back. How many minutes are kept depends on the number of sectors
+ * and on how steady the signals are.
+ *
+ * Samples are quantized to fixed point and delta-encoded as zigzag varints
+ * into block-sized buffers of a RAM staging ring. input() only ever writes
+ * to RAM, in bounded time, so it can be called from the control loop; if
+ * the flash falls too far behind, whole blocks are dropped rather than
+ * waiting. update() appends at most one sealed block per call to the store.
+ * A block is sealed once it is full or spans max_block_duration, and when a
+ * dump starts, so that even steady signals reach the flash within a second.
+ *
+ * Layout of a block, which is stored as one record:
+ *   [0, 4)    number of the boot the block was recorded in
+ *   [4, 8)    time of the first entry, in ms
+ *   [8, 12)   time of the last entry, in ms
+ *   [12, ...) entries, each starting with a varint of the time elapsed since
+ *             the previous entry in the block, shifted left by one bit, with
+ *             the low bit set for events:
+ *     sample: a zigzag varint of the change of each channel from the
+ *             previous sample in the block, in the order of Sample; the
+ *             first sample of a block is relative to zero
+ *     event:  a varint of the event code
+ * Numbers and times are big-endian. Channels are stored in units of 0.01 L/min for
+ * flows, 0.01 cmH2O for pressure, 0.1 % for FiO2, and 0.0001 for valve
+ * openings.
+ *
+ * Blocks are streamed back one at a time with serve(), which answers a
+ * RecorderChunkRequest for the n-th block overlapping a time window with a
+ * RecorderChunk, examining one stored block per call. Times restart from
+ * zero on every reset, so windows only cover blocks of the current boot.
+ */
+template <size_t sector_count>
+class Recorder {
+ public:
+  using Store = LogStore<sector_count>;
+  using Status = typename Store::Status;
+
+  struct Sample {
+    uint32_t time = 0;            // ms
+    float flow_air = 0;           // L/min
+    float flow_o2 = 0;            // L/min
+    float paw = 0;                // cmH2O
+    float fio2 = 0;               // %
+    float valve_air_opening = 0;  // duty cycle, from 0 to 1
+    float valve_o2_opening = 0;   // duty cycle, from 0 to 1
+  };
+
+  static const uint8_t record_key = Store::indexed_keys;
+  static const size_t block_size = sizeof(RecorderChunk_data_t::bytes);
+  static const size_t first_time_offset = 4;
+  static const size_t last_time_offset = 8;
+  static const size_t block_header_size = 12;
+  static const size_t channel_count = 6;
+  // A time header and a delta for every channel
+  static const size_t max_entry_size = (channel_count + 1) * Util::varint_max_size;
+  // Covers a sector erase at the typical data rate several times over
+  static const size_t staging_blocks = 16;
+  static const uint32_t max_block_duration = 1000;  // ms
+
+  static constexpr std::array<float, channel_count> channel_scales = {
+      100, 100, 100, 10, 10000, 10000};
+
+  static_assert(block_size <= Store::max_payload_size, "Blocks must fit in a record");
+
+  explicit Recorder(Store &store) : store_(store) {}
+
+  /**
+   * Scans the stored blocks to number the current boot after the newest
+   * one. Call this once after the store is mounted, before any sample is
+   * input. This blocks for flash reads.
+   * @return ok on success, even if nothing was stored yet, error code
+   * otherwise
+   */
+  Status load();
+
+  /**
+   * Records a sample. A sample with the same time as the previous one is
+   * ignored, so this may be called more often than the control loop steps.
+   * This never blocks.
+   * @param sample the sample
+   */
+  void input(const Sample &sample);
+
+  /**
+   * Records an event, such as an alarm being raised. This never blocks.
+   * @param time the time of the event, in ms
+   * @param code the event code
+   */
+  void input_event(uint32_t time, uint32_t code);
+
+  /**
+   * Closes the block being filled, so that update() writes it out even
+   * though it is not full
+   */
+  void seal();
+
+  /**
+   * Appends the oldest sealed block to the store, if any. Call this
+   * regularly from the main loop, along with the store's update().
+   * @return ok on success, or if the append must be retried later, error
+   * code otherwise
+   */
+  Status update();
+
+  /**
+   * Advances the answer to a dump request by examining at most one stored
+   * block, and only when no flash operations are queued, so that reading
+   * never waits for them. Call this regularly from the main loop.
+   * @param request the block index and time window requested
+   * @param chunk[out] the block, once it has been found, or an empty chunk
+   * marked as last after the end of the window in the current boot
+   * @param current_time the current time, in ms
+   * @return ok on success, error code otherwise
+   */
+  Status serve(const RecorderChunkRequest &request, RecorderChunk &chunk, uint32_t current_time);
+
+  /**
+   * Returns the number of blocks dropped because the flash fell behind
+   * @return the number of dropped blocks
+   */
+  [[nodiscard]] uint32_t dropped() const { return dropped_; }
+
+ private:
+  struct Block {
+    std::array<uint8_t, block_size> data{};
+    size_t size = 0;
+  };
+
+  using Values = std::array<int32_t, channel_count>;
+
+  Store &store_;
+
+  // Staging ring: input() fills blocks_[newest_], update() drains sealed
+  // blocks from blocks_[oldest_]
+  std::array<Block, staging_blocks> blocks_{};
+  volatile HAL::AtomicSize newest_ = 0;
+  volatile HAL::AtomicSize oldest_ = 0;
+  Values previous_values_{};
+  uint32_t block_time_ = 0;     // time of the first entry in the block
+  uint32_t previous_time_ = 0;  // time of the previous entry in the block
+  uint32_t sample_time_ = 0;    // time of the previous sample
+  bool sampled_ = false;
+  uint32_t dropped_ = 0;
+  uint32_t boot_ = 0;
+
+  // Dump
+  typename Store::Cursor cursor_{};
+  std::array<uint8_t, block_size> buffer_{};
+  bool dumping_ = false;
+  bool served_ = false;
+  uint32_t dump_start_ = 0;
+  uint32_t dump_end_ = 0;
+  uint32_t dump_index_ = 0;  // index of the next block found in the window
+
+  static Values quantize(const Sample &sample);
+  Block &open_block(uint32_t time, size_t entry_size);
+  void write_header(Block &block, uint32_t time, bool event);
+  void write_varint(Block &block, uint32_t value);
+  void finish(const RecorderChunkRequest &request, RecorderChunk &chunk, uint32_t current_time);
+};
+
+}  // namespace Storage
+}  // namespace Driver
+}  // namespace Pufferfish
+
+#include "Recorder.tpp"
@@ -0,0 +1,313 @@
+/// Recorder.tpp
+/// This file has methods for a black-box recorder of breathing circuit
+/// waveforms on SPI flash.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+
+#include "Pufferfish/Util/Endian.h"
+#include "Recorder.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Storage {
+
+// Recorder
+
+template <size_t sector_count>
+typename Recorder<sector_count>::Status Recorder<sector_count>::load() {
+  if (!store_.mounted()) {
+    return Status::unmounted;
+  }
+
+  bool found = false;
+  uint32_t last_boot = 0;
+  typename Store::Cursor cursor;
+  store_.begin(cursor);
+  while (true) {
+    typename Store::Record record;
+    Status status = store_.next(cursor, record);
+    if (status == Status::not_found) {
+      break;
+    }
+    if (status != Status::ok) {
+      return status;
+    }
+    if (record.key != record_key || record.length < block_header_size ||
+        record.length > block_size) {
+      continue;
+    }
+
+    status = store_.read(record, buffer_.data(), buffer_.size());
+    if (status == Status::invalid) {
+      continue;
+    }
+    if (status != Status::ok) {
+      return status;
+    }
+
+    // Blocks are stored in order of boot
+    Util::read_ntoh(buffer_.data(), last_boot);
+    found = true;
+  }
+
+  boot_ = found ? last_boot + 1 : 0;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+void Recorder<sector_count>::input(const Sample &sample) {
+  if (sampled_ && sample.time == sample_time_) {
+    return;
+  }
+
+  const Values values = quantize(sample);
+  Block &block = open_block(sample.time, max_entry_size);
+  write_header(block, sample.time, false);
+  for (size_t i = 0; i < channel_count; ++i) {
+    // Channels are clamped so that their deltas cannot overflow
+    const int32_t delta = values.at(i) - previous_values_.at(i);
+    write_varint(block, Util::zigzag_encode(delta));
+  }
+  previous_values_ = values;
+  sample_time_ = sample.time;
+  sampled_ = true;
+}
+
+template <size_t sector_count>
+void Recorder<sector_count>::input_event(uint32_t time, uint32_t code) {
+  Block &block = open_block(time, 2 * Util::varint_max_size);
+  write_header(block, time, true);
+  write_varint(block, code);
+}
+
+template <size_t sector_count>
+void Recorder<sector_count>::seal() {
+  Block &block = blocks_.at(newest_);
+  if (block.size == 0) {
+    return;
+  }
+
+  Util::write_hton(previous_time_, block.data.data() + last_time_offset);
+  const HAL::AtomicSize next = (newest_ + 1) % staging_blocks;
+  if (next == oldest_) {
+    // The flash has fallen behind, and waiting for it is not an option
+    block.size = 0;
+    ++dropped_;
+    return;
+  }
+
+  blocks_.at(next).size = 0;
+  // The block must be complete before update() can see it
+  std::atomic_signal_fence(std::memory_order_release);
+  newest_ = next;
+}
+
+template <size_t sector_count>
+typename Recorder<sector_count>::Status Recorder<sector_count>::update() {
+  if (oldest_ == newest_) {
+    return Status::ok;
+  }
+  std::atomic_signal_fence(std::memory_order_acquire);
+
+  const Block &block = blocks_.at(oldest_);
+  Status status = store_.append(record_key, block.data.data(), block.size);
+  if (status == Status::full || status == Status::busy) {
+    // The block stays staged for the next update(); if the flash stays
+    // behind for long, seal() drops the newest blocks instead
+    return Status::ok;
+  }
+  if (status != Status::ok) {
+    ++dropped_;
+  }
+
+  std::atomic_signal_fence(std::memory_order_release);
+  oldest_ = (oldest_ + 1) % staging_blocks;
+  return status;
+}
+
+template <size_t sector_count>
+typename Recorder<sector_count>::Status Recorder<sector_count>::serve(
+    const RecorderChunkRequest &request, RecorderChunk &chunk, uint32_t current_time) {
+  const bool same_window =
+      dumping_ && request.start == dump_start_ && request.end == dump_end_;
+  if (same_window && served_ && request.index == chunk.index) {
+    return Status::ok;
+  }
+
+  if (!same_window || request.index < dump_index_) {
+    // Blocks are only ever appended, so counting restarts from the oldest,
+    // and the newest entries are staged to be appended before the end
+    seal();
+    store_.begin(cursor_);
+    dumping_ = true;
+    dump_start_ = request.start;
+    dump_end_ = request.end;
+    dump_index_ = 0;
+  }
+  served_ = false;
+  if (!store_.idle()) {
+    return Status::ok;
+  }
+
+  typename Store::Record record;
+  Status status = store_.next(cursor_, record);
+  if (status == Status::not_found) {
+    finish(request, chunk, current_time);
+    return Status::ok;
+  }
+  if (status != Status::ok) {
+    return status;
+  }
+  if (record.key != record_key || record.length < block_header_size ||
+      record.length > block_size) {
+    return Status::ok;
+  }
+
+  status = store_.read(record, buffer_.data(), buffer_.size());
+  if (status == Status::invalid) {
+    // The block was corrupted, or reclaimed since the cursor passed it
+    return Status::ok;
+  }
+  if (status != Status::ok) {
+    return status;
+  }
+
+  uint32_t boot = 0;
+  uint32_t first_time = 0;
+  uint32_t last_time = 0;
+  Util::read_ntoh(buffer_.data(), boot);
+  Util::read_ntoh(buffer_.data() + first_time_offset, first_time);
+  Util::read_ntoh(buffer_.data() + last_time_offset, last_time);
+  if (boot != boot_) {
+    // Times of earlier boots cannot be compared with the window
+    return Status::ok;
+  }
+  if (first_time > request.end) {
+    // Blocks of a boot are stored in order of time
+    finish(request, chunk, current_time);
+    return Status::ok;
+  }
+  if (last_time < request.start) {
+    return Status::ok;
+  }
+
+  if (dump_index_ == request.index) {
+    chunk.time = current_time;
+    chunk.start = request.start;
+    chunk.end = request.end;
+    chunk.index = request.index;
+    chunk.last = false;
+    for (size_t i = 0; i < record.length; ++i) {
+      chunk.data.bytes[i] = buffer_.at(i);
+    }
+    chunk.data.size = record.length;
+    served_ = true;
+  }
+  ++dump_index_;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename Recorder<sector_count>::Values Recorder<sector_count>::quantize(const Sample &sample) {
+  const std::array<float, channel_count> channels = {
+      sample.flow_air,
+      sample.flow_o2,
+      sample.paw,
+      sample.fio2,
+      sample.valve_air_opening,
+      sample.valve_o2_opening};
+  // Keeps the difference of any two values within the range of int32_t
+  static constexpr float limit = 1e9;
+
+  Values values{};
+  for (size_t i = 0; i < channel_count; ++i) {
+    const float scaled = channels.at(i) * channel_scales.at(i);
+    if (std::isnan(scaled)) {
+      values.at(i) = 0;
+    } else if (scaled > limit) {
+      values.at(i) = static_cast<int32_t>(limit);
+    } else if (scaled < -limit) {
+      values.at(i) = -static_cast<int32_t>(limit);
+    } else {
+      values.at(i) = static_cast<int32_t>(std::lround(scaled));
+    }
+  }
+  return values;
+}
+
+template <size_t sector_count>
+typename Recorder<sector_count>::Block &Recorder<sector_count>::open_block(
+    uint32_t time, size_t entry_size) {
+  const size_t size = blocks_.at(newest_).size;
+  // Entries out of order are not old enough to seal the block
+  const uint32_t age = time - block_time_;
+  const bool expired = age >= max_block_duration && age <= (UINT32_MAX >> 1U);
+  if (size + entry_size > block_size || (size != 0 && expired)) {
+    seal();
+  }
+
+  Block &block = blocks_.at(newest_);
+  if (block.size == 0) {
+    Util::write_hton(boot_, block.data.data());
+    Util::write_hton(time, block.data.data() + first_time_offset);
+    Util::write_hton(time, block.data.data() + last_time_offset);
+    block.size = block_header_size;
+    previous_values_.fill(0);
+    block_time_ = time;
+    previous_time_ = time;
+  }
+  return block;
+}
+
+template <size_t sector_count>
+void Recorder<sector_count>::write_header(Block &block, uint32_t time, bool event) {
+  uint32_t elapsed = time - previous_time_;
+  if (elapsed > (UINT32_MAX >> 1U)) {
+    // Entries out of order are recorded as simultaneous
+    elapsed = 0;
+  } else {
+    previous_time_ = time;
+  }
+  write_varint(block, (elapsed << 1U) | (event ? 1U : 0U));
+}
+
+template <size_t sector_count>
+void Recorder<sector_count>::write_varint(Block &block, uint32_t value) {
+  block.size += Util::write_varint(value, block.data.data() + block.size);
+}
+
+template <size_t sector_count>
+void Recorder<sector_count>::finish(
+    const RecorderChunkRequest &request, RecorderChunk &chunk, uint32_t current_time) {
+  chunk.time = current_time;
+  chunk.start = request.start;
+  chunk.end = request.end;
+  chunk.index = request.index;
+  chunk.last = true;
+  chunk.data.size = 0;
+  served_ = true;
+}
+
+}  // namespace Storage
+}  // namespace Driver
+}  // namespace Pufferfish
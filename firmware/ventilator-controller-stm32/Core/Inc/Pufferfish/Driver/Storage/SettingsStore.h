@@ -0,0 +1,137 @@
+/// SettingsStore.h
+/// This file has a persistent store for ventilation settings and
+/// calibration data on SPI flash.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "LogStore.h"
+#include "Pufferfish/Application/States.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Storage {
+
+/**
+ * Keeps Parameters, AlarmLimits and an opaque calibration blob in indexed
+ * keys of a LogStore, so that they survive a reset.
+ *
+ * Each slot is stored as a whole record, protobuf-encoded for the states,
+ * and a new record only supersedes the old one once it has been written
+ * completely with a valid CRC; the store thus always holds a complete copy
+ * of every slot, old or new. Slots are compared against their last
+ * committed copy on each update() and only appended when they change, so
+ * nothing is written while settings are steady.
+ */
+template <size_t sector_count>
+class SettingsStore {
+ public:
+  using Store = LogStore<sector_count>;
+  using Status = typename Store::Status;
+
+  static const uint8_t parameters_key = 0;
+  static const uint8_t alarm_limits_key = 1;
+  static const uint8_t calibration_key = 2;
+  static const size_t max_calibration_size = Store::max_payload_size;
+  // A setting being adjusted step by step is only committed this often
+  static const uint32_t commit_interval = 500;  // ms
+
+  static_assert(Parameters_size <= Store::max_payload_size, "Parameters must fit in a record");
+  static_assert(AlarmLimits_size <= Store::max_payload_size, "AlarmLimits must fit in a record");
+
+  SettingsStore(Store &store, Application::States &states) : store_(store), states_(states) {}
+
+  /**
+   * Loads the newest committed copy of each slot into the states, and also
+   * into the matching requests so that they are not overridden by empty
+   * ones. Call this once after the store is mounted, before the main loop.
+   * This blocks for flash reads.
+   * @return ok on success, even if nothing was stored yet, error code
+   * otherwise
+   */
+  Status restore();
+
+  /**
+   * Commits at most one changed slot. The record is queued on the flash, so
+   * this never waits for it; call this regularly from the main loop.
+   * @param current_time the current time, in ms
+   * @return ok on success, or if the commit must be retried later, error
+   * code otherwise
+   */
+  Status update(uint32_t current_time);
+
+  /**
+   * Replaces the calibration data, which is committed by update()
+   * @param data the calibration data
+   * @param size the size of the calibration data
+   * @return ok on success, invalid if the data is too large
+   */
+  Status set_calibration(const uint8_t *data, size_t size);
+
+  /**
+   * Copies out the calibration data
+   * @param data[out] output of the calibration data
+   * @param capacity the size of the output buffer
+   * @param size[out] the size of the calibration data
+   * @return ok on success, not_found if there is no calibration data,
+   * invalid if the output buffer is too small
+   */
+  Status calibration(uint8_t *data, size_t capacity, size_t &size) const;
+
+  /**
+   * Checks whether every slot matches its last committed copy
+   * @return true if nothing is waiting to be committed, false otherwise
+   */
+  [[nodiscard]] bool committed();
+
+ private:
+  enum class Slot : uint8_t { parameters = 0, alarm_limits, calibration };
+  static const size_t slot_count = 3;
+
+  using Buffer = std::array<uint8_t, Store::max_payload_size>;
+
+  struct Copy {
+    Buffer data{};
+    size_t size = 0;
+  };
+
+  Store &store_;
+  Application::States &states_;
+  std::array<Copy, slot_count> committed_{};
+  Buffer buffer_{};
+  Buffer calibration_{};
+  size_t calibration_size_ = 0;
+  bool committing_ = false;
+  uint32_t last_commit_time_ = 0;
+
+  static uint8_t key(Slot slot);
+  bool encode(Slot slot, Buffer &buffer, size_t &size);
+  bool decode(Slot slot, const uint8_t *data, size_t size);
+  [[nodiscard]] bool changed(Slot slot, const Buffer &buffer, size_t size) const;
+};
+
+}  // namespace Storage
+}  // namespace Driver
+}  // namespace Pufferfish
+
+#include "SettingsStore.tpp"
@@ -0,0 +1,240 @@
+/// SettingsStore.tpp
+/// This file has methods for a persistent store for ventilation settings and
+/// calibration data on SPI flash.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Pufferfish/Util/Timeouts.h"
+#include "SettingsStore.h"
+#include "nanopb/pb_decode.h"
+#include "nanopb/pb_encode.h"
+
+namespace Pufferfish {
+namespace Driver {
+namespace Storage {
+
+// SettingsStore
+
+template <size_t sector_count>
+typename SettingsStore<sector_count>::Status SettingsStore<sector_count>::restore() {
+  for (size_t i = 0; i < slot_count; ++i) {
+    const auto slot = static_cast<Slot>(i);
+    Copy &copy = committed_.at(i);
+
+    size_t length = 0;
+    Status status = store_.read_latest(key(slot), buffer_.data(), buffer_.size(), length);
+    if (status == Status::ok && decode(slot, buffer_.data(), length)) {
+      copy.data = buffer_;
+      copy.size = length;
+      continue;
+    }
+    if (status != Status::ok && status != Status::not_found && status != Status::invalid) {
+      return status;
+    }
+
+    // Nothing usable is stored, so the current defaults count as committed
+    // until they change
+    if (!encode(slot, copy.data, copy.size)) {
+      copy.size = 0;
+    }
+  }
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename SettingsStore<sector_count>::Status SettingsStore<sector_count>::update(
+    uint32_t current_time) {
+  if (committing_ && Util::within_timeout(last_commit_time_, commit_interval, current_time)) {
+    return Status::ok;
+  }
+  committing_ = false;
+
+  for (size_t i = 0; i < slot_count; ++i) {
+    const auto slot = static_cast<Slot>(i);
+    size_t size = 0;
+    if (!encode(slot, buffer_, size) || !changed(slot, buffer_, size)) {
+      continue;
+    }
+
+    Status status = store_.append(key(slot), buffer_.data(), size);
+    if (status == Status::full || status == Status::busy) {
+      // The slot still differs from its committed copy, so the next update()
+      // tries it again
+      return Status::ok;
+    }
+    if (status != Status::ok) {
+      return status;
+    }
+
+    Copy &copy = committed_.at(i);
+    copy.data = buffer_;
+    copy.size = size;
+    committing_ = true;
+    last_commit_time_ = current_time;
+    return Status::ok;
+  }
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename SettingsStore<sector_count>::Status SettingsStore<sector_count>::set_calibration(
+    const uint8_t *data, size_t size) {
+  if (size > calibration_.size()) {
+    return Status::invalid;
+  }
+
+  for (size_t i = 0; i < size; ++i) {
+    calibration_.at(i) = data[i];
+  }
+  calibration_size_ = size;
+  return Status::ok;
+}
+
+template <size_t sector_count>
+typename SettingsStore<sector_count>::Status SettingsStore<sector_count>::calibration(
+    uint8_t *data, size_t capacity, size_t &size) const {
+  size = calibration_size_;
+  if (calibration_size_ == 0) {
+    return Status::not_found;
+  }
+  if (capacity < calibration_size_) {
+    return Status::invalid;
+  }
+
+  for (size_t i = 0; i < calibration_size_; ++i) {
+    data[i] = calibration_.at(i);
+  }
+  return Status::ok;
+}
+
+template <size_t sector_count>
+bool SettingsStore<sector_count>::committed() {
+  for (size_t i = 0; i < slot_count; ++i) {
+    const auto slot = static_cast<Slot>(i);
+    size_t size = 0;
+    if (encode(slot, buffer_, size) && changed(slot, buffer_, size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <size_t sector_count>
+uint8_t SettingsStore<sector_count>::key(Slot slot) {
+  switch (slot) {
+    case Slot::parameters:
+      return parameters_key;
+    case Slot::alarm_limits:
+      return alarm_limits_key;
+    case Slot::calibration:
+      break;
+  }
+  return calibration_key;
+}
+
+template <size_t sector_count>
+bool SettingsStore<sector_count>::encode(Slot slot, Buffer &buffer, size_t &size) {
+  pb_ostream_t stream = pb_ostream_from_buffer(buffer.data(), buffer.size());
+  switch (slot) {
+    case Slot::parameters: {
+      // Timestamps change without the settings changing
+      Parameters parameters = states_.parameters();
+      parameters.time = 0;
+      if (!pb_encode(&stream, Parameters_fields, &parameters)) {
+        return false;
+      }
+      break;
+    }
+    case Slot::alarm_limits: {
+      AlarmLimits alarm_limits = states_.alarm_limits();
+      alarm_limits.time = 0;
+      if (!pb_encode(&stream, AlarmLimits_fields, &alarm_limits)) {
+        return false;
+      }
+      break;
+    }
+    case Slot::calibration:
+      buffer = calibration_;
+      size = calibration_size_;
+      return true;
+  }
+  size = stream.bytes_written;
+  return true;
+}
+
+template <size_t sector_count>
+bool SettingsStore<sector_count>::decode(Slot slot, const uint8_t *data, size_t size) {
+  // Each state has the same fields as its request, so the same encoding
+  // restores both
+  switch (slot) {
+    case Slot::parameters: {
+      pb_istream_t stream = pb_istream_from_buffer(data, size);
+      Parameters parameters = Parameters_init_zero;
+      if (!pb_decode(&stream, Parameters_fields, &parameters)) {
+        return false;
+      }
+      stream = pb_istream_from_buffer(data, size);
+      ParametersRequest parameters_request = ParametersRequest_init_zero;
+      if (!pb_decode(&stream, ParametersRequest_fields, &parameters_request)) {
+        return false;
+      }
+      states_.parameters() = parameters;
+      states_.parameters_request() = parameters_request;
+      return true;
+    }
+    case Slot::alarm_limits: {
+      pb_istream_t stream = pb_istream_from_buffer(data, size);
+      AlarmLimits alarm_limits = AlarmLimits_init_zero;
+      if (!pb_decode(&stream, AlarmLimits_fields, &alarm_limits)) {
+        return false;
+      }
+      stream = pb_istream_from_buffer(data, size);
+      AlarmLimitsRequest alarm_limits_request = AlarmLimitsRequest_init_zero;
+      if (!pb_decode(&stream, AlarmLimitsRequest_fields, &alarm_limits_request)) {
+        return false;
+      }
+      states_.alarm_limits() = alarm_limits;
+      states_.alarm_limits_request() = alarm_limits_request;
+      return true;
+    }
+    case Slot::calibration:
+      break;
+  }
+  return set_calibration(data, size) == Status::ok;
+}
+
+template <size_t sector_count>
+bool SettingsStore<sector_count>::changed(Slot slot, const Buffer &buffer, size_t size) const {
+  const Copy &copy = committed_.at(static_cast<size_t>(slot));
+  if (size != copy.size) {
+    return true;
+  }
+
+  for (size_t i = 0; i < size; ++i) {
+    if (buffer.at(i) != copy.data.at(i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace Storage
+}  // namespace Driver
+}  // namespace Pufferfish
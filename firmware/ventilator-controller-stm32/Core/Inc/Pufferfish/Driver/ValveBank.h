@@ -0,0 +1,88 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * ValveBank.h
+ *
+ * Stages the openings of a bank of PWM-driven valves and commits them together
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/HAL/Interfaces/PWM.h"
+#include "Pufferfish/HAL/Interfaces/PWMUpdateGate.h"
+#include "Pufferfish/Statuses.h"
+
+namespace Pufferfish {
+namespace Driver {
+
+/**
+ * An abstract class for a bank of valves whose openings change together
+ */
+class ValveBank {
+ public:
+  /**
+   * Stages a new opening for a valve, which takes effect at the next commit()
+   * @param valve the index of the valve in the bank
+   * @param opening a number between 0.0 (closed) and 1.0 (open), inclusive
+   * @return ok on success, invalid_duty_cycle if the valve or opening is out of range
+   */
+  virtual PWMStatus stage(size_t valve, float opening) = 0;
+
+  /**
+   * Makes all staged openings take effect together, in the same PWM period
+   */
+  virtual void commit() = 0;
+};
+
+/**
+ * A bank of valves driven by PWM channels on timers behind one update gate.
+ * Compare values are computed in fixed point when openings are staged, and
+ * only the channels whose compare values changed are written on commit().
+ */
+template <size_t size>
+class PWMValveBank : public ValveBank {
+ public:
+  static_assert(size <= 32, "A valve bank holds at most 32 valves");
+
+  using Valves = std::array<HAL::PWM *, size>;
+
+  static const uint32_t opening_bits = 16;
+  static const uint32_t opening_one = 1UL << opening_bits;  // fixed-point fully open
+
+  PWMValveBank(const Valves &valves, HAL::PWMUpdateGate &gate) : valves_(valves), gate_(gate) {}
+
+  /**
+   * Starts all valves closed with their PWM periods aligned; must be
+   * called after their timers have been set up
+   * @return ok on success, error code otherwise
+   */
+  PWMStatus setup();
+
+  PWMStatus stage(size_t valve, float opening) override;
+
+  /**
+   * Stages a new fixed-point opening for a valve
+   * @param valve the index of the valve in the bank
+   * @param opening a number between 0 (closed) and opening_one (open), inclusive
+   * @return ok on success, invalid_duty_cycle if the valve or opening is out of range
+   */
+  PWMStatus stage_fixed(size_t valve, uint32_t opening);
+
+  void commit() override;
+
+ private:
+  const Valves valves_;
+  HAL::PWMUpdateGate &gate_;
+  std::array<uint32_t, size> max_duties_{};
+  std::array<uint32_t, size> compares_{};
+  uint32_t changed_ = 0;  // bit i is set if valve i has a new compare value
+};
+
+}  // namespace Driver
+}  // namespace Pufferfish
+
+#include "ValveBank.tpp"
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * ValveBank.tpp
+ *
+ * Stages the openings of a bank of PWM-driven valves and commits them together
+ */
+
+#pragma once
+
+#include "ValveBank.h"
+
+namespace Pufferfish::Driver {
+
+template <size_t size>
+PWMStatus PWMValveBank<size>::setup() {
+  for (size_t i = 0; i < size; ++i) {
+    max_duties_[i] = valves_[i]->get_max_duty_cycle();
+    compares_[i] = 0;
+    valves_[i]->set_duty_cycle_raw(0);
+    PWMStatus status = valves_[i]->start();
+    if (status != PWMStatus::ok) {
+      return status;
+    }
+  }
+
+  changed_ = 0;
+  gate_.synchronize();
+  return PWMStatus::ok;
+}
+
+template <size_t size>
+PWMStatus PWMValveBank<size>::stage(size_t valve, float opening) {
+  if (opening < 0 || opening > 1) {
+    return PWMStatus::invalid_duty_cycle;
+  }
+
+  return stage_fixed(valve, static_cast<uint32_t>(opening * opening_one));
+}
+
+template <size_t size>
+PWMStatus PWMValveBank<size>::stage_fixed(size_t valve, uint32_t opening) {
+  if (valve >= size || opening > opening_one) {
+    return PWMStatus::invalid_duty_cycle;
+  }
+
+  auto compare = static_cast<uint32_t>(
+      (static_cast<uint64_t>(opening) * max_duties_[valve]) >> opening_bits);
+  if (compare != compares_[valve]) {
+    compares_[valve] = compare;
+    changed_ |= 1UL << valve;
+  }
+  return PWMStatus::ok;
+}
+
+template <size_t size>
+void PWMValveBank<size>::commit() {
+  if (changed_ == 0) {
+    return;
+  }
+
+  gate_.hold();
+  for (uint32_t changed = changed_; changed != 0; changed &= changed - 1) {
+    auto valve = static_cast<size_t>(__builtin_ctz(changed));
+    valves_[valve]->set_duty_cycle_raw(compares_[valve]);
+  }
+  gate_.release();
+  changed_ = 0;
+}
+
+}  // namespace Pufferfish::Driver
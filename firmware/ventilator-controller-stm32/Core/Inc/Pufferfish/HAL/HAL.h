@@ -18,17 +18,24 @@
 #include "Interfaces/DigitalOutput.h"
 #include "Interfaces/I2CDevice.h"
 #include "Interfaces/PWM.h"
+#include "Interfaces/PWMUpdateGate.h"
+#include "Interfaces/PulseOutput.h"
 #include "Interfaces/SPIDevice.h"
 #include "Interfaces/Time.h"
 
 // STM32 HAL
 
+#include "STM32/Cache.h"
 #include "STM32/Endian.h"
 #include "STM32/HALAnalogInput.h"
 #include "STM32/HALBufferedUART.h"
 #include "STM32/HALDigitalInput.h"
+#include "STM32/HALDigitalInputBank.h"
 #include "STM32/HALDigitalOutput.h"
 #include "STM32/HALI2CDevice.h"
 #include "STM32/HALPWM.h"
+#include "STM32/HALPWMUpdateGate.h"
+#include "STM32/HALPulseOutput.h"
 #include "STM32/HALSPIDevice.h"
 #include "STM32/HALTime.h"
+#include "STM32/MemoryMonitor.h"
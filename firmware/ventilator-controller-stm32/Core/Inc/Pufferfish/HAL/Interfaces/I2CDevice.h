@@ -49,6 +49,25 @@ class I2CDevice {
    * @return ok on success, error code otherwise
    */
   virtual I2CDeviceStatus write(uint8_t *buf, size_t count) = 0;
+
+  /**
+   * Starts reading data from the device without waiting for the transfer,
+   * which then runs in the background until finish_read() reports it done.
+   * By default, the data is read before this returns.
+   * @param buf[out]    output of the data, which must stay valid until
+   * finish_read() stops returning busy
+   * @param count   the number of bytes to be read
+   * @return ok if the read was started, busy if a transfer is still in
+   * progress on the bus, error code otherwise
+   */
+  virtual I2CDeviceStatus start_read(uint8_t *buf, size_t count) { return read(buf, count); }
+
+  /**
+   * Checks on the read most recently started by start_read()
+   * @return ok once the data is in the buffer, busy while the transfer is in
+   * progress, error code if it failed
+   */
+  virtual I2CDeviceStatus finish_read() { return I2CDeviceStatus::ok; }
 };
 
 }  // namespace HAL
@@ -0,0 +1,49 @@
+/// PWMUpdateGate.h
+/// This file has interface class and methods for committing PWM duty cycles together.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * An abstract class which represents a set of PWM timers sharing one period,
+ * whose buffered duty cycles take effect together at their next update event
+ */
+class PWMUpdateGate {
+ public:
+  /**
+   * Aligns the periods of all the timers, which must already be running
+   */
+  virtual void synchronize() = 0;
+
+  /**
+   * Keeps any duty cycles set after this call from taking effect
+   */
+  virtual void hold() = 0;
+
+  /**
+   * Lets all duty cycles set since hold() take effect at the next update event
+   */
+  virtual void release() = 0;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
@@ -0,0 +1,50 @@
+/// PulseOutput.h
+/// This file has interface class and methods for hardware-timed pulse outputs.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "DigitalOutput.h"
+#include "Pufferfish/Statuses.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * An abstract class which represents a GPIO output which can repeat a
+ * pulse on its own, without being written to again
+ */
+class PulseOutput : public DigitalOutput {
+ public:
+  /**
+   * Repeats a pulse which is active for the first duty ms of every
+   * period ms, until the next call to set_pulses() or write().
+   * A duty of 0 holds the output non-active, and a duty of at least
+   * period holds it active.
+   * @param period the period of the pulses, in ms
+   * @param duty the active duration of each pulse, in ms
+   * @return ok on success, error code otherwise
+   */
+  virtual TimerStatus set_pulses(uint32_t period, uint32_t duty) = 0;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
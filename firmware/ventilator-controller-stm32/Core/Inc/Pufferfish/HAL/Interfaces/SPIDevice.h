@@ -58,6 +58,23 @@ class SPIDevice {
    */
   virtual SPIDeviceStatus write_read(uint8_t *tx_buf, uint8_t *rx_buf, size_t count) = 0;
 
+  /**
+   * Starts reading data from the device in the background; by default this
+   * reads in the foreground, for devices without background transfers
+   * @param buf[out]    output of the data, which must not be touched until
+   * read_status() stops returning busy
+   * @param count   the number of bytes to be read
+   * @return ok on success, error code otherwise
+   */
+  virtual SPIDeviceStatus start_read(uint8_t *buf, size_t count) { return read(buf, count); }
+
+  /**
+   * Checks on a read started by start_read()
+   * @return busy while the read is in progress, ok once it has completed,
+   * error code otherwise
+   */
+  virtual SPIDeviceStatus read_status() { return SPIDeviceStatus::ok; }
+
   /**
    * To make the chip select as high or low
    * @param cs true(high) or false(low)
@@ -0,0 +1,50 @@
+/// TraceOutput.h
+/// This file has interface class and methods for a non-blocking debug trace output.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * An abstract class which represents a byte stream to a debug probe, which
+ * may or may not be listening
+ */
+class TraceOutput {
+ public:
+  /**
+   * @return true if a debug probe has enabled the output
+   */
+  virtual bool enabled() = 0;
+
+  /**
+   * Writes as many bytes as the output can take without waiting
+   * @param bytes the bytes to write
+   * @param size the number of bytes to write
+   * @return the number of bytes written
+   */
+  virtual size_t write(const uint8_t *bytes, size_t size) = 0;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
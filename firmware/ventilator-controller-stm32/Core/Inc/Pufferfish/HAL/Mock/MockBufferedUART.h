@@ -55,9 +55,9 @@ class MockBufferedUART : public BufferedUART {
   /**
    * sets read byte data from ring buffer
    * @param  Set read byte input data
-   * @return None
+   * @return buffer status of ring buffer, full if the byte was dropped
    */
-  void set_read(const uint8_t &byte) volatile;
+  BufferStatus set_read(const uint8_t &byte) volatile;
 
   /**
    * Write byte data to ring buffer
@@ -32,8 +32,9 @@ BufferStatus MockBufferedUART<rx_buffer_size, tx_buffer_size>::read(uint8_t &rea
 }
 
 template <AtomicSize rx_buffer_size, AtomicSize tx_buffer_size>
-void MockBufferedUART<rx_buffer_size, tx_buffer_size>::set_read(const uint8_t &byte) volatile {
-  rx_buffer_.write(byte);
+BufferStatus MockBufferedUART<rx_buffer_size, tx_buffer_size>::set_read(
+    const uint8_t &byte) volatile {
+  return rx_buffer_.write(byte);
 }
 
 template <AtomicSize rx_buffer_size, AtomicSize tx_buffer_size>
@@ -55,6 +55,16 @@ class MockI2CDevice : public I2CDevice {
    */
   void add_read(const uint8_t *buf, size_t count);
 
+  /**
+   * @brief  Append the input data to the read queue, to be returned by the
+   * read which consumes it along with the given status
+   * @param  buf the input data to append
+   * @param  count size of input data to add to queue
+   * @param  status the status to return from that read
+   * @return None
+   */
+  void add_read(const uint8_t *buf, size_t count, I2CDeviceStatus status);
+
   /**
    * @brief  Updates the private buffer variable mWriteBuf with the input data
    * @param  buf update the private variable mWriteBuf with the buffer input
@@ -86,6 +96,7 @@ class MockI2CDevice : public I2CDevice {
   using WriteBuffer = std::array<uint8_t, write_buf_size>;
 
   std::queue<ReadBuffer> read_buf_queue_;
+  std::queue<I2CDeviceStatus> read_status_queue_;
   std::queue<WriteBuffer> write_buf_queue_;
 
   I2CDeviceStatus return_status_ = I2CDeviceStatus::ok;
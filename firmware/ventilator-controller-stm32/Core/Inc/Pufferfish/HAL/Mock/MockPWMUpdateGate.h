@@ -0,0 +1,64 @@
+/// MockPWMUpdateGate.h
+/// This file has mock class and methods for unit testing of PWM update
+/// gates.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+
+#include "Pufferfish/HAL/Interfaces/PWMUpdateGate.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * Represents a set of synchronized PWM timers, for mock functional testing
+ */
+class MockPWMUpdateGate : public PWMUpdateGate {
+ public:
+  MockPWMUpdateGate() = default;
+
+  void synchronize() override;
+  void hold() override;
+  void release() override;
+
+  /**
+   * Test method to check whether the duty cycles are being held
+   */
+  [[nodiscard]] bool held() const;
+
+  /**
+   * Test method to get the number of calls to synchronize()
+   */
+  [[nodiscard]] size_t synchronizations() const;
+
+  /**
+   * Test method to get the number of calls to release()
+   */
+  [[nodiscard]] size_t releases() const;
+
+ private:
+  bool held_ = false;
+  size_t synchronizations_ = 0;
+  size_t releases_ = 0;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
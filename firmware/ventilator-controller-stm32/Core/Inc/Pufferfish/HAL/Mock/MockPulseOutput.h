@@ -0,0 +1,70 @@
+/// MockPulseOutput.h
+/// This file has mock class and methods for unit testing of Pulse
+/// Output.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Pufferfish/HAL/Interfaces/PulseOutput.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * Represents a hardware-timed pulse output, for mock functional testing
+ */
+class MockPulseOutput : public PulseOutput {
+ public:
+  MockPulseOutput() = default;
+
+  /**
+   * Holds the output constant, clearing the pulse period and duty
+   * @param output the output value to store
+   */
+  void write(bool output) override;
+
+  /**
+   * Stores the pulse period and duty, and the constant level they
+   * reduce to when the output is not pulsing
+   */
+  TimerStatus set_pulses(uint32_t period, uint32_t duty) override;
+
+  /**
+   * Test method to get the constant level last written
+   */
+  [[nodiscard]] bool get_write() const;
+
+  /**
+   * Test method to get the pulse period last set, or 0 if constant
+   */
+  [[nodiscard]] uint32_t get_period() const;
+
+  /**
+   * Test method to get the pulse duty last set, or 0 if constant
+   */
+  [[nodiscard]] uint32_t get_duty() const;
+
+ private:
+  bool last_output_ = false;
+  uint32_t period_ = 0;
+  uint32_t duty_ = 0;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
@@ -0,0 +1,87 @@
+/// MockSFM3019.h
+/// This file has a mock I2C device which answers commands like a healthy
+/// SFM3019 flow sensor, for closed-loop simulation of the breathing circuit.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/HAL/CRCChecker.h"
+#include "Pufferfish/HAL/Interfaces/I2CDevice.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * An I2C device which decodes the commands written to it and answers reads
+ * the way an SFM3019 would, with CRC-checked words. Once a measurement has
+ * been started, every read returns the flow most recently set with
+ * set_flow(), quantized by the sensor's conversion factors.
+ */
+class MockSFM3019 : public I2CDevice {
+ public:
+  MockSFM3019() = default;
+
+  /**
+   * Answers the most recent command
+   * @param buf the response, as 16-bit words each followed by its CRC
+   * @param count number of bytes to read
+   * @return ok if the most recent command has a response, no_new_data otherwise
+   */
+  I2CDeviceStatus read(uint8_t *buf, size_t count) override;
+
+  /**
+   * Decodes a command
+   * @param buf the command, optionally followed by an argument and its CRC
+   * @param count number of bytes written
+   * @return ok on success, invalid_arguments for a malformed command
+   */
+  I2CDeviceStatus write(uint8_t *buf, size_t count) override;
+
+  /**
+   * Sets the flow to be reported by subsequent measurements
+   * @param flow the flow through the sensor, in L/min
+   */
+  void set_flow(float flow);
+
+  /**
+   * @return true once a measurement has been started
+   */
+  [[nodiscard]] bool measuring() const;
+
+ private:
+  static constexpr CRC8Parameters crc_params = {0x31, 0xff, false, false, 0x00};
+  static const size_t word_size = 3;  // bytes, including the CRC
+  static const int16_t scale_factor = 170;
+  static const int16_t offset = -24576;
+  static const uint16_t flow_unit = 0x0148;
+  static const uint16_t temperature = 5000;  // 25 deg C, scaled by 200
+
+  SoftCRC8 crc8_{crc_params};
+  uint16_t command_ = 0;
+  bool measuring_ = false;
+  uint16_t raw_flow_ = static_cast<uint16_t>(offset);
+
+  void write_word(uint8_t *buf, size_t count, size_t index, uint16_t word);
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
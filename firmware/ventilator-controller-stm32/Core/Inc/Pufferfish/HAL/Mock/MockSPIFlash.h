@@ -0,0 +1,166 @@
+/// MockSPIFlash.h
+/// This file has a RAM-backed mock SPI device which emulates a W25Q-series
+/// SPI NOR flash chip, for unit testing of flash drivers and storage.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/HAL/Interfaces/SPIDevice.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * A mock SPI device which decodes W25Q16 instructions framed by chip select
+ * and applies them to a RAM array, with NOR semantics: programming can only
+ * clear bits, and only erases set them again. Program and erase instructions
+ * need the write enable latch, are dropped on protected sectors, and can be
+ * made to keep the BUSY bit set for a number of status register polls.
+ * Individual block locks cover single sectors in the top and bottom 64 KB
+ * blocks and whole blocks elsewhere, as on the real chip.
+ */
+template <size_t capacity>
+class MockSPIFlash : public SPIDevice {
+ public:
+  static const size_t page_size = 256;
+  static const size_t sector_size = 4096;
+  static const size_t block_size = 65536;
+  static const size_t sector_count = capacity / sector_size;
+  static const uint8_t manufacturer_id = 0xEF;
+  static const uint8_t device_id = 0x14;
+  static const uint16_t jedec_device_id = 0x4015;
+
+  static_assert(capacity % sector_size == 0, "Capacity must be a whole number of sectors");
+
+  MockSPIFlash();
+
+  SPIDeviceStatus read(uint8_t *buf, size_t count) override;
+  SPIDeviceStatus write(uint8_t *buf, size_t count) override;
+  SPIDeviceStatus write_read(uint8_t *tx_buf, uint8_t *rx_buf, size_t count) override;
+
+  /**
+   * Starts a transaction when driven low, and executes any pending program,
+   * erase or register write when driven high
+   * @param input true(high) or false(low)
+   */
+  void chip_select(bool input) override;
+
+  /**
+   * @brief  Sets how many status register reads return BUSY after each
+   * program or erase
+   * @param  polls the number of status register reads
+   */
+  void set_busy_polls(size_t polls);
+
+  /**
+   * @brief  Makes the next page program keep only its first bytes, as if
+   * power was lost part-way through it
+   * @param  bytes the number of bytes of the next page program to apply
+   */
+  void tear_next_program(size_t bytes);
+
+  /**
+   * @brief  Emulates a power cycle: volatile state is reset, and every
+   * individual block lock is set again
+   */
+  void power_cycle();
+
+  /**
+   * @brief  Sets the return status of all transfers
+   * @param  input the SPIDeviceStatus
+   */
+  void set_return_status(SPIDeviceStatus input);
+
+  /**
+   * @brief  Gives direct access to the emulated memory array
+   * @return a pointer to the first byte of the memory array
+   */
+  uint8_t *memory();
+
+  /**
+   * @brief  Returns the number of times a sector has been erased
+   * @param  sector the index of the sector
+   * @return the erase count of the sector
+   */
+  [[nodiscard]] uint32_t erase_count(size_t sector) const;
+
+  /**
+   * @brief  Returns the number of page programs which have been applied
+   * @return the page program count
+   */
+  [[nodiscard]] uint32_t program_count() const;
+
+  /**
+   * @brief  Returns the number of transactions which started with an
+   * instruction
+   * @param  instruction the instruction
+   * @return the number of transactions with that instruction
+   */
+  [[nodiscard]] uint32_t instruction_count(SPIInstruction instruction) const;
+
+  [[nodiscard]] uint8_t status_register1() const;
+  [[nodiscard]] uint8_t status_register3() const;
+  [[nodiscard]] bool block_locked(uint32_t addr) const;
+
+ private:
+  static const uint8_t busy_bit = 0x01;
+  static const uint8_t write_enable_bit = 0x02;
+  static const uint8_t wps_bit = 0x04;
+  static const size_t address_end = 4;
+
+  std::array<uint8_t, capacity> memory_{};
+  std::array<bool, sector_count> locks_{};
+  std::array<uint32_t, sector_count> erase_counts_{};
+  std::array<uint8_t, page_size> page_buffer_{};
+  std::array<uint32_t, UINT8_MAX + 1> instruction_counts_{};
+
+  SPIDeviceStatus return_status_ = SPIDeviceStatus::ok;
+  bool selected_ = false;
+  uint8_t instruction_ = 0;
+  size_t position_ = 0;
+  uint32_t address_ = 0;
+  size_t page_count_ = 0;
+
+  bool write_enabled_ = false;
+  uint8_t status_register2_ = 0;
+  uint8_t status_register3_ = 0;
+  size_t busy_polls_ = 0;
+  size_t busy_remaining_ = 0;
+  size_t tear_bytes_ = 0;
+  bool tear_pending_ = false;
+  uint32_t program_count_ = 0;
+
+  uint8_t transfer(uint8_t tx);
+  uint8_t respond(uint8_t tx);
+  void execute();
+  [[nodiscard]] bool writable(uint32_t addr) const;
+  void erase(uint32_t addr, size_t size);
+  void set_lock(uint32_t addr, bool lock);
+  void program();
+  void start_busy();
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
+
+#include "MockSPIFlash.tpp"
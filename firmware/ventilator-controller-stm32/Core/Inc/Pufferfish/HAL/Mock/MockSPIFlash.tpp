@@ -0,0 +1,371 @@
+/// MockSPIFlash.tpp
+/// This file has mock class methods for emulating SPI NOR flash memory.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <climits>
+
+#include "MockSPIFlash.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+template <size_t capacity>
+MockSPIFlash<capacity>::MockSPIFlash() {
+  memory_.fill(UINT8_MAX);
+  locks_.fill(true);
+}
+
+template <size_t capacity>
+SPIDeviceStatus MockSPIFlash<capacity>::read(uint8_t *buf, size_t count) {
+  if (return_status_ != SPIDeviceStatus::ok) {
+    return SPIDeviceStatus::read_error;
+  }
+
+  for (size_t index = 0; index < count; ++index) {
+    buf[index] = transfer(0);
+  }
+  return SPIDeviceStatus::ok;
+}
+
+template <size_t capacity>
+SPIDeviceStatus MockSPIFlash<capacity>::write(uint8_t *buf, size_t count) {
+  if (return_status_ != SPIDeviceStatus::ok) {
+    return SPIDeviceStatus::write_error;
+  }
+
+  for (size_t index = 0; index < count; ++index) {
+    transfer(buf[index]);
+  }
+  return SPIDeviceStatus::ok;
+}
+
+template <size_t capacity>
+SPIDeviceStatus MockSPIFlash<capacity>::write_read(
+    uint8_t *tx_buf, uint8_t *rx_buf, size_t count) {
+  if (return_status_ != SPIDeviceStatus::ok) {
+    return SPIDeviceStatus::read_error;
+  }
+
+  for (size_t index = 0; index < count; ++index) {
+    rx_buf[index] = transfer(tx_buf[index]);
+  }
+  return SPIDeviceStatus::ok;
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::chip_select(bool input) {
+  if (!input && !selected_) {
+    selected_ = true;
+    position_ = 0;
+    address_ = 0;
+    page_count_ = 0;
+    return;
+  }
+
+  if (input && selected_) {
+    selected_ = false;
+    if (position_ > 0) {
+      execute();
+    }
+  }
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::set_busy_polls(size_t polls) {
+  busy_polls_ = polls;
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::tear_next_program(size_t bytes) {
+  tear_pending_ = true;
+  tear_bytes_ = bytes;
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::power_cycle() {
+  selected_ = false;
+  write_enabled_ = false;
+  busy_remaining_ = 0;
+  locks_.fill(true);
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::set_return_status(SPIDeviceStatus input) {
+  return_status_ = input;
+}
+
+template <size_t capacity>
+uint8_t *MockSPIFlash<capacity>::memory() {
+  return memory_.data();
+}
+
+template <size_t capacity>
+uint32_t MockSPIFlash<capacity>::erase_count(size_t sector) const {
+  return erase_counts_.at(sector);
+}
+
+template <size_t capacity>
+uint32_t MockSPIFlash<capacity>::program_count() const {
+  return program_count_;
+}
+
+template <size_t capacity>
+uint32_t MockSPIFlash<capacity>::instruction_count(SPIInstruction instruction) const {
+  return instruction_counts_.at(static_cast<uint8_t>(instruction));
+}
+
+template <size_t capacity>
+uint8_t MockSPIFlash<capacity>::status_register1() const {
+  uint8_t value = 0;
+  if (busy_remaining_ > 0) {
+    value |= busy_bit;
+  }
+  if (write_enabled_) {
+    value |= write_enable_bit;
+  }
+  return value;
+}
+
+template <size_t capacity>
+uint8_t MockSPIFlash<capacity>::status_register3() const {
+  return status_register3_;
+}
+
+template <size_t capacity>
+bool MockSPIFlash<capacity>::block_locked(uint32_t addr) const {
+  return locks_.at((addr % capacity) / sector_size);
+}
+
+template <size_t capacity>
+uint8_t MockSPIFlash<capacity>::transfer(uint8_t tx) {
+  if (!selected_) {
+    return UINT8_MAX;
+  }
+
+  uint8_t rx = respond(tx);
+  ++position_;
+  return rx;
+}
+
+template <size_t capacity>
+uint8_t MockSPIFlash<capacity>::respond(uint8_t tx) {
+  if (position_ == 0) {
+    instruction_ = tx;
+    ++instruction_counts_.at(tx);
+    return UINT8_MAX;
+  }
+
+  switch (static_cast<SPIInstruction>(instruction_)) {
+    case SPIInstruction::read_status_register1:
+      return status_register1();
+    case SPIInstruction::read_status_register2:
+      return status_register2_;
+    case SPIInstruction::read_status_register3:
+      return status_register3_;
+    case SPIInstruction::jedec_id: {
+      static const std::array<uint8_t, address_end> jedec = {
+          0, manufacturer_id, jedec_device_id >> CHAR_BIT, jedec_device_id & UINT8_MAX};
+      return position_ < address_end ? jedec.at(position_) : UINT8_MAX;
+    }
+    case SPIInstruction::write_status_register1:
+    case SPIInstruction::write_status_register2:
+    case SPIInstruction::write_status_register3:
+      if (position_ == 1) {
+        address_ = tx;
+      }
+      return UINT8_MAX;
+    default:
+      break;
+  }
+
+  // Instructions from here on start with a 24-bit address
+  if (position_ < address_end) {
+    address_ = (address_ << static_cast<uint8_t>(CHAR_BIT)) | tx;
+    return UINT8_MAX;
+  }
+
+  const size_t data_index = position_ - address_end;
+  switch (static_cast<SPIInstruction>(instruction_)) {
+    case SPIInstruction::read_byte:
+      return memory_.at((address_ + data_index) % capacity);
+    case SPIInstruction::fast_read:
+      // Data follows a dummy byte
+      if (data_index == 0) {
+        return UINT8_MAX;
+      }
+      return memory_.at((address_ + data_index - 1) % capacity);
+    case SPIInstruction::read_block_status:
+      return block_locked(address_) ? 1 : 0;
+    case SPIInstruction::device_id:
+      return (data_index % 2 == 0) ? manufacturer_id : device_id;
+    case SPIInstruction::write_byte:
+      if (data_index == 0) {
+        page_buffer_.fill(UINT8_MAX);
+      }
+      // Data past the end of the page wraps around to its start
+      if (!tear_pending_ || data_index < tear_bytes_) {
+        page_buffer_.at((address_ + data_index) % page_size) &= tx;
+      }
+      ++page_count_;
+      return UINT8_MAX;
+    default:
+      return UINT8_MAX;
+  }
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::execute() {
+  const auto instruction = static_cast<SPIInstruction>(instruction_);
+
+  // Only status register reads are accepted during a program or erase
+  if (busy_remaining_ > 0) {
+    if (instruction == SPIInstruction::read_status_register1) {
+      --busy_remaining_;
+    }
+    return;
+  }
+
+  static const size_t block_32kb = 32768;
+  const bool has_address = position_ >= address_end;
+  switch (instruction) {
+    case SPIInstruction::write_enable:
+      write_enabled_ = true;
+      return;
+    case SPIInstruction::write_disable:
+    case SPIInstruction::reset_device:
+      write_enabled_ = false;
+      return;
+    case SPIInstruction::write_status_register1:
+    case SPIInstruction::write_status_register2:
+      break;
+    case SPIInstruction::write_status_register3:
+      if (write_enabled_ && position_ >= 2) {
+        status_register3_ = static_cast<uint8_t>(address_);
+        start_busy();
+      }
+      break;
+    case SPIInstruction::write_byte:
+      if (write_enabled_ && page_count_ > 0) {
+        program();
+      }
+      tear_pending_ = false;
+      break;
+    case SPIInstruction::sector_erase_4kb:
+      if (write_enabled_ && has_address) {
+        erase(address_, sector_size);
+      }
+      break;
+    case SPIInstruction::block_erase_32kb:
+      if (write_enabled_ && has_address) {
+        erase(address_, block_32kb);
+      }
+      break;
+    case SPIInstruction::block_erase_64kb:
+      if (write_enabled_ && has_address) {
+        erase(address_, block_size);
+      }
+      break;
+    case SPIInstruction::chip_erase:
+      if (write_enabled_) {
+        erase(0, capacity);
+      }
+      break;
+    case SPIInstruction::lock_block:
+    case SPIInstruction::unlock_block:
+      if (write_enabled_ && has_address) {
+        set_lock(address_, instruction == SPIInstruction::lock_block);
+      }
+      break;
+    case SPIInstruction::global_lock:
+    case SPIInstruction::global_unlock:
+      if (write_enabled_) {
+        locks_.fill(instruction == SPIInstruction::global_lock);
+      }
+      break;
+    default:
+      // Reads and unsupported instructions leave the write enable latch as-is
+      return;
+  }
+  write_enabled_ = false;
+}
+
+template <size_t capacity>
+bool MockSPIFlash<capacity>::writable(uint32_t addr) const {
+  return (status_register3_ & wps_bit) == 0 || !block_locked(addr);
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::erase(uint32_t addr, size_t size) {
+  const size_t length = (size < capacity) ? size : capacity;
+  const size_t start = (addr % capacity) - (addr % length);
+
+  // The whole instruction is ignored if any part of the range is protected
+  for (size_t offset = 0; offset < length; offset += sector_size) {
+    if (!writable(start + offset)) {
+      return;
+    }
+  }
+
+  for (size_t offset = 0; offset < length; offset += sector_size) {
+    for (size_t index = 0; index < sector_size; ++index) {
+      memory_.at(start + offset + index) = UINT8_MAX;
+    }
+    ++erase_counts_.at((start + offset) / sector_size);
+  }
+  start_busy();
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::set_lock(uint32_t addr, bool lock) {
+  const size_t address = addr % capacity;
+  const size_t block = address / block_size;
+  size_t start = address - (address % sector_size);
+  size_t length = sector_size;
+  if (block != 0 && block != (capacity - 1) / block_size) {
+    start = address - (address % block_size);
+    length = block_size;
+  }
+  for (size_t offset = 0; offset < length; offset += sector_size) {
+    locks_.at((start + offset) / sector_size) = lock;
+  }
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::program() {
+  const size_t page_start = (address_ % capacity) - (address_ % page_size);
+  if (!writable(page_start)) {
+    return;
+  }
+
+  for (size_t index = 0; index < page_size; ++index) {
+    memory_.at(page_start + index) &= page_buffer_.at(index);
+  }
+  ++program_count_;
+  start_busy();
+}
+
+template <size_t capacity>
+void MockSPIFlash<capacity>::start_busy() {
+  busy_remaining_ = busy_polls_;
+}
+
+}  // namespace HAL
+}  // namespace Pufferfish
@@ -0,0 +1,65 @@
+/// MockTraceOutput.h
+/// This file has mock class and methods for unit testing of debug trace
+/// outputs.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "Pufferfish/HAL/Interfaces/TraceOutput.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * Collects all bytes written to a trace output, for mock functional testing
+ */
+class MockTraceOutput : public TraceOutput {
+ public:
+  MockTraceOutput() = default;
+
+  bool enabled() override;
+  size_t write(const uint8_t *bytes, size_t size) override;
+
+  /**
+   * Test method to enable or disable the output
+   */
+  void set_enabled(bool enabled);
+
+  /**
+   * Test method to limit how many bytes each call to write() takes
+   */
+  void set_write_limit(size_t limit);
+
+  /**
+   * Test method to get all bytes written so far
+   */
+  [[nodiscard]] const std::vector<uint8_t> &written() const;
+
+ private:
+  bool enabled_ = true;
+  size_t write_limit_ = std::numeric_limits<size_t>::max();
+  std::vector<uint8_t> written_;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
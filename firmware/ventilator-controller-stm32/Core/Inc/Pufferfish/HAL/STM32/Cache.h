@@ -0,0 +1,132 @@
+/// Cache.h
+/// This file has STM32 HAL classes and methods for Cortex-M7 cache management
+/// around DMA transfers.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "stm32h7xx_hal.h"
+
+// Places a variable in the non-cacheable DMA region reserved by the linker
+// script; the MPU region covering it is set up by Cache::configure_mpu()
+#define PF_DMA_BUFFER __attribute__((section(".dma_buffers")))  // NOLINT(cppcoreguidelines-macro-usage)
+
+// Places a variable in D3 SRAM, the only memory reachable by the BDMA
+// controller serving D3 peripherals such as ADC3; this memory is cacheable,
+// so buffers placed there should be DMABuffers
+#define PF_BDMA_BUFFER __attribute__((section(".bdma_buffers")))  // NOLINT(cppcoreguidelines-macro-usage)
+
+namespace Pufferfish {
+namespace HAL {
+
+static const size_t cache_line_size = 32;  // bytes, Cortex-M7 L1 D-cache
+
+/**
+ * Rounds a buffer size up to a whole number of cache lines
+ * @param size the size of the buffer, in bytes
+ * @return the smallest multiple of the cache line size which is at least size
+ */
+constexpr size_t cache_aligned_size(size_t size) {
+  return (size + cache_line_size - 1) / cache_line_size * cache_line_size;
+}
+
+/**
+ * Cortex-M7 instruction/data cache and MPU configuration
+ */
+class Cache {
+ public:
+  /**
+   * Marks the 32 KB .dma_buffers linker section as a non-cacheable,
+   * shareable MPU region and enables the MPU with the default memory map elsewhere.
+   * Must be called before enable().
+   */
+  static void configure_mpu();
+
+  /**
+   * Enables the instruction and data caches
+   */
+  static void enable();
+
+  /**
+   * Checks whether the data cache is enabled
+   * @return true if the D-cache is enabled, false otherwise
+   */
+  static bool dcache_enabled();
+
+  /**
+   * Writes back any dirty cache lines covering a memory range, so that a DMA
+   * master reading from memory sees the CPU's writes
+   * @param address the start of the range, which must be cache-line-aligned
+   * @param size the size of the range, in bytes
+   */
+  static void clean(const void *address, size_t size);
+
+  /**
+   * Discards any cache lines covering a memory range, so that the CPU reads
+   * what a DMA master wrote to memory. Any CPU writes to the range which
+   * have not been cleaned are lost.
+   * @param address the start of the range, which must be cache-line-aligned
+   * @param size the size of the range, in bytes
+   */
+  static void invalidate(void *address, size_t size);
+};
+
+/**
+ * A byte buffer for DMA transfers in cacheable memory, aligned and padded to
+ * whole cache lines so that cache maintenance never touches neighboring data.
+ * Ownership of the buffer passes between the CPU and the DMA controller with
+ * the release/acquire methods below.
+ */
+template <size_t buffer_size>
+class alignas(cache_line_size) DMABuffer {
+ public:
+  static const size_t max_size = buffer_size;
+
+  [[nodiscard]] uint8_t *data() { return buffer_.data(); }
+  [[nodiscard]] const uint8_t *data() const { return buffer_.data(); }
+  [[nodiscard]] static constexpr size_t size() { return buffer_size; }
+
+  /**
+   * Hands the buffer to a DMA transmission after the CPU has written it
+   */
+  void release_for_transmit() const;
+
+  /**
+   * Hands the buffer to a DMA reception; the CPU must not touch it until
+   * acquire_after_receive() is called
+   */
+  void release_for_receive();
+
+  /**
+   * Takes the buffer back from a completed DMA reception
+   */
+  void acquire_after_receive();
+
+ private:
+  std::array<uint8_t, cache_aligned_size(buffer_size)> buffer_{};
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
+
+#include "Cache.tpp"
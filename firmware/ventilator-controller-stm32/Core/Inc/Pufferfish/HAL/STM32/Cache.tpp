@@ -0,0 +1,45 @@
+/// Cache.tpp
+/// This file has template methods for DMA buffers in cacheable memory.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Cache.h"
+
+namespace Pufferfish::HAL {
+
+template <size_t buffer_size>
+void DMABuffer<buffer_size>::release_for_transmit() const {
+  Cache::clean(buffer_.data(), buffer_.size());
+}
+
+template <size_t buffer_size>
+void DMABuffer<buffer_size>::release_for_receive() {
+  // Drop the lines now, so that no dirty line can be evicted over the data
+  // written by the DMA controller while it owns the buffer
+  Cache::invalidate(buffer_.data(), buffer_.size());
+}
+
+template <size_t buffer_size>
+void DMABuffer<buffer_size>::acquire_after_receive() {
+  // Speculative reads may have refilled lines during the transfer
+  Cache::invalidate(buffer_.data(), buffer_.size());
+}
+
+}  // namespace Pufferfish::HAL
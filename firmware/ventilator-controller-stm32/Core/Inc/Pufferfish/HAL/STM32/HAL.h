@@ -8,13 +8,17 @@
 
 #pragma once
 
+#include "Cache.h"
 #include "Endian.h"
 #include "HALAnalogInput.h"
+#include "HALAnalogScan.h"
 #include "HALBufferedUART.h"
 #include "HALCRCChecker.h"
 #include "HALDigitalInput.h"
 #include "HALDigitalOutput.h"
 #include "HALI2CDevice.h"
+#include "HALIntervalTimer.h"
 #include "HALPWM.h"
 #include "HALSPIDevice.h"
 #include "HALTime.h"
+#include "MemoryMonitor.h"
@@ -0,0 +1,99 @@
+/// HALAnalogScan.h
+/// This file has an STM32 HAL class for continuous multi-channel ADC scans
+/// with DMA.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Cache.h"
+#include "Pufferfish/Driver/Analog/Decimator.h"
+#include "Pufferfish/Statuses.h"
+#include "stm32h7xx_hal.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * Continuous scan of all regular channels of an ADC, transferred by DMA in
+ * circular mode into a double buffer. Each half of the buffer is handed to
+ * a decimator as soon as the DMA controller has filled it, while the
+ * controller fills the other half, so no CPU time is spent polling. The
+ * ADC must be set up for scan mode, continuous conversion and circular DMA
+ * data management; hardware oversampling can be enabled in the ADC setup.
+ */
+template <size_t channel_count, size_t block_sequences>
+class HALAnalogScan {
+ public:
+  // Number of samples in each half of the double buffer
+  static const size_t block_samples = channel_count * block_sequences;
+  using Buffer = DMABuffer<2 * block_samples * sizeof(uint16_t)>;
+  using Decimator = Driver::Analog::Decimator<channel_count>;
+
+  static_assert(
+      block_samples * sizeof(uint16_t) % cache_line_size == 0,
+      "Each half of the buffer must be a whole number of cache lines");
+
+  /**
+   * @param hadc the ADC to scan, which must have a DMA channel linked
+   * @param buffer the double buffer, placed in memory which the ADC's DMA
+   * controller can reach
+   * @param decimator the decimator to receive the samples
+   */
+  HALAnalogScan(ADC_HandleTypeDef &hadc, Buffer &buffer, Decimator &decimator)
+      : adc_(hadc), buffer_(buffer), decimator_(decimator) {}
+
+  /**
+   * Calibrates the ADC and starts the continuous scan
+   * @return ok on success, error otherwise
+   */
+  ADCStatus start();
+
+  /**
+   * Stops the continuous scan
+   * @return ok on success, error otherwise
+   */
+  ADCStatus stop();
+
+  /**
+   * Handles the first half of the buffer, to be called from
+   * HAL_ADC_ConvHalfCpltCallback
+   */
+  void handle_half_complete();
+
+  /**
+   * Handles the second half of the buffer, to be called from
+   * HAL_ADC_ConvCpltCallback
+   */
+  void handle_complete();
+
+ private:
+  ADC_HandleTypeDef &adc_;
+  Buffer &buffer_;
+  Decimator &decimator_;
+
+  void input_block(size_t block);
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
+
+#include "HALAnalogScan.tpp"
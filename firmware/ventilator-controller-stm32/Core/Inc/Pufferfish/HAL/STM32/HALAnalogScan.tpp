@@ -0,0 +1,79 @@
+/// HALAnalogScan.tpp
+/// This file has methods for the STM32 HAL class for continuous
+/// multi-channel ADC scans with DMA.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "HALAnalogScan.h"
+
+namespace Pufferfish::HAL {
+
+template <size_t channel_count, size_t block_sequences>
+ADCStatus HALAnalogScan<channel_count, block_sequences>::start() {
+  if (HAL_ADCEx_Calibration_Start(&adc_, ADC_CALIB_OFFSET, ADC_SINGLE_ENDED) != HAL_OK) {
+    return ADCStatus::error;
+  }
+
+  buffer_.release_for_receive();
+  if (HAL_ADC_Start_DMA(
+          &adc_,
+          // The HAL takes a word pointer but transfers half-words for 16-bit data
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+          reinterpret_cast<uint32_t *>(buffer_.data()),
+          2 * block_samples) != HAL_OK) {
+    return ADCStatus::error;
+  }
+
+  return ADCStatus::ok;
+}
+
+template <size_t channel_count, size_t block_sequences>
+ADCStatus HALAnalogScan<channel_count, block_sequences>::stop() {
+  if (HAL_ADC_Stop_DMA(&adc_) != HAL_OK) {
+    return ADCStatus::error;
+  }
+
+  return ADCStatus::ok;
+}
+
+template <size_t channel_count, size_t block_sequences>
+void HALAnalogScan<channel_count, block_sequences>::handle_half_complete() {
+  input_block(0);
+}
+
+template <size_t channel_count, size_t block_sequences>
+void HALAnalogScan<channel_count, block_sequences>::handle_complete() {
+  input_block(1);
+}
+
+template <size_t channel_count, size_t block_sequences>
+void HALAnalogScan<channel_count, block_sequences>::input_block(size_t block) {
+  static const size_t block_size = block_samples * sizeof(uint16_t);
+
+  uint8_t *start = buffer_.data() + block * block_size;
+  // The DMA controller has moved on to the other half, so this half is ours until it wraps around
+  Cache::invalidate(start, block_size);
+  decimator_.input(
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<const uint16_t *>(start),
+      block_sequences);
+}
+
+}  // namespace Pufferfish::HAL
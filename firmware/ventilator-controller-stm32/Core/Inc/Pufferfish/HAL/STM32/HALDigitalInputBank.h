@@ -0,0 +1,53 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALDigitalInputBank.h
+ *
+ * Reads a set of GPIO input pins together as one bitmask
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "stm32h7xx_hal.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * A GPIO input pin in a HALDigitalInputBank
+ */
+struct HALDigitalInputPin {
+  GPIO_TypeDef *port;  /// GPIO port of the MCU (A, B, ...)
+  uint16_t pin;        /// GPIO pin mask of the MCU (GPIO_PIN_0, ...)
+  bool inverted;       /// true if the input is active-low
+};
+
+/**
+ * Samples up to 32 GPIO inputs in one pass, reading each port's input data
+ * register once for each run of consecutive pins on that port, so pins
+ * should be listed grouped by port. Safe to call from an ISR.
+ */
+template <size_t size>
+class HALDigitalInputBank {
+ public:
+  static_assert(size <= 32, "A bank holds at most 32 inputs");
+
+  explicit HALDigitalInputBank(const std::array<HALDigitalInputPin, size> &pins) : pins_(pins) {}
+
+  /**
+   * @return bit i is set if the input pins[i] is active, cleared otherwise
+   */
+  uint32_t read() const;
+
+ private:
+  const std::array<HALDigitalInputPin, size> pins_;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
+
+#include "HALDigitalInputBank.tpp"
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALDigitalInputBank.tpp
+ *
+ * Reads a set of GPIO input pins together as one bitmask
+ */
+
+#pragma once
+
+#include "HALDigitalInputBank.h"
+
+namespace Pufferfish::HAL {
+
+template <size_t size>
+uint32_t HALDigitalInputBank<size>::read() const {
+  uint32_t samples = 0;
+  const GPIO_TypeDef *port = nullptr;
+  uint32_t levels = 0;
+  for (size_t i = 0; i < size; ++i) {
+    const HALDigitalInputPin &input = pins_[i];
+    if (input.port != port) {
+      port = input.port;
+      levels = port->IDR;
+    }
+    bool high = (levels & input.pin) != 0;
+    if (high != input.inverted) {
+      samples |= 1UL << i;
+    }
+  }
+  return samples;
+}
+
+}  // namespace Pufferfish::HAL
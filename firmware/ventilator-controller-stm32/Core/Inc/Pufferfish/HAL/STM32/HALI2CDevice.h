@@ -35,6 +35,14 @@ class HALI2CDevice : public I2CDevice {
    */
   I2CDeviceStatus write(uint8_t *buf, size_t count) override;
 
+  /**
+   * Starts an interrupt-driven read, so the event and error interrupts of
+   * the I2C port must be enabled
+   */
+  I2CDeviceStatus start_read(uint8_t *buf, size_t count) override;
+
+  I2CDeviceStatus finish_read() override;
+
  private:
   I2C_HandleTypeDef &dev_;
   const uint16_t addr;
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALIntervalTimer.h
+ *
+ * A hardware timer which raises an interrupt at a fixed interval
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "Pufferfish/Statuses.h"
+#include "stm32h7xx_hal.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * Drives a basic timer (TIM6 or TIM7), or the update interrupt of a general
+ * purpose timer (e.g. TIM13 or TIM14), on the APB1 timer clock, counting in
+ * microseconds and raising an update interrupt once per interval. The timer
+ * clock and its IRQ must be enabled before setup(), and the IRQ handler
+ * should call handle_irq().
+ */
+class HALIntervalTimer {
+ public:
+  /**
+   * @param htim a timer handle whose Instance is an APB1 timer
+   * @param interval_us the interval between interrupts, in us
+   */
+  HALIntervalTimer(TIM_HandleTypeDef &htim, uint32_t interval_us)
+      : htim_(htim), interval_us_(interval_us) {}
+
+  /**
+   * Sets up the timer's prescaler and period, without starting it
+   * @return ok on success, error code otherwise
+   */
+  TimerStatus setup();
+
+  /**
+   * Starts raising interrupts, the first of which comes one interval later
+   * @return ok on success, error code otherwise
+   */
+  TimerStatus start();
+
+  /**
+   * Stops raising interrupts; may be called from the timer's IRQ handler
+   * @return ok on success, error code otherwise
+   */
+  TimerStatus stop();
+
+  /**
+   * Acknowledges the timer's interrupt, to be called from its IRQ handler
+   * @return true if an interval has elapsed, false otherwise
+   */
+  bool handle_irq();
+
+ private:
+  static const uint32_t tick_frequency = 1000000;  // Hz
+
+  TIM_HandleTypeDef &htim_;
+  const uint32_t interval_us_;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALPWMUpdateGate.h
+ *
+ * Commits the duty cycles of PWM channels across several timers together
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "Pufferfish/HAL/Interfaces/PWMUpdateGate.h"
+#include "stm32h7xx_hal.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * Gates the update events of several PWM timers which run from the same
+ * clock with the same prescaler and period. HAL_TIM_PWM_ConfigChannel
+ * enables the compare preload of every PWM channel, so new compare values
+ * only reach the outputs at an update event; while held, the timers' update
+ * events are disabled (UDIS), so every compare value written in between
+ * reaches the outputs together at the first update event after release.
+ */
+template <size_t timer_count>
+class HALPWMUpdateGate : public PWMUpdateGate {
+ public:
+  using Timers = std::array<TIM_HandleTypeDef *, timer_count>;
+
+  explicit HALPWMUpdateGate(const Timers &timers) : timers_(timers) {}
+
+  void synchronize() override;
+  void hold() override;
+  void release() override;
+
+ private:
+  const Timers timers_;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
+
+#include "HALPWMUpdateGate.tpp"
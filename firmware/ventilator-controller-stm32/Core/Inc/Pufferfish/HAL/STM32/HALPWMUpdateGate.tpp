@@ -0,0 +1,41 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALPWMUpdateGate.tpp
+ *
+ * Commits the duty cycles of PWM channels across several timers together
+ */
+
+#pragma once
+
+#include "HALPWMUpdateGate.h"
+
+namespace Pufferfish::HAL {
+
+template <size_t timer_count>
+void HALPWMUpdateGate<timer_count>::synchronize() {
+  // The timers share a clock, so once their counters are reset together
+  // (within a few cycles of each other) their update events stay aligned
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  for (TIM_HandleTypeDef *htim : timers_) {
+    __HAL_TIM_SET_COUNTER(htim, 0);
+  }
+  __set_PRIMASK(primask);
+}
+
+template <size_t timer_count>
+void HALPWMUpdateGate<timer_count>::hold() {
+  for (TIM_HandleTypeDef *htim : timers_) {
+    htim->Instance->CR1 |= TIM_CR1_UDIS;
+  }
+}
+
+template <size_t timer_count>
+void HALPWMUpdateGate<timer_count>::release() {
+  for (TIM_HandleTypeDef *htim : timers_) {
+    htim->Instance->CR1 &= ~TIM_CR1_UDIS;
+  }
+}
+
+}  // namespace Pufferfish::HAL
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALPulseOutput.h
+ *
+ * A GPIO output whose pulses are timed by a hardware timer and driven by DMA
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Pufferfish/HAL/Interfaces/PulseOutput.h"
+#include "stm32h7xx_hal.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * Repeats pulses on any GPIO output pin with no CPU involvement: a timer
+ * counting in ms requests one DMA transfer on each update, which sets the
+ * pin through its port's BSRR, and another on each channel 1 compare match,
+ * which resets it. The timer must have an update and a channel 1 DMA
+ * request (e.g. TIM15, TIM16 or TIM17) and run on the APB2 timer clock.
+ * The timer clock must be enabled and the DMA handles' Instance and
+ * Init.Request fields must be filled in before setup().
+ */
+class HALPulseOutput : public PulseOutput {
+ public:
+  /// The words which the DMA streams copy into the BSRR; these must be
+  /// placed in the non-cacheable DMA buffer region (see PF_DMA_BUFFER)
+  using BSRRWords = std::array<uint32_t, 2>;
+
+  static const uint32_t max_period = 65536;  // ms
+
+  /**
+   * @param htim a timer handle with update and channel 1 DMA requests
+   * @param hdma_set a DMA stream handle for the timer's update request
+   * @param hdma_reset a DMA stream handle for the timer's channel 1 request
+   * @param port GPIO port of the MCU (A, B, ...)
+   * @param pin GPIO pin of the MCU (1, 2, ...)
+   * @param words storage for the BSRR words in the DMA buffer region
+   */
+  HALPulseOutput(
+      TIM_HandleTypeDef &htim,
+      DMA_HandleTypeDef &hdma_set,
+      DMA_HandleTypeDef &hdma_reset,
+      GPIO_TypeDef &port,
+      uint16_t pin,
+      BSRRWords &words)
+      : htim_(htim),
+        hdma_set_(hdma_set),
+        hdma_reset_(hdma_reset),
+        port_(port),
+        pin_(pin),
+        words_(words) {}
+
+  /**
+   * Sets up the timer and starts both DMA streams, leaving the timer stopped
+   * @return ok on success, error code otherwise
+   */
+  TimerStatus setup();
+
+  /**
+   * Stops any pulses and holds the pin at a constant level
+   * @param output true if the pin should be held high, false for low
+   */
+  void write(bool output) override;
+
+  TimerStatus set_pulses(uint32_t period, uint32_t duty) override;
+
+ private:
+  static const uint32_t tick_frequency = 1000;  // Hz
+
+  TimerStatus setup_dma(DMA_HandleTypeDef &hdma, const uint32_t &word);
+
+  TIM_HandleTypeDef &htim_;
+  DMA_HandleTypeDef &hdma_set_;
+  DMA_HandleTypeDef &hdma_reset_;
+  GPIO_TypeDef &port_;
+  const uint16_t pin_;
+  BSRRWords &words_;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
@@ -22,6 +22,7 @@
 
 #include "Pufferfish/HAL/Interfaces/DigitalOutput.h"
 #include "Pufferfish/HAL/Interfaces/SPIDevice.h"
+#include "Pufferfish/HAL/STM32/Cache.h"
 #include "stm32h7xx_hal.h"
 
 namespace Pufferfish {
@@ -67,6 +68,26 @@ class HALSPIDevice : public SPIDevice {
    */
   SPIDeviceStatus write_read(uint8_t *tx_buf, uint8_t *rx_buf, size_t count) override;
 
+  /**
+   * Starts reading data from the device with DMA, in chunks of just under
+   * 64 KB. DMA is used when the port has DMA streams linked and the
+   * buffer needs no cache maintenance beyond whole cache lines: it lies in
+   * the non-cacheable DMA region, the D-cache is off, or the buffer and count
+   * are cache-line-aligned. Otherwise the read is done in the foreground.
+   * @param buf[out]    output of the data
+   * @param count   the number of bytes to be read
+   * @return ok on success, error code otherwise
+   */
+  SPIDeviceStatus start_read(uint8_t *buf, size_t count) override;
+
+  /**
+   * Checks on a read started by start_read(), starting its next chunk if
+   * the previous one has completed
+   * @return busy while the read is in progress, ok once it has completed,
+   * error code otherwise
+   */
+  SPIDeviceStatus read_status() override;
+
   /**
    * To make the chip select as high or low
    * @param cs true(high) or false(low)
@@ -74,8 +95,18 @@ class HALSPIDevice : public SPIDevice {
   void chip_select(bool input) override;
 
  private:
+  // largest transfer the HAL accepts at once, kept to whole cache lines
+  static const size_t max_dma_chunk = UINT16_MAX / cache_line_size * cache_line_size;
+
   SPI_HandleTypeDef &dev_;
   DigitalOutput &cs_pin_;
+  uint8_t *rx_next_ = nullptr;
+  size_t rx_remaining_ = 0;
+  size_t rx_chunk_ = 0;
+  bool rx_invalidate_ = false;
+
+  [[nodiscard]] bool dma_capable(const uint8_t *buf, size_t count) const;
+  SPIDeviceStatus start_chunk();
 };
 
 }  // namespace HAL
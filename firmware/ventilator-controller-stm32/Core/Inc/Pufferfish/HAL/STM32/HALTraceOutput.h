@@ -0,0 +1,45 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALTraceOutput.h
+ *
+ * A byte stream to a debug probe over an ITM stimulus port and SWO
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Pufferfish/HAL/Interfaces/TraceOutput.h"
+#include "stm32h7xx_hal.h"
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * Writes bytes to an ITM stimulus port, which a debug probe reads out over
+ * SWO. The probe is responsible for setting up the trace clock, the SWO pin
+ * and the ITM; until it enables the port, the output is disabled and writes
+ * are skipped in constant time, so this is safe to leave in production
+ * firmware. Writes never wait for the stimulus port FIFO to drain.
+ */
+class HALTraceOutput : public TraceOutput {
+ public:
+  static const uint8_t max_port = 31;
+
+  /**
+   * @param port the ITM stimulus port, from 0 to 31; port 0 is
+   * conventionally used for printf-style text
+   */
+  explicit HALTraceOutput(uint8_t port) : port_(port) {}
+
+  bool enabled() override;
+  size_t write(const uint8_t *bytes, size_t size) override;
+
+ private:
+  const uint8_t port_;
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
@@ -0,0 +1,80 @@
+/// MemoryMonitor.h
+/// This file has STM32 HAL classes and methods for runtime stack and heap
+/// usage monitoring.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pufferfish {
+namespace HAL {
+
+/**
+ * Tracks the stack high-water mark by painting the free RAM between the heap
+ * and the stack at boot, then incrementally scanning it for overwritten words.
+ * The stack grows down from _estack and the heap grows up from the end of
+ * .bss (see sysmem.c), so they share the same free region.
+ */
+class MemoryMonitor {
+ public:
+  static const uint32_t paint_pattern = 0xC5C5C5C5;
+  // Bytes below the stack pointer left unpainted for paint_stack's own frame
+  static const size_t paint_margin = 64;
+  // Upper bound on the words examined by each call to update()
+  static const size_t scan_words_per_update = 256;
+
+  MemoryMonitor() = default;
+
+  /**
+   * Fills all free RAM between the heap end and the current stack pointer
+   * with the paint pattern. Must be called as early as possible in main().
+   */
+  static void paint_stack();
+
+  /**
+   * Scans a bounded chunk of the painted region for the deepest stack usage.
+   * Call this regularly from the main loop.
+   */
+  void update();
+
+  /**
+   * Returns the largest stack depth observed so far
+   * @return the stack high-water mark, in bytes
+   */
+  [[nodiscard]] uint32_t stack_high_water() const;
+
+  /**
+   * Returns the free RAM left between the heap end and the deepest stack
+   * usage observed so far
+   * @return the remaining free memory, in bytes
+   */
+  [[nodiscard]] uint32_t heap_free() const;
+
+ private:
+  uintptr_t low_water_ = 0;
+  uintptr_t cursor_ = 0;
+
+  static uintptr_t heap_end();
+  static uintptr_t stack_top();
+};
+
+}  // namespace HAL
+}  // namespace Pufferfish
@@ -55,7 +55,8 @@ enum class I2CDeviceStatus {
   crc_check_failed,   /// The CRC code received is inconsistent
   invalid_ext_slot,   /// The MUX slot of ExtendedI2CDevice is invalid
   test_failed,        /// unit tests are failing
-  no_new_data         /// no new data is received from the sensor
+  no_new_data,        /// no new data is received from the sensor
+  busy                /// a non-blocking transfer is still in progress
 };
 
 /**
@@ -67,6 +68,15 @@ enum class PWMStatus {
   hal_error            /// error starting or stopping the PWM generator
 };
 
+/**
+ * An outcome of performing an operation on an interval timer
+ */
+enum class TimerStatus {
+  ok = 0,           /// success
+  invalid_pattern,  /// the requested pattern does not fit in the timer
+  hal_error         /// error setting up, starting or stopping the timer
+};
+
 /**
  * An outcome of performing an operation on SPI bus
  */
@@ -89,6 +99,7 @@ enum class SPIInstruction {
   write_disable = 0x04,           /// Instruction for write disable
   write_byte = 0x02,              /// Instruction for write byte
   read_byte = 0x03,               /// Instruction for read byte
+  fast_read = 0x0B,               /// Instruction for fast read
   lock_block = 0x36,              /// Instruction for individual lock block
   unlock_block = 0x39,            /// Instruction for individual Unlock block
   global_lock = 0x7E,             /// Instruction for global lock block
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <climits>
+#include <cstddef>
 #include <cstdint>
 
 namespace Pufferfish::Util {
@@ -51,6 +52,17 @@ constexpr T set_byte(uint8_t byte) noexcept {
 template <typename T>
 T set_byte(uint8_t byte, size_t byte_index);
 
+/**
+ * Count the zero bits above the most significant set bit of a number, which
+ * takes a single CLZ instruction on Cortex-M
+ * @param number the number
+ * @return the number of leading zero bits, or 32 if the number is zero
+ */
+inline uint8_t count_leading_zeros(uint32_t number) noexcept {
+  static const uint8_t width = sizeof(uint32_t) * CHAR_BIT;
+  return number == 0 ? width : static_cast<uint8_t>(__builtin_clz(number));
+}
+
 }  // namespace Pufferfish::Util
 
 #include "Bytes.tpp"
@@ -0,0 +1,60 @@
+/// \file
+/// \brief Decimal integer parsing and formatting
+///
+/// Locale-free functions for reading and writing integers as ASCII decimal
+/// text, without any dependency on stdio or iostreams and without dynamic
+/// memory allocation
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pufferfish {
+namespace Util {
+
+static const uint8_t decimal_base = 10;
+
+/**
+ * Reads an integer written in decimal, with an optional leading minus sign
+ * for signed integer types
+ * @param begin the first character of the number
+ * @param end one past the last character which may be read
+ * @param value[out] the parsed number; only valid on success
+ * @return one past the last character of the number, or begin if there is no
+ * number at begin or the number does not fit in the integer type
+ */
+template <typename Integer>
+const char *read_decimal(const char *begin, const char *end, Integer &value);
+
+/**
+ * Writes an integer in decimal, with a leading minus sign if it is negative
+ * @param value the number to write
+ * @param buffer[out] output of the characters, without a null terminator
+ * @param size the number of characters available in the buffer
+ * @return the number of characters written, or 0 if the buffer is too small
+ */
+template <typename Integer>
+size_t write_decimal(Integer value, char *buffer, size_t size);
+
+}  // namespace Util
+}  // namespace Pufferfish
+
+#include "Decimal.tpp"
@@ -0,0 +1,111 @@
+/// \file
+/// \brief Decimal integer parsing and formatting
+///
+/// Locale-free functions for reading and writing integers as ASCII decimal
+/// text
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <limits>
+#include <type_traits>
+
+#include "Decimal.h"
+
+namespace Pufferfish::Util {
+
+template <typename Integer>
+const char *read_decimal(const char *begin, const char *end, Integer &value) {
+  static_assert(std::is_integral<Integer>::value, "Only integers can be parsed");
+  using Unsigned = std::make_unsigned_t<Integer>;
+
+  const char *current = begin;
+  bool negative = false;
+  if (std::is_signed<Integer>::value && current != end && *current == '-') {
+    negative = true;
+    ++current;
+  }
+
+  // The magnitude of the most negative number is one more than the most positive number
+  const auto limit = static_cast<Unsigned>(
+      static_cast<Unsigned>(std::numeric_limits<Integer>::max()) + (negative ? 1U : 0U));
+  const char *digits_begin = current;
+  Unsigned magnitude = 0;
+  for (; current != end && *current >= '0' && *current <= '9'; ++current) {
+    const auto digit = static_cast<Unsigned>(*current - '0');
+    if (magnitude > static_cast<Unsigned>((limit - digit) / decimal_base)) {
+      return begin;
+    }
+
+    magnitude = static_cast<Unsigned>(magnitude * decimal_base + digit);
+  }
+  if (current == digits_begin) {
+    return begin;
+  }
+
+  if (negative && magnitude > 0) {
+    // Negate without overflowing on the most negative number
+    value = static_cast<Integer>(-static_cast<Integer>(magnitude - 1) - 1);
+  } else {
+    value = static_cast<Integer>(magnitude);
+  }
+  return current;
+}
+
+template <typename Integer>
+size_t write_decimal(Integer value, char *buffer, size_t size) {
+  static_assert(std::is_integral<Integer>::value, "Only integers can be written");
+  using Unsigned = std::make_unsigned_t<Integer>;
+  static const size_t max_digits = std::numeric_limits<Unsigned>::digits10 + 1;
+
+  const bool negative = value < 0;
+  auto magnitude = static_cast<Unsigned>(value);
+  if (negative) {
+    magnitude = static_cast<Unsigned>(Unsigned(0) - magnitude);
+  }
+
+  // Digits are generated from least to most significant
+  std::array<char, max_digits> digits{};
+  size_t num_digits = 0;
+  do {
+    digits[num_digits] = static_cast<char>('0' + magnitude % decimal_base);
+    magnitude = static_cast<Unsigned>(magnitude / decimal_base);
+    ++num_digits;
+  } while (magnitude > 0);
+
+  const size_t length = num_digits + (negative ? 1 : 0);
+  if (length > size) {
+    return 0;
+  }
+
+  size_t index = 0;
+  if (negative) {
+    buffer[index] = '-';
+    ++index;
+  }
+  while (num_digits > 0) {
+    --num_digits;
+    buffer[index] = digits[num_digits];
+    ++index;
+  }
+  return length;
+}
+
+}  // namespace Pufferfish::Util
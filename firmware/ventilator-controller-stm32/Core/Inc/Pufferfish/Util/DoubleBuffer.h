@@ -0,0 +1,69 @@
+/// \file
+/// \brief A lock-free double buffer for passing values to or from an ISR
+///
+/// One side writes whole values and the other reads the most recent one,
+/// without either side disabling interrupts or waiting on the other
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace Pufferfish {
+namespace Util {
+
+/**
+ * Passes the latest value of a type from a single writer to a single reader,
+ * where one of them may preempt the other (e.g. an ISR and the main loop).
+ * The writer fills the buffer which the reader is not reading and then
+ * publishes it by incrementing a write count. A reader which is preempted by
+ * two or more writes retries its copy, which can only happen when the reader
+ * is the one being preempted, so an ISR reader never retries.
+ */
+template <typename Value>
+class DoubleBuffer {
+ public:
+  /**
+   * Publishes a new value, to be called only by the writer
+   * @param value the value to publish
+   */
+  void write(const Value &value);
+
+  /**
+   * Copies the most recently published value, to be called only by the reader
+   * @param value the most recent value, or a default-initialized value if
+   * none has been published yet
+   */
+  void read(Value &value) const;
+
+  /**
+   * @return the number of values published so far, modulo rollover
+   */
+  [[nodiscard]] uint32_t writes() const { return writes_; }
+
+ private:
+  std::array<Value, 2> buffers_{};
+  volatile uint32_t writes_ = 0;
+};
+
+}  // namespace Util
+}  // namespace Pufferfish
+
+#include "DoubleBuffer.tpp"
@@ -0,0 +1,50 @@
+/// \file
+/// \brief A lock-free double buffer for passing values to or from an ISR
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+
+#include "DoubleBuffer.h"
+
+namespace Pufferfish::Util {
+
+template <typename Value>
+void DoubleBuffer<Value>::write(const Value &value) {
+  uint32_t writes = writes_;
+  buffers_[(writes + 1) % buffers_.size()] = value;
+  // The copy must complete before it is published
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  writes_ = writes + 1;
+}
+
+template <typename Value>
+void DoubleBuffer<Value>::read(Value &value) const {
+  uint32_t writes = 0;
+  do {
+    writes = writes_;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    value = buffers_[writes % buffers_.size()];
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    // A second write during the copy would have overwritten the buffer
+  } while (writes_ - writes >= buffers_.size());
+}
+
+}  // namespace Pufferfish::Util
@@ -0,0 +1,74 @@
+/// \file
+/// \brief A lock-free queue for passing every value from an ISR
+///
+/// One side writes whole values and the other reads each of them once, in
+/// order, without either side disabling interrupts or waiting on the other
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Pufferfish/HAL/Types.h"
+#include "Pufferfish/Statuses.h"
+
+namespace Pufferfish {
+namespace Util {
+
+/**
+ * Passes every value of a type from a single writer to a single reader,
+ * where one of them may preempt the other (e.g. an ISR and the main loop).
+ * Unlike a DoubleBuffer, no value is skipped as long as the reader keeps up
+ * on average; when the queue is full, new values are dropped and counted.
+ * One slot always stays empty, so the queue holds up to capacity - 1 values.
+ */
+template <typename Value, HAL::AtomicSize capacity>
+class ValueQueue {
+ public:
+  /**
+   * Appends a value, to be called only by the writer
+   * @param value the value to append
+   * @return ok on success, full if the value was dropped
+   */
+  BufferStatus write(const Value &value);
+
+  /**
+   * Takes the oldest value, to be called only by the reader
+   * @param value[out] the oldest value, only set on success
+   * @return ok on success, empty if there is no value
+   */
+  BufferStatus read(Value &value);
+
+  /**
+   * @return the number of values dropped because the queue was full
+   */
+  [[nodiscard]] uint32_t dropped() const { return dropped_; }
+
+ private:
+  std::array<Value, capacity> buffer_{};
+  volatile HAL::AtomicSize newest_index_ = 0;
+  volatile HAL::AtomicSize oldest_index_ = 0;
+  volatile uint32_t dropped_ = 0;
+};
+
+}  // namespace Util
+}  // namespace Pufferfish
+
+#include "ValueQueue.tpp"
@@ -0,0 +1,60 @@
+/// \file
+/// \brief A lock-free queue for passing every value from an ISR
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+
+#include "ValueQueue.h"
+
+namespace Pufferfish::Util {
+
+template <typename Value, HAL::AtomicSize capacity>
+BufferStatus ValueQueue<Value, capacity>::write(const Value &value) {
+  const HAL::AtomicSize newest = newest_index_;
+  const HAL::AtomicSize next = (newest + 1) % capacity;
+  if (next == oldest_index_) {
+    dropped_ = dropped_ + 1;
+    return BufferStatus::full;
+  }
+
+  buffer_[newest] = value;
+  // The copy must complete before it is published
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  newest_index_ = next;
+  return BufferStatus::ok;
+}
+
+template <typename Value, HAL::AtomicSize capacity>
+BufferStatus ValueQueue<Value, capacity>::read(Value &value) {
+  const HAL::AtomicSize oldest = oldest_index_;
+  if (oldest == newest_index_) {
+    return BufferStatus::empty;
+  }
+
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  value = buffer_[oldest];
+  // The copy must complete before the slot is given back to the writer
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  oldest_index_ = (oldest + 1) % capacity;
+  return BufferStatus::ok;
+}
+
+}  // namespace Pufferfish::Util
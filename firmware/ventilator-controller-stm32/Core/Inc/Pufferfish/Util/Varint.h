@@ -0,0 +1,72 @@
+/// \file
+/// \brief Variable-length integer encoding
+///
+/// Functions for LEB128 varints and zigzag encoding of signed integers, as
+/// used by protobuf, for compact encoding of small numbers and deltas
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pufferfish {
+namespace Util {
+
+// A uint32_t takes at most 5 bytes as a varint
+static const size_t varint_max_size = 5;
+
+/**
+ * Maps a signed integer to an unsigned integer so that numbers of small
+ * magnitude, positive or negative, become small numbers
+ * @param value the signed integer
+ * @return the zigzag encoding of the signed integer
+ */
+inline uint32_t zigzag_encode(int32_t value);
+
+/**
+ * Inverts zigzag_encode
+ * @param value the zigzag encoding of a signed integer
+ * @return the signed integer
+ */
+inline int32_t zigzag_decode(uint32_t value);
+
+/**
+ * Writes a varint into a buffer, which must have room for varint_max_size
+ * bytes
+ * @param value the number to encode
+ * @param buffer[out] output of the encoded bytes
+ * @return the number of bytes written
+ */
+inline size_t write_varint(uint32_t value, uint8_t *buffer);
+
+/**
+ * Reads a varint from a buffer
+ * @param buffer the encoded bytes
+ * @param size the number of bytes available in the buffer
+ * @param value[out] the decoded number
+ * @return the number of bytes read, or 0 if the buffer ends before the
+ * varint does or the varint is too long
+ */
+inline size_t read_varint(const uint8_t *buffer, size_t size, uint32_t &value);
+
+}  // namespace Util
+}  // namespace Pufferfish
+
+#include "Varint.tpp"
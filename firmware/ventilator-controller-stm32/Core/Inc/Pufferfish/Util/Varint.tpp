@@ -0,0 +1,64 @@
+/// \file
+/// \brief Variable-length integer encoding
+///
+/// Functions for LEB128 varints and zigzag encoding of signed integers
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Varint.h"
+
+namespace Pufferfish::Util {
+
+inline uint32_t zigzag_encode(int32_t value) {
+  // Right shift of a negative number is arithmetic on all supported compilers
+  return (static_cast<uint32_t>(value) << 1U) ^ static_cast<uint32_t>(value >> 31);
+}
+
+inline int32_t zigzag_decode(uint32_t value) {
+  return static_cast<int32_t>((value >> 1U) ^ (~(value & 1U) + 1U));
+}
+
+inline size_t write_varint(uint32_t value, uint8_t *buffer) {
+  static const uint32_t continuation = 0x80;
+  size_t size = 0;
+  while (value >= continuation) {
+    buffer[size] = static_cast<uint8_t>(value | continuation);
+    value >>= 7U;
+    ++size;
+  }
+  buffer[size] = static_cast<uint8_t>(value);
+  return size + 1;
+}
+
+inline size_t read_varint(const uint8_t *buffer, size_t size, uint32_t &value) {
+  static const uint8_t continuation = 0x80;
+  static const uint8_t payload_mask = 0x7F;
+  uint32_t result = 0;
+  for (size_t i = 0; i < size && i < varint_max_size; ++i) {
+    result |= static_cast<uint32_t>(buffer[i] & payload_mask) << (7 * i);
+    if ((buffer[i] & continuation) == 0) {
+      value = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace Pufferfish::Util
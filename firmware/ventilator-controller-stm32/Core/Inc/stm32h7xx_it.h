@@ -60,6 +60,19 @@ void USART3_IRQHandler(void);
 void UART4_IRQHandler(void);
 void UART7_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA1_Stream0_IRQHandler(void);
+void DMA1_Stream1_IRQHandler(void);
+void SPI1_IRQHandler(void);
+void BDMA_Channel0_IRQHandler(void);
+void I2C1_EV_IRQHandler(void);
+void I2C1_ER_IRQHandler(void);
+void I2C2_EV_IRQHandler(void);
+void I2C2_ER_IRQHandler(void);
+void I2C4_EV_IRQHandler(void);
+void I2C4_ER_IRQHandler(void);
+void TIM6_DAC_IRQHandler(void);
+void TIM7_IRQHandler(void);
+void TIM8_UP_TIM13_IRQHandler(void);
 
 /* USER CODE END EFP */
 
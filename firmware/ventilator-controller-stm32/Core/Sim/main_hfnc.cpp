@@ -0,0 +1,175 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * main_hfnc.cpp
+ *
+ * Faster-than-real-time simulation of the HFNC control loop: the firmware's
+ * parameters service, control loop, SFM3019 drivers and valve bank run
+ * against the HAL mocks, closed through a fixed-step model of the breathing
+ * circuit. Results only depend on the arguments, never on the host.
+ *
+ * Usage: HFNCSimulator [duration (s)] [flow (L/min)] [FiO2 (%)] [output interval (ms)]
+ * Prints one CSV row per output interval to stdout, then a summary to stderr.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Pufferfish/Application/States.h"
+#include "Pufferfish/Driver/BreathingCircuit/ControlLoop.h"
+#include "Pufferfish/Driver/BreathingCircuit/ParametersService.h"
+#include "Pufferfish/Driver/BreathingCircuit/Plant.h"
+#include "Pufferfish/Driver/I2C/SFM3019/Sensor.h"
+#include "Pufferfish/Driver/ValveBank.h"
+#include "Pufferfish/HAL/Mock/MockI2CDevice.h"
+#include "Pufferfish/HAL/Mock/MockPWM.h"
+#include "Pufferfish/HAL/Mock/MockPWMUpdateGate.h"
+#include "Pufferfish/HAL/Mock/MockSFM3019.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+
+namespace PF = Pufferfish;
+namespace BreathingCircuit = PF::Driver::BreathingCircuit;
+namespace SFM3019 = PF::Driver::I2C::SFM3019;
+
+namespace {
+
+const uint32_t step_duration = 1000;  // us, the period of the control loop's timer
+const uint32_t valve_max_duty = 6400;
+const uint32_t settling_duration = 5000;  // ms, excluded from the summary statistics
+
+struct Options {
+  uint32_t duration = 3600;         // s
+  float flow = 40;                  // L/min
+  float fio2 = 60;                  // %
+  uint32_t output_interval = 1000;  // ms
+};
+
+Options parse_options(int argc, char *argv[]) {
+  Options options;
+  if (argc > 1) {
+    options.duration = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    options.flow = std::strtof(argv[2], nullptr);
+  }
+  if (argc > 3) {
+    options.fio2 = std::strtof(argv[3], nullptr);
+  }
+  if (argc > 4) {
+    options.output_interval = std::strtoul(argv[4], nullptr, 10);
+  }
+  if (options.output_interval == 0) {
+    options.output_interval = 1;
+  }
+  return options;
+}
+
+float opening(const PF::HAL::MockPWM &pwm) {
+  return pwm.get_duty_cycle_raw() / static_cast<float>(valve_max_duty);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const Options options = parse_options(argc, argv);
+
+  // Firmware
+  PF::Application::States all_states;
+  BreathingCircuit::ParametersServices parameters_service;
+
+  PF::HAL::MockTime time;
+  PF::HAL::MockSFM3019 i2c_sfm3019_air;
+  PF::HAL::MockSFM3019 i2c_sfm3019_o2;
+  PF::HAL::MockI2CDevice i2c_global_air;
+  PF::HAL::MockI2CDevice i2c_global_o2;
+  SFM3019::Device sfm3019_dev_air(i2c_sfm3019_air, i2c_global_air, SFM3019::GasType::air);
+  SFM3019::Sensor sfm3019_air(sfm3019_dev_air, true, time);
+  SFM3019::Device sfm3019_dev_o2(i2c_sfm3019_o2, i2c_global_o2, SFM3019::GasType::o2);
+  SFM3019::Sensor sfm3019_o2(sfm3019_dev_o2, true, time);
+
+  PF::HAL::MockPWM valve_air;
+  PF::HAL::MockPWM valve_o2;
+  PF::HAL::MockPWMUpdateGate valves_gate;
+  PF::Driver::PWMValveBank<2> valves({&valve_air, &valve_o2}, valves_gate);
+  valve_air.set_max_duty_cycle(valve_max_duty);
+  valve_o2.set_max_duty_cycle(valve_max_duty);
+  valves.setup();
+
+  BreathingCircuit::HFNCControlLoop hfnc(sfm3019_air, sfm3019_o2, valves);
+
+  // Plant
+  BreathingCircuit::HFNCPlant plant(BreathingCircuit::PlantParameters{}, step_duration);
+
+  ParametersRequest &parameters_request = all_states.parameters_request();
+  parameters_request.mode = VentilationMode_hfnc;
+  parameters_request.ventilating = true;
+  parameters_request.flow = options.flow;
+  parameters_request.fio2 = options.fio2;
+
+  std::printf(
+      "time,flow_setpoint_air,flow_setpoint_o2,flow_air,flow_o2,"
+      "valve_air_opening,valve_o2_opening,paw,fio2,inspired_fio2\n");
+
+  const uint64_t duration_us = static_cast<uint64_t>(options.duration) * 1000000;
+  uint32_t samples = 0;
+  double flow_squared_error = 0;
+  double fio2_squared_error = 0;
+  BreathingCircuit::ControlTelemetry telemetry{};
+  while (plant.elapsed_us() < duration_us) {
+    // Clocks are truncated to 32 bits, wrapping around like the MCU's
+    const uint64_t current_time_us = plant.elapsed_us();
+    const auto current_time = static_cast<uint32_t>(current_time_us / 1000);
+    time.set_micros(static_cast<uint32_t>(current_time_us));
+    time.set_millis(current_time);
+
+    // Main loop
+    sfm3019_air.setup();
+    sfm3019_o2.setup();
+    parameters_service.transform(all_states.parameters_request(), all_states.parameters());
+    hfnc.input(all_states.parameters());
+
+    // Control loop timer interrupt, sampling the plant's flows
+    i2c_sfm3019_air.set_flow(plant.vars().flow_air);
+    i2c_sfm3019_o2.set_flow(plant.vars().flow_o2);
+    hfnc.update(current_time);
+
+    plant.update(opening(valve_air), opening(valve_o2));
+
+    const BreathingCircuit::PlantVars &vars = plant.vars();
+    if (current_time >= settling_duration) {
+      float flow_error = vars.flow_air + vars.flow_o2 - all_states.parameters().flow;
+      float fio2_error = vars.fio2 - all_states.parameters().fio2;
+      flow_squared_error += flow_error * flow_error;
+      fio2_squared_error += fio2_error * fio2_error;
+      ++samples;
+    }
+
+    if (current_time_us % (options.output_interval * 1000ULL) == 0) {
+      hfnc.output(telemetry);
+      std::printf(
+          "%u,%.3f,%.3f,%.3f,%.3f,%.4f,%.4f,%.3f,%.3f,%.3f\n",
+          current_time,
+          telemetry.actuator_setpoints.flow_air,
+          telemetry.actuator_setpoints.flow_o2,
+          vars.flow_air,
+          vars.flow_o2,
+          opening(valve_air),
+          opening(valve_o2),
+          vars.paw,
+          vars.fio2,
+          vars.inspired_fio2);
+    }
+  }
+
+  if (samples > 0) {
+    std::fprintf(
+        stderr,
+        "Simulated %u s: RMS flow error %.4f L/min, RMS FiO2 error %.4f %%\n",
+        options.duration,
+        std::sqrt(flow_squared_error / samples),
+        std::sqrt(fio2_squared_error / samples));
+  }
+  return 0;
+}
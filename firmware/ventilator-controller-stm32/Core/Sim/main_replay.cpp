@@ -0,0 +1,292 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * main_replay.cpp
+ *
+ * Replays a capture of the ventilator's UART and I2C traffic, as streamed
+ * over SWO by Driver::Capture::TraceWriter, through the firmware's real
+ * backend, FDO2, Nonin OEM III and SFM3019 drivers running against the HAL
+ * mocks. The drivers are run once per simulated millisecond, and the wall
+ * time spent parsing each channel's traffic is measured.
+ *
+ * Usage: CaptureReplay <capture file> [speed]
+ * A speed of 1 replays in real time, 10 ten times faster, and 0 (the
+ * default) as fast as possible. Prints a summary of each channel to stdout.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "Pufferfish/Application/States.h"
+#include "Pufferfish/Driver/Capture/Replay.h"
+#include "Pufferfish/Driver/I2C/SFM3019/Sensor.h"
+#include "Pufferfish/Driver/Serial/Backend/Backend.h"
+#include "Pufferfish/Driver/Serial/FDO2/Device.h"
+#include "Pufferfish/Driver/Serial/Nonin/Device.h"
+#include "Pufferfish/HAL/CRCChecker.h"
+#include "Pufferfish/HAL/Mock/MockBufferedUART.h"
+#include "Pufferfish/HAL/Mock/MockI2CDevice.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+
+namespace PF = Pufferfish;
+namespace Capture = PF::Driver::Capture;
+namespace Serial = PF::Driver::Serial;
+namespace SFM3019 = PF::Driver::I2C::SFM3019;
+
+namespace {
+
+const uint64_t step_duration = 1000;  // us, between runs of the drivers
+
+using Clock = std::chrono::steady_clock;
+
+struct TimedRecord {
+  uint64_t time;  // us, unwrapped
+  Capture::Record record;
+};
+
+// Statistics of the replay of one channel
+struct ChannelStats {
+  const char *name;
+  uint32_t records = 0;
+  uint32_t bytes = 0;   // bytes received by the driver
+  uint32_t frames = 0;  // frames or measurements parsed successfully
+  uint32_t errors = 0;  // frames or reads rejected by the driver
+  uint32_t dropped = 0;  // bytes which overflowed the receive buffer
+  Clock::duration parse_time{};
+
+  template <typename Function>
+  void measure(Function function) {
+    Clock::time_point start = Clock::now();
+    function();
+    parse_time += Clock::now() - start;
+  }
+
+  void print() const {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(parse_time).count();
+    std::printf(
+        "%-12s %8u records %9u bytes %8u frames %6u errors %6u dropped %10.0f ns/frame\n",
+        name,
+        records,
+        bytes,
+        frames,
+        errors,
+        dropped,
+        frames > 0 ? static_cast<double>(ns) / frames : 0.0);
+  }
+};
+
+bool read_capture(const char *path, std::vector<TimedRecord> &records, uint32_t &invalid) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  Capture::RecordReceiver receiver;
+  uint64_t previous_time = 0;
+  std::istreambuf_iterator<char> end;
+  for (auto it = std::istreambuf_iterator<char>(file); it != end; ++it) {
+    if (receiver.input(static_cast<uint8_t>(*it)) !=
+        Serial::Backend::FrameProps::InputStatus::output_ready) {
+      continue;
+    }
+
+    TimedRecord timed{};
+    if (receiver.output(timed.record) != Capture::RecordReceiver::Status::ok) {
+      ++invalid;
+      continue;
+    }
+    timed.time = records.empty() ? timed.record.time
+                                 : Capture::unwrap_time(previous_time, timed.record.time);
+    previous_time = timed.time;
+    records.push_back(timed);
+  }
+
+  // Records from different sources are interleaved slightly out of order
+  std::stable_sort(
+      records.begin(), records.end(), [](const TimedRecord &a, const TimedRecord &b) {
+        return a.time < b.time;
+      });
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::fprintf(stderr, "Usage: %s <capture file> [speed]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const double speed = argc > 2 ? std::strtod(argv[2], nullptr) : 0;
+
+  std::vector<TimedRecord> records;
+  uint32_t invalid = 0;
+  if (!read_capture(argv[1], records, invalid)) {
+    std::fprintf(stderr, "Couldn't open %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  if (records.empty()) {
+    std::fprintf(stderr, "No records in %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  PF::HAL::MockTime time;
+  Capture::Replayer replayer(time);
+
+  // Backend
+  PF::HAL::MockLargeBufferedUART backend_uart;
+  PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+  PF::Application::States all_states;
+  Serial::Backend::Backend backend(crc32c, all_states);
+  Capture::UARTReplayTarget<PF::HAL::mock_large_uart_buffer_size, PF::HAL::mock_large_uart_buffer_size>
+      backend_target(backend_uart);
+  replayer.attach(Capture::Channel::backend, backend_target);
+
+  // FDO2
+  PF::HAL::MockLargeBufferedUART fdo2_uart;
+  Serial::FDO2::Device fdo2_dev(fdo2_uart);
+  Capture::UARTReplayTarget<PF::HAL::mock_large_uart_buffer_size, PF::HAL::mock_large_uart_buffer_size>
+      fdo2_target(fdo2_uart);
+  replayer.attach(Capture::Channel::fdo2, fdo2_target);
+
+  // Nonin OEM III
+  PF::HAL::MockReadOnlyBufferedUART nonin_oem_uart;
+  Serial::Nonin::Device nonin_oem_dev(nonin_oem_uart);
+  Capture::UARTReplayTarget<PF::HAL::mock_read_only_uart_buffer_size, 1> nonin_oem_target(
+      nonin_oem_uart);
+  replayer.attach(Capture::Channel::nonin_oem, nonin_oem_target);
+
+  // SFM3019
+  PF::HAL::MockI2CDevice i2c_sfm3019_air;
+  PF::HAL::MockI2CDevice i2c_sfm3019_o2;
+  PF::HAL::MockI2CDevice i2c_global_air;
+  PF::HAL::MockI2CDevice i2c_global_o2;
+  SFM3019::Device sfm3019_dev_air(i2c_sfm3019_air, i2c_global_air, SFM3019::GasType::air);
+  SFM3019::Sensor sfm3019_air(sfm3019_dev_air, true, time);
+  SFM3019::Device sfm3019_dev_o2(i2c_sfm3019_o2, i2c_global_o2, SFM3019::GasType::o2);
+  SFM3019::Sensor sfm3019_o2(sfm3019_dev_o2, true, time);
+  Capture::I2CReplayTarget sfm3019_air_target(i2c_sfm3019_air);
+  Capture::I2CReplayTarget sfm3019_o2_target(i2c_sfm3019_o2);
+  replayer.attach(Capture::Channel::sfm3019_air, sfm3019_air_target);
+  replayer.attach(Capture::Channel::sfm3019_o2, sfm3019_o2_target);
+
+  std::array<ChannelStats, 5> stats{
+      {{"backend"}, {"fdo2"}, {"nonin_oem"}, {"sfm3019_air"}, {"sfm3019_o2"}}};
+  ChannelStats &backend_stats = stats[static_cast<size_t>(Capture::Channel::backend)];
+  ChannelStats &fdo2_stats = stats[static_cast<size_t>(Capture::Channel::fdo2)];
+  ChannelStats &nonin_oem_stats = stats[static_cast<size_t>(Capture::Channel::nonin_oem)];
+  std::array<SFM3019::Sensor *, 2> sfm3019_sensors{{&sfm3019_air, &sfm3019_o2}};
+  std::array<SFM3019::Sample, 2> sfm3019_samples{};
+  std::array<ChannelStats *, 2> sfm3019_stats{
+      {&stats[static_cast<size_t>(Capture::Channel::sfm3019_air)],
+       &stats[static_cast<size_t>(Capture::Channel::sfm3019_o2)]}};
+
+  const uint64_t start_time = records.front().time;
+  const uint64_t end_time = records.back().time + step_duration;
+  const Clock::time_point wall_start = Clock::now();
+  size_t next_record = 0;
+  size_t nonin_oem_pending = 0;
+  for (uint64_t current_time = start_time; current_time < end_time;
+       current_time += step_duration) {
+    // Traffic
+    while (next_record < records.size() && records[next_record].time <= current_time) {
+      const Capture::Record &record = records[next_record].record;
+      replayer.input(record);
+      if (record.channel < stats.size()) {
+        ++stats[record.channel].records;
+        if (record.kind == Capture::RecordKind::uart_rx ||
+            record.kind == Capture::RecordKind::i2c_read) {
+          stats[record.channel].bytes += record.size;
+        }
+      }
+      if (record.channel == static_cast<uint8_t>(Capture::Channel::nonin_oem)) {
+        nonin_oem_pending += record.size;
+      }
+      ++next_record;
+    }
+    time.set_micros(static_cast<uint32_t>(current_time));
+    time.set_millis(static_cast<uint32_t>(current_time / 1000));
+
+    // Drivers
+    backend_stats.measure([&] {
+      uint8_t byte = 0;
+      while (backend_uart.read(byte) == PF::BufferStatus::ok) {
+        switch (backend.input(byte)) {
+          case Serial::Backend::Backend::Status::ok:
+            ++backend_stats.frames;
+            break;
+          case Serial::Backend::Backend::Status::invalid:
+            ++backend_stats.errors;
+            break;
+          default:
+            break;
+        }
+      }
+    });
+    fdo2_stats.measure([&] {
+      Serial::FDO2::Response response{};
+      while (fdo2_dev.receive(response) == Serial::FDO2::Device::Status::ok) {
+        ++fdo2_stats.frames;
+      }
+    });
+    nonin_oem_stats.measure([&] {
+      // Each call parses at most one byte
+      for (; nonin_oem_pending > 0; --nonin_oem_pending) {
+        PF::Driver::Serial::Nonin::PacketMeasurements measurements{};
+        switch (nonin_oem_dev.output(measurements)) {
+          case Serial::Nonin::Device::PacketStatus::available:
+            ++nonin_oem_stats.frames;
+            break;
+          case Serial::Nonin::Device::PacketStatus::framing_error:
+          case Serial::Nonin::Device::PacketStatus::missed_data:
+            ++nonin_oem_stats.errors;
+            break;
+          default:
+            break;
+        }
+      }
+    });
+    for (size_t i = 0; i < sfm3019_sensors.size(); ++i) {
+      sfm3019_stats[i]->measure([&] {
+        SFM3019::Sensor &sensor = *sfm3019_sensors[i];
+        if (sensor.setup() != PF::InitializableState::ok) {
+          return;
+        }
+        SFM3019::Sample &sample = sfm3019_samples[i];
+        const uint32_t previous_time = sample.time_us;
+        if (sensor.output(sample) == PF::InitializableState::failed) {
+          ++sfm3019_stats[i]->errors;
+        } else if (sample.time_us != previous_time) {
+          ++sfm3019_stats[i]->frames;
+        }
+      });
+    }
+
+    if (speed > 0) {
+      auto elapsed = std::chrono::microseconds(
+          static_cast<int64_t>(static_cast<double>(current_time - start_time) / speed));
+      std::this_thread::sleep_until(wall_start + elapsed);
+    }
+  }
+
+  backend_stats.dropped = backend_target.dropped();
+  fdo2_stats.dropped = fdo2_target.dropped();
+  nonin_oem_stats.dropped = nonin_oem_target.dropped();
+  std::printf(
+      "Replayed %.3f s of traffic from %zu records (%u invalid frames, %u unattached records)\n",
+      static_cast<double>(end_time - start_time) / 1e6,
+      records.size(),
+      invalid,
+      replayer.unattached());
+  for (const ChannelStats &channel : stats) {
+    channel.print();
+  }
+  return EXIT_SUCCESS;
+}
@@ -9,6 +9,8 @@
 
 #include "Pufferfish/AlarmsManager.h"
 
+#include "Pufferfish/Util/Bytes.h"
+
 namespace Pufferfish {
 
 AlarmManagerStatus Pufferfish::AlarmsManager::add(AlarmStatus a) {
@@ -19,6 +21,7 @@ AlarmManagerStatus Pufferfish::AlarmsManager::add(AlarmStatus a) {
   }
 
   alarms_cnt_[ind]++;
+  active_mask_ |= alarm_bit(ind);
   this->update_active();
 
   return AlarmManagerStatus::ok;
@@ -36,6 +39,9 @@ AlarmManagerStatus Pufferfish::AlarmsManager::remove(AlarmStatus a) {
   }
 
   alarms_cnt_[ind]--;
+  if (alarms_cnt_[ind] == 0) {
+    active_mask_ &= ~alarm_bit(ind);
+  }
   this->update_active();
 
   return AlarmManagerStatus::ok;
@@ -45,6 +51,7 @@ void AlarmsManager::clear_all() {
   for (int i = 0; i < static_cast<int>(AlarmStatus::no_alarm); i++) {
     alarms_cnt_[i] = 0;
   }
+  active_mask_ = 0;
 
   this->update_active();
 }
@@ -70,21 +77,18 @@ AlarmStatus Pufferfish::AlarmsManager::get_active() {
 }
 
 void Pufferfish::AlarmsManager::update_active() {
-  for (int i = 0; i < static_cast<int>(AlarmStatus::no_alarm); i++) {
-    if (alarms_cnt_[i] > 0) {
-      if (static_cast<AlarmStatus>(i) != active_) {
-        led_.set_alarm(static_cast<AlarmStatus>(i));
-        auditory_.set_alarm(static_cast<AlarmStatus>(i));
-      }
-
-      active_ = static_cast<AlarmStatus>(i);
-      return;
-    }
+  // Alarms are ordered by priority from the most significant bit, and the
+  // count of leading zeros of an empty mask is no_alarm
+  auto active = static_cast<AlarmStatus>(Util::count_leading_zeros(active_mask_));
+  if (active > AlarmStatus::no_alarm) {
+    active = AlarmStatus::no_alarm;
   }
 
-  led_.set_alarm(AlarmStatus::no_alarm);
-  auditory_.set_alarm(AlarmStatus::no_alarm);
-  active_ = AlarmStatus::no_alarm;
+  if (active != active_ || active == AlarmStatus::no_alarm) {
+    led_.set_alarm(active);
+    auditory_.set_alarm(active);
+  }
+  active_ = active;
 }
 
 }  // namespace Pufferfish
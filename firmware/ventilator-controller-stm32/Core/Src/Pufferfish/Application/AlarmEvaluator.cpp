@@ -0,0 +1,148 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * AlarmEvaluator.cpp
+ *
+ * Checks measurements against the alarm limits, raising and clearing patient
+ * alarms
+ */
+
+#include "Pufferfish/Application/AlarmEvaluator.h"
+
+#include "Pufferfish/Util/Bytes.h"
+#include "Pufferfish/Util/Timeouts.h"
+
+namespace Pufferfish::Application {
+
+AlarmEvaluator::AlarmEvaluator(const Rules &rules) : rules_(rules) {
+  for (size_t i = 0; i < rule_count; ++i) {
+    input_rules_[static_cast<size_t>(rules_[i].input)] |= rule_bit(i);
+  }
+}
+
+void AlarmEvaluator::input(const AlarmLimits &alarm_limits) {
+  input_limit(AlarmInput::fio2, alarm_limits.has_fio2, alarm_limits.fio2);
+  input_limit(AlarmInput::spo2, alarm_limits.has_spo2, alarm_limits.spo2);
+  input_limit(AlarmInput::hr, alarm_limits.has_hr, alarm_limits.hr);
+  input_limit(AlarmInput::rr, alarm_limits.has_rr, alarm_limits.rr);
+}
+
+void AlarmEvaluator::input(const SensorMeasurements &sensor_measurements) {
+  input_value(AlarmInput::fio2, sensor_measurements.fio2);
+  input_value(AlarmInput::spo2, sensor_measurements.spo2);
+  input_value(AlarmInput::hr, sensor_measurements.hr);
+}
+
+void AlarmEvaluator::input(const CycleMeasurements &cycle_measurements) {
+  input_value(AlarmInput::rr, cycle_measurements.rr);
+}
+
+void AlarmEvaluator::update(uint32_t current_time) {
+  raised_ = 0;
+  cleared_ = 0;
+
+  uint32_t rules = pending_;
+  for (size_t i = 0; i < input_count; ++i) {
+    if ((changed_ & input_bit(static_cast<AlarmInput>(i))) != 0) {
+      rules |= input_rules_[i];
+    }
+  }
+  changed_ = 0;
+
+  while (rules != 0) {
+    size_t rule = Util::count_leading_zeros(rules);
+    rules &= ~rule_bit(rule);
+    evaluate(rule, current_time);
+  }
+}
+
+bool AlarmEvaluator::output(AlarmTransition &transition) {
+  uint32_t &transitions = raised_ != 0 ? raised_ : cleared_;
+  if (transitions == 0) {
+    return false;
+  }
+
+  size_t rule = Util::count_leading_zeros(transitions);
+  transition.code = rules_[rule].code;
+  transition.priority = rules_[rule].priority;
+  transition.active = &transitions == &raised_;
+  transitions &= ~rule_bit(rule);
+  return true;
+}
+
+bool AlarmEvaluator::highest(LogEventCode &code) const {
+  if (active_ == 0) {
+    return false;
+  }
+
+  code = rules_[Util::count_leading_zeros(active_)].code;
+  return true;
+}
+
+void AlarmEvaluator::input_value(AlarmInput input, float value) {
+  auto index = static_cast<size_t>(input);
+  if ((received_ & input_bit(input)) != 0 && values_[index] == value) {
+    return;
+  }
+
+  values_[index] = value;
+  received_ |= input_bit(input);
+  changed_ |= input_bit(input);
+}
+
+void AlarmEvaluator::input_limit(AlarmInput input, bool set, const Range &range) {
+  Limit &limit = limits_[static_cast<size_t>(input)];
+  if (limit.set == set && limit.range.lower == range.lower && limit.range.upper == range.upper) {
+    return;
+  }
+
+  limit.set = set;
+  limit.range = range;
+  changed_ |= input_bit(input);
+}
+
+void AlarmEvaluator::evaluate(size_t rule, uint32_t current_time) {
+  const AlarmRule &alarm = rules_[rule];
+  const uint32_t bit = rule_bit(rule);
+  const auto index = static_cast<size_t>(alarm.input);
+  const Limit &limit = limits_[index];
+
+  if (!limit.set || (received_ & input_bit(alarm.input)) == 0) {
+    pending_ &= ~bit;
+    if ((active_ & bit) != 0) {
+      active_ &= ~bit;
+      cleared_ |= bit;
+    }
+    return;
+  }
+
+  const float value = values_[index];
+  const auto threshold = static_cast<float>(alarm.upper ? limit.range.upper : limit.range.lower);
+  if ((active_ & bit) != 0) {
+    bool recovered = alarm.upper ? value <= threshold - alarm.hysteresis
+                                 : value >= threshold + alarm.hysteresis;
+    if (recovered) {
+      active_ &= ~bit;
+      cleared_ |= bit;
+    }
+    return;
+  }
+
+  bool violated = alarm.upper ? value > threshold : value < threshold;
+  if (!violated) {
+    pending_ &= ~bit;
+    return;
+  }
+
+  if ((pending_ & bit) == 0) {
+    pending_ |= bit;
+    pending_since_[rule] = current_time;
+  }
+  if (!Util::within_timeout(pending_since_[rule], alarm.persistence, current_time)) {
+    pending_ &= ~bit;
+    active_ |= bit;
+    raised_ |= bit;
+  }
+}
+
+}  // namespace Pufferfish::Application
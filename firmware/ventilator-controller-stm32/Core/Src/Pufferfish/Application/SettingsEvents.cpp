@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * SettingsEvents.cpp
+ *
+ * Detects changes of the parameters and alarm limits as log events
+ */
+
+#include "Pufferfish/Application/SettingsEvents.h"
+
+namespace Pufferfish::Application {
+
+void SettingsEvents::input(
+    uint32_t current_time, const Parameters &parameters, const AlarmLimits &alarm_limits) {
+  if (!initialized_) {
+    parameters_ = parameters;
+    alarm_limits_ = alarm_limits;
+    initialized_ = true;
+    return;
+  }
+
+  if (parameters.ventilating != parameters_.ventilating) {
+    const LogEventCode code = LogEventCode_ventilation_operation_changed;
+    const bool first = !pending(code);
+    LogEvent &event = change(current_time, code, LogEventType_control);
+    if (first) {
+      event.old_bool = parameters_.ventilating;
+    }
+    event.new_bool = parameters.ventilating;
+  }
+  if (parameters.mode != parameters_.mode) {
+    const LogEventCode code = LogEventCode_ventilation_mode_changed;
+    const bool first = !pending(code);
+    LogEvent &event = change(current_time, code, LogEventType_control);
+    if (first) {
+      event.old_mode = parameters_.mode;
+    }
+    event.new_mode = parameters.mode;
+  }
+  input_float(current_time, LogEventCode_fio2_setting_changed, parameters_.fio2, parameters.fio2);
+  input_float(current_time, LogEventCode_flow_setting_changed, parameters_.flow, parameters.flow);
+  input_range(
+      current_time,
+      LogEventCode_fio2_alarm_limits_changed,
+      alarm_limits_.has_fio2,
+      alarm_limits_.fio2,
+      alarm_limits.has_fio2,
+      alarm_limits.fio2);
+  input_range(
+      current_time,
+      LogEventCode_spo2_alarm_limits_changed,
+      alarm_limits_.has_spo2,
+      alarm_limits_.spo2,
+      alarm_limits.has_spo2,
+      alarm_limits.spo2);
+  input_range(
+      current_time,
+      LogEventCode_hr_alarm_limits_changed,
+      alarm_limits_.has_hr,
+      alarm_limits_.hr,
+      alarm_limits.has_hr,
+      alarm_limits.hr);
+
+  parameters_ = parameters;
+  alarm_limits_ = alarm_limits;
+}
+
+bool SettingsEvents::output(LogEvent &event) {
+  for (size_t i = 0; i < code_count; ++i) {
+    const auto code = static_cast<LogEventCode>(LogEventCode_ventilation_operation_changed + i);
+    if (pending(code)) {
+      event = events_.at(i);
+      pending_ &= static_cast<uint8_t>(~bit(code));
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t SettingsEvents::bit(LogEventCode code) {
+  return static_cast<uint8_t>(1U << (code - LogEventCode_ventilation_operation_changed));
+}
+
+bool SettingsEvents::pending(LogEventCode code) const {
+  return (pending_ & bit(code)) != 0;
+}
+
+LogEvent &SettingsEvents::change(uint32_t current_time, LogEventCode code, LogEventType type) {
+  LogEvent &event = events_.at(code - LogEventCode_ventilation_operation_changed);
+  if (!pending(code)) {
+    event = LogEvent{};
+    event.code = code;
+    event.type = type;
+    pending_ |= bit(code);
+  }
+  event.time = current_time;
+  return event;
+}
+
+void SettingsEvents::input_float(
+    uint32_t current_time, LogEventCode code, float previous, float value) {
+  if (value == previous) {
+    return;
+  }
+
+  const bool first = !pending(code);
+  LogEvent &event = change(current_time, code, LogEventType_control);
+  if (first) {
+    event.old_float = previous;
+  }
+  event.new_float = value;
+}
+
+void SettingsEvents::input_range(
+    uint32_t current_time,
+    LogEventCode code,
+    bool previous_set,
+    const Range &previous,
+    bool set,
+    const Range &range) {
+  if (previous_set == set && previous.lower == range.lower && previous.upper == range.upper) {
+    return;
+  }
+
+  const bool first = !pending(code);
+  LogEvent &event = change(current_time, code, LogEventType_alarm_limits);
+  if (first) {
+    event.has_old_range = previous_set;
+    event.old_range = previous;
+  }
+  event.has_new_range = set;
+  event.new_range = range;
+}
+
+}  // namespace Pufferfish::Application
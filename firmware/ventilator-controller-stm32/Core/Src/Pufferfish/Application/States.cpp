@@ -42,6 +42,11 @@ STATESEGMENT_TAGGED_SETTER(Parameters, parameters)
 STATESEGMENT_TAGGED_SETTER(ParametersRequest, parameters_request)
 STATESEGMENT_TAGGED_SETTER(AlarmLimits, alarm_limits)
 STATESEGMENT_TAGGED_SETTER(AlarmLimitsRequest, alarm_limits_request)
+STATESEGMENT_TAGGED_SETTER(ExpectedLogEvent, expected_log_event)
+STATESEGMENT_TAGGED_SETTER(NextLogEvents, next_log_events)
+STATESEGMENT_TAGGED_SETTER(MemoryUsage, memory_usage)
+STATESEGMENT_TAGGED_SETTER(RecorderChunk, recorder_chunk)
+STATESEGMENT_TAGGED_SETTER(RecorderChunkRequest, recorder_chunk_request)
 
 }  // namespace Pufferfish::Util
 
@@ -53,10 +58,22 @@ const ParametersRequest &States::parameters_request() const {
   return state_segments_.parameters_request;
 }
 
+ParametersRequest &States::parameters_request() {
+  return state_segments_.parameters_request;
+}
+
 Parameters &States::parameters() {
   return state_segments_.parameters;
 }
 
+AlarmLimitsRequest &States::alarm_limits_request() {
+  return state_segments_.alarm_limits_request;
+}
+
+AlarmLimits &States::alarm_limits() {
+  return state_segments_.alarm_limits;
+}
+
 SensorMeasurements &States::sensor_measurements() {
   return state_segments_.sensor_measurements;
 }
@@ -65,6 +82,26 @@ CycleMeasurements &States::cycle_measurements() {
   return state_segments_.cycle_measurements;
 }
 
+const ExpectedLogEvent &States::expected_log_event() const {
+  return state_segments_.expected_log_event;
+}
+
+NextLogEvents &States::next_log_events() {
+  return state_segments_.next_log_events;
+}
+
+MemoryUsage &States::memory_usage() {
+  return state_segments_.memory_usage;
+}
+
+RecorderChunk &States::recorder_chunk() {
+  return state_segments_.recorder_chunk;
+}
+
+const RecorderChunkRequest &States::recorder_chunk_request() const {
+  return state_segments_.recorder_chunk_request;
+}
+
 States::InputStatus States::input(const StateSegment &input) {
   switch (input.tag) {
     case MessageTypes::sensor_measurements:
@@ -85,6 +122,21 @@ States::InputStatus States::input(const StateSegment &input) {
     case MessageTypes::alarm_limits_request:
       STATESEGMENT_GET_TAGGED(alarm_limits_request, input);
       return InputStatus::ok;
+    case MessageTypes::expected_log_event:
+      STATESEGMENT_GET_TAGGED(expected_log_event, input);
+      return InputStatus::ok;
+    case MessageTypes::next_log_events:
+      STATESEGMENT_GET_TAGGED(next_log_events, input);
+      return InputStatus::ok;
+    case MessageTypes::memory_usage:
+      STATESEGMENT_GET_TAGGED(memory_usage, input);
+      return InputStatus::ok;
+    case MessageTypes::recorder_chunk:
+      STATESEGMENT_GET_TAGGED(recorder_chunk, input);
+      return InputStatus::ok;
+    case MessageTypes::recorder_chunk_request:
+      STATESEGMENT_GET_TAGGED(recorder_chunk_request, input);
+      return InputStatus::ok;
     default:
       return InputStatus::invalid_type;
   }
@@ -110,6 +162,21 @@ States::OutputStatus States::output(MessageTypes type, StateSegment &output) con
     case MessageTypes::alarm_limits_request:
       output.set(state_segments_.alarm_limits_request);
       return OutputStatus::ok;
+    case MessageTypes::expected_log_event:
+      output.set(state_segments_.expected_log_event);
+      return OutputStatus::ok;
+    case MessageTypes::next_log_events:
+      output.set(state_segments_.next_log_events);
+      return OutputStatus::ok;
+    case MessageTypes::memory_usage:
+      output.set(state_segments_.memory_usage);
+      return OutputStatus::ok;
+    case MessageTypes::recorder_chunk:
+      output.set(state_segments_.recorder_chunk);
+      return OutputStatus::ok;
+    case MessageTypes::recorder_chunk_request:
+      output.set(state_segments_.recorder_chunk_request);
+      return OutputStatus::ok;
     default:
       return OutputStatus::invalid_type;
   }
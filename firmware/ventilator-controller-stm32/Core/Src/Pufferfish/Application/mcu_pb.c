@@ -57,6 +57,15 @@ PB_BIND(AlarmMute, AlarmMute, AUTO)
 PB_BIND(AlarmMuteRequest, AlarmMuteRequest, AUTO)
 
 
+PB_BIND(MemoryUsage, MemoryUsage, AUTO)
+
+
+PB_BIND(RecorderChunk, RecorderChunk, AUTO)
+
+
+PB_BIND(RecorderChunkRequest, RecorderChunkRequest, AUTO)
+
+
 
 
 
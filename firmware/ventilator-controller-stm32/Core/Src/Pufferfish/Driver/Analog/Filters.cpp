@@ -0,0 +1,68 @@
+/// Filters.cpp
+/// Fixed-cost digital filters for conditioning sensor signals one sample at
+/// a time: biquad IIR cascades, FIR filters, running medians and spike
+/// rejection.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Pufferfish/Driver/Analog/Filters.h"
+
+#include <cmath>
+
+namespace Pufferfish::Driver::Analog {
+
+BiquadCoefficients lowpass_biquad(float cutoff, float sample_rate, float q) {
+  static constexpr float pi = 3.14159265F;
+
+  const float omega = 2 * pi * cutoff / sample_rate;
+  const float cos_omega = std::cos(omega);
+  const float alpha = std::sin(omega) / (2 * q);
+  const float a0 = 1 + alpha;
+  return BiquadCoefficients{
+      (1 - cos_omega) / 2 / a0,
+      (1 - cos_omega) / a0,
+      (1 - cos_omega) / 2 / a0,
+      -2 * cos_omega / a0,
+      (1 - alpha) / a0};
+}
+
+// SpikeRejector
+
+float SpikeRejector::input(float sample) {
+  // Non-finite samples would poison every later filter state
+  bool spike = !std::isfinite(sample);
+  if (!spike && consecutive_ < max_rejections_) {
+    spike = std::abs(sample - previous_) > max_step_;
+  }
+  if (spike) {
+    ++consecutive_;
+    ++rejected_;
+    return previous_;
+  }
+
+  consecutive_ = 0;
+  previous_ = sample;
+  return sample;
+}
+
+void SpikeRejector::reset(float value) {
+  previous_ = value;
+  consecutive_ = 0;
+}
+
+}  // namespace Pufferfish::Driver::Analog
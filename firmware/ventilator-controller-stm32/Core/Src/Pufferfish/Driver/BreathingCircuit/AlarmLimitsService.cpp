@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * AlarmLimitsService.cpp
+ *
+ * Servicing of alarm limits requests into the alarm limits which are in
+ * effect, for each ventilation mode
+ */
+
+#include "Pufferfish/Driver/BreathingCircuit/AlarmLimitsService.h"
+
+namespace Pufferfish::Driver::BreathingCircuit {
+
+// AlarmLimitsService
+
+void AlarmLimitsService::transform_range(
+    bool has_request,
+    const Range &request,
+    uint32_t floor,
+    uint32_t ceiling,
+    bool &has_response,
+    Range &response) {
+  if (!has_request) {
+    return;
+  }
+
+  if (floor <= request.lower && request.lower <= request.upper && request.upper <= ceiling) {
+    has_response = true;
+    response = request;
+  }
+}
+
+void AlarmLimitsService::transform_common(
+    const AlarmLimitsRequest &alarm_limits_request, AlarmLimits &alarm_limits) {
+  transform_range(
+      alarm_limits_request.has_fio2,
+      alarm_limits_request.fio2,
+      fio2_floor,
+      fio2_ceiling,
+      alarm_limits.has_fio2,
+      alarm_limits.fio2);
+  transform_range(
+      alarm_limits_request.has_spo2,
+      alarm_limits_request.spo2,
+      spo2_floor,
+      spo2_ceiling,
+      alarm_limits.has_spo2,
+      alarm_limits.spo2);
+  transform_range(
+      alarm_limits_request.has_hr,
+      alarm_limits_request.hr,
+      hr_floor,
+      hr_ceiling,
+      alarm_limits.has_hr,
+      alarm_limits.hr);
+}
+
+// PCAC Alarm Limits
+
+void PCACAlarmLimits::transform(
+    const AlarmLimitsRequest &alarm_limits_request, AlarmLimits &alarm_limits) {
+  transform_common(alarm_limits_request, alarm_limits);
+  transform_range(
+      alarm_limits_request.has_rr,
+      alarm_limits_request.rr,
+      rr_floor,
+      rr_ceiling,
+      alarm_limits.has_rr,
+      alarm_limits.rr);
+}
+
+// HFNC Alarm Limits
+
+void HFNCAlarmLimits::transform(
+    const AlarmLimitsRequest &alarm_limits_request, AlarmLimits &alarm_limits) {
+  transform_common(alarm_limits_request, alarm_limits);
+}
+
+// AlarmLimitsServices
+
+void AlarmLimitsServices::transform(
+    const Parameters &parameters,
+    const AlarmLimitsRequest &alarm_limits_request,
+    AlarmLimits &alarm_limits) {
+  switch (parameters.mode) {
+    case VentilationMode_pc_ac:
+      active_service_ = &pc_ac_;
+      break;
+    case VentilationMode_hfnc:
+      active_service_ = &hfnc_;
+      break;
+    default:
+      active_service_ = nullptr;
+      break;
+  }
+  if (active_service_ == nullptr) {
+    return;
+  }
+
+  active_service_->transform(alarm_limits_request, alarm_limits);
+}
+
+AlarmLimits AlarmLimitsServices::default_alarm_limits() {
+  AlarmLimits alarm_limits{};
+  alarm_limits.has_fio2 = true;
+  alarm_limits.fio2 = default_fio2;
+  alarm_limits.has_spo2 = true;
+  alarm_limits.spo2 = default_spo2;
+  alarm_limits.has_hr = true;
+  alarm_limits.hr = default_hr;
+  alarm_limits.has_rr = true;
+  alarm_limits.rr = default_rr;
+  return alarm_limits;
+}
+
+}  // namespace Pufferfish::Driver::BreathingCircuit
@@ -12,16 +12,27 @@ namespace Pufferfish::Driver::BreathingCircuit {
 // PI
 
 void PI::transform(float measurement, float setpoint, float &actuation) {
+  transform(measurement, setpoint, 0, actuation);
+}
+
+void PI::transform(float measurement, float setpoint, float feedforward, float &actuation) {
   error_ = setpoint - measurement;
-  error_integral_ += error_;
-  if (error_integral_ < i_min) {
-    error_integral_ = i_min;
+
+  // The integral only ever needs to span the range of the actuation, and
+  // stops winding up further while the actuation is saturated
+  float proportional = feedforward + error_ * gains_.p;
+  float unsaturated = proportional + integral_;
+  if (!(unsaturated >= out_max && error_ > 0) && !(unsaturated <= out_min && error_ < 0)) {
+    integral_ += error_ * gains_.i;
   }
-  if (error_integral_ > i_max) {
-    error_integral_ = i_max;
+  if (integral_ < out_min - feedforward) {
+    integral_ = out_min - feedforward;
+  }
+  if (integral_ > out_max - feedforward) {
+    integral_ = out_max - feedforward;
   }
 
-  actuation = error_ * p_gain + error_integral_ * i_gain;
+  actuation = proportional + integral_;
   if (actuation < out_min) {
     actuation = out_min;
   }
@@ -30,4 +41,8 @@ void PI::transform(float measurement, float setpoint, float &actuation) {
   }
 }
 
+void PI::set_gains(const PIGains &gains) {
+  gains_ = gains;
+}
+
 }  // namespace Pufferfish::Driver::BreathingCircuit
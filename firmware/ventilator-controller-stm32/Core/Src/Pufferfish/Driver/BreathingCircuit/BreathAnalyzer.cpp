@@ -0,0 +1,136 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * BreathAnalyzer.cpp
+ *
+ * Streaming computation of breath cycle measurements from airway flow and
+ * pressure samples
+ */
+
+#include "Pufferfish/Driver/BreathingCircuit/BreathAnalyzer.h"
+
+namespace Pufferfish::Driver::BreathingCircuit {
+
+void BreathAnalyzer::input(uint32_t time, float flow, float paw) {
+  uint32_t interval = time - previous_time_;
+  if (sampled_ && interval == 0) {
+    return;
+  }
+  if (sampled_ && interval > max_sample_interval) {
+    reset();
+  }
+
+  // The sample at a phase transition belongs to the new phase
+  const bool settled = time - phase_start_time_ >= min_phase_duration;
+  switch (phase_) {
+    case Phase::unknown:
+      // A breath which is already in progress can't be measured
+      if (flow > insp_flow_threshold) {
+        phase_ = Phase::inspiratory;
+        phase_start_time_ = time;
+      } else if (flow < exp_flow_threshold) {
+        start_expiration(time, paw);
+      }
+      break;
+    case Phase::inspiratory:
+      if (settled && flow < exp_flow_threshold) {
+        start_expiration(time, paw);
+      }
+      break;
+    case Phase::expiratory:
+      if (settled && flow > insp_flow_threshold) {
+        start_breath(time, paw);
+      }
+      break;
+  }
+
+  if (sampled_) {
+    accumulate(interval, flow, paw);
+  }
+  sampled_ = true;
+  previous_time_ = time;
+  previous_flow_ = flow;
+}
+
+bool BreathAnalyzer::output(CycleMeasurements &cycle_measurements) {
+  if (!available_) {
+    return false;
+  }
+
+  cycle_measurements = measurements_;
+  available_ = false;
+  return true;
+}
+
+void BreathAnalyzer::reset() {
+  *this = BreathAnalyzer{};
+}
+
+void BreathAnalyzer::start_breath(uint32_t time, float paw) {
+  // Only a breath whose start was seen is complete
+  if (breath_started_) {
+    uint32_t duration = time - breath_start_time_;
+    measurements_.time = time;
+    measurements_.vt = insp_volume_;
+    measurements_.rr = ms_per_min / static_cast<float>(duration);
+    measurements_.peep = end_exp_paw_;
+    measurements_.pip = peak_paw_;
+    measurements_.ip =
+        insp_duration_ > 0 ? insp_paw_integral_ / static_cast<float>(insp_duration_) : 0;
+
+    // Weighting each breath by its duration approximates a one-minute window
+    float breath_ve = insp_volume_ / ml_per_l * measurements_.rr;
+    if (!ve_initialized_ || duration >= ve_window) {
+      ve_ = breath_ve;
+      ve_initialized_ = true;
+    } else {
+      ve_ += (breath_ve - ve_) * static_cast<float>(duration) / ve_window;
+    }
+    measurements_.ve = ve_;
+    available_ = true;
+  }
+
+  breath_started_ = true;
+  breath_start_time_ = time;
+  phase_ = Phase::inspiratory;
+  phase_start_time_ = time;
+  volume_ = 0;
+  insp_volume_ = 0;
+  peak_paw_ = paw;
+  insp_paw_integral_ = 0;
+  insp_duration_ = 0;
+}
+
+void BreathAnalyzer::start_expiration(uint32_t time, float paw) {
+  phase_ = Phase::expiratory;
+  phase_start_time_ = time;
+  end_exp_paw_ = paw;
+}
+
+void BreathAnalyzer::accumulate(uint32_t interval, float flow, float paw) {
+  const auto duration = static_cast<float>(interval);
+
+  // Trapezoidal integration of the flow
+  float delta_volume = (previous_flow_ + flow) / 2 * duration / ms_per_min * ml_per_l;
+  volume_ += delta_volume;
+  if (paw > peak_paw_) {
+    peak_paw_ = paw;
+  }
+
+  switch (phase_) {
+    case Phase::inspiratory:
+      insp_volume_ += delta_volume;
+      insp_paw_integral_ += paw * duration;
+      insp_duration_ += interval;
+      break;
+    case Phase::expiratory:
+      // Low-pass filtered, so that the value at the end of expiration is
+      // robust to noise
+      end_exp_paw_ += (paw - end_exp_paw_) * duration / (peep_time_constant + duration);
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace Pufferfish::Driver::BreathingCircuit
@@ -7,67 +7,209 @@
 
 #include "Pufferfish/Driver/BreathingCircuit/ControlLoop.h"
 
-#include "Pufferfish/Util/Timeouts.h"
-
 namespace Pufferfish::Driver::BreathingCircuit {
 
 // ControlLoop
 
-void ControlLoop::advance_step_time(uint32_t current_time) {
-  previous_step_time_ = current_time;
+void ControlLoop::input(const Parameters &parameters) {
+  parameters_.write(parameters);
+}
+
+void ControlLoop::output(ControlTelemetry &telemetry) const {
+  telemetry_.read(telemetry);
 }
 
-uint32_t ControlLoop::step_duration(uint32_t current_time) const {
-  return current_time - previous_step_time_;
+bool ControlLoop::take_step(ControlTelemetry &step) {
+  return steps_.read(step) == BufferStatus::ok;
 }
 
-bool ControlLoop::update_needed(uint32_t current_time) const {
-  return !Util::within_timeout(previous_step_time_, update_interval, current_time);
+void ControlLoop::publish(const ControlTelemetry &step) {
+  telemetry_.write(step);
+  steps_.write(step);
 }
 
 // HFNC ControlLoop
 
-SensorVars &HFNCControlLoop::sensor_vars() {
-  return sensor_vars_;
+HFNCControlLoop::FlowConditioner::Config HFNCControlLoop::default_flow_conditioning() {
+  FlowConditioner::ChannelConfig flow;
+  flow.max_step = flow_max_step;
+  flow.max_rejections = flow_max_rejections;
+  flow.median = true;
+  flow.biquads = {Analog::lowpass_biquad(flow_cutoff, control_rate)};
+  return FlowConditioner::Config{flow, flow};
+}
+
+void HFNCControlLoop::update(uint32_t current_time) {
+  parameters_.read(parameters_step_);
+  if (characterization_.writes() != characterization_writes_) {
+    characterization_writes_ = characterization_.writes();
+    ValveCharacterization characterization{};
+    characterization_.read(characterization);
+    controller_.set_characterization(characterization);
+  }
+  if (gains_.writes() != gains_writes_) {
+    gains_writes_ = gains_.writes();
+    PIGains gains{};
+    gains_.read(gains);
+    controller_.set_gains(gains);
+  }
+  if (calibration_requested_) {
+    calibration_requested_ = false;
+    calibration_.start();
+  }
+  if (!calibration_.running() && parameters_step_.mode != VentilationMode_hfnc) {
+    flow_conditioner_.reset();
+    if (active_) {
+      // Whichever mode runs next starts with these valves closed
+      active_ = false;
+      valves_.stage(valve_air, 0);
+      valves_.stage(valve_o2, 0);
+      valves_.commit();
+    }
+    return;
+  }
+  active_ = true;
+
+  // Update sensors: each output collects the read started on the previous
+  // step and starts the next one, so the step never waits on the I2C buses
+  // TODO(lietk12): handle errors from sensors
+  sfm3019_air_.output(raw_flows_[flow_air]);
+  sfm3019_o2_.output(raw_flows_[flow_o2]);
+  flow_conditioner_.transform(raw_flows_, flows_);
+  step_.sensor_vars.flow_air = flows_[flow_air];
+  step_.sensor_vars.flow_o2 = flows_[flow_o2];
+
+  if (calibration_.running()) {
+    // Update calibration
+    step_.actuator_setpoints = ActuatorSetpoints{};
+    if (calibration_.transform(step_.sensor_vars, step_.actuator_vars) &&
+        controller_.set_characterization(calibration_.characterization())) {
+      calibration_result_.write(calibration_.characterization());
+    }
+    calibrating_ = calibration_.running();
+  } else {
+    // Update controller
+    controller_.transform(
+        current_time,
+        parameters_step_,
+        step_.sensor_vars,
+        sensor_measurements_,
+        step_.actuator_setpoints,
+        step_.actuator_vars);
+  }
+
+  // Update actuators together
+  valves_.stage(valve_air, step_.actuator_vars.valve_air_opening);
+  valves_.stage(valve_o2, step_.actuator_vars.valve_o2_opening);
+  valves_.commit();
+
+  step_.step_time = current_time;
+  publish(step_);
 }
 
-const SensorVars &HFNCControlLoop::sensor_vars() const {
-  return sensor_vars_;
+void HFNCControlLoop::input(const ValveCharacterization &characterization) {
+  characterization_.write(characterization);
 }
 
-const ActuatorVars &HFNCControlLoop::actuator_vars() const {
-  return actuator_vars_;
+bool HFNCControlLoop::restore(const ValveCharacterization &characterization) {
+  return controller_.set_characterization(characterization);
 }
 
-void HFNCControlLoop::update(uint32_t current_time) {
-  if (!update_needed(current_time)) {
-    return;
+void HFNCControlLoop::input(const PIGains &gains) {
+  gains_.write(gains);
+}
+
+void HFNCControlLoop::calibrate() {
+  calibrating_ = true;
+  calibration_requested_ = true;
+}
+
+bool HFNCControlLoop::calibrating() const {
+  return calibrating_;
+}
+
+bool HFNCControlLoop::output(ValveCharacterization &characterization) {
+  if (calibration_result_.writes() == calibration_result_reads_) {
+    return false;
   }
 
-  if (parameters_.mode != VentilationMode_hfnc) {
+  calibration_result_reads_ = calibration_result_.writes();
+  calibration_result_.read(characterization);
+  return true;
+}
+
+// PC-AC ControlLoop
+
+PCACControlLoop::PressureConditioner::Config PCACControlLoop::default_pressure_conditioning() {
+  PressureConditioner::ChannelConfig paw;
+  paw.max_step = pressure_max_step;
+  paw.max_rejections = pressure_max_rejections;
+  paw.median = true;
+  paw.biquads = {Analog::lowpass_biquad(pressure_cutoff, control_rate)};
+  return PressureConditioner::Config{paw};
+}
+
+void PCACControlLoop::update(uint32_t current_time) {
+  parameters_.read(parameters_step_);
+  if (gains_.writes() != gains_writes_) {
+    gains_writes_ = gains_.writes();
+    std::array<PIGains, 2> gains{};
+    gains_.read(gains);
+    controller_.set_gains(gains[0], gains[1]);
+  }
+  if (parameters_step_.mode != VentilationMode_pc_ac) {
+    pressure_conditioner_.reset();
+    paw_reading_ = false;
+    if (active_) {
+      // Whichever mode runs next starts with these valves closed
+      active_ = false;
+      valves_.stage(valve_inspiratory, 0);
+      valves_.stage(valve_expiratory, 0);
+      valves_.commit();
+    }
     return;
   }
-
-  // Update sensors
-  // TODO(lietk12): handle errors from sensors
-  sfm3019_air_.output(sensor_vars_.flow_air);
-  sfm3019_o2_.output(sensor_vars_.flow_o2);
-  sensor_measurements_.flow = sensor_vars_.flow_air + sensor_vars_.flow_o2;
+  active_ = true;
+
+  // Update sensors: collect the read started on the previous step and start
+  // the next one, so the step never waits on the I2C bus. A failed or faulty
+  // reading repeats the previous one, which the conditioner then holds steady
+  if (paw_reading_) {
+    Driver::I2C::ABPSample sample{};
+    I2CDeviceStatus status = paw_sensor_.finish_sample(sample);
+    paw_reading_ = status == I2CDeviceStatus::busy;
+    if (status == I2CDeviceStatus::ok &&
+        (sample.status == Driver::I2C::ABPStatus::no_error ||
+         sample.status == Driver::I2C::ABPStatus::stale_data)) {
+      raw_paw_[0] = sample.pressure * cm_h2o_per_psi;
+    }
+  }
+  if (!paw_reading_) {
+    paw_reading_ = paw_sensor_.start_sample() == I2CDeviceStatus::ok;
+  }
+  pressure_conditioner_.transform(raw_paw_, paw_);
+  step_.sensor_vars.paw = paw_[0];
 
   // Update controller
   controller_.transform(
-      current_time,
-      parameters_,
-      sensor_vars_,
+      time_.micros(),
+      parameters_step_,
+      step_.sensor_vars,
       sensor_measurements_,
-      actuator_setpoints_,
-      actuator_vars_);
+      step_.actuator_setpoints,
+      step_.actuator_vars);
 
-  // Update actuators
-  valve_air_.set_duty_cycle(actuator_vars_.valve_air_opening);
-  valve_o2_.set_duty_cycle(actuator_vars_.valve_o2_opening);
+  // Update actuators together
+  valves_.stage(valve_inspiratory, step_.actuator_vars.valve_inspiratory_opening);
+  valves_.stage(valve_expiratory, step_.actuator_vars.valve_expiratory_opening);
+  valves_.commit();
+
+  step_.step_time = current_time;
+  publish(step_);
+}
 
-  advance_step_time(current_time);
+void PCACControlLoop::input(const PIGains &inspiratory, const PIGains &expiratory) {
+  gains_.write({inspiratory, expiratory});
 }
 
 }  // namespace Pufferfish::Driver::BreathingCircuit
@@ -7,6 +7,8 @@
 
 #include "Pufferfish/Driver/BreathingCircuit/Controller.h"
 
+#include "Pufferfish/Util/Timeouts.h"
+
 namespace Pufferfish::Driver::BreathingCircuit {
 
 // HFNC Controller
@@ -19,6 +21,8 @@ void HFNCController::transform(
     ActuatorSetpoints &actuator_setpoints,
     ActuatorVars &actuator_vars) {
   if (parameters.mode != VentilationMode_hfnc) {
+    flow_air_reference_ = 0;
+    flow_o2_reference_ = 0;
     return;
   }
 
@@ -32,11 +36,19 @@ void HFNCController::transform(
     actuator_setpoints.flow_air = 0;
   }
 
-  // PI Controller
+  // Feed-forward from the valve tables, with PI correction
+  flow_air_reference_ += (actuator_setpoints.flow_air - flow_air_reference_) * reference_response;
+  flow_o2_reference_ += (actuator_setpoints.flow_o2 - flow_o2_reference_) * reference_response;
   valve_air_.transform(
-      sensor_vars.flow_air, actuator_setpoints.flow_air, actuator_vars.valve_air_opening);
+      sensor_vars.flow_air,
+      flow_air_reference_,
+      valve_air_table_.opening(actuator_setpoints.flow_air),
+      actuator_vars.valve_air_opening);
   valve_o2_.transform(
-      sensor_vars.flow_o2, actuator_setpoints.flow_o2, actuator_vars.valve_o2_opening);
+      sensor_vars.flow_o2,
+      flow_o2_reference_,
+      valve_o2_table_.opening(actuator_setpoints.flow_o2),
+      actuator_vars.valve_o2_opening);
 
   // Override for closed valve
   if (actuator_setpoints.flow_o2 == 0) {
@@ -47,4 +59,85 @@ void HFNCController::transform(
   }
 }
 
+bool HFNCController::set_characterization(const ValveCharacterization &characterization) {
+  if (valve_air_table_.set(characterization.air) && valve_o2_table_.set(characterization.o2)) {
+    return true;
+  }
+
+  valve_air_table_.clear();
+  valve_o2_table_.clear();
+  return false;
+}
+
+void HFNCController::set_gains(const PIGains &gains) {
+  valve_air_.set_gains(gains);
+  valve_o2_.set_gains(gains);
+}
+
+// PC-AC Controller
+
+void PCACController::transform(
+    uint32_t current_time,
+    const Parameters &parameters,
+    const SensorVars &sensor_vars,
+    const SensorMeasurements & /*sensor_measurements*/,
+    ActuatorSetpoints &actuator_setpoints,
+    ActuatorVars &actuator_vars) {
+  if (parameters.mode != VentilationMode_pc_ac) {
+    phase_ = Phase::idle;
+    return;
+  }
+
+  if (!parameters.ventilating || parameters.rr <= 0 || parameters.ie <= 0) {
+    // Vent the airway to the atmosphere
+    phase_ = Phase::idle;
+    paw_reference_ = sensor_vars.paw;
+    actuator_setpoints.paw = 0;
+    actuator_vars.valve_inspiratory_opening = 0;
+    actuator_vars.valve_expiratory_opening = 1;
+    return;
+  }
+
+  // Phase timing
+  if (phase_ == Phase::idle ||
+      !Util::within_timeout(cycle_start_time_, cycle_period_, current_time)) {
+    start_cycle(current_time, parameters);
+  }
+  if (Util::within_timeout(cycle_start_time_, inspiratory_duration_, current_time)) {
+    phase_ = Phase::inspiratory;
+    actuator_setpoints.paw = parameters.pip;
+  } else {
+    phase_ = Phase::expiratory;
+    actuator_setpoints.paw = parameters.peep;
+  }
+  paw_reference_ += (actuator_setpoints.paw - paw_reference_) * reference_response;
+
+  // Valves
+  if (phase_ == Phase::inspiratory) {
+    valve_inspiratory_.transform(
+        sensor_vars.paw, paw_reference_, actuator_vars.valve_inspiratory_opening);
+    actuator_vars.valve_expiratory_opening = 0;
+  } else {
+    actuator_vars.valve_inspiratory_opening = expiratory_bias_opening;
+    // The expiratory valve opens as the airway pressure exceeds its reference
+    valve_expiratory_.transform(
+        paw_reference_, sensor_vars.paw, actuator_vars.valve_expiratory_opening);
+  }
+}
+
+void PCACController::set_gains(const PIGains &inspiratory, const PIGains &expiratory) {
+  valve_inspiratory_.set_gains(inspiratory);
+  valve_expiratory_.set_gains(expiratory);
+}
+
+void PCACController::start_cycle(uint32_t current_time, const Parameters &parameters) {
+  if (phase_ == Phase::idle) {
+    paw_reference_ = parameters.peep;
+  }
+  cycle_start_time_ = current_time;
+  cycle_period_ = static_cast<uint32_t>(minute_duration / parameters.rr);
+  inspiratory_duration_ =
+      static_cast<uint32_t>(static_cast<float>(cycle_period_) / (1 + 1 / parameters.ie));
+}
+
 }  // namespace Pufferfish::Driver::BreathingCircuit
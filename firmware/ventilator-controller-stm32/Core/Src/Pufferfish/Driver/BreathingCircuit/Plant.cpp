@@ -0,0 +1,150 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Plant.cpp
+ *
+ * Fixed-step model of the valves, circuit and patient of the HFNC breathing
+ * circuit, for closing the control loop in simulation
+ */
+
+#include "Pufferfish/Driver/BreathingCircuit/Plant.h"
+
+#include <cmath>
+
+#include "Pufferfish/Driver/BreathingCircuit/Controller.h"
+
+namespace Pufferfish::Driver::BreathingCircuit {
+
+// HFNC Plant
+
+HFNCPlant::HFNCPlant(const PlantParameters &parameters, uint32_t step_duration_us)
+    : parameters_(parameters),
+      step_duration_(static_cast<float>(step_duration_us) / us_per_s),
+      step_duration_us_(step_duration_us),
+      vars_{0, 0, 0, 0, fio2_min, fio2_min} {}
+
+void HFNCPlant::update(float valve_air_opening, float valve_o2_opening) {
+  transform_valve(valve_air_opening, vars_.flow_air);
+  transform_valve(valve_o2_opening, vars_.flow_o2);
+  transform_circuit();
+  transform_patient();
+  elapsed_us_ += step_duration_us_;
+}
+
+const PlantVars &HFNCPlant::vars() const {
+  return vars_;
+}
+
+uint64_t HFNCPlant::elapsed_us() const {
+  return elapsed_us_;
+}
+
+float HFNCPlant::valve_flow(float opening) const {
+  if (opening <= parameters_.valve_cracking_opening) {
+    return 0;
+  }
+  if (opening > 1) {
+    opening = 1;
+  }
+
+  return parameters_.valve_max_flow * (opening - parameters_.valve_cracking_opening) /
+         (1 - parameters_.valve_cracking_opening);
+}
+
+void HFNCPlant::transform_valve(float opening, float &flow) const {
+  // Backward Euler is stable for any step duration
+  float response = step_duration_ / (parameters_.valve_time_constant + step_duration_);
+  flow += (valve_flow(opening) - flow) * response;
+}
+
+void HFNCPlant::transform_circuit() {
+  float flow = vars_.flow_air + vars_.flow_o2;
+  if (flow <= 0) {
+    return;
+  }
+
+  float inflow_fio2 = (vars_.flow_air * fio2_min + vars_.flow_o2 * fio2_max) / flow;
+  float flushed = flow / s_per_min * step_duration_ / parameters_.circuit_volume;
+  if (flushed > 1) {
+    flushed = 1;
+  }
+  vars_.fio2 += (inflow_fio2 - vars_.fio2) * flushed;
+}
+
+void HFNCPlant::transform_patient() {
+  float breath_duration = s_per_min / parameters_.rr;
+  float insp_fraction = parameters_.ie_ratio / (1 + parameters_.ie_ratio);
+  breath_phase_ += step_duration_ / breath_duration;
+  if (breath_phase_ >= 1) {
+    breath_phase_ -= 1;
+  }
+
+  // Half-sine inspiratory demand, no demand during exhalation
+  if (breath_phase_ < insp_fraction) {
+    vars_.patient_flow =
+        parameters_.peak_inspiratory_flow * std::sin(pi * breath_phase_ / insp_fraction);
+  } else {
+    vars_.patient_flow = 0;
+  }
+
+  // Room air is entrained around the cannula to make up any shortfall
+  float flow = vars_.flow_air + vars_.flow_o2;
+  if (vars_.patient_flow > flow) {
+    vars_.inspired_fio2 =
+        (flow * vars_.fio2 + (vars_.patient_flow - flow) * fio2_min) / vars_.patient_flow;
+  } else {
+    vars_.inspired_fio2 = vars_.fio2;
+  }
+
+  // Excess flow leaks out around the cannula, building up pressure
+  float leak = flow - vars_.patient_flow;
+  vars_.paw = std::copysign(parameters_.cannula_resistance * leak * leak, leak);
+}
+
+// PC-AC Plant
+
+PCACPlant::PCACPlant(const PCACPlantParameters &parameters, uint32_t step_duration_us)
+    : parameters_(parameters),
+      step_duration_(static_cast<float>(step_duration_us) / us_per_s),
+      step_duration_us_(step_duration_us) {}
+
+void PCACPlant::update(float valve_inspiratory_opening, float valve_expiratory_opening) {
+  transform_valve(valve_inspiratory_opening, inspiratory_fraction_);
+  transform_valve(valve_expiratory_opening, expiratory_fraction_);
+
+  // Backward Euler on the compartment pressure, since the outflow depends on it
+  float inflow = parameters_.valve_max_flow * inspiratory_fraction_;
+  float conductance =
+      parameters_.expiratory_conductance * expiratory_fraction_ + parameters_.leak_conductance;
+  float scale = step_duration_ / s_per_min / parameters_.compliance;
+  vars_.paw = (vars_.paw + inflow * scale) / (1 + conductance * scale);
+  vars_.flow_inspiratory = inflow;
+  vars_.flow_expiratory = conductance * vars_.paw;
+  elapsed_us_ += step_duration_us_;
+}
+
+const PCACPlantVars &PCACPlant::vars() const {
+  return vars_;
+}
+
+uint64_t PCACPlant::elapsed_us() const {
+  return elapsed_us_;
+}
+
+float PCACPlant::valve_fraction(float opening) const {
+  if (opening <= parameters_.valve_cracking_opening) {
+    return 0;
+  }
+  if (opening > 1) {
+    opening = 1;
+  }
+
+  return (opening - parameters_.valve_cracking_opening) / (1 - parameters_.valve_cracking_opening);
+}
+
+void PCACPlant::transform_valve(float opening, float &fraction) const {
+  float response = step_duration_ / (parameters_.valve_time_constant + step_duration_);
+  fraction += (valve_fraction(opening) - fraction) * response;
+}
+
+}  // namespace Pufferfish::Driver::BreathingCircuit
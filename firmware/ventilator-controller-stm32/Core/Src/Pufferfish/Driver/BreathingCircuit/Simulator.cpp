@@ -7,6 +7,8 @@
 
 #include "Pufferfish/Driver/BreathingCircuit/Simulator.h"
 
+#include <cmath>
+
 #include "Pufferfish/Util/Timeouts.h"
 
 namespace Pufferfish::Driver::BreathingCircuit {
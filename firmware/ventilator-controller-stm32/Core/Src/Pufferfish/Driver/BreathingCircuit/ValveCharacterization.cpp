@@ -0,0 +1,159 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * ValveCharacterization.cpp
+ *
+ * Tables of the flow through each proportional valve against its opening,
+ * the calibration routine which measures them, and their persistent format
+ */
+
+#include "Pufferfish/Driver/BreathingCircuit/ValveCharacterization.h"
+
+#include <cmath>
+#include <initializer_list>
+
+#include "Pufferfish/Driver/BreathingCircuit/Controller.h"
+#include "Pufferfish/Util/Endian.h"
+
+namespace Pufferfish::Driver::BreathingCircuit {
+
+// ValveTable
+
+bool ValveTable::set(const Flows &flows) {
+  float previous = 0;
+  for (size_t i = 0; i < point_count; ++i) {
+    float flow = std::isfinite(flows[i]) ? flows[i] : 0;
+    flows_[i] = i == 0 || flow > previous ? flow : previous;
+    previous = flows_[i];
+  }
+  characterized_ = flows_[point_count - 1] - flows_[0] >= min_flow_span;
+  if (!characterized_) {
+    clear();
+  }
+  return characterized_;
+}
+
+void ValveTable::clear() {
+  flows_ = {};
+  characterized_ = false;
+}
+
+float ValveTable::flow(float opening) const {
+  if (opening <= 0) {
+    return flows_[0];
+  }
+  if (opening >= 1) {
+    return flows_[point_count - 1];
+  }
+
+  float position = opening * max_index;
+  auto index = static_cast<size_t>(position);
+  float fraction = position - static_cast<float>(index);
+  return flows_[index] + (flows_[index + 1] - flows_[index]) * fraction;
+}
+
+float ValveTable::opening(float flow) const {
+  if (!characterized_ || flow <= flows_[0]) {
+    return 0;
+  }
+  if (flow >= flows_[point_count - 1]) {
+    return 1;
+  }
+
+  // Find the first point at or above the flow; the point before it is below
+  size_t low = 0;
+  size_t high = point_count - 1;
+  while (high - low > 1) {
+    size_t middle = (low + high) / 2;
+    if (flows_[middle] < flow) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  float fraction = (flow - flows_[low]) / (flows_[high] - flows_[low]);
+  return (static_cast<float>(low) + fraction) / max_index;
+}
+
+// ValveCalibration
+
+void ValveCalibration::start() {
+  running_ = true;
+  point_ = 0;
+  step_ = 0;
+  sum_air_ = 0;
+  sum_o2_ = 0;
+}
+
+bool ValveCalibration::transform(const SensorVars &sensor_vars, ActuatorVars &actuator_vars) {
+  if (!running_) {
+    return false;
+  }
+
+  ++step_;
+  if (step_ > settle_steps) {
+    sum_air_ += sensor_vars.flow_air;
+    sum_o2_ += sensor_vars.flow_o2;
+  }
+  if (step_ == settle_steps + average_steps) {
+    characterization_.air[point_] = sum_air_ / average_steps;
+    characterization_.o2[point_] = sum_o2_ / average_steps;
+    sum_air_ = 0;
+    sum_o2_ = 0;
+    step_ = 0;
+    ++point_;
+  }
+
+  if (point_ == ValveTable::point_count) {
+    running_ = false;
+    actuator_vars.valve_air_opening = 0;
+    actuator_vars.valve_o2_opening = 0;
+    return true;
+  }
+
+  actuator_vars.valve_air_opening = opening();
+  actuator_vars.valve_o2_opening = opening();
+  return false;
+}
+
+float ValveCalibration::opening() const {
+  return static_cast<float>(point_) / (ValveTable::point_count - 1);
+}
+
+// ValveCharacterizationFormat
+
+void ValveCharacterizationFormat::write(
+    const ValveCharacterization &characterization, uint8_t *buffer) {
+  static constexpr float max_flow = UINT16_MAX * flow_resolution;
+
+  buffer[0] = version;
+  size_t offset = 1;
+  for (const ValveTable::Flows *flows : {&characterization.air, &characterization.o2}) {
+    for (float flow : *flows) {
+      float clamped = flow < 0 ? 0 : (flow > max_flow ? max_flow : flow);
+      auto scaled = static_cast<uint16_t>(std::lround(clamped / flow_resolution));
+      Util::write_hton(scaled, buffer + offset);
+      offset += sizeof(uint16_t);
+    }
+  }
+}
+
+bool ValveCharacterizationFormat::read(
+    const uint8_t *buffer, size_t length, ValveCharacterization &characterization) {
+  if (length != size || buffer[0] != version) {
+    return false;
+  }
+
+  size_t offset = 1;
+  for (ValveTable::Flows *flows : {&characterization.air, &characterization.o2}) {
+    for (float &flow : *flows) {
+      uint16_t scaled = 0;
+      Util::read_ntoh(buffer + offset, scaled);
+      flow = static_cast<float>(scaled) * flow_resolution;
+      offset += sizeof(uint16_t);
+    }
+  }
+  return true;
+}
+
+}  // namespace Pufferfish::Driver::BreathingCircuit
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Capture.cpp
+ *
+ * Captures timestamped UART and I2C traffic and streams it to a trace output
+ */
+
+#include "Pufferfish/Driver/Capture/Capture.h"
+
+namespace Pufferfish::Driver::Capture {
+
+// UARTCapture
+
+void UARTCapture::input(RecordKind kind, const uint8_t *bytes, size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  uint32_t current_time = time_.micros();
+  Record &record = (kind == RecordKind::uart_tx) ? tx_ : rx_;
+  record.kind = kind;
+  append(record, bytes, size, current_time);
+}
+
+void UARTCapture::update() {
+  uint32_t current_time = time_.micros();
+  for (Record *record : {&rx_, &tx_}) {
+    if (record->size > 0 && current_time - record->time >= batch_window) {
+      close(*record);
+    }
+  }
+}
+
+void UARTCapture::append(
+    Record &record, const uint8_t *bytes, size_t size, uint32_t current_time) {
+  for (size_t i = 0; i < size; ++i) {
+    if (record.size > 0 && current_time - record.time >= batch_window) {
+      close(record);
+    }
+    if (record.size == 0) {
+      record.time = current_time;
+      record.channel = channel_;
+      record.status = static_cast<uint8_t>(BufferStatus::ok);
+    }
+
+    record.data[record.size] = bytes[i];
+    ++record.size;
+    if (record.size == Record::max_data_size) {
+      close(record);
+    }
+  }
+}
+
+void UARTCapture::close(Record &record) {
+  sink_.input(record);
+  record.size = 0;
+}
+
+// CapturedUART
+
+BufferStatus CapturedUART::read(uint8_t &read_byte) volatile {
+  BufferStatus status = uart_.read(read_byte);
+  if (status == BufferStatus::ok) {
+    capture_.input(RecordKind::uart_rx, &read_byte, 1);
+  }
+  return status;
+}
+
+BufferStatus CapturedUART::write(uint8_t write_byte) volatile {
+  BufferStatus status = uart_.write(write_byte);
+  if (status == BufferStatus::ok) {
+    capture_.input(RecordKind::uart_tx, &write_byte, 1);
+  }
+  return status;
+}
+
+BufferStatus CapturedUART::write(
+    const uint8_t *write_bytes,
+    HAL::AtomicSize write_size,
+    HAL::AtomicSize &written_size) volatile {
+  BufferStatus status = uart_.write(write_bytes, write_size, written_size);
+  capture_.input(RecordKind::uart_tx, write_bytes, written_size);
+  return status;
+}
+
+BufferStatus CapturedUART::write_block(uint8_t write_byte, uint32_t timeout) volatile {
+  BufferStatus status = uart_.write_block(write_byte, timeout);
+  if (status == BufferStatus::ok) {
+    capture_.input(RecordKind::uart_tx, &write_byte, 1);
+  }
+  return status;
+}
+
+BufferStatus CapturedUART::write_block(
+    const uint8_t *write_bytes,
+    HAL::AtomicSize write_size,
+    uint32_t timeout,
+    HAL::AtomicSize &written_size) volatile {
+  BufferStatus status = uart_.write_block(write_bytes, write_size, timeout, written_size);
+  capture_.input(RecordKind::uart_tx, write_bytes, written_size);
+  return status;
+}
+
+// CapturedI2CDevice
+
+I2CDeviceStatus CapturedI2CDevice::read(uint8_t *buf, size_t count) {
+  uint32_t start_time = time_.micros();
+  I2CDeviceStatus status = dev_.read(buf, count);
+  record(RecordKind::i2c_read, start_time, status, buf, status == I2CDeviceStatus::ok ? count : 0);
+  return status;
+}
+
+I2CDeviceStatus CapturedI2CDevice::write(uint8_t *buf, size_t count) {
+  uint32_t start_time = time_.micros();
+  I2CDeviceStatus status = dev_.write(buf, count);
+  record(RecordKind::i2c_write, start_time, status, buf, count);
+  return status;
+}
+
+I2CDeviceStatus CapturedI2CDevice::start_read(uint8_t *buf, size_t count) {
+  uint32_t start_time = time_.micros();
+  I2CDeviceStatus status = dev_.start_read(buf, count);
+  if (status != I2CDeviceStatus::ok) {
+    record(RecordKind::i2c_read, start_time, status, buf, 0);
+    return status;
+  }
+
+  pending_buf_ = buf;
+  pending_count_ = count;
+  pending_time_ = start_time;
+  return status;
+}
+
+I2CDeviceStatus CapturedI2CDevice::finish_read() {
+  I2CDeviceStatus status = dev_.finish_read();
+  if (status == I2CDeviceStatus::busy || pending_buf_ == nullptr) {
+    return status;
+  }
+
+  record(
+      RecordKind::i2c_read,
+      pending_time_,
+      status,
+      pending_buf_,
+      status == I2CDeviceStatus::ok ? pending_count_ : 0);
+  pending_buf_ = nullptr;
+  return status;
+}
+
+void CapturedI2CDevice::record(
+    RecordKind kind, uint32_t time, I2CDeviceStatus status, const uint8_t *buf, size_t count) {
+  Record record{};
+  record.time = time;
+  record.channel = channel_;
+  record.kind = kind;
+  record.status = static_cast<uint8_t>(status);
+  record.size = static_cast<uint8_t>(count < Record::max_data_size ? count : Record::max_data_size);
+  for (size_t i = 0; i < record.size; ++i) {
+    record.data[i] = buf[i];
+  }
+  sink_.input(record);
+}
+
+}  // namespace Pufferfish::Driver::Capture
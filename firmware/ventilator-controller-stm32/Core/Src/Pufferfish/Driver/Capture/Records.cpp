@@ -0,0 +1,76 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Records.cpp
+ *
+ * Timestamped records of UART and I2C traffic, and their serialization
+ */
+
+#include "Pufferfish/Driver/Capture/Records.h"
+
+#include "Pufferfish/Util/Endian.h"
+
+namespace Pufferfish::Driver::Capture {
+
+using Serial::Backend::FrameProps;
+
+// RecordSender
+
+IndexStatus RecordSender::transform(
+    const Record &record, FrameProps::ChunkBuffer &output_buffer) const {
+  if (record.size > Record::max_data_size) {
+    return IndexStatus::out_of_bounds;
+  }
+
+  FrameProps::PayloadBuffer payload;
+  payload.resize(header_size + record.size);
+  Util::write_hton(record.time, payload.buffer());
+  payload[4] = record.channel;
+  payload[5] = static_cast<uint8_t>(record.kind);
+  payload[6] = record.status;
+  payload[7] = record.size;
+  payload.copy_from(record.data.data(), record.size, header_size);
+
+  if (frame_sender_.transform(payload, output_buffer) != FrameProps::OutputStatus::ok) {
+    return IndexStatus::out_of_bounds;
+  }
+  return IndexStatus::ok;
+}
+
+// RecordReceiver
+
+FrameProps::InputStatus RecordReceiver::input(uint8_t new_byte) {
+  return frame_receiver_.input(new_byte);
+}
+
+RecordReceiver::Status RecordReceiver::output(Record &record) {
+  FrameProps::PayloadBuffer payload;
+  switch (frame_receiver_.output(payload)) {
+    case FrameProps::OutputStatus::ok:
+      break;
+    case FrameProps::OutputStatus::waiting:
+      return Status::waiting;
+    default:
+      return Status::invalid_frame;
+  }
+
+  if (payload.size() < RecordSender::header_size) {
+    return Status::invalid_record;
+  }
+  uint8_t size = payload[7];
+  if (size > Record::max_data_size || payload.size() != RecordSender::header_size + size) {
+    return Status::invalid_record;
+  }
+
+  Util::read_ntoh(payload.buffer(), record.time);
+  record.channel = payload[4];
+  record.kind = static_cast<RecordKind>(payload[5]);
+  record.status = payload[6];
+  record.size = size;
+  for (size_t i = 0; i < size; ++i) {
+    record.data[i] = payload[RecordSender::header_size + i];
+  }
+  return Status::ok;
+}
+
+}  // namespace Pufferfish::Driver::Capture
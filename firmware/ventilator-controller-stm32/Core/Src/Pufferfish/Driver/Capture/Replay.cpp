@@ -0,0 +1,62 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Replay.cpp
+ *
+ * Replays captured UART and I2C traffic into the HAL mocks
+ */
+
+#include "Pufferfish/Driver/Capture/Replay.h"
+
+namespace Pufferfish::Driver::Capture {
+
+uint64_t unwrap_time(uint64_t previous_time, uint32_t time) {
+  static const uint64_t period = 1ULL << 32U;
+  static const uint64_t half_period = period / 2;
+
+  uint64_t unwrapped = (previous_time & ~(period - 1)) | time;
+  if (unwrapped + half_period < previous_time) {
+    unwrapped += period;
+  } else if (unwrapped > previous_time + half_period && unwrapped >= period) {
+    unwrapped -= period;
+  }
+  return unwrapped;
+}
+
+// I2CReplayTarget
+
+void I2CReplayTarget::replay(const Record &record) {
+  if (record.kind != RecordKind::i2c_read) {
+    return;
+  }
+
+  dev_.add_read(record.data.data(), record.size, static_cast<I2CDeviceStatus>(record.status));
+}
+
+// Replayer
+
+void Replayer::attach(Channel channel, ReplayTarget &target) {
+  auto index = static_cast<size_t>(channel);
+  if (index < targets_.size()) {
+    targets_[index] = &target;
+  }
+}
+
+void Replayer::input(const Record &record) {
+  uint64_t time_us = started_ ? unwrap_time(time_us_, record.time) : record.time;
+  started_ = true;
+  if (time_us > time_us_) {
+    time_us_ = time_us;
+  }
+  time_.set_micros(static_cast<uint32_t>(time_us_));
+  time_.set_millis(static_cast<uint32_t>(time_us_ / 1000));
+
+  ReplayTarget *target = record.channel < targets_.size() ? targets_[record.channel] : nullptr;
+  if (target == nullptr) {
+    ++unattached_;
+    return;
+  }
+  target->replay(record);
+}
+
+}  // namespace Pufferfish::Driver::Capture
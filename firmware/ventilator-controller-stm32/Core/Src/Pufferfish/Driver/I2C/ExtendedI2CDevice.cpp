@@ -26,4 +26,17 @@ I2CDeviceStatus ExtendedI2CDevice::write(uint8_t *buf, size_t count) {
   return dev_.write(buf, count);
 }
 
+I2CDeviceStatus ExtendedI2CDevice::start_read(uint8_t *buf, size_t count) {
+  I2CDeviceStatus stat = mux_.select_slot(ext_slot);
+  if (stat != I2CDeviceStatus::ok) {
+    return stat;
+  }
+
+  return dev_.start_read(buf, count);
+}
+
+I2CDeviceStatus ExtendedI2CDevice::finish_read() {
+  return dev_.finish_read();
+}
+
 }  // namespace Pufferfish::Driver::I2C
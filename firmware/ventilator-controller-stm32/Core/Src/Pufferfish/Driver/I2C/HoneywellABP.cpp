@@ -24,17 +24,34 @@ I2CDeviceStatus HoneywellABP::read_sample(ABPSample &sample) {
     return ret;
   }
 
+  decode(data, sample);
+  return I2CDeviceStatus::ok;
+}
+
+I2CDeviceStatus HoneywellABP::start_sample() {
+  return dev_.start_read(data_.data(), data_.size());
+}
+
+I2CDeviceStatus HoneywellABP::finish_sample(ABPSample &sample) {
+  I2CDeviceStatus ret = dev_.finish_read();
+  if (ret != I2CDeviceStatus::ok) {
+    return ret;
+  }
+
+  decode(data_, sample);
+  return I2CDeviceStatus::ok;
+}
+
+void HoneywellABP::decode(const std::array<uint8_t, 2> &data, ABPSample &sample) const {
   static const uint8_t status_shift = 6;
   static const size_t bridge_high = 0;
-  static const size_t bridge_low = 0;
+  static const size_t bridge_low = 1;
   static const uint16_t bridge_mask = 0x3FFF;
   sample.status = ABPStatus(data[0] >> status_shift);
   sample.bridge_data = (data[bridge_high] << static_cast<uint8_t>(CHAR_BIT)) + data[bridge_low];
   sample.bridge_data &= bridge_mask;
   sample.pressure = raw_to_pressure(sample.bridge_data);
   sample.unit = unit;
-
-  return I2CDeviceStatus::ok;
 }
 
 float HoneywellABP::raw_to_pressure(uint16_t output) const {
@@ -21,6 +21,10 @@ I2CDeviceStatus Device::start_measure() {
   return sensirion_.write(static_cast<uint16_t>(gas));
 }
 
+I2CDeviceStatus Device::start_measure_all() {
+  return global_.write(static_cast<uint16_t>(gas));
+}
+
 I2CDeviceStatus Device::stop_measure() {
   return sensirion_.write(static_cast<uint16_t>(Command::stop_measure));
 }
@@ -71,11 +75,37 @@ I2CDeviceStatus Device::read_sample(Sample &sample, int16_t scale_factor, int16_
     return ret;
   }
 
-  Util::read_ntoh(buffer.data(), sample.raw_flow);
+  decode(buffer.data(), false, sample, scale_factor, offset);
+  return I2CDeviceStatus::ok;
+}
 
-  // convert to actual flow rate
-  sample.flow = static_cast<float>(sample.raw_flow - offset) / static_cast<float>(scale_factor);
+I2CDeviceStatus Device::read_full_sample(
+    Sample &sample, int16_t scale_factor, int16_t offset) {
+  // read flow, temperature and status words
+  std::array<uint8_t, 3 * sizeof(uint16_t)> buffer{};
+  I2CDeviceStatus ret = sensirion_.read(buffer);
+  if (ret != I2CDeviceStatus::ok) {
+    return ret;
+  }
+
+  decode(buffer.data(), true, sample, scale_factor, offset);
+  return I2CDeviceStatus::ok;
+}
 
+I2CDeviceStatus Device::start_sample(RawSample &raw, bool full) {
+  return sensirion_.start_read(raw.data(), full ? raw.size() : raw.size() / 3);
+}
+
+I2CDeviceStatus Device::finish_sample(
+    const RawSample &raw, bool full, Sample &sample, int16_t scale_factor, int16_t offset) {
+  std::array<uint8_t, 3 * sizeof(uint16_t)> buffer{};
+  I2CDeviceStatus ret = sensirion_.finish_read(
+      raw.data(), buffer.data(), full ? buffer.size() : sizeof(uint16_t));
+  if (ret != I2CDeviceStatus::ok) {
+    return ret;
+  }
+
+  decode(buffer.data(), full, sample, scale_factor, offset);
   return I2CDeviceStatus::ok;
 }
 
@@ -83,4 +113,19 @@ I2CDeviceStatus Device::reset() {
   return global_.write(static_cast<uint8_t>(Command::reset));
 }
 
+void Device::decode(
+    const uint8_t *buffer, bool full, Sample &sample, int16_t scale_factor, int16_t offset) {
+  Util::read_ntoh(buffer, sample.raw_flow);
+  if (full) {
+    Util::read_ntoh(buffer + sizeof(uint16_t), sample.raw_temperature);
+    Util::read_ntoh(buffer + 2 * sizeof(uint16_t), sample.status);
+  }
+
+  // convert to actual flow rate and temperature
+  sample.flow = static_cast<float>(sample.raw_flow - offset) / static_cast<float>(scale_factor);
+  if (full) {
+    sample.temperature = static_cast<float>(sample.raw_temperature) / temperature_scale;
+  }
+}
+
 }  // namespace Pufferfish::Driver::I2C::SFM3019
@@ -16,32 +16,85 @@ namespace Pufferfish::Driver::I2C::SFM3019 {
 
 // StateMachine
 
-StateMachine::Action StateMachine::update(uint32_t current_time_us) {
+StateMachine::Action StateMachine::update(uint32_t current_time_us, bool succeeded) {
   current_time_us_ = current_time_us;
   switch (next_action_) {
-    case Action::initialize:
-      next_action_ = Action::wait_warmup;
-      start_waiting();
+    case Action::wait_power_up:
+      if (finished_waiting(power_up_duration_us)) {
+        next_action_ = Action::read_product_id;
+      }
+      break;
+    case Action::wait_conversion:
+      if (finished_waiting(conversion_duration_us)) {
+        next_action_ = Action::read_conversion;
+      }
       break;
     case Action::wait_warmup:
       if (finished_waiting(warming_up_duration_us)) {
         next_action_ = Action::check_range;
       }
       break;
-    case Action::check_range:
-    case Action::measure:
-      next_action_ = Action::wait_measurement;
-      start_waiting();
+    case Action::wait_retry:
+      if (finished_waiting(backoff_us_)) {
+        next_action_ = retry_action_;
+        backoff_us_ = (backoff_us_ < max_backoff_us / 2) ? 2 * backoff_us_ : max_backoff_us;
+      }
       break;
     case Action::wait_measurement:
       if (finished_waiting(measuring_duration_us)) {
         next_action_ = Action::measure;
       }
       break;
+    case Action::measure:
+      // Measurements are simply retried on the next read
+      if (succeeded) {
+        next_action_ = Action::wait_measurement;
+        start_waiting();
+      }
+      break;
+    default:
+      if (!succeeded) {
+        retry_action_ = restart_point(next_action_);
+        next_action_ = Action::wait_retry;
+        start_waiting();
+        break;
+      }
+      backoff_us_ = initial_backoff_us;
+      next_action_ = following(next_action_);
+      start_waiting();
+      break;
   }
   return next_action_;
 }
 
+StateMachine::Action StateMachine::following(Action action) {
+  switch (action) {
+    case Action::reset:
+      return Action::wait_power_up;
+    case Action::read_product_id:
+      return Action::request_conversion;
+    case Action::request_conversion:
+      return Action::wait_conversion;
+    case Action::read_conversion:
+      return Action::set_averaging;
+    case Action::set_averaging:
+      return Action::start_measure;
+    case Action::start_measure:
+      return Action::wait_warmup;
+    default:
+      break;
+  }
+  return Action::wait_measurement;
+}
+
+StateMachine::Action StateMachine::restart_point(Action action) {
+  // Conversion factors are only readable right after they are requested
+  if (action == Action::read_conversion) {
+    return Action::request_conversion;
+  }
+  return action;
+}
+
 void StateMachine::start_waiting() {
   wait_start_time_us_ = current_time_us_;
 }
@@ -53,132 +106,144 @@ bool StateMachine::finished_waiting(uint32_t timeout_us) const {
 // Sensor
 
 InitializableState Sensor::setup() {
-  switch (next_action_) {
-    case Action::initialize:
-      return initialize(time_.micros());
-    case Action::wait_warmup:
-      next_action_ = fsm_.update(time_.micros());
-      return InitializableState::setup;
-    case Action::check_range:
-      return check_range(time_.micros());
-    case Action::measure:
-    case Action::wait_measurement:
-      return InitializableState::ok;
-  }
-  return InitializableState::failed;
-}
-
-InitializableState Sensor::output(float &flow) {
   switch (next_action_) {
     case Action::measure:
-      return measure(time_.micros(), flow);
     case Action::wait_measurement:
-      next_action_ = fsm_.update(time_.micros());
       return InitializableState::ok;
     default:
       break;
   }
-  return InitializableState::failed;
-}
 
-InitializableState Sensor::initialize(uint32_t current_time_us) {
-  if (retry_count_ > max_retries_setup) {
-    return InitializableState::failed;
-  }
-
-  retry_count_ = 0;
-  // Reset the device
-  if (resetter) {
-    while (device_.reset() != I2CDeviceStatus::ok) {
-      ++retry_count_;
-      if (retry_count_ > max_retries_setup) {
-        return InitializableState::failed;
-      }
-    }
-  }
-
-  // Wait for power-up
-  time_.delay(power_up_delay);
-
-  // Read product number
-  while (device_.read_product_id(pn_) != I2CDeviceStatus::ok || pn_ != product_number) {
+  const bool succeeded = run_setup_action();
+  if (!succeeded) {
     ++retry_count_;
     if (retry_count_ > max_retries_setup) {
       return InitializableState::failed;
     }
   }
 
-  // Request conversion factors
-  while (device_.request_conversion_factors() != I2CDeviceStatus::ok) {
-    ++retry_count_;
-    if (retry_count_ > max_retries_setup) {
-      return InitializableState::failed;
-    }
+  next_action_ = fsm_.update(time_.micros(), succeeded);
+  if (next_action_ == Action::wait_measurement) {
+    retry_count_ = 0;  // reset retries to 0 for measuring
+    return InitializableState::ok;
   }
+  return InitializableState::setup;
+}
 
-  // Read conversion factors
-  time_.delay_micros(read_conv_delay_us);
-  while (device_.read_conversion_factors(conversion_) != I2CDeviceStatus::ok ||
-         conversion_.scale_factor != scale_factor || conversion_.offset != offset ||
-         conversion_.flow_unit != flow_unit) {
-    ++retry_count_;
-    if (retry_count_ > max_retries_setup) {
-      return InitializableState::failed;
-    }
+InitializableState Sensor::output(float &flow) {
+  Sample sample{};
+  InitializableState state = output(sample);
+  if (state == InitializableState::ok) {
+    flow = sample.flow;
   }
+  return state;
+}
 
-  // Set the averaging window size
-  while (device_.set_averaging(averaging_window) != I2CDeviceStatus::ok) {
-    ++retry_count_;
-    if (retry_count_ > max_retries_setup) {
+InitializableState Sensor::output(Sample &sample) {
+  switch (next_action_) {
+    case Action::measure:
+    case Action::wait_measurement:
+      break;
+    default:
       return InitializableState::failed;
-    }
   }
 
-  // Start continuous measurement
-  while (device_.start_measure() != I2CDeviceStatus::ok) {
+  // The previous read has had the whole time since the previous call to
+  // finish, so a read still in progress counts as a failed one
+  const uint32_t current_time_us = time_.micros();
+  bool failed = reading_ && !finish_reading();
+  if (next_action_ == Action::wait_measurement) {
+    next_action_ = fsm_.update(current_time_us);
+  }
+  if (!reading_ && next_action_ == Action::measure) {
+    const bool started = start_reading(current_time_us);
+    failed = failed || !started;
+    next_action_ = fsm_.update(current_time_us, started);
+  }
+
+  sample = sample_;
+  if (failed) {
     ++retry_count_;
-    if (retry_count_ > max_retries_setup) {
-      return InitializableState::failed;
-    }
   }
+  if (retry_count_ > max_retries_measure) {
+    // Abandon a read which never finishes, so that the next call retries
+    reading_ = false;
+    return InitializableState::failed;
+  }
+  return InitializableState::ok;
+}
 
-  next_action_ = fsm_.update(current_time_us);
-  retry_count_ = 0;  // reset retries to 0 for measuring
-  return InitializableState::setup;
+bool Sensor::run_setup_action() {
+  switch (next_action_) {
+    case Action::reset:
+      return !resetter || device_.reset() == I2CDeviceStatus::ok;
+    case Action::read_product_id:
+      return device_.read_product_id(pn_) == I2CDeviceStatus::ok && pn_ == product_number;
+    case Action::request_conversion:
+      return device_.request_conversion_factors() == I2CDeviceStatus::ok;
+    case Action::read_conversion:
+      return device_.read_conversion_factors(conversion_) == I2CDeviceStatus::ok &&
+             conversion_.scale_factor == scale_factor && conversion_.offset == offset &&
+             conversion_.flow_unit == flow_unit;
+    case Action::set_averaging:
+      return device_.set_averaging(averaging_window) == I2CDeviceStatus::ok;
+    case Action::start_measure:
+      if (synchronized) {
+        return device_.start_measure_all() == I2CDeviceStatus::ok;
+      }
+      return device_.start_measure() == I2CDeviceStatus::ok;
+    case Action::check_range:
+      return read_sample(time_.micros()) && sample_.flow >= flow_min && sample_.flow <= flow_max;
+    default:
+      // Waits only need the state machine to be updated
+      return true;
+  }
 }
 
-InitializableState Sensor::check_range(uint32_t current_time_us) {
-  if (device_.read_sample(sample_, conversion_.scale_factor, conversion_.offset) ==
-          I2CDeviceStatus::ok &&
-      sample_.flow >= flow_min && sample_.flow <= flow_max) {
-    next_action_ = fsm_.update(current_time_us);
-    return InitializableState::ok;
+bool Sensor::read_sample(uint32_t current_time_us) {
+  Sample sample{};
+  I2CDeviceStatus status = I2CDeviceStatus::ok;
+  if (full_samples) {
+    status = device_.read_full_sample(sample, conversion_.scale_factor, conversion_.offset);
+  } else {
+    status = device_.read_sample(sample, conversion_.scale_factor, conversion_.offset);
+  }
+  if (status != I2CDeviceStatus::ok) {
+    return false;
   }
 
-  ++retry_count_;
-  if (retry_count_ > max_retries_setup) {
-    return InitializableState::failed;
+  sample.time_us = current_time_us;
+  sample_ = sample;
+  return true;
+}
+
+bool Sensor::start_reading(uint32_t current_time_us) {
+  if (device_.start_sample(raw_, full_samples) != I2CDeviceStatus::ok) {
+    return false;
   }
 
-  return InitializableState::setup;
+  reading_ = true;
+  read_time_us_ = current_time_us;
+  return true;
 }
 
-InitializableState Sensor::measure(uint32_t current_time_us, float &flow) {
-  if (device_.read_sample(sample_, conversion_.scale_factor, conversion_.offset) ==
-      I2CDeviceStatus::ok) {
-    retry_count_ = 0;  // reset retries to 0 for next measurement
-    flow = sample_.flow;
-    next_action_ = fsm_.update(current_time_us);
-    return InitializableState::ok;
+bool Sensor::finish_reading() {
+  Sample sample{};
+  I2CDeviceStatus status = device_.finish_sample(
+      raw_, full_samples, sample, conversion_.scale_factor, conversion_.offset);
+  if (status == I2CDeviceStatus::busy) {
+    return false;
   }
 
-  ++retry_count_;
-  if (retry_count_ > max_retries_measure) {
-    return InitializableState::failed;
+  reading_ = false;
+  if (status != I2CDeviceStatus::ok) {
+    return false;
   }
 
-  return InitializableState::ok;
+  sample.time_us = read_time_us_;
+  sample_ = sample;
+  retry_count_ = 0;  // reset retries to 0 for next measurement
+  return true;
 }
 
 }  // namespace Pufferfish::Driver::I2C::SFM3019
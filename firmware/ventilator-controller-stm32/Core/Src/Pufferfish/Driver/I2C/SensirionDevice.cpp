@@ -12,6 +12,20 @@
 
 namespace Pufferfish::Driver::I2C {
 
+I2CDeviceStatus SensirionDevice::start_read(uint8_t *buf_with_crc, size_t count) {
+  return dev_.start_read(buf_with_crc, count);
+}
+
+I2CDeviceStatus SensirionDevice::finish_read(
+    const uint8_t *buf_with_crc, uint8_t *buf, size_t size) {
+  I2CDeviceStatus ret = dev_.finish_read();
+  if (ret != I2CDeviceStatus::ok) {
+    return ret;
+  }
+
+  return unpack(buf_with_crc, buf, size);
+}
+
 I2CDeviceStatus SensirionDevice::write(uint8_t command) {
   return dev_.write(&command, sizeof(uint8_t));
 }
@@ -37,4 +51,19 @@ I2CDeviceStatus SensirionDevice::write(uint16_t command, uint16_t arg) {
   return dev_.write(write_buf.data(), write_buf.size());
 }
 
+I2CDeviceStatus SensirionDevice::unpack(const uint8_t *buf_with_crc, uint8_t *buf, size_t size) {
+  for (size_t word_start = 0; word_start < 3 * size / 2; word_start += 3) {
+    uint8_t expected_crc = crc8_.compute(buf_with_crc + word_start, sizeof(uint16_t));
+    uint8_t received_crc = buf_with_crc[word_start + sizeof(uint16_t)];
+    if (expected_crc != received_crc) {
+      return I2CDeviceStatus::crc_check_failed;
+    }
+
+    buf[2 * word_start / 3] = buf_with_crc[word_start];
+    buf[2 * word_start / 3 + sizeof(uint8_t)] = buf_with_crc[word_start + sizeof(uint8_t)];
+  }
+
+  return I2CDeviceStatus::ok;
+}
+
 }  // namespace Pufferfish::Driver::I2C
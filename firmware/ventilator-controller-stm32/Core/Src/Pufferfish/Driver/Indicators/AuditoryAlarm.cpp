@@ -42,35 +42,34 @@ AlarmManagerStatus AuditoryAlarm::update(uint32_t current_time) {
   return AlarmManagerStatus::ok;
 }
 
-AlarmManagerStatus AuditoryAlarm::set_alarm(AlarmStatus a) {
-  static constexpr Parameters high_priority{true, true, true, 0, 0};
-  static constexpr Parameters medium_priority{false, true, true, 0, 0};
-  static constexpr Parameters low_priority{false, false, true, 0, 0};
-  static constexpr Parameters technical1{false, false, false, 2000, 200};
-  static constexpr Parameters technical2{false, false, false, 4000, 200};
-  static constexpr Parameters no_alarm{false, false, false, 0, 0};
-  reset_ = true;
+AlarmManagerStatus auditory_parameters(AlarmStatus a, AuditoryParameters &parameters) {
+  static constexpr AuditoryParameters high_priority{true, true, true, 0, 0};
+  static constexpr AuditoryParameters medium_priority{false, true, true, 0, 0};
+  static constexpr AuditoryParameters low_priority{false, false, true, 0, 0};
+  static constexpr AuditoryParameters technical1{false, false, false, 2000, 200};
+  static constexpr AuditoryParameters technical2{false, false, false, 4000, 200};
+  static constexpr AuditoryParameters no_alarm{false, false, false, 0, 0};
 
   switch (a) {
     case AlarmStatus::high_priority:
-      parameters_ = high_priority;
+      parameters = high_priority;
       break;
     case AlarmStatus::medium_priority:
-      parameters_ = medium_priority;
+      parameters = medium_priority;
       break;
     case AlarmStatus::low_priority:
-      parameters_ = low_priority;
+      parameters = low_priority;
       break;
     case AlarmStatus::technical1:
       // technical1 = buzzer at 0.5 Hz with 10% duty cycle
-      parameters_ = technical1;
+      parameters = technical1;
       break;
     case AlarmStatus::technical2:
       // technical2 = buzzer at 0.25 Hz with 5% duty cycle
-      parameters_ = technical2;
+      parameters = technical2;
       break;
     case AlarmStatus::no_alarm:
-      parameters_ = no_alarm;
+      parameters = no_alarm;
       break;
     default:
       return AlarmManagerStatus::invalid_alarm;
@@ -79,4 +78,31 @@ AlarmManagerStatus AuditoryAlarm::set_alarm(AlarmStatus a) {
   return AlarmManagerStatus::ok;
 }
 
+AlarmManagerStatus AuditoryAlarm::set_alarm(AlarmStatus a) {
+  reset_ = true;
+  return auditory_parameters(a, parameters_);
+}
+
+AlarmManagerStatus TimedAuditoryAlarm::update(uint32_t /*current_time*/) {
+  return AlarmManagerStatus::ok;
+}
+
+AlarmManagerStatus TimedAuditoryAlarm::set_alarm(AlarmStatus a) {
+  AuditoryParameters parameters{};
+  AlarmManagerStatus status = auditory_parameters(a, parameters);
+  if (status != AlarmManagerStatus::ok) {
+    return status;
+  }
+
+  reg_high_.write(parameters.out_high);
+  reg_med_.write(parameters.out_med);
+  reg_low_.write(parameters.out_low);
+  if (buzzer_.set_pulses(parameters.buzzer_pulse_period, parameters.buzzer_pulse_duty) !=
+      TimerStatus::ok) {
+    return AlarmManagerStatus::hardware_error;
+  }
+
+  return AlarmManagerStatus::ok;
+}
+
 }  // namespace Pufferfish::Driver::Indicators
@@ -29,6 +29,10 @@ void PWMGenerator::start(uint32_t current_time) {
   this->input(current_time);
 }
 
+TimerStatus PWMGenerator::start(HAL::PulseOutput &output) const {
+  return output.set_pulses(pulse_period_, pulse_duty_);
+}
+
 void PWMGenerator::input(uint32_t current_time) {
   /* validate the pulse duration */
   uint32_t pulse_duration = current_time - last_cycle_;
@@ -0,0 +1,193 @@
+/// AsyncFlash.cpp
+/// This file has methods for a non-blocking program/erase engine for SPI
+/// flash memory.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Pufferfish/Driver/SPI/AsyncFlash.h"
+
+namespace Pufferfish::Driver::SPI {
+
+AsyncFlash::Status AsyncFlash::program(uint32_t addr, const uint8_t *data, size_t size) {
+  if (addr >= SPIFlash::capacity || size > SPIFlash::capacity - addr) {
+    return Status::invalid;
+  }
+
+  const size_t first_page = addr / SPIFlash::page_size;
+  const size_t last_page = (addr + size - 1) / SPIFlash::page_size;
+  if (size > 0 && last_page - first_page + 1 > available()) {
+    return Status::busy;
+  }
+
+  while (size > 0) {
+    size_t chunk = SPIFlash::page_size - (addr % SPIFlash::page_size);
+    if (chunk > size) {
+      chunk = size;
+    }
+
+    Operation &operation = push();
+    operation.type = OperationType::program;
+    operation.address = addr;
+    operation.size = static_cast<uint16_t>(chunk);
+    for (size_t i = 0; i < chunk; ++i) {
+      operation.data[i] = data[i];
+    }
+
+    addr += chunk;
+    data += chunk;
+    size -= chunk;
+  }
+  return Status::ok;
+}
+
+AsyncFlash::Status AsyncFlash::erase_sector(uint32_t addr) {
+  if (addr >= SPIFlash::capacity) {
+    return Status::invalid;
+  }
+  if (available() == 0) {
+    return Status::busy;
+  }
+
+  Operation &operation = push();
+  operation.type = OperationType::erase_sector;
+  operation.address = addr - (addr % SPIFlash::sector_size);
+  operation.size = 0;
+  return Status::ok;
+}
+
+AsyncFlash::Status AsyncFlash::update() {
+  if (phase_ != Phase::ready) {
+    uint8_t reg_data = 0;
+    if (flash_.read_status_register1(reg_data) != SPIDeviceStatus::ok) {
+      return Status::error;
+    }
+    if ((reg_data & SPIFlash::busy_bit) != 0) {
+      return Status::ok;
+    }
+
+    if (phase_ == Phase::operating) {
+      pop();
+    }
+    phase_ = Phase::ready;
+  }
+
+  if (count_ > 0) {
+    return start_next();
+  }
+
+  // Restore block protection once the queue drains
+  if (unlocked_range_ != no_range) {
+    const uint32_t range = unlocked_range_;
+    unlocked_range_ = no_range;
+    if (flash_.set_individual_block_lock(range, true) != SPIDeviceStatus::ok) {
+      return Status::error;
+    }
+  }
+  return Status::ok;
+}
+
+AsyncFlash::Status AsyncFlash::flush() {
+  while (!idle()) {
+    if (update() != Status::ok) {
+      return Status::error;
+    }
+  }
+  return Status::ok;
+}
+
+AsyncFlash::Status AsyncFlash::read(uint32_t addr, uint8_t *data, size_t size) {
+  if (!idle()) {
+    return Status::busy;
+  }
+  if (flash_.read(addr, data, size) != SPIDeviceStatus::ok) {
+    return Status::error;
+  }
+  return Status::ok;
+}
+
+bool AsyncFlash::idle() const {
+  return count_ == 0 && phase_ == Phase::ready;
+}
+
+size_t AsyncFlash::available() const {
+  return queue_depth - count_;
+}
+
+AsyncFlash::Operation &AsyncFlash::push() {
+  Operation &operation = queue_[(head_ + count_) % queue_depth];
+  ++count_;
+  return operation;
+}
+
+void AsyncFlash::pop() {
+  head_ = (head_ + 1) % queue_depth;
+  --count_;
+}
+
+AsyncFlash::Status AsyncFlash::start_next() {
+  if (!wps_set_) {
+    // Individual block locks only take effect while WPS is set
+    uint8_t reg_data = 0;
+    if (flash_.read_status_register3(reg_data) != SPIDeviceStatus::ok) {
+      return Status::error;
+    }
+    wps_set_ = true;
+    if ((reg_data & SPIFlash::wps_bit) == 0) {
+      if (flash_.start_write_status_register3(reg_data | SPIFlash::wps_bit) !=
+          SPIDeviceStatus::ok) {
+        wps_set_ = false;
+        return Status::error;
+      }
+      phase_ = Phase::protecting;
+      return Status::ok;
+    }
+  }
+
+  const Operation &operation = queue_[head_];
+  const uint32_t range = SPIFlash::lock_range(operation.address);
+  if (range != unlocked_range_) {
+    if (unlocked_range_ != no_range &&
+        flash_.set_individual_block_lock(unlocked_range_, true) != SPIDeviceStatus::ok) {
+      return Status::error;
+    }
+    unlocked_range_ = no_range;
+    if (flash_.set_individual_block_lock(range, false) != SPIDeviceStatus::ok) {
+      return Status::error;
+    }
+    unlocked_range_ = range;
+  }
+
+  SPIDeviceStatus ret = SPIDeviceStatus::ok;
+  switch (operation.type) {
+    case OperationType::program:
+      ret = flash_.start_program(operation.address, operation.data.data(), operation.size);
+      break;
+    case OperationType::erase_sector:
+      ret = flash_.start_erase(SPIInstruction::sector_erase_4kb, operation.address);
+      break;
+  }
+  if (ret != SPIDeviceStatus::ok) {
+    pop();
+    return Status::error;
+  }
+
+  phase_ = Phase::operating;
+  return Status::ok;
+}
+
+}  // namespace Pufferfish::Driver::SPI
@@ -0,0 +1,106 @@
+/// FlashReader.cpp
+/// This file has methods for a streaming sequential reader for SPI flash
+/// memory.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Pufferfish/Driver/SPI/FlashReader.h"
+
+namespace Pufferfish::Driver::SPI {
+
+SPIDeviceStatus FlashReader::open(uint32_t addr, size_t length) {
+  if (open_) {
+    return SPIDeviceStatus::busy;
+  }
+  if (addr >= SPIFlash::capacity || length > SPIFlash::capacity - addr) {
+    return SPIDeviceStatus::error;
+  }
+
+  SPIDeviceStatus ret = flash_.open_stream(addr);
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
+
+  open_ = true;
+  address_ = addr;
+  remaining_ = length;
+  return SPIDeviceStatus::ok;
+}
+
+SPIDeviceStatus FlashReader::start_next(uint8_t *data, size_t size, size_t &count) {
+  count = 0;
+  if (!open_) {
+    return SPIDeviceStatus::error;
+  }
+  if (remaining_ == 0 || size == 0) {
+    return SPIDeviceStatus::ok;
+  }
+
+  const size_t chunk = (size < remaining_) ? size : remaining_;
+  SPIDeviceStatus ret = flash_.continue_stream(data, chunk);
+  if (ret == SPIDeviceStatus::busy) {
+    return ret;
+  }
+  if (ret != SPIDeviceStatus::ok) {
+    open_ = false;
+    return ret;
+  }
+
+  count = chunk;
+  address_ += chunk;
+  remaining_ -= chunk;
+  return SPIDeviceStatus::ok;
+}
+
+SPIDeviceStatus FlashReader::poll() {
+  if (!open_) {
+    return SPIDeviceStatus::ok;
+  }
+
+  SPIDeviceStatus ret = flash_.read_status();
+  if (ret != SPIDeviceStatus::ok && ret != SPIDeviceStatus::busy) {
+    open_ = false;
+  }
+  return ret;
+}
+
+SPIDeviceStatus FlashReader::next(uint8_t *data, size_t size, size_t &count) {
+  SPIDeviceStatus ret = start_next(data, size, count);
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
+
+  do {
+    ret = poll();
+  } while (ret == SPIDeviceStatus::busy);
+  if (ret != SPIDeviceStatus::ok) {
+    count = 0;
+  }
+  return ret;
+}
+
+void FlashReader::close() {
+  if (!open_) {
+    return;
+  }
+
+  flash_.close_stream();
+  open_ = false;
+}
+
+}  // namespace Pufferfish::Driver::SPI
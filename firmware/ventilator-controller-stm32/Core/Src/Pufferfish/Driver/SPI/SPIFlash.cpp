@@ -123,128 +123,164 @@ SPIDeviceStatus SPIFlash::disable_write() {
   /* return SPIDeviceStatus */
   return ret;
 }
-/*
-SPIDeviceStatus SPIFlash::write_byte(uint32_t addr, const uint8_t *input, uint8_t size) {
+
+SPIDeviceStatus SPIFlash::write_byte(uint32_t addr, const uint8_t *input, size_t size) {
   uint8_t reg_data = 0;
-  // FIXME: We will need to use a statically-allocated vector instead of a C
-  // array. Also, it is an error to try to initialize a variable-sized array -
-  // that relies on a GCC extension - so the array is left uninitialized.
-  // NOLINTNEXTLINE(modernize-avoid-c-arrays)
-  uint8_t tx_buf[size + 4];
 
-  // Invoke read_block_status to get the status of block
-  SPIDeviceStatus block_status = this->read_block_status(addr);
+  /* A page program wraps around within its page, so reject data crossing a page boundary */
+  if (size == 0 || (addr % page_size) + size > page_size) {
+    return SPIDeviceStatus::write_error;
+  }
 
+  /* Invoke read_block_status to get the status of block */
+  SPIDeviceStatus block_status = this->read_block_status(addr);
   if (block_status == SPIDeviceStatus::block_lock) {
-    // if block is locked then invoke unLockIndividualBlock to unlock the block
+    /* if block is locked then invoke unLockIndividualBlock to unlock the block
+     */
     SPIDeviceStatus ret = this->unlock_individual_block(addr);
-    // return ret if it is not ok
+    /* return ret if it is not ok */
     if (ret != SPIDeviceStatus::ok) {
       return ret;
     }
   }
 
-  // Invoke read_status_register1 to get the status of device
+  /* Invoke read_status_register1 to get the status of device */
   SPIDeviceStatus ret = this->read_status_register1(reg_data);
-  // return ret if it is not ok
+  /* return ret if it is not ok */
   if (ret != SPIDeviceStatus::ok) {
     return ret;
   }
 
-  // if LSB bit is 1 then return SPIDeviceStatus as busy
+  /* if LSB bit is 1 then return SPIDeviceStatus as busy */
   if ((reg_data & 0x01U) == 1) {
     return SPIDeviceStatus::busy;
   }
 
-  // Update the Byte0 of tx_buf with write byte instruction
-  tx_buf[0] = static_cast<uint8_t>(SPIInstruction::write_byte);
+  /* Invoke start_program to send the instruction, address and data */
+  ret = this->start_program(addr, input, size);
+  /* return ret if it is not ok */
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
+
+  /* provide a delay of 3ms */
+  static const uint32_t write_delay = 3;
+  time_.delay(write_delay);
 
-  // Fill the Byte1-Byte3 with address and remaining bytes with input which is
-  // to be written
-  for (uint8_t index = 1; index <= (size + 4); index++) {
-    if (index < 4) {
-      tx_buf[index] = addr >> (static_cast<uint8_t>(CHAR_BIT) * (3U - index));
-    } else {
-      tx_buf[index] = input[index - 4];
-    }
+  /* Invoke lockIndividualBlock to lock the block */
+  ret = this->lock_individual_block(addr);
+  /* return ret if it is not ok */
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
   }
+  /* return SPIDeviceStatus */
+  return ret;
+}
 
-  // Invoke enableWrite to set the WEL bit to 1
-  ret = this->enable_write();
-  // return ret if it is not ok
+SPIDeviceStatus SPIFlash::read(uint32_t addr, uint8_t *data, size_t size) {
+  /* Invoke start_read to begin the transfer into the output */
+  SPIDeviceStatus ret = this->start_read(addr, data, size);
+  /* return ret if it is not ok */
   if (ret != SPIDeviceStatus::ok) {
     return ret;
   }
 
-  // Make the CS pin Low before write operation
-  spi_.chip_select(false);
+  /* Wait for the transfer to complete */
+  do {
+    ret = this->read_status();
+  } while (ret == SPIDeviceStatus::busy);
 
-  // Write data into the device
-  ret = spi_.write(static_cast<uint8_t *>(tx_buf), size + 4);
+  /* return SPIDeviceStatus */
+  return ret;
+}
 
-  // Make the CS pin High after write operation
-  spi_.chip_select(true);
+SPIDeviceStatus SPIFlash::start_read(uint32_t addr, uint8_t *data, size_t size) {
+  /* Invoke open_stream to send the instruction and address */
+  SPIDeviceStatus ret = this->open_stream(addr);
+  /* return ret if it is not ok */
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
 
-  // return ret if it is not ok
+  /* Start receiving the data directly into the output */
+  ret = spi_.start_read(data, size);
   if (ret != SPIDeviceStatus::ok) {
+    this->close_stream();
     return ret;
   }
 
-  // provide a delay of 3ms
-  time_.delay(3);
+  /* The CS pin is made high by read_status once the data is in */
+  read_mode_ = ReadMode::single;
+  return ret;
+}
 
-  // Invoke lockIndividualBlock to lock the block
-  ret = this->lock_individual_block(addr);
-  // return ret if it is not ok
-  if (ret != SPIDeviceStatus::ok) {
+SPIDeviceStatus SPIFlash::read_status() {
+  if (read_mode_ == ReadMode::idle) {
+    return SPIDeviceStatus::ok;
+  }
+
+  SPIDeviceStatus ret = spi_.read_status();
+  if (ret == SPIDeviceStatus::busy) {
     return ret;
   }
-  // return SPIDeviceStatus
+
+  /* Make the CS pin High after a single read, or after a failed stream */
+  if (read_mode_ == ReadMode::single || ret != SPIDeviceStatus::ok) {
+    this->close_stream();
+  }
   return ret;
 }
 
-SPIDeviceStatus SPIFlash::read_byte(uint32_t addr, uint8_t *data, uint8_t size) {
-  // FIXME: We will need to use a statically-allocated vector instead of a C
-  // array. Also, it is an error to try to initialize a variable-sized array -
-  // that relies on a GCC extension - so the array is left uninitialized.
-  // NOLINTNEXTLINE(modernize-avoid-c-arrays)
-  uint8_t tx_buf[size + 4];
-  // FIXME: We will need to use a statically-allocated vector instead of a C
-  // array. Also, it is an error to try to initialize a variable-sized array -
-  // that relies on a GCC extension - so the array is left uninitialized.
-  // NOLINTNEXTLINE(modernize-avoid-c-arrays)
-  uint8_t rx_buf[size + 4];
-
-  // Update the Byte0 of tx_buf with read byte instruction
-  tx_buf[0] = static_cast<uint8_t>(SPIInstruction::read_byte);
-
-  // Fill the Byte1-Byte3 with address
+SPIDeviceStatus SPIFlash::open_stream(uint32_t addr) {
+  static const size_t header_size = 5;
+  std::array<uint8_t, header_size> tx_buf = {0};
+
+  if (read_mode_ != ReadMode::idle) {
+    return SPIDeviceStatus::busy;
+  }
+
+  /* Update the Byte0 of tx_buf with fast read instruction */
+  tx_buf[0] = static_cast<uint8_t>(SPIInstruction::fast_read);
+
+  /* Fill the Byte1-Byte3 with address, leaving Byte4 as the dummy byte */
   for (uint8_t index = 1; index <= 3; index++) {
     tx_buf[index] = addr >> (static_cast<uint8_t>(CHAR_BIT) * (3U - index));
   }
 
-  // Make the CS pin Low before read operation
+  /* Make the CS pin Low before read operation*/
   spi_.chip_select(false);
 
-  // Write and Read data to and from the device
-  SPIDeviceStatus ret =
-      spi_.write_read(static_cast<uint8_t *>(tx_buf), static_cast<uint8_t *>(rx_buf), size + 4);
-
-  // Make the CS pin High after read operation
-  spi_.chip_select(true);
-
-  // return ret if it is not ok
+  /* Write the instruction, address and dummy byte */
+  SPIDeviceStatus ret = spi_.write(tx_buf.data(), header_size);
   if (ret != SPIDeviceStatus::ok) {
+    spi_.chip_select(true);
     return ret;
   }
 
-  for (uint8_t index = 4; index < (size + 4); index++) {
-    data[index - 4] = rx_buf[index];
+  read_mode_ = ReadMode::stream;
+  return ret;
+}
+
+SPIDeviceStatus SPIFlash::continue_stream(uint8_t *data, size_t size) {
+  if (read_mode_ != ReadMode::stream) {
+    return SPIDeviceStatus::error;
+  }
+
+  /* The chip keeps sending data from where the last chunk ended */
+  SPIDeviceStatus ret = spi_.start_read(data, size);
+  /* A chunk still in progress leaves the stream open */
+  if (ret != SPIDeviceStatus::ok && ret != SPIDeviceStatus::busy) {
+    this->close_stream();
   }
-  // return SPIDeviceStatus
   return ret;
 }
-*/
+
+void SPIFlash::close_stream() {
+  /* Make the CS pin High after read operation */
+  spi_.chip_select(true);
+  read_mode_ = ReadMode::idle;
+}
+
 SPIDeviceStatus SPIFlash::lock_individual_block(uint32_t addr) {
   static const uint8_t size = 4;
   std::array<uint8_t, size + 1> tx_buf = {0};
@@ -532,218 +568,21 @@ SPIDeviceStatus SPIFlash::erase_chip() {
 }
 
 SPIDeviceStatus SPIFlash::erase_sector_4kb(uint32_t addr) {
-  static const size_t size = 4;
-  std::array<uint8_t, size> tx_buf = {0};
-  uint8_t reg_data = 0;
-
-  /* Invoke read_block_status to get the status of block */
-  SPIDeviceStatus block_status = this->read_block_status(addr);
-  if (block_status == SPIDeviceStatus::block_lock) {
-    /* if block is locked then invoke unLockIndividualBlock to unlock the block
-     */
-    SPIDeviceStatus ret = this->unlock_individual_block(addr);
-    /* return ret if it is not ok */
-    if (ret != SPIDeviceStatus::ok) {
-      return ret;
-    }
-  }
-
-  /* Invoke read_status_register1 to get the status of device */
-  SPIDeviceStatus ret = this->read_status_register1(reg_data);
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-
-  /* if LSB bit is 1 then return SPIDeviceStatus as busy */
-  if ((reg_data & 0x01U) == 1) {
-    return SPIDeviceStatus::busy;
-  }
-
-  /* Update the Byte0 of tx_buf with sector erase of 4KB instruction */
-  tx_buf[0] = static_cast<uint8_t>(SPIInstruction::sector_erase_4kb);
-
-  /* Fill the Byte1-Byte3 with address */
-  for (uint8_t index = 1; index <= 3; index++) {
-    tx_buf[index] = addr >> (static_cast<uint8_t>(CHAR_BIT) * (3U - index));
-  }
-
-  /* Invoke enableWrite to set the WEL bit to 1 */
-  ret = this->enable_write();
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-
-  /* Make the CS pin Low before read operation*/
-  spi_.chip_select(false);
-
-  /* Write data into the device */
-  ret = spi_.write(tx_buf.data(), size);
-
-  /* Make the CS pin High after read operation */
-  spi_.chip_select(true);
-
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-
   /* provide a delay of 400ms */
   static const uint32_t erase_delay = 400;
-  time_.delay(erase_delay);
-
-  /* Invoke lockIndividualBlock to lock the block */
-  ret = this->lock_individual_block(addr);
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-  /* return SPIDeviceStatus */
-  return ret;
+  return this->erase(SPIInstruction::sector_erase_4kb, addr, erase_delay);
 }
 
 SPIDeviceStatus SPIFlash::erase_block_32kb(uint32_t addr) {
-  static const size_t size = 4;
-  std::array<uint8_t, size> tx_buf = {0};
-  uint8_t reg_data = 0;
-
-  /* Invoke read_block_status to get the status of block */
-  SPIDeviceStatus block_status = this->read_block_status(addr);
-  if (block_status == SPIDeviceStatus::block_lock) {
-    /* if block is locked then invoke unLockIndividualBlock to unlock the block
-     */
-    SPIDeviceStatus ret = this->unlock_individual_block(addr);
-    /* return ret if it is not ok */
-    if (ret != SPIDeviceStatus::ok) {
-      return ret;
-    }
-  }
-
-  /* Invoke read_status_register1 to get the status of device */
-  SPIDeviceStatus ret = this->read_status_register1(reg_data);
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-
-  /* if LSB bit is 1 then return SPIDeviceStatus as busy */
-  if ((reg_data & 0x01U) == 1) {
-    return SPIDeviceStatus::busy;
-  }
-
-  /* Update the Byte0 of tx_buf with block erase 32KB instruction */
-  tx_buf[0] = static_cast<uint8_t>(SPIInstruction::block_erase_32kb);
-
-  /* Fill the Byte1-Byte3 with address */
-  for (uint8_t index = 1; index <= 3; index++) {
-    tx_buf[index] = addr >> (static_cast<uint8_t>(CHAR_BIT) * (3U - index));
-  }
-
-  /* Invoke enableWrite to set the WEL bit to 1 */
-  ret = this->enable_write();
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-
-  /* Make the CS pin Low before read operation*/
-  spi_.chip_select(false);
-
-  /* Write data into the device */
-  ret = spi_.write(tx_buf.data(), size);
-
-  /* Make the CS pin High after read operation */
-  spi_.chip_select(true);
-
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-
   /* provide a delay of 1600ms */
   static const uint32_t erase_delay = 1600;
-  time_.delay(erase_delay);
-
-  /* Invoke lockIndividualBlock to lock the block */
-  ret = this->lock_individual_block(addr);
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-  /* return SPIDeviceStatus */
-  return ret;
+  return this->erase(SPIInstruction::block_erase_32kb, addr, erase_delay);
 }
 
 SPIDeviceStatus SPIFlash::erase_block_64kb(uint32_t addr) {
-  static const size_t size = 4;
-  std::array<uint8_t, size> tx_buf = {0};
-  uint8_t reg_data = 0;
-
-  /* Invoke read_block_status to get the status of block */
-  SPIDeviceStatus block_status = this->read_block_status(addr);
-  if (block_status == SPIDeviceStatus::block_lock) {
-    /* if block is locked then invoke unLockIndividualBlock to unlock the block
-     */
-    SPIDeviceStatus ret = this->unlock_individual_block(addr);
-    /* return ret if it is not ok */
-    if (ret != SPIDeviceStatus::ok) {
-      return ret;
-    }
-  }
-
-  /* Invoke read_status_register1 to get the status of device */
-  SPIDeviceStatus ret = this->read_status_register1(reg_data);
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-
-  /* if LSB bit is 1 then return SPIDeviceStatus as busy */
-  if ((reg_data & 0x01U) == 1) {
-    return SPIDeviceStatus::busy;
-  }
-
-  /* Update the Byte0 of tx_buf with block erase 64KB instruction */
-  tx_buf[0] = static_cast<uint8_t>(SPIInstruction::block_erase_64kb);
-
-  /* Fill the Byte1-Byte3 with address */
-  for (uint8_t index = 1; index <= 3; index++) {
-    tx_buf[index] = addr >> (static_cast<uint8_t>(CHAR_BIT) * (3U - index));
-  }
-
-  /* Invoke enableWrite to set the WEL bit to 1 */
-  ret = this->enable_write();
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-
-  /* Make the CS pin Low before read operation*/
-  spi_.chip_select(false);
-
-  /* Write data into the device */
-  ret = spi_.write(tx_buf.data(), size);
-
-  /* Make the CS pin High after read operation */
-  spi_.chip_select(true);
-
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-
   /* provide a delay of 2000ms */
   static const uint32_t erase_delay = 2000;
-  time_.delay(erase_delay);
-
-  /* Invoke lockIndividualBlock to lock the block */
-  ret = this->lock_individual_block(addr);
-  /* return ret if it is not ok */
-  if (ret != SPIDeviceStatus::ok) {
-    return ret;
-  }
-  /* return SPIDeviceStatus */
-  return ret;
+  return this->erase(SPIInstruction::block_erase_64kb, addr, erase_delay);
 }
 
 SPIDeviceStatus SPIFlash::write_status_register1(uint8_t input) {
@@ -1100,4 +939,157 @@ SPIDeviceStatus SPIFlash::reset_device() {
   return ret;
 }
 
+SPIDeviceStatus SPIFlash::start_program(uint32_t addr, const uint8_t *input, size_t size) {
+  /* A page program wraps around within its page, so reject data crossing a page boundary */
+  if (size == 0 || (addr % page_size) + size > page_size) {
+    return SPIDeviceStatus::write_error;
+  }
+
+  /* Invoke write_command to set the WEL bit and send the instruction and address */
+  SPIDeviceStatus ret = this->write_command(SPIInstruction::write_byte, addr);
+  if (ret == SPIDeviceStatus::ok) {
+    /* Write the data straight from the input */
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    ret = spi_.write(const_cast<uint8_t *>(input), size);
+  }
+
+  /* Make the CS pin High after write operation */
+  spi_.chip_select(true);
+
+  /* return SPIDeviceStatus */
+  return ret;
+}
+
+SPIDeviceStatus SPIFlash::start_erase(SPIInstruction instruction, uint32_t addr) {
+  /* Invoke write_command to set the WEL bit and send the instruction and address */
+  SPIDeviceStatus ret = this->write_command(instruction, addr);
+
+  /* Make the CS pin High after write operation */
+  spi_.chip_select(true);
+
+  /* return SPIDeviceStatus */
+  return ret;
+}
+
+SPIDeviceStatus SPIFlash::start_write_status_register3(uint8_t input) {
+  static const size_t size = 2;
+  std::array<uint8_t, size> tx_buf = {0};
+
+  /* Update the tx_buf with write status register 3 instruction and input */
+  tx_buf[0] = static_cast<uint8_t>(SPIInstruction::write_status_register3);
+  tx_buf[1] = input;
+
+  /* Invoke enableWrite to set the WEL bit to 1 */
+  SPIDeviceStatus ret = this->enable_write();
+  /* return ret if it is not ok */
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
+
+  /* Make the CS pin Low before write operation*/
+  spi_.chip_select(false);
+
+  /* Write data into the device */
+  ret = spi_.write(tx_buf.data(), size);
+
+  /* Make the CS pin High after write operation */
+  spi_.chip_select(true);
+
+  /* return SPIDeviceStatus */
+  return ret;
+}
+
+SPIDeviceStatus SPIFlash::set_individual_block_lock(uint32_t addr, bool lock) {
+  /* Invoke write_command to set the WEL bit and send the instruction and address */
+  SPIDeviceStatus ret = this->write_command(
+      lock ? SPIInstruction::lock_block : SPIInstruction::unlock_block, addr);
+
+  /* Make the CS pin High after write operation */
+  spi_.chip_select(true);
+
+  /* return SPIDeviceStatus */
+  return ret;
+}
+
+uint32_t SPIFlash::lock_range(uint32_t addr) {
+  static const uint32_t last_block = (capacity / block_size) - 1;
+  const uint32_t block = addr / block_size;
+  if (block == 0 || block == last_block) {
+    return addr - (addr % sector_size);
+  }
+  return addr - (addr % block_size);
+}
+
+SPIDeviceStatus SPIFlash::write_command(SPIInstruction instruction, uint32_t addr) {
+  static const size_t size = 4;
+  std::array<uint8_t, size> tx_buf = {0};
+
+  /* Update the Byte0 of tx_buf with the instruction */
+  tx_buf[0] = static_cast<uint8_t>(instruction);
+
+  /* Fill the Byte1-Byte3 with address */
+  for (uint8_t index = 1; index <= 3; index++) {
+    tx_buf[index] = addr >> (static_cast<uint8_t>(CHAR_BIT) * (3U - index));
+  }
+
+  /* Invoke enableWrite to set the WEL bit to 1 */
+  SPIDeviceStatus ret = this->enable_write();
+  /* return ret if it is not ok */
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
+
+  /* Make the CS pin Low before write operation; the caller makes it High */
+  spi_.chip_select(false);
+
+  /* Write data into the device */
+  return spi_.write(tx_buf.data(), size);
+}
+
+SPIDeviceStatus SPIFlash::erase(SPIInstruction instruction, uint32_t addr, uint32_t erase_delay) {
+  uint8_t reg_data = 0;
+
+  /* Invoke read_block_status to get the status of block */
+  SPIDeviceStatus block_status = this->read_block_status(addr);
+  if (block_status == SPIDeviceStatus::block_lock) {
+    /* if block is locked then invoke unLockIndividualBlock to unlock the block
+     */
+    SPIDeviceStatus ret = this->unlock_individual_block(addr);
+    /* return ret if it is not ok */
+    if (ret != SPIDeviceStatus::ok) {
+      return ret;
+    }
+  }
+
+  /* Invoke read_status_register1 to get the status of device */
+  SPIDeviceStatus ret = this->read_status_register1(reg_data);
+  /* return ret if it is not ok */
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
+
+  /* if LSB bit is 1 then return SPIDeviceStatus as busy */
+  if ((reg_data & 0x01U) == 1) {
+    return SPIDeviceStatus::busy;
+  }
+
+  /* Invoke start_erase to send the erase instruction and address */
+  ret = this->start_erase(instruction, addr);
+  /* return ret if it is not ok */
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
+
+  time_.delay(erase_delay);
+
+  /* Invoke lockIndividualBlock to lock the block */
+  ret = this->lock_individual_block(addr);
+  /* return ret if it is not ok */
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
+  /* return SPIDeviceStatus */
+  return ret;
+}
+
 }  // namespace Pufferfish::Driver::SPI
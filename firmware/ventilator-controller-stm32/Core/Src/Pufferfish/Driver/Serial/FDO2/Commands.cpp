@@ -8,9 +8,8 @@
 #include "Pufferfish/Driver/Serial/FDO2/Commands.h"
 
 #include <algorithm>
-#include <cstdio>
-#include <cstdlib>
-#include <sstream>
+
+#include "Pufferfish/Util/Decimal.h"
 
 namespace FDO2 = Pufferfish::Driver::Serial::FDO2;
 
@@ -22,7 +21,9 @@ namespace FDO2 = Pufferfish::Driver::Serial::FDO2;
 #define RESPONSE_PARSE_TAGGED(type, field, input_buffer, output_response) \
   if (std::equal(Headers::field.begin(), Headers::field.end(), (input_buffer).buffer())) {\
     type response{};\
-    parse(input_buffer, response);\
+    if (parse(input_buffer, response) != Responses::ParseStatus::ok) {\
+      return Status::invalid_args;\
+    }\
     (output_response).set(response);\
     return Status::ok;\
   }
@@ -66,62 +67,81 @@ namespace Pufferfish::Driver::Serial::FDO2 {
 
 namespace Responses {
 
+namespace {
+
+// Scans the space-delimited integer arguments following the header of a response, in one pass
+// over the buffer
+class ArgScanner {
+ public:
+  explicit ArgScanner(const ChunkBuffer &input_buffer)
+      // The last character of the buffer is the frame delimiter
+      : end_(input_buffer.buffer() + (input_buffer.empty() ? 0 : input_buffer.size() - 1)),
+        current_(std::min(input_buffer.buffer() + Headers::length, end_)) {}
+
+  template <typename Integer>
+  ParseStatus next(Integer &value) {
+    if (current_ == end_) {
+      return ParseStatus::missing_arg;
+    }
+
+    if (*current_ != arg_delimiter) {
+      return ParseStatus::invalid_arg_delimiter;
+    }
+
+    const char *start = current_ + 1;
+    current_ = Util::read_decimal(start, end_, value);
+    if (current_ == start) {
+      return ParseStatus::invalid_arg;
+    }
+
+    return ParseStatus::ok;
+  }
+
+  [[nodiscard]] ParseStatus finish() const {
+    if (current_ != end_) {
+      return ParseStatus::unexpected_arg;
+    }
+
+    return ParseStatus::ok;
+  }
+
+ private:
+  const char *end_;
+  const char *current_;
+};
+
+// Scans each of the given fields in order, stopping at the first failure
+template <typename... Integer>
+ParseStatus scan_args(const ChunkBuffer &input_buffer, Integer &... fields) {
+  ArgScanner scanner(input_buffer);
+  if constexpr (sizeof...(fields) > 0) {
+    ParseStatus status = ParseStatus::ok;
+    auto scan = [&scanner, &status](auto &field) {
+      if (status == ParseStatus::ok) {
+        status = scanner.next(field);
+      }
+    };
+    (scan(fields), ...);
+    if (status != ParseStatus::ok) {
+      return status;
+    }
+  }
+
+  return scanner.finish();
+}
+
+}  // namespace
+
 // Vers
 
 template <>
 ParseStatus parse<Vers>(const ChunkBuffer &input_buffer, Vers &response) {
-  const char *end = input_buffer.buffer() + input_buffer.size() - 1;
-  const char *parse_start = input_buffer.buffer() + Headers::length;
-  char *parse_end = nullptr;
-  if (*parse_start != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // device_id
-  parse_start = parse_start + 1;
-  parse_end = nullptr;
-  response.device_id = std::strtoul(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // num_channels
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.num_channels = std::strtoul(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // firmware_rev
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.firmware_rev = std::strtoul(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // type
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.type = std::strtoul(parse_start, &parse_end, arg_base);
-  if (parse_end != end) {
-    return ParseStatus::unexpected_arg;
-  }
-
-  return ParseStatus::ok;
+  return scan_args(
+      input_buffer,
+      response.device_id,
+      response.num_channels,
+      response.firmware_rev,
+      response.type);
 }
 
 bool operator==(const Vers &left, const Vers &right) {
@@ -133,142 +153,30 @@ bool operator==(const Vers &left, const Vers &right) {
 
 template <>
 ParseStatus parse<Mraw>(const ChunkBuffer &input_buffer, Mraw &response) {
-  const char *end = input_buffer.buffer() + input_buffer.size() - 1;
-  const char *parse_start = input_buffer.buffer() + Headers::length;
-  char *parse_end = nullptr;
-  if (*parse_start != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // po2
-  parse_start = parse_start + 1;
-  parse_end = nullptr;
-  response.po2 = std::strtol(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // temperature
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.temperature = std::strtol(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // status
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.status = std::strtoul(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // phase_shift
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.phase_shift = std::strtol(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // signal_intensity
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.signal_intensity = std::strtol(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // ambient_light
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.ambient_light = std::strtol(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // ambient_pressure
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.ambient_pressure = std::strtol(parse_start, &parse_end, arg_base);
-  if (parse_end >= end) {
-    return ParseStatus::missing_arg;
-  }
-
-  if (*parse_end != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // relative_humidity
-  parse_start = parse_end + 1;
-  parse_end = nullptr;
-  response.relative_humidity = std::strtol(parse_start, &parse_end, arg_base);
-  if (parse_end != end) {
-    return ParseStatus::unexpected_arg;
-  }
-
-  return ParseStatus::ok;
+  return scan_args(
+      input_buffer,
+      response.po2,
+      response.temperature,
+      response.status,
+      response.phase_shift,
+      response.signal_intensity,
+      response.ambient_light,
+      response.ambient_pressure,
+      response.relative_humidity);
 }
 
 // Logo
 
 template <>
 ParseStatus parse<Logo>(const ChunkBuffer &input_buffer, Logo & /*response*/) {
-  const char *end = input_buffer.buffer() + input_buffer.size() - 1;
-  const char *parse_start = input_buffer.buffer() + Headers::length;
-  const char *parse_end = parse_start + 1;
-  if (parse_end != end) {
-    return ParseStatus::unexpected_arg;
-  }
-
-  return ParseStatus::ok;
+  return scan_args(input_buffer);
 }
 
 // Bcst
 
 template <>
 ParseStatus parse<Bcst>(const ChunkBuffer &input_buffer, Bcst &response) {
-  const char *end = input_buffer.buffer() + input_buffer.size() - 1;
-  const char *parse_start = input_buffer.buffer() + Headers::length;
-  char *parse_end = nullptr;
-  if (*parse_start != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // interval
-  parse_start = parse_start + 1;
-  parse_end = nullptr;
-  response.interval = std::strtoul(parse_start, &parse_end, arg_base);
-  if (parse_end != end) {
-    return ParseStatus::unexpected_arg;
-  }
-
-  return ParseStatus::ok;
+  return scan_args(input_buffer, response.interval);
 }
 
 bool operator==(const Bcst &left, const Bcst &right) {
@@ -279,22 +187,7 @@ bool operator==(const Bcst &left, const Bcst &right) {
 
 template <>
 ParseStatus parse<Erro>(const ChunkBuffer &input_buffer, Erro &response) {
-  const char *end = input_buffer.buffer() + input_buffer.size() - 1;
-  const char *parse_start = input_buffer.buffer() + Headers::length;
-  char *parse_end = nullptr;
-  if (*parse_start != arg_delimiter) {
-    return ParseStatus::invalid_arg_delimiter;
-  }
-
-  // code
-  parse_start = parse_start + 1;
-  parse_end = nullptr;
-  response.code = std::strtol(parse_start, &parse_end, arg_base);
-  if (parse_end != end) {
-    return ParseStatus::unexpected_arg;
-  }
-
-  return ParseStatus::ok;
+  return scan_args(input_buffer, response.code);
 }
 
 }  // namespace Responses
@@ -318,15 +211,11 @@ void write<Bcst>(const Bcst &request, ChunkBuffer &output_buffer) {
   output_buffer.clear();
   output_buffer.copy_from(Headers::bcst);
   output_buffer.push_back(arg_delimiter);
-  // We use a stream to avoid using snprintf, which Clang-tidy complains about due to its
-  // use of varargs. Hopefully the way we're using streams here isn't causing dynamic
-  // memory allocation.
-  std::ostringstream stream;
-  stream.rdbuf()->pubsetbuf(
+  size_t length = Util::write_decimal(
+      request.interval,
       output_buffer.buffer() + output_buffer.size(),
       ChunkBuffer::max_size() - output_buffer.size());
-  stream << request.interval;
-  if (output_buffer.resize(output_buffer.size() + stream.tellp()) != IndexStatus::ok) {
+  if (length == 0 || output_buffer.resize(output_buffer.size() + length) != IndexStatus::ok) {
     // TODO(lietk12): return error
     return;
   }
@@ -7,8 +7,6 @@
 
 #include "Pufferfish/Driver/Serial/FDO2/Device.h"
 
-#include <cstdio>
-
 namespace FDO2 = Pufferfish::Driver::Serial::FDO2;
 
 // This macro is used to add a setter for a specified request type with an associated
@@ -108,7 +106,7 @@ RequestSender::Status RequestSender::transform(
 
 Device::Status Device::start_broadcast() {
   Requests::ChunkBuffer request_buffer;
-  Requests::Bcst bcst{broadcast_interval};
+  Requests::Bcst bcst{broadcast_interval_};
   Request request{};
   request.set(bcst);
   requests_.transform(request, request_buffer);
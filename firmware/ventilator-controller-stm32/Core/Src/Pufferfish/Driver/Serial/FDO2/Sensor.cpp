@@ -35,9 +35,10 @@ StateMachine::Action StateMachine::update(uint32_t current_time, bool passed_che
       break;
     case Action::check_version:
       if (passed_check) {
+        backoff_ = initial_backoff;
         next_action_ = Action::start_broadcast;
-      } else if (timed_out()) {
-        next_action_ = Action::request_version;
+      } else if (timed_out(response_timeout)) {
+        start_retry(Action::request_version);
       }
       break;
     case Action::start_broadcast:
@@ -46,10 +47,18 @@ StateMachine::Action StateMachine::update(uint32_t current_time, bool passed_che
       break;
     case Action::check_broadcast:
       if (passed_check) {
+        backoff_ = initial_backoff;
         next_action_ = Action::wait_measurement;
-      } else if (timed_out()) {
-        next_action_ = Action::start_broadcast;
+      } else if (timed_out(response_timeout)) {
+        start_retry(Action::start_broadcast);
+      }
+      break;
+    case Action::wait_retry:
+      if (timed_out(backoff_)) {
+        next_action_ = retry_action_;
+        backoff_ = (backoff_ < max_backoff / 2) ? 2 * backoff_ : max_backoff;
       }
+      break;
     case Action::wait_measurement:
       break;
   }
@@ -60,8 +69,14 @@ void StateMachine::start_request() {
   request_time_ = current_time_;
 }
 
-bool StateMachine::timed_out() const {
-  return !Util::within_timeout(request_time_, response_timeout, current_time_);
+void StateMachine::start_retry(Action action) {
+  retry_action_ = action;
+  next_action_ = Action::wait_retry;
+  start_request();
+}
+
+bool StateMachine::timed_out(uint32_t timeout) const {
+  return !Util::within_timeout(request_time_, timeout, current_time_);
 }
 
 RESPONSE_TAGGED_COMPARISON(Responses::Vers, vers)
@@ -87,6 +102,9 @@ InitializableState Sensor::setup() {
       return InitializableState::setup;
     case Action::check_broadcast:
       return check_broadcast(time_.millis());
+    case Action::wait_retry:
+      next_action_ = fsm_.update(time_.millis());
+      return InitializableState::setup;
     case Action::wait_measurement:
       next_action_ = fsm_.update(time_.millis());
       return InitializableState::ok;
@@ -99,15 +117,49 @@ InitializableState Sensor::output(uint32_t &po2) {
     return InitializableState::failed;
   }
 
-  Response response;
-  device_.receive(response);
-  // This is a tagged union access
-  if (response.tag == CommandTypes::mraw) {
-    po2 = response.value.mraw.po2;  // NOLINT(cppcoreguidelines-pro-type-union-access)
+  receive_all(time_.millis());
+  if (measured_) {
+    po2 = mraw_.po2;
+  }
+  return InitializableState::ok;
+}
+
+InitializableState Sensor::output(Responses::Mraw &mraw, uint32_t &received_time) {
+  if (next_action_ != Action::wait_measurement) {
+    return InitializableState::failed;
   }
+
+  receive_all(time_.millis());
+  if (!measured_) {
+    return InitializableState::setup;
+  }
+
+  mraw = mraw_;
+  received_time = mraw_time_;
   return InitializableState::ok;
 }
 
+void Sensor::receive_all(uint32_t current_time) {
+  // Drain every complete response, so that stale measurements don't pile up in the UART buffer
+  Response response;
+  while (device_.receive(response) == Device::Status::ok) {
+    // This is a tagged union access
+    switch (response.tag) {
+      case CommandTypes::mraw:
+        mraw_ = response.value.mraw;  // NOLINT(cppcoreguidelines-pro-type-union-access)
+        mraw_time_ = current_time;
+        measured_ = true;
+        break;
+      case CommandTypes::erro:
+        ++error_count_;
+        last_error_ = response.value.erro.code;  // NOLINT(cppcoreguidelines-pro-type-union-access)
+        break;
+      default:
+        break;
+    }
+  }
+}
+
 bool Sensor::get_response(CommandTypes type, Response &response) {
   while (true) {
     if (device_.receive(response) != Device::Status::ok) {
@@ -117,6 +169,11 @@ bool Sensor::get_response(CommandTypes type, Response &response) {
     if (response.tag == type) {
       return true;
     }
+
+    if (response.tag == CommandTypes::erro) {
+      ++error_count_;
+      last_error_ = response.value.erro.code;  // NOLINT(cppcoreguidelines-pro-type-union-access)
+    }
   }
 }
 
@@ -149,7 +206,7 @@ InitializableState Sensor::check_broadcast(uint32_t current_time) {
     return InitializableState::setup;
   }
 
-  if (response == expected_bcst) {
+  if (response == Responses::Bcst{device_.broadcast_interval()}) {
     next_action_ = fsm_.update(current_time, true);
   } else {
     next_action_ = fsm_.update(current_time);
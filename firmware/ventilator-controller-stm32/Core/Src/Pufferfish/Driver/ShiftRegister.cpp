@@ -23,27 +23,62 @@ bool ShiftRegister::get_channel(uint8_t chan) const {
   return (output_reg_ & (1U << chan)) != 0U;
 }
 
-void ShiftRegister::update() {
-  // reset all pins to initial state
-  serial_in_.write(false);
-  serial_clear_.write(false);
-  serial_clock_.write(false);
-  r_clock_.write(false);
-  time_.delay_micros(baud_rate);
+bool ShiftRegister::update() {
+  if (busy_ || (synced_ && output_reg_ == shifted_reg_)) {
+    return false;
+  }
 
-  for (int i = num_channels - 1; i >= 0; i--) {
-    serial_in_.write(get_channel(i));
-    time_.delay_micros(baud_rate);
-    serial_clock_.write(true);
-    time_.delay_micros(baud_rate);
+  sequence_reg_ = output_reg_;
+  edge_ = 0;
+  busy_ = true;
+  return true;
+}
+
+bool ShiftRegister::step() {
+  if (!busy_) {
+    return false;
+  }
+
+  const uint8_t edge = edge_;
+  ++edge_;
+  if (edge == 0) {
+    // reset all pins to initial state
+    serial_in_.write(false);
+    serial_clear_.write(false);
     serial_clock_.write(false);
-    time_.delay_micros(baud_rate);
+    r_clock_.write(false);
+    return true;
+  }
+
+  if (edge <= edges_per_channel * num_channels) {
+    // channels are shifted out from the highest to the lowest
+    const uint8_t index = (edge - 1) / edges_per_channel;
+    const auto channel = static_cast<uint8_t>(num_channels - 1 - index);
+    switch ((edge - 1) % edges_per_channel) {
+      case 0:
+        serial_in_.write((sequence_reg_ & (1U << channel)) != 0U);
+        break;
+      case 1:
+        serial_clock_.write(true);
+        break;
+      default:
+        serial_clock_.write(false);
+        break;
+    }
+    return true;
   }
 
   // set RClock to display all the LED at once
-  r_clock_.write(true);
-  time_.delay_micros(baud_rate);
+  if (edge < sequence_edges - 1) {
+    r_clock_.write(true);
+    return true;
+  }
+
   r_clock_.write(false);
+  shifted_reg_ = sequence_reg_;
+  synced_ = true;
+  busy_ = false;
+  return false;
 }
 
 void ShiftRegister::clear() {
@@ -39,15 +39,22 @@ I2CDeviceStatus MockI2CDevice::read(uint8_t *buf, size_t count) {
     buf[index] = read_buf[index];
   }
   read_buf_queue_.pop();
+  I2CDeviceStatus status = read_status_queue_.front();
+  read_status_queue_.pop();
 
-  return I2CDeviceStatus::ok;
+  return status;
 }
 
 void MockI2CDevice::add_read(const uint8_t *buf, size_t count) {
+  add_read(buf, count, I2CDeviceStatus::ok);
+}
+
+void MockI2CDevice::add_read(const uint8_t *buf, size_t count, I2CDeviceStatus status) {
   size_t index = 0;
   size_t minumum = (count < read_buf_size) ? count : read_buf_size;
 
   read_buf_queue_.emplace();
+  read_status_queue_.push(status);
   auto &read_buf = read_buf_queue_.back();
 
   for (index = 0; index < minumum; index++) {
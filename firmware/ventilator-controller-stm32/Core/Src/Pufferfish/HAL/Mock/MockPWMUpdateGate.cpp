@@ -0,0 +1,51 @@
+/// MockPWMUpdateGate.cpp
+/// This file has methods for mock abstract interfaces for testing PWM
+/// update gates.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Pufferfish/HAL/Mock/MockPWMUpdateGate.h"
+
+namespace Pufferfish::HAL {
+
+void MockPWMUpdateGate::synchronize() {
+  ++synchronizations_;
+}
+
+void MockPWMUpdateGate::hold() {
+  held_ = true;
+}
+
+void MockPWMUpdateGate::release() {
+  held_ = false;
+  ++releases_;
+}
+
+bool MockPWMUpdateGate::held() const {
+  return held_;
+}
+
+size_t MockPWMUpdateGate::synchronizations() const {
+  return synchronizations_;
+}
+
+size_t MockPWMUpdateGate::releases() const {
+  return releases_;
+}
+
+}  // namespace Pufferfish::HAL
@@ -0,0 +1,56 @@
+/// MockPulseOutput.cpp
+/// This file has methods for mock abstract interfaces for testing Pulse
+/// Output.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Pufferfish/HAL/Mock/MockPulseOutput.h"
+
+namespace Pufferfish::HAL {
+
+void MockPulseOutput::write(bool output) {
+  last_output_ = output;
+  period_ = 0;
+  duty_ = 0;
+}
+
+TimerStatus MockPulseOutput::set_pulses(uint32_t period, uint32_t duty) {
+  if (duty == 0 || duty >= period) {
+    write(duty != 0);
+    return TimerStatus::ok;
+  }
+
+  last_output_ = false;
+  period_ = period;
+  duty_ = duty;
+  return TimerStatus::ok;
+}
+
+bool MockPulseOutput::get_write() const {
+  return last_output_;
+}
+
+uint32_t MockPulseOutput::get_period() const {
+  return period_;
+}
+
+uint32_t MockPulseOutput::get_duty() const {
+  return duty_;
+}
+
+}  // namespace Pufferfish::HAL
@@ -0,0 +1,113 @@
+/// MockSFM3019.cpp
+/// This file has methods for a mock I2C device which answers commands like
+/// a healthy SFM3019 flow sensor.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Pufferfish/HAL/Mock/MockSFM3019.h"
+
+#include <cmath>
+#include <limits>
+
+#include "Pufferfish/Driver/I2C/SFM3019/Types.h"
+
+namespace Pufferfish::HAL {
+
+using SFM3019Command = Driver::I2C::SFM3019::Command;
+
+I2CDeviceStatus MockSFM3019::read(uint8_t *buf, size_t count) {
+  switch (static_cast<SFM3019Command>(command_)) {
+    case SFM3019Command::read_product_id:
+      write_word(buf, count, 0, 0x0402);
+      write_word(buf, count, 1, 0x0611);
+      return I2CDeviceStatus::ok;
+    case SFM3019Command::read_conversion:
+      write_word(buf, count, 0, static_cast<uint16_t>(scale_factor));
+      write_word(buf, count, 1, static_cast<uint16_t>(offset));
+      write_word(buf, count, 2, flow_unit);
+      return I2CDeviceStatus::ok;
+    default:
+      break;
+  }
+  if (!measuring_) {
+    return I2CDeviceStatus::no_new_data;
+  }
+
+  write_word(buf, count, 0, raw_flow_);
+  write_word(buf, count, 1, temperature);
+  write_word(buf, count, 2, 0);
+  return I2CDeviceStatus::ok;
+}
+
+I2CDeviceStatus MockSFM3019::write(uint8_t *buf, size_t count) {
+  if (count == sizeof(uint8_t)) {
+    // The only single-byte command is the general call reset
+    command_ = buf[0];
+    measuring_ = false;
+    return I2CDeviceStatus::ok;
+  }
+  if (count < sizeof(uint16_t)) {
+    return I2CDeviceStatus::invalid_arguments;
+  }
+
+  command_ = static_cast<uint16_t>((buf[0] << 8U) | buf[1]);
+  switch (static_cast<SFM3019Command>(command_)) {
+    case SFM3019Command::start_measure_air:
+    case SFM3019Command::start_measure_o2:
+    case SFM3019Command::start_measure_mixture:
+      measuring_ = true;
+      break;
+    case SFM3019Command::stop_measure:
+      measuring_ = false;
+      break;
+    default:
+      break;
+  }
+  return I2CDeviceStatus::ok;
+}
+
+void MockSFM3019::set_flow(float flow) {
+  static const float raw_min = std::numeric_limits<int16_t>::min();
+  static const float raw_max = std::numeric_limits<int16_t>::max();
+
+  float raw = std::round(flow * scale_factor) + offset;
+  if (raw < raw_min) {
+    raw = raw_min;
+  }
+  if (raw > raw_max) {
+    raw = raw_max;
+  }
+  raw_flow_ = static_cast<uint16_t>(static_cast<int16_t>(raw));
+}
+
+bool MockSFM3019::measuring() const {
+  return measuring_;
+}
+
+void MockSFM3019::write_word(uint8_t *buf, size_t count, size_t index, uint16_t word) {
+  size_t start = index * word_size;
+  if (start + word_size > count) {
+    return;
+  }
+
+  buf[start] = static_cast<uint8_t>(word >> 8U);
+  buf[start + 1] = static_cast<uint8_t>(word & 0xffU);
+  buf[start + 2] = crc8_.compute(buf + start, sizeof(uint16_t));
+}
+
+}  // namespace Pufferfish::HAL
@@ -0,0 +1,52 @@
+/// MockTraceOutput.cpp
+/// This file has methods for mock abstract interfaces for testing debug
+/// trace outputs.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Pufferfish/HAL/Mock/MockTraceOutput.h"
+
+namespace Pufferfish::HAL {
+
+bool MockTraceOutput::enabled() {
+  return enabled_;
+}
+
+size_t MockTraceOutput::write(const uint8_t *bytes, size_t size) {
+  if (!enabled_) {
+    return 0;
+  }
+
+  size_t written = size < write_limit_ ? size : write_limit_;
+  written_.insert(written_.end(), bytes, bytes + written);
+  return written;
+}
+
+void MockTraceOutput::set_enabled(bool enabled) {
+  enabled_ = enabled;
+}
+
+void MockTraceOutput::set_write_limit(size_t limit) {
+  write_limit_ = limit;
+}
+
+const std::vector<uint8_t> &MockTraceOutput::written() const {
+  return written_;
+}
+
+}  // namespace Pufferfish::HAL
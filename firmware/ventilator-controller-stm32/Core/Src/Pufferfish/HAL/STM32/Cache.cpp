@@ -0,0 +1,88 @@
+/// Cache.cpp
+/// This file has methods for Cortex-M7 cache management around DMA transfers.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Pufferfish/HAL/STM32/Cache.h"
+
+// Defined in the linker script
+extern "C" uint32_t _sdma_buffers;  // NOLINT(bugprone-reserved-identifier)
+
+namespace Pufferfish::HAL {
+
+void Cache::configure_mpu() {
+  // The D2 SRAMs holding the DMA region are clocked off after reset
+  __HAL_RCC_D2SRAM1_CLK_ENABLE();
+  __HAL_RCC_D2SRAM2_CLK_ENABLE();
+  __HAL_RCC_D2SRAM3_CLK_ENABLE();
+
+  HAL_MPU_Disable();
+
+  // Normal memory, non-cacheable (TEX=1, C=0, B=0), shareable
+  MPU_Region_InitTypeDef region{};
+  region.Enable = MPU_REGION_ENABLE;
+  region.Number = MPU_REGION_NUMBER0;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  region.BaseAddress = reinterpret_cast<uint32_t>(&_sdma_buffers);
+  region.Size = MPU_REGION_SIZE_32KB;
+  region.SubRegionDisable = 0x00;
+  region.TypeExtField = MPU_TEX_LEVEL1;
+  region.AccessPermission = MPU_REGION_FULL_ACCESS;
+  region.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+  region.IsShareable = MPU_ACCESS_SHAREABLE;
+  region.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+  region.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+  HAL_MPU_ConfigRegion(&region);
+
+  HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+}
+
+void Cache::enable() {
+  SCB_EnableICache();
+  SCB_EnableDCache();
+}
+
+bool Cache::dcache_enabled() {
+  // The following lines suppress Eclipse CDT's warning about C-style casts and
+  // unresolvable fields; these come from the STM32 HAL so we can't do anything
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
+  return (SCB->CCR &  // @suppress("C-Style cast instead of C++ cast") // @suppress("Field cannot be resolved")
+          SCB_CCR_DC_Msk) != 0U;
+}
+
+void Cache::clean(const void *address, size_t size) {
+  if (!dcache_enabled() || size == 0) {
+    return;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast,cppcoreguidelines-pro-type-reinterpret-cast)
+  auto *words = reinterpret_cast<uint32_t *>(const_cast<void *>(address));
+  SCB_CleanDCache_by_Addr(words, static_cast<int32_t>(size));
+}
+
+void Cache::invalidate(void *address, size_t size) {
+  if (!dcache_enabled() || size == 0) {
+    return;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  auto *words = reinterpret_cast<uint32_t *>(address);
+  SCB_InvalidateDCache_by_Addr(words, static_cast<int32_t>(size));
+}
+
+}  // namespace Pufferfish::HAL
@@ -31,4 +31,25 @@ I2CDeviceStatus HALI2CDevice::write(uint8_t *buf, size_t count) {
   return I2CDeviceStatus::write_error;
 }
 
+I2CDeviceStatus HALI2CDevice::start_read(uint8_t *buf, size_t count) {
+  HAL_StatusTypeDef stat = HAL_I2C_Master_Receive_IT(&dev_, addr << 1U, buf, count);
+  if (stat == HAL_OK) {
+    return I2CDeviceStatus::ok;
+  }
+  if (stat == HAL_BUSY) {
+    return I2CDeviceStatus::busy;
+  }
+  return I2CDeviceStatus::read_error;
+}
+
+I2CDeviceStatus HALI2CDevice::finish_read() {
+  if (HAL_I2C_GetState(&dev_) != HAL_I2C_STATE_READY) {
+    return I2CDeviceStatus::busy;
+  }
+  if (HAL_I2C_GetError(&dev_) != HAL_I2C_ERROR_NONE) {
+    return I2CDeviceStatus::read_error;
+  }
+  return I2CDeviceStatus::ok;
+}
+
 }  // namespace Pufferfish::HAL
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALIntervalTimer.cpp
+ *
+ * A hardware timer which raises an interrupt at a fixed interval
+ */
+
+#include "Pufferfish/HAL/STM32/HALIntervalTimer.h"
+
+namespace Pufferfish::HAL {
+
+TimerStatus HALIntervalTimer::setup() {
+  // APB1 timers run at twice the APB1 clock whenever APB1 is divided down
+  uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+  if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE1) != RCC_APB1_DIV1) {
+    timer_clock *= 2;
+  }
+
+  htim_.Init.Prescaler = timer_clock / tick_frequency - 1;
+  htim_.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim_.Init.Period = interval_us_ - 1;
+  htim_.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+  if (HAL_TIM_Base_Init(&htim_) != HAL_OK) {
+    return TimerStatus::hal_error;
+  }
+
+  return TimerStatus::ok;
+}
+
+TimerStatus HALIntervalTimer::start() {
+  __HAL_TIM_SET_COUNTER(&htim_, 0);
+  HAL_StatusTypeDef stat = HAL_TIM_Base_Start_IT(&htim_);
+  return stat == HAL_OK ? TimerStatus::ok : TimerStatus::hal_error;
+}
+
+TimerStatus HALIntervalTimer::stop() {
+  HAL_StatusTypeDef stat = HAL_TIM_Base_Stop_IT(&htim_);
+  return stat == HAL_OK ? TimerStatus::ok : TimerStatus::hal_error;
+}
+
+bool HALIntervalTimer::handle_irq() {
+  if (__HAL_TIM_GET_FLAG(&htim_, TIM_FLAG_UPDATE) == RESET ||
+      __HAL_TIM_GET_IT_SOURCE(&htim_, TIM_IT_UPDATE) == RESET) {
+    return false;
+  }
+
+  __HAL_TIM_CLEAR_IT(&htim_, TIM_IT_UPDATE);
+  return true;
+}
+
+}  // namespace Pufferfish::HAL
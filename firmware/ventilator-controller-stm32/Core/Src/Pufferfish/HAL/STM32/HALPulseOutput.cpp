@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALPulseOutput.cpp
+ *
+ * A GPIO output whose pulses are timed by a hardware timer and driven by DMA
+ */
+
+#include "Pufferfish/HAL/STM32/HALPulseOutput.h"
+
+namespace Pufferfish::HAL {
+
+static const uint32_t bsrr_reset_shift = 16;
+
+TimerStatus HALPulseOutput::setup() {
+  words_[0] = pin_;
+  words_[1] = static_cast<uint32_t>(pin_) << bsrr_reset_shift;
+
+  // APB2 timers run at twice the APB2 clock whenever APB2 is divided down
+  uint32_t timer_clock = HAL_RCC_GetPCLK2Freq();
+  if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE2) != RCC_APB2_DIV1) {
+    timer_clock *= 2;
+  }
+
+  htim_.Init.Prescaler = timer_clock / tick_frequency - 1;
+  htim_.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim_.Init.Period = max_period - 1;
+  htim_.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim_.Init.RepetitionCounter = 0;
+  htim_.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim_) != HAL_OK) {
+    return TimerStatus::hal_error;
+  }
+
+  // Channel 1 stays in frozen output compare mode, which drives no pin but
+  // still raises its DMA request on every match
+  TimerStatus status = setup_dma(hdma_set_, words_[0]);
+  if (status != TimerStatus::ok) {
+    return status;
+  }
+  status = setup_dma(hdma_reset_, words_[1]);
+  if (status != TimerStatus::ok) {
+    return status;
+  }
+
+  __HAL_TIM_ENABLE_DMA(&htim_, TIM_DMA_UPDATE);
+  __HAL_TIM_ENABLE_DMA(&htim_, TIM_DMA_CC1);
+  return TimerStatus::ok;
+}
+
+TimerStatus HALPulseOutput::setup_dma(DMA_HandleTypeDef &hdma, const uint32_t &word) {
+  hdma.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma.Init.MemInc = DMA_MINC_DISABLE;
+  hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  hdma.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+  hdma.Init.Mode = DMA_CIRCULAR;
+  hdma.Init.Priority = DMA_PRIORITY_LOW;
+  hdma.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_DMA_Init(&hdma) != HAL_OK) {
+    return TimerStatus::hal_error;
+  }
+
+  HAL_StatusTypeDef stat = HAL_DMA_Start(
+      &hdma,
+      reinterpret_cast<uint32_t>(&word),  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<uint32_t>(&port_.BSRR),  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+      1);
+  return stat == HAL_OK ? TimerStatus::ok : TimerStatus::hal_error;
+}
+
+void HALPulseOutput::write(bool output) {
+  __HAL_TIM_DISABLE(&htim_);
+  port_.BSRR = output ? words_[0] : words_[1];
+}
+
+TimerStatus HALPulseOutput::set_pulses(uint32_t period, uint32_t duty) {
+  if (duty == 0 || duty >= period) {
+    write(duty != 0);
+    return TimerStatus::ok;
+  }
+  if (period > max_period) {
+    return TimerStatus::invalid_pattern;
+  }
+
+  // Start the first pulse now; the update DMA request starts every later one
+  write(true);
+  __HAL_TIM_SET_AUTORELOAD(&htim_, period - 1);
+  __HAL_TIM_SET_COMPARE(&htim_, TIM_CHANNEL_1, duty);
+  __HAL_TIM_SET_COUNTER(&htim_, 0);
+  __HAL_TIM_ENABLE(&htim_);
+  return TimerStatus::ok;
+}
+
+}  // namespace Pufferfish::HAL
@@ -22,6 +22,10 @@
 
 #include "stm32h7xx_hal.h"
 
+// Defined in the linker script
+extern "C" uint32_t _sdma_buffers;  // NOLINT(bugprone-reserved-identifier)
+extern "C" uint32_t _edma_buffers;  // NOLINT(bugprone-reserved-identifier)
+
 namespace Pufferfish::HAL {
 
 SPIDeviceStatus HALSPIDevice::read(uint8_t *buf, size_t count) {
@@ -52,6 +56,91 @@ SPIDeviceStatus HALSPIDevice::write_read(uint8_t *tx_buf, uint8_t *rx_buf, size_
   return SPIDeviceStatus::error;
 }
 
+SPIDeviceStatus HALSPIDevice::start_read(uint8_t *buf, size_t count) {
+  if (rx_remaining_ > 0) {
+    return SPIDeviceStatus::busy;
+  }
+  if (count == 0) {
+    return SPIDeviceStatus::ok;
+  }
+  if (!dma_capable(buf, count)) {
+    return read(buf, count);
+  }
+
+  // Lines must not be evicted over the DMA's writes; the buffer is rewritten
+  // completely, so nothing needs to be cleaned first
+  rx_invalidate_ = Cache::dcache_enabled();
+  if (rx_invalidate_) {
+    Cache::invalidate(buf, count);
+  }
+  rx_next_ = buf;
+  rx_remaining_ = count;
+  return start_chunk();
+}
+
+SPIDeviceStatus HALSPIDevice::read_status() {
+  if (rx_remaining_ == 0) {
+    return SPIDeviceStatus::ok;
+  }
+  if (HAL_SPI_GetState(&dev_) != HAL_SPI_STATE_READY) {
+    return SPIDeviceStatus::busy;
+  }
+  if (HAL_SPI_GetError(&dev_) != HAL_SPI_ERROR_NONE) {
+    rx_remaining_ = 0;
+    return SPIDeviceStatus::read_error;
+  }
+
+  // Discard anything speculatively read into the cache during the transfer
+  if (rx_invalidate_) {
+    Cache::invalidate(rx_next_, rx_chunk_);
+  }
+  rx_next_ += rx_chunk_;
+  rx_remaining_ -= rx_chunk_;
+  if (rx_remaining_ == 0) {
+    return SPIDeviceStatus::ok;
+  }
+  SPIDeviceStatus ret = start_chunk();
+  if (ret != SPIDeviceStatus::ok) {
+    return ret;
+  }
+  return SPIDeviceStatus::busy;
+}
+
+bool HALSPIDevice::dma_capable(const uint8_t *buf, size_t count) const {
+  if (dev_.hdmarx == nullptr || dev_.hdmatx == nullptr) {
+    return false;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto address = reinterpret_cast<uintptr_t>(buf);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto region_start = reinterpret_cast<uintptr_t>(&_sdma_buffers);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto region_end = reinterpret_cast<uintptr_t>(&_edma_buffers);
+  if (address >= region_start && address + count <= region_end) {
+    return true;
+  }
+  if (!Cache::dcache_enabled()) {
+    return true;
+  }
+  return address % cache_line_size == 0 && count % cache_line_size == 0;
+}
+
+SPIDeviceStatus HALSPIDevice::start_chunk() {
+  rx_chunk_ = (rx_remaining_ < max_dma_chunk) ? rx_remaining_ : max_dma_chunk;
+  // In full-duplex master mode this clocks the buffer itself out as the
+  // dummy bytes, so no scratch transmit buffer is needed
+  HAL_StatusTypeDef stat = HAL_SPI_Receive_DMA(&dev_, rx_next_, rx_chunk_);
+  if (stat == HAL_OK) {
+    return SPIDeviceStatus::ok;
+  }
+  rx_remaining_ = 0;
+  if (stat == HAL_BUSY) {
+    return SPIDeviceStatus::busy;
+  }
+  return SPIDeviceStatus::read_error;
+}
+
 void HALSPIDevice::chip_select(bool input) {
   cs_pin_.write(input);
 }
@@ -0,0 +1,32 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * HALTraceOutput.cpp
+ *
+ * A byte stream to a debug probe over an ITM stimulus port and SWO
+ */
+
+#include "Pufferfish/HAL/STM32/HALTraceOutput.h"
+
+namespace Pufferfish::HAL {
+
+bool HALTraceOutput::enabled() {
+  return port_ <= max_port && (CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) != 0U &&
+         (ITM->TCR & ITM_TCR_ITMENA_Msk) != 0U && (ITM->TER & (1UL << port_)) != 0U;
+}
+
+size_t HALTraceOutput::write(const uint8_t *bytes, size_t size) {
+  if (!enabled()) {
+    return 0;
+  }
+
+  size_t written = 0;
+  // Reading a stimulus port returns 0 while its FIFO is full
+  while (written < size && ITM->PORT[port_].u32 != 0U) {
+    ITM->PORT[port_].u8 = bytes[written];
+    ++written;
+  }
+  return written;
+}
+
+}  // namespace Pufferfish::HAL
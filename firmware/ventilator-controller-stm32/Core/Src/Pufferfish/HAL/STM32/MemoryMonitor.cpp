@@ -0,0 +1,102 @@
+/// MemoryMonitor.cpp
+/// This file has methods for runtime stack and heap usage monitoring.
+
+// Copyright (c) 2020 Pez-Globo and the Pufferfish project contributors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied.
+//
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Pufferfish/HAL/STM32/MemoryMonitor.h"
+
+#include <sys/types.h>
+
+#include "stm32h7xx_hal.h"
+
+// Defined in the linker script
+extern "C" uint32_t _estack;  // NOLINT(bugprone-reserved-identifier)
+// Defined in sysmem.c; _sbrk(0) returns the current heap end
+extern "C" caddr_t _sbrk(int incr);  // NOLINT(bugprone-reserved-identifier)
+
+namespace Pufferfish::HAL {
+
+namespace {
+
+constexpr uintptr_t word_align_up(uintptr_t address) {
+  return (address + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+}
+
+}  // namespace
+
+void MemoryMonitor::paint_stack() {
+  uintptr_t address = word_align_up(heap_end());
+  const uintptr_t end = __get_MSP() - paint_margin;
+  for (; address < end; address += sizeof(uint32_t)) {
+    // NOLINTNEXTLINE(performance-no-int-to-ptr,cppcoreguidelines-pro-type-reinterpret-cast)
+    *reinterpret_cast<volatile uint32_t *>(address) = paint_pattern;
+  }
+}
+
+void MemoryMonitor::update() {
+  // The current stack pointer is in use by definition
+  const uintptr_t stack_pointer = __get_MSP();
+  if (low_water_ == 0 || stack_pointer < low_water_) {
+    low_water_ = stack_pointer;
+  }
+
+  // Scan upwards from the heap end, so the first overwritten word found in a
+  // pass is the deepest one
+  const uintptr_t bottom = word_align_up(heap_end());
+  if (cursor_ < bottom || cursor_ >= low_water_) {
+    cursor_ = bottom;
+  }
+  for (size_t i = 0; i < scan_words_per_update && cursor_ < low_water_; ++i) {
+    // NOLINTNEXTLINE(performance-no-int-to-ptr,cppcoreguidelines-pro-type-reinterpret-cast)
+    if (*reinterpret_cast<const volatile uint32_t *>(cursor_) != paint_pattern) {
+      low_water_ = cursor_;
+      cursor_ = bottom;
+      return;
+    }
+    cursor_ += sizeof(uint32_t);
+  }
+}
+
+uint32_t MemoryMonitor::stack_high_water() const {
+  if (low_water_ == 0) {
+    return 0;
+  }
+
+  return stack_top() - low_water_;
+}
+
+uint32_t MemoryMonitor::heap_free() const {
+  const uintptr_t heap = heap_end();
+  if (low_water_ <= heap) {
+    return 0;
+  }
+
+  return low_water_ - heap;
+}
+
+uintptr_t MemoryMonitor::heap_end() {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return reinterpret_cast<uintptr_t>(_sbrk(0));
+}
+
+uintptr_t MemoryMonitor::stack_top() {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return reinterpret_cast<uintptr_t>(&_estack);
+}
+
+}  // namespace Pufferfish::HAL
@@ -32,11 +32,16 @@
 #include <functional>
 
 #include "Pufferfish/AlarmsManager.h"
+#include "Pufferfish/Application/AlarmEvaluator.h"
+#include "Pufferfish/Application/SettingsEvents.h"
 #include "Pufferfish/Application/States.h"
+#include "Pufferfish/Driver/BreathingCircuit/AlarmLimitsService.h"
+#include "Pufferfish/Driver/BreathingCircuit/BreathAnalyzer.h"
 #include "Pufferfish/Driver/BreathingCircuit/ControlLoop.h"
 #include "Pufferfish/Driver/BreathingCircuit/ParametersService.h"
 #include "Pufferfish/Driver/BreathingCircuit/Simulator.h"
-#include "Pufferfish/Driver/Button/Button.h"
+#include "Pufferfish/Driver/Button/BankDebouncer.h"
+#include "Pufferfish/Driver/Capture/Capture.h"
 #include "Pufferfish/Driver/I2C/ExtendedI2CDevice.h"
 #include "Pufferfish/Driver/I2C/HoneywellABP.h"
 #include "Pufferfish/Driver/I2C/SDP.h"
@@ -46,14 +51,20 @@
 #include "Pufferfish/Driver/Indicators/AuditoryAlarm.h"
 #include "Pufferfish/Driver/Indicators/LEDAlarm.h"
 #include "Pufferfish/Driver/Indicators/PulseGenerator.h"
+#include "Pufferfish/Driver/Initializer.h"
+#include "Pufferfish/Driver/SPI/AsyncFlash.h"
 #include "Pufferfish/Driver/Serial/Backend/UART.h"
 #include "Pufferfish/Driver/Serial/FDO2/Sensor.h"
 #include "Pufferfish/Driver/Serial/Nonin/Sensor.h"
 #include "Pufferfish/Driver/ShiftedOutput.h"
+#include "Pufferfish/Driver/Storage/EventLog.h"
+#include "Pufferfish/Driver/Storage/Recorder.h"
+#include "Pufferfish/Driver/Storage/SettingsStore.h"
+#include "Pufferfish/Driver/ValveBank.h"
 #include "Pufferfish/HAL/HAL.h"
+#include "Pufferfish/HAL/STM32/HALTraceOutput.h"
 #include "Pufferfish/HAL/STM32/HAL.h"
 #include "Pufferfish/Statuses.h"
-#include "Pufferfish/Util/Timeouts.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -103,9 +114,11 @@ PF::Application::States all_states;
 
 // Parameters
 PF::Driver::BreathingCircuit::ParametersServices parameters_service;
+PF::Driver::BreathingCircuit::AlarmLimitsServices alarm_limits_service;
 
 // Breathing Circuit Simulation
 PF::Driver::BreathingCircuit::Simulators simulator;
+PF::Driver::BreathingCircuit::BreathAnalyzer breath_analyzer;
 
 // HAL Utilities
 PF::HAL::HALCRC32 crc32c(hcrc);
@@ -113,17 +126,85 @@ PF::HAL::HALCRC32 crc32c(hcrc);
 // HAL Time
 PF::HAL::HALTime time;
 
+// Memory Usage
+PF::HAL::MemoryMonitor memory_monitor;
+
+// External Flash
+// PA4 is driven as a GPIO, since the flash drivers frame each instruction
+// with chip select themselves
+PF::HAL::HALDigitalOutput ext_flash_cs(
+    *GPIOA,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    GPIO_PIN_4);
+PF::HAL::HALSPIDevice ext_flash_spi(hspi1, ext_flash_cs);
+PF::Driver::SPI::SPIFlash ext_flash(ext_flash_spi, time);
+PF::Driver::SPI::AsyncFlash ext_flash_queue(ext_flash);
+
+// Persistent Settings
+static const uint32_t settings_log_address = 0x000000;
+static const size_t settings_log_sectors = 4;
+PF::Driver::Storage::LogStore<settings_log_sectors> settings_log(
+    ext_flash_queue, crc32c, settings_log_address);
+PF::Driver::Storage::SettingsStore<settings_log_sectors> settings_store(settings_log, all_states);
+using ValveCharacterizationFormat = PF::Driver::BreathingCircuit::ValveCharacterizationFormat;
+static_assert(
+    ValveCharacterizationFormat::size <= decltype(settings_store)::max_calibration_size,
+    "Valve characterizations must fit in the calibration slot");
+
+// Black-box Recorder
+// 1.5 MB starting at the second 64 KB block keeps several minutes of waveforms
+static const uint32_t recorder_log_address = 0x010000;
+static const size_t recorder_log_sectors = 384;
+PF::Driver::Storage::LogStore<recorder_log_sectors> recorder_log(
+    ext_flash_queue, crc32c, recorder_log_address);
+PF::Driver::Storage::Recorder<recorder_log_sectors> recorder(recorder_log);
+
+// Event Log
+// The rest of the 2 MB chip after the recorder keeps thousands of events
+static const uint32_t event_log_address = 0x190000;
+static const size_t event_log_sectors = 112;
+PF::Driver::Storage::LogStore<event_log_sectors> event_log_store(
+    ext_flash_queue, crc32c, event_log_address);
+PF::Driver::Storage::EventLog<event_log_sectors> event_log(event_log_store);
+PF::Application::SettingsEvents settings_events;
+
 // Buffered UARTs
 volatile Pufferfish::HAL::LargeBufferedUART backend_uart(huart3, time);
 volatile Pufferfish::HAL::LargeBufferedUART fdo2_uart(huart7, time);
 volatile Pufferfish::HAL::ReadOnlyBufferedUART nonin_oem_uart(huart4, time);
 
-// UART Serial Communication
-PF::Driver::Serial::Backend::UARTBackend backend(backend_uart, crc32c, all_states);
+// Traffic Capture
+// UART and I2C traffic is streamed over SWO (ITM stimulus port 1) whenever
+// a debug probe has enabled that port, for replay with CaptureReplay
+PF::HAL::HALTraceOutput trace_output(1);
+static const PF::HAL::AtomicSize capture_slots = 32;
+PF::Driver::Capture::RecordBuffer<capture_slots> uart_records;  // filled from the main loop
+PF::Driver::Capture::RecordBuffer<capture_slots> i2c_records;   // filled from the control loop
+PF::Driver::Capture::UARTCapture backend_capture(
+    PF::Driver::Capture::Channel::backend, uart_records, time);
+PF::Driver::Capture::CapturedUART captured_backend_uart(backend_uart, backend_capture);
+PF::Driver::Capture::UARTCapture fdo2_capture(
+    PF::Driver::Capture::Channel::fdo2, uart_records, time);
+PF::Driver::Capture::CapturedUART captured_fdo2_uart(fdo2_uart, fdo2_capture);
+PF::Driver::Capture::UARTCapture nonin_oem_capture(
+    PF::Driver::Capture::Channel::nonin_oem, uart_records, time);
+PF::Driver::Capture::CapturedUART captured_nonin_oem_uart(nonin_oem_uart, nonin_oem_capture);
+PF::Driver::Capture::TraceWriter<2> trace_writer({&uart_records, &i2c_records}, trace_output);
 
-// Create an object for ADC3 of AnalogInput Class
-static const uint32_t adc_poll_timeout = 10;
-PF::HAL::HALAnalogInput adc3_input(hadc3, adc_poll_timeout);
+// UART Serial Communication
+PF::Driver::Serial::Backend::UARTBackend backend(captured_backend_uart, crc32c, all_states);
+
+// ADC3 continuously scans the battery voltage and the analog O2 sensor,
+// oversampled 16x in hardware; at roughly 2k scans/s, each half of the DMA
+// buffer fills up about 60 times a second
+static const size_t adc3_channels = 2;
+static const size_t adc3_block_sequences = 32;
+using ADC3Scan = PF::HAL::HALAnalogScan<adc3_channels, adc3_block_sequences>;
+static const size_t adc3_battery_channel = 0;
+static const size_t adc3_o2_channel = 1;
+PF_BDMA_BUFFER ADC3Scan::Buffer adc3_buffer;
+// Battery voltage is published at ~10 Hz and O2 sensor voltage at ~1 kHz
+ADC3Scan::Decimator adc3_values(ADC3Scan::Decimator::Decimations{200, 2});
+ADC3Scan adc3_scan(hadc3, adc3_buffer, adc3_values);
 
 // The following lines suppress Eclipse CDT's warning about C-style casts;
 // those come from STM32CubeMX-generated #define constants, which we have no
@@ -147,9 +228,18 @@ PF::HAL::HALDigitalOutput ser_input(
     SER_IN_Pin,  // @suppress("C-Style cast instead of C++ cast")
     true);
 
-PF::HAL::HALDigitalOutput board_led1(
+// TIM15 and two DMA streams pulse the board LED without any work in the loop
+TIM_HandleTypeDef htim15;
+DMA_HandleTypeDef hdma_tim15_up;
+DMA_HandleTypeDef hdma_tim15_ch1;
+PF_DMA_BUFFER PF::HAL::HALPulseOutput::BSRRWords board_led1_words;
+PF::HAL::HALPulseOutput board_led1(
+    htim15,
+    hdma_tim15_up,
+    hdma_tim15_ch1,
     *LD1_GPIO_Port,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
-    LD1_Pin);  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    LD1_Pin,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    board_led1_words);
 static const uint32_t flash_period = 50;
 static const uint32_t blink_period = 500;
 static const uint32_t dim_period = 8;
@@ -157,6 +247,9 @@ PF::Driver::Indicators::PWMGenerator flasher(flash_period, 1);
 PF::Driver::Indicators::PWMGenerator blinker(blink_period, 1);
 PF::Driver::Indicators::PWMGenerator dimmer(dim_period, 1);
 PF::Driver::ShiftRegister leds_reg(ser_input, ser_clock, ser_r_clock, ser_clear, time);
+// TIM6 steps the shift register one pin edge per baud period, only while it is shifting
+TIM_HandleTypeDef htim6;
+PF::HAL::HALIntervalTimer leds_timer(htim6, PF::Driver::ShiftRegister::baud_rate);
 
 PF::Driver::ShiftedOutput alarm_led_r(leds_reg, 0);
 PF::Driver::ShiftedOutput alarm_led_g(leds_reg, 1);
@@ -177,39 +270,43 @@ PF::HAL::HALDigitalOutput alarm_reg_med(
 PF::HAL::HALDigitalOutput alarm_reg_low(
     *ALARM1_LOW_GPIO_Port,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
     ALARM1_LOW_Pin);  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
-PF::HAL::HALDigitalOutput alarm_buzzer(
+// TIM16 and two DMA streams pulse the buzzer without any work in the loop
+TIM_HandleTypeDef htim16;
+DMA_HandleTypeDef hdma_tim16_up;
+DMA_HandleTypeDef hdma_tim16_ch1;
+PF_DMA_BUFFER PF::HAL::HALPulseOutput::BSRRWords alarm_buzzer_words;
+PF::HAL::HALPulseOutput alarm_buzzer(
+    htim16,
+    hdma_tim16_up,
+    hdma_tim16_ch1,
     *BUZZ1_EN_GPIO_Port,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
-    BUZZ1_EN_Pin);  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    BUZZ1_EN_Pin,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    alarm_buzzer_words);
 
 PF::Driver::Indicators::LEDAlarm alarm_dev_led(alarm_led_r, alarm_led_g, alarm_led_b);
-PF::Driver::Indicators::AuditoryAlarm alarm_dev_sound(
+PF::Driver::Indicators::TimedAuditoryAlarm alarm_dev_sound(
     alarm_reg_high, alarm_reg_med, alarm_reg_low, alarm_buzzer);
 PF::AlarmsManager h_alarms(alarm_dev_led, alarm_dev_sound);
-
-PF::HAL::HALDigitalInput button_alarm_en(
-    *SET_ALARM_EN_GPIO_Port,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
-    SET_ALARM_EN_Pin,  // @suppress("C-Style cast instead of C++ cast")
-    true);
-PF::HAL::HALDigitalInput button_full_o2(
-    *SET_100_O2_GPIO_Port,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
-    SET_100_O2_Pin,  // @suppress("C-Style cast instead of C++ cast")
-    true);
-PF::HAL::HALDigitalInput button_manual_breath(
-    *SET_MANUAL_BREATH_GPIO_Port,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
-    SET_MANUAL_BREATH_Pin,  // @suppress("C-Style cast instead of C++ cast")
-    true);
-PF::HAL::HALDigitalInput button_lock(
-    *SET_LOCK_GPIO_Port,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
-    SET_LOCK_Pin,  // @suppress("C-Style cast instead of C++ cast")
-    true);
-PF::HAL::HALDigitalInput button_power(
-    *SET_PWR_ON_OFF_GPIO_Port,  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
-    SET_PWR_ON_OFF_Pin,  // @suppress("C-Style cast instead of C++ cast")
-    true);
-
-PF::Driver::Button::Debouncer switch_debounce;
-PF::Driver::Button::EdgeDetector switch_transition;
-PF::Driver::Button::Button button_membrane(button_alarm_en, switch_debounce, time);
+PF::Application::AlarmEvaluator alarm_evaluator;
+
+// Front Panel Buttons, listed grouped by GPIO port
+static const uint8_t button_alarm_en = 0;
+static const uint8_t button_full_o2 = 1;
+static const uint8_t button_manual_breath = 2;
+static const uint8_t button_lock = 3;
+static const uint8_t button_power = 4;
+PF::HAL::HALDigitalInputBank<5> buttons_input({{
+    {SET_ALARM_EN_GPIO_Port, SET_ALARM_EN_Pin, true},  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    {SET_100_O2_GPIO_Port, SET_100_O2_Pin, true},  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    {SET_MANUAL_BREATH_GPIO_Port, SET_MANUAL_BREATH_Pin, true},  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    {SET_LOCK_GPIO_Port, SET_LOCK_Pin, true},  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    {SET_PWR_ON_OFF_GPIO_Port, SET_PWR_ON_OFF_Pin, true}  // @suppress("C-Style cast instead of C++ cast") // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+}});
+PF::Driver::Button::BankDebouncer<16> buttons;
+// TIM7 samples all buttons together every 5 ms, so a press must be stable for 20 ms
+static const uint32_t buttons_sampling_interval = 5000;  // us
+TIM_HandleTypeDef htim7;
+PF::HAL::HALIntervalTimer buttons_timer(htim7, buttons_sampling_interval);
 
 // Solenoid Valves
 PF::HAL::HALPWM drive1_ch1(htim2, TIM_CHANNEL_4);
@@ -226,6 +323,14 @@ PF::HAL::HALPWM drive2_ch4(htim8, TIM_CHANNEL_1);
 PF::HAL::HALPWM drive2_ch5(htim8, TIM_CHANNEL_2);
 PF::HAL::HALPWM drive2_ch6(htim8, TIM_CHANNEL_4);
 PF::HAL::HALPWM drive2_ch7(htim12, TIM_CHANNEL_2);
+// All valve timers share one period, so their duty cycles can change together
+PF::HAL::HALPWMUpdateGate<6> valves_gate({&htim2, &htim3, &htim4, &htim5, &htim8, &htim12});
+// The first two valves are the air and O2 valves of the HFNC control loop, and
+// the next two are the inspiratory and expiratory valves of the PC-AC control loop
+PF::Driver::PWMValveBank<14> valves(
+    {{&drive1_ch1, &drive1_ch2, &drive1_ch3, &drive1_ch4, &drive1_ch5, &drive1_ch6, &drive1_ch7,
+      &drive2_ch1, &drive2_ch2, &drive2_ch3, &drive2_ch4, &drive2_ch5, &drive2_ch6, &drive2_ch7}},
+    valves_gate);
 
 // Base I2C Devices
 // Note: I2C1 is marked I2C2 in the control board v1.0 schematic, and vice versa
@@ -249,6 +354,10 @@ PF::HAL::HALI2CDevice i2c2_hal_global(hi2c2, 0x00);
 PF::HAL::HALI2CDevice i2c4_hal_global(hi2c4, 0x00);
 PF::HAL::HALI2CDevice i2c_hal_sfm3019_air(hi2c2, PF::Driver::I2C::SFM3019::default_i2c_addr);
 PF::HAL::HALI2CDevice i2c_hal_sfm3019_o2(hi2c4, PF::Driver::I2C::SFM3019::default_i2c_addr);
+PF::Driver::Capture::CapturedI2CDevice captured_sfm3019_air(
+    i2c_hal_sfm3019_air, PF::Driver::Capture::Channel::sfm3019_air, i2c_records, time);
+PF::Driver::Capture::CapturedI2CDevice captured_sfm3019_o2(
+    i2c_hal_sfm3019_o2, PF::Driver::Capture::Channel::sfm3019_o2, i2c_records, time);
 /*
 // I2C Mux
 PF::Driver::I2C::TCA9548A i2c_mux1(i2c_hal_mux1);
@@ -292,25 +401,33 @@ PF::Driver::I2C::SDPSensor i2c_press18(i2c_ext_press18);
 // SFM3019
 
 PF::Driver::I2C::SFM3019::Device sfm3019_dev_air(
-    i2c_hal_sfm3019_air, i2c2_hal_global, PF::Driver::I2C::SFM3019::GasType::air);
+    captured_sfm3019_air, i2c2_hal_global, PF::Driver::I2C::SFM3019::GasType::air);
 PF::Driver::I2C::SFM3019::Sensor sfm3019_air(sfm3019_dev_air, true, time);
 PF::Driver::I2C::SFM3019::Device sfm3019_dev_o2(
-    i2c_hal_sfm3019_o2, i2c4_hal_global, PF::Driver::I2C::SFM3019::GasType::o2);
+    captured_sfm3019_o2, i2c4_hal_global, PF::Driver::I2C::SFM3019::GasType::o2);
 PF::Driver::I2C::SFM3019::Sensor sfm3019_o2(sfm3019_dev_o2, true, time);
 
+// Airway Pressure
+// The ABP on slot 0 of the mux on I2C1, the first of the pressure sensors above
+PF::HAL::HALI2CDevice i2c_hal_mux_paw(hi2c1, PF::Driver::I2C::TCA9548A::default_i2c_addr);
+PF::Driver::I2C::TCA9548A i2c_mux_paw(i2c_hal_mux_paw);
+PF::HAL::HALI2CDevice i2c_hal_paw(hi2c1, PF::Driver::I2C::abpxxxx001pg2a3.i2c_addr);
+PF::Driver::I2C::ExtendedI2CDevice i2c_ext_paw(i2c_hal_paw, i2c_mux_paw, 0);
+PF::Driver::I2C::HoneywellABP paw_sensor(i2c_ext_paw, PF::Driver::I2C::abpxxxx001pg2a3);
+
 // FDO2
-PF::Driver::Serial::FDO2::Device fdo2_dev(fdo2_uart);
+PF::Driver::Serial::FDO2::Device fdo2_dev(captured_fdo2_uart);
 PF::Driver::Serial::FDO2::Sensor fdo2(fdo2_dev, time);
 
 // Nonin OEM III
-PF::Driver::Serial::Nonin::Device nonin_oem_dev(nonin_oem_uart);
+PF::Driver::Serial::Nonin::Device nonin_oem_dev(captured_nonin_oem_uart);
 PF::Driver::Serial::Nonin::Sensor nonin_oem(nonin_oem_dev);
 
 // Initializables
 
 auto initializables = PF::Util::make_array<std::reference_wrapper<PF::Driver::Initializable>>(
     sfm3019_air, sfm3019_o2, /*fdo2, */ nonin_oem);
-std::array<PF::InitializableState, initializables.size()> initialization_states;
+PF::Driver::Initializer<initializables.size()> initializer(initializables);
 
 /*
 // Test list
@@ -336,13 +453,12 @@ int interface_test_state = 0;
 int interface_test_millis = 0;
 
 // Breathing Circuit Control
-PF::Driver::BreathingCircuit::HFNCControlLoop hfnc(
-    all_states.parameters(),
-    all_states.sensor_measurements(),
-    sfm3019_air,
-    sfm3019_o2,
-    drive1_ch1,
-    drive1_ch2);
+PF::Driver::BreathingCircuit::HFNCControlLoop hfnc(sfm3019_air, sfm3019_o2, valves);
+PF::Driver::BreathingCircuit::PCACControlLoop pcac(paw_sensor, valves, time);
+// TIM13 steps the control loops at a fixed rate, once the sensors are set up
+static const uint32_t control_interval = 1000;  // us
+TIM_HandleTypeDef htim13;
+PF::HAL::HALIntervalTimer control_timer(htim13, control_interval);
 
 /* USER CODE END PV */
 
@@ -374,11 +490,11 @@ static void MX_TIM12_Init(void);
 /* USER CODE BEGIN 0 */
 void interface_test_loop() {
   // get state of buttons
-  bool l_alarm_en = button_alarm_en.read();
-  bool l_o2 = button_full_o2.read();
-  bool l_manual = button_manual_breath.read();
-  bool l_lock = button_lock.read();
-  // bool l_power = button_power.read();
+  bool l_alarm_en = buttons.pressed(button_alarm_en);
+  bool l_o2 = buttons.pressed(button_full_o2);
+  bool l_manual = buttons.pressed(button_manual_breath);
+  bool l_lock = buttons.pressed(button_lock);
+  // bool l_power = buttons.pressed(button_power);
 
   // simply write back
   led_alarm_en.write(l_alarm_en);
@@ -416,13 +532,20 @@ int main(void)
   // Local variable to read ADC3 input
   uint32_t adc3_data = 0;
 
-  PF::Driver::Button::EdgeState state;
-  bool mem_buttonstate = false;
+  PF::Driver::Button::ButtonEvent button_event;
 
   static const uint32_t blink_low_delay = 5;
   static const uint32_t loop_delay = 50;
   */
 
+  // Memory usage: paint the free RAM before anything deepens the stack
+  PF::HAL::MemoryMonitor::paint_stack();
+
+  // Caches: DMA buffers live in the non-cacheable region set up by the MPU,
+  // so the MPU must be configured before the D-cache is turned on
+  PF::HAL::Cache::configure_mpu();
+  PF::HAL::Cache::enable();
+
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -466,26 +589,91 @@ int main(void)
 
   /*
   interface_test_millis = time.millis();
+  */
 
   // ADCs
-  adc3_input.start();
-  */
+  adc3_scan.start();
 
   // UARTs
   backend_uart.setup_irq();
   fdo2_uart.setup_irq();
   nonin_oem_uart.setup_irq();
 
+  // Shift Register Timer
+  __HAL_RCC_TIM6_CLK_ENABLE();
+  htim6.Instance = TIM6;
+  if (leds_timer.setup() != PF::TimerStatus::ok) {
+    Error_Handler();
+  }
+  HAL_NVIC_SetPriority(TIM6_DAC_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(TIM6_DAC_IRQn);
+
+  // Hardware Pulse Outputs
+  __HAL_RCC_TIM15_CLK_ENABLE();
+  htim15.Instance = TIM15;
+  hdma_tim15_up.Instance = DMA1_Stream2;
+  hdma_tim15_up.Init.Request = DMA_REQUEST_TIM15_UP;
+  hdma_tim15_ch1.Instance = DMA1_Stream3;
+  hdma_tim15_ch1.Init.Request = DMA_REQUEST_TIM15_CH1;
+  if (board_led1.setup() != PF::TimerStatus::ok) {
+    Error_Handler();
+  }
+  __HAL_RCC_TIM16_CLK_ENABLE();
+  htim16.Instance = TIM16;
+  hdma_tim16_up.Instance = DMA1_Stream4;
+  hdma_tim16_up.Init.Request = DMA_REQUEST_TIM16_UP;
+  hdma_tim16_ch1.Instance = DMA1_Stream5;
+  hdma_tim16_ch1.Init.Request = DMA_REQUEST_TIM16_CH1;
+  if (alarm_buzzer.setup() != PF::TimerStatus::ok) {
+    Error_Handler();
+  }
+
+  // Button Sampling Timer
+  __HAL_RCC_TIM7_CLK_ENABLE();
+  htim7.Instance = TIM7;
+  if (buttons_timer.setup() != PF::TimerStatus::ok) {
+    Error_Handler();
+  }
+  HAL_NVIC_SetPriority(TIM7_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(TIM7_IRQn);
+  if (buttons_timer.start() != PF::TimerStatus::ok) {
+    Error_Handler();
+  }
+
   // Hardware PWMs
-  drive1_ch1.start();
-  drive1_ch1.set_duty_cycle_raw(0);
-  drive1_ch2.start();
-  drive1_ch2.set_duty_cycle_raw(0);
+  if (valves.setup() != PF::PWMStatus::ok) {
+    Error_Handler();
+  }
 
-  // Software PWMs
-  blinker.start(time.millis());
-  flasher.start(time.millis());
-  dimmer.start(time.millis());
+  // Alarm limits stay in effect until the backend requests others, unless
+  // stored ones are restored below
+  all_states.alarm_limits() =
+      PF::Driver::BreathingCircuit::AlarmLimitsServices::default_alarm_limits();
+
+  // Persistent Settings: resume the previous settings right away, without
+  // waiting for the backend; a missing or blank flash chip leaves the defaults
+  if (settings_log.mount() == PF::Driver::Storage::LogStore<settings_log_sectors>::Status::ok) {
+    settings_store.restore();
+  }
+  // Valve characterization: without a usable stored one, calibrate the valves
+  // once the control loop starts
+  bool valves_characterized = false;
+  {
+    std::array<uint8_t, ValveCharacterizationFormat::size> stored{};
+    size_t stored_size = 0;
+    PF::Driver::BreathingCircuit::ValveCharacterization characterization{};
+    if (settings_store.calibration(stored.data(), stored.size(), stored_size) ==
+            decltype(settings_store)::Status::ok &&
+        ValveCharacterizationFormat::read(stored.data(), stored_size, characterization)) {
+      valves_characterized = hfnc.restore(characterization);
+    }
+  }
+  if (recorder_log.mount() == decltype(recorder_log)::Status::ok) {
+    recorder.load();
+  }
+  if (event_log_store.mount() == PF::Driver::Storage::LogStore<event_log_sectors>::Status::ok) {
+    event_log.load();
+  }
 
   /* USER CODE END 2 */
 
@@ -496,27 +684,17 @@ int main(void)
 
   board_led1.write(true);
   while (true) {
-    // Run setup on all initializables
-    for (size_t i = 0; i < initializables.size(); ++i) {
-      initialization_states[i] = initializables[i].get().setup();
-    }
+    // Run setup on all initializables concurrently
+    PF::InitializableState initialization_state = initializer.update(time.millis());
 
     // Check initializables' states
-    if (std::find(  // At least one has failed
-            initialization_states.cbegin(),
-            initialization_states.cend(),
-            PF::InitializableState::failed) != initialization_states.cend()) {
-      const uint32_t flash_start_time = time.millis();
+    if (initialization_state == PF::InitializableState::failed) {  // At least one has failed
       // Flash the LED rapidly to indicate failure
-      while (PF::Util::within_timeout(flash_start_time, setup_indicator_duration, time.millis())) {
-        flasher.input(time.millis());
-        board_led1.write(flasher.output());
+      if (flasher.start(board_led1) != PF::TimerStatus::ok) {
+        Error_Handler();
       }
-    } else if (  // At least one is still in setup
-        std::find(
-            initialization_states.cbegin(),
-            initialization_states.cend(),
-            PF::InitializableState::setup) != initialization_states.cend()) {
+      time.delay(setup_indicator_duration);
+    } else if (initialization_state == PF::InitializableState::setup) {  // At least one is in setup
       board_led1.write(true);
     } else {  // All are done with setup and ok
       break;
@@ -524,60 +702,208 @@ int main(void)
   }
 
   // Blink the LED somewhat slowly to indicate success
-  const uint32_t setup_completion_time = time.millis();
-  while (PF::Util::within_timeout(setup_completion_time, setup_indicator_duration, time.millis())) {
-    blinker.input(time.millis());
-    board_led1.write(blinker.output());
+  if (blinker.start(board_led1) != PF::TimerStatus::ok) {
+    Error_Handler();
   }
+  time.delay(setup_indicator_duration);
   board_led1.write(false);
 
+  // Breathing Circuit Control Loops: from now on only their interrupt uses the
+  // flow and airway pressure sensors. The airway pressure sensor's mux stays
+  // on its slot, so that its reads never wait on a mux write.
+  i2c_mux_paw.select_slot(0);
+  hfnc.input(all_states.parameters());
+  pcac.input(all_states.parameters());
+  __HAL_RCC_TIM13_CLK_ENABLE();
+  htim13.Instance = TIM13;
+  if (control_timer.setup() != PF::TimerStatus::ok) {
+    Error_Handler();
+  }
+  // The control loops start sensor reads which complete in the background
+  HAL_NVIC_SetPriority(I2C1_EV_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+  HAL_NVIC_SetPriority(I2C1_ER_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
+  HAL_NVIC_SetPriority(I2C2_EV_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(I2C2_EV_IRQn);
+  HAL_NVIC_SetPriority(I2C2_ER_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(I2C2_ER_IRQn);
+  HAL_NVIC_SetPriority(I2C4_EV_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(I2C4_EV_IRQn);
+  HAL_NVIC_SetPriority(I2C4_ER_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(I2C4_ER_IRQn);
+  // Below the UARTs, DMA and I2C, so that a slow control step can't overrun them
+  HAL_NVIC_SetPriority(TIM8_UP_TIM13_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(TIM8_UP_TIM13_IRQn);
+  if (control_timer.start() != PF::TimerStatus::ok) {
+    Error_Handler();
+  }
+  if (!valves_characterized) {
+    hfnc.calibrate();
+  }
+
   // Normal loop
+  bool valve_air_indicated = false;
+  PF::Driver::BreathingCircuit::ControlTelemetry control{};
+  PF::Driver::BreathingCircuit::ValveCharacterization characterization{};
+  uint32_t po2 = 0;
   while (true) {
     uint32_t current_time = time.millis();
 
-    // Software PWM signals
-    flasher.input(time.millis());
-    blinker.input(time.millis());
-    dimmer.input(time.millis());
-
     // Parameters update
     parameters_service.transform(all_states.parameters_request(), all_states.parameters());
+    alarm_limits_service.transform(
+        all_states.parameters(), all_states.alarm_limits_request(), all_states.alarm_limits());
+
+    // Breathing Circuit Control Loop
+    hfnc.input(all_states.parameters());
+    pcac.input(all_states.parameters());
+    if (all_states.parameters().mode == VentilationMode_pc_ac) {
+      pcac.output(control);
+    } else {
+      hfnc.output(control);
+    }
+    control.sensor_vars.po2 = po2;
+    if (hfnc.output(characterization)) {
+      std::array<uint8_t, ValveCharacterizationFormat::size> encoded{};
+      ValveCharacterizationFormat::write(characterization, encoded.data());
+      settings_store.set_calibration(encoded.data(), encoded.size());
+    }
 
     // Breathing Circuit Sensor Simulator
     simulator.transform(
         current_time,
         all_states.parameters(),
-        hfnc.sensor_vars(),
+        control.sensor_vars,
         all_states.sensor_measurements(),
         all_states.cycle_measurements());
 
     // Independent Sensors
-    fdo2.output(hfnc.sensor_vars().po2);
+    fdo2.output(po2);
     nonin_oem.output(all_states.sensor_measurements().spo2);
 
-    // Breathing Circuit Control Loop
-    hfnc.update(current_time);
+    if (all_states.parameters().mode == VentilationMode_hfnc) {
+      all_states.sensor_measurements().flow =
+          control.sensor_vars.flow_air + control.sensor_vars.flow_o2;
+    }
+    if (all_states.parameters().mode == VentilationMode_pc_ac) {
+      all_states.sensor_measurements().paw = control.sensor_vars.paw;
+    }
+
+    // Control Steps: each step since the previous loop is processed once,
+    // with the values measured in that step. The PC-AC loop measures no flow,
+    // so its breaths are simulated until it does.
+    const bool breaths_measured = all_states.parameters().ventilating &&
+                                  all_states.parameters().mode != VentilationMode_pc_ac;
+    PF::Driver::BreathingCircuit::ControlTelemetry step{};
+    while (hfnc.take_step(step) || pcac.take_step(step)) {
+      recorder.input(PF::Driver::Storage::Recorder<recorder_log_sectors>::Sample{
+          step.step_time,
+          step.sensor_vars.flow_air,
+          step.sensor_vars.flow_o2,
+          step.sensor_vars.paw,
+          all_states.sensor_measurements().fio2,
+          step.actuator_vars.valve_air_opening,
+          step.actuator_vars.valve_o2_opening});
+      if (breaths_measured) {
+        breath_analyzer.input(
+            step.step_time,
+            step.sensor_vars.flow_air + step.sensor_vars.flow_o2,
+            step.sensor_vars.paw);
+      }
+    }
+
+    // Breath Cycle Measurements
+    if (breaths_measured) {
+      breath_analyzer.output(all_states.cycle_measurements());
+    } else {
+      breath_analyzer.reset();
+    }
+
+    // Alarms
+    alarm_evaluator.input(all_states.alarm_limits());
+    alarm_evaluator.input(all_states.sensor_measurements());
+    alarm_evaluator.input(all_states.cycle_measurements());
+    alarm_evaluator.update(current_time);
+    PF::Application::AlarmTransition alarm{};
+    while (alarm_evaluator.output(alarm)) {
+      if (alarm.active) {
+        recorder.input_event(current_time, alarm.code);
+        LogEvent event{};
+        event.time = current_time;
+        event.code = alarm.code;
+        event.type = LogEventType_patient;
+        event_log.input(event);
+        h_alarms.add(alarm.priority);
+      } else {
+        h_alarms.remove(alarm.priority);
+      }
+    }
+    if (h_alarms.update(current_time) != PF::AlarmManagerStatus::ok) {
+      Error_Handler();
+    }
+    settings_events.input(current_time, all_states.parameters(), all_states.alarm_limits());
+    LogEvent settings_event{};
+    while (settings_events.output(settings_event)) {
+      event_log.input(settings_event);
+    }
 
     // Indicators for debugging
     static constexpr float valve_opening_indicator_threshold = 0.00001;
-    if (hfnc.actuator_vars().valve_air_opening > valve_opening_indicator_threshold) {
-      board_led1.write(dimmer.output());
-    } else {
-      board_led1.write(false);
+    bool valve_air_open =
+        control.actuator_vars.valve_air_opening > valve_opening_indicator_threshold;
+    if (valve_air_open != valve_air_indicated) {
+      valve_air_indicated = valve_air_open;
+      if (!valve_air_open) {
+        board_led1.write(false);
+      } else if (dimmer.start(board_led1) != PF::TimerStatus::ok) {
+        Error_Handler();
+      }
     }
-    /*if (hfnc.sensor_vars().flow_o2 > 1 || hfnc.sensor_vars().flow_air > 1) {
+    /*if (control.sensor_vars.flow_o2 > 1 || control.sensor_vars.flow_air > 1) {
       board_led1.write(true);
-    } else if (hfnc.sensor_vars().flow_o2 < -1 || hfnc.sensor_vars().flow_air < -1) {
+    } else if (control.sensor_vars.flow_o2 < -1 || control.sensor_vars.flow_air < -1) {
       board_led1.write(dimmer.output());
     } else {
       board_led1.write(false);
     }*/
 
+    // Interface Board LEDs
+    if (leds_reg.update()) {
+      leds_timer.start();
+    }
+
+    // Persistent Settings
+    settings_store.update(current_time);
+    settings_log.update();
+
+    // Black-box Recorder
+    recorder.update();
+    recorder_log.update();
+    recorder.serve(all_states.recorder_chunk_request(), all_states.recorder_chunk(), current_time);
+
+    // Event Log
+    event_log.update();
+    event_log_store.update();
+    event_log.serve(all_states.expected_log_event(), all_states.next_log_events());
+
+    // Memory Usage
+    memory_monitor.update();
+    all_states.memory_usage().time = current_time;
+    all_states.memory_usage().stack_high_water = memory_monitor.stack_high_water();
+    all_states.memory_usage().heap_free = memory_monitor.heap_free();
+
     // Backend Communication Protocol
     backend.receive();
     backend.update_clock(current_time);
     backend.send();
 
+    // Traffic Capture
+    backend_capture.update();
+    fdo2_capture.update();
+    nonin_oem_capture.update();
+    trace_writer.update();
+
     /*
     PF::AlarmManagerStatus stat = h_alarms.update(time.millis());
     if (stat != PF::AlarmManagerStatus::ok) {
@@ -588,7 +914,6 @@ int main(void)
     time.delay(blink_low_delay);
     board_led1.write(true);
     //interface_test_loop();
-    //leds_reg.update();
 
     for (PF::Driver::Testable *t : i2c_test_list) {
       if (t->test() != PF::I2CDeviceStatus::ok) {
@@ -600,13 +925,15 @@ int main(void)
 
     // FIXME: Added for testing
     // Read the Analog data of ADC3 and validate the return value
-    if (adc3_input.read(adc3_data) != PF::ADCStatus::ok) {
+    if (adc3_values.output(adc3_battery_channel, adc3_data) != PF::ADCStatus::ok) {
     } else {
     }
-    button_membrane.read_state(mem_buttonstate, state);
-    if (state != PF::Driver::Button::EdgeState::rising_edge) {
-      board_led1.write(true);
-      time.delay(5);
+    while (buttons.output(button_event) == PF::BufferStatus::ok) {
+      if (button_event.button == button_alarm_en &&
+          button_event.edge == PF::Driver::Button::EdgeState::rising_edge) {
+        board_led1.write(true);
+        time.delay(5);
+      }
     }
     */
 
@@ -751,6 +1078,34 @@ static void MX_ADC3_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN ADC3_Init 2 */
+  // Scan both channels continuously into a circular DMA buffer, with 16x
+  // hardware oversampling shifted back down to 16 bits
+  hadc3.Init.ScanConvMode = ADC_SCAN_ENABLE;
+  hadc3.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+  hadc3.Init.NbrOfConversion = adc3_channels;
+  hadc3.Init.ConversionDataManagement = ADC_CONVERSIONDATA_DMA_CIRCULAR;
+  hadc3.Init.OversamplingMode = ENABLE;
+  hadc3.Init.Oversampling.Ratio = 16;
+  hadc3.Init.Oversampling.RightBitShift = ADC_RIGHTBITSHIFT_4;
+  hadc3.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+  hadc3.Init.Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;
+  if (HAL_ADC_Init(&hadc3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sConfig.SamplingTime = ADC_SAMPLETIME_387CYCLES_5;
+  sConfig.Channel = ADC_CHANNEL_7;
+  sConfig.Rank = ADC_REGULAR_RANK_1;
+  if (HAL_ADC_ConfigChannel(&hadc3, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sConfig.Channel = ADC_CHANNEL_2;
+  sConfig.Rank = ADC_REGULAR_RANK_2;
+  if (HAL_ADC_ConfigChannel(&hadc3, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
 
   /* USER CODE END ADC3_Init 2 */
 
@@ -976,6 +1331,14 @@ static void MX_SPI1_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN SPI1_Init 2 */
+  // Chip select is driven in software, so PA4 is taken back from SPI1_NSS
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+  HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, GPIO_PIN_SET);
+  GPIO_InitStruct.Pin = GPIO_PIN_4;
+  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
   /* USER CODE END SPI1_Init 2 */
 
@@ -1721,6 +2084,18 @@ static void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 4 */
 
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc) {
+  if (hadc == &hadc3) {
+    adc3_scan.handle_half_complete();
+  }
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
+  if (hadc == &hadc3) {
+    adc3_scan.handle_complete();
+  }
+}
+
 /* USER CODE END 4 */
 
 /**
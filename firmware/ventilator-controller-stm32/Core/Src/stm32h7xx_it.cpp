@@ -23,8 +23,13 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "Pufferfish/Driver/BreathingCircuit/ControlLoop.h"
+#include "Pufferfish/Driver/Button/BankDebouncer.h"
 #include "Pufferfish/Driver/Serial/Nonin/Device.h"
+#include "Pufferfish/Driver/ShiftRegister.h"
 #include "Pufferfish/HAL/STM32/HALBufferedUART.h"
+#include "Pufferfish/HAL/STM32/HALDigitalInputBank.h"
+#include "Pufferfish/HAL/STM32/HALIntervalTimer.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -48,6 +53,17 @@
 extern volatile Pufferfish::HAL::LargeBufferedUART backend_uart;
 extern volatile Pufferfish::HAL::LargeBufferedUART fdo2_uart;
 extern volatile Pufferfish::HAL::ReadOnlyBufferedUART nonin_oem_uart;
+/// Interface Board LEDs
+extern Pufferfish::Driver::ShiftRegister leds_reg;
+extern Pufferfish::HAL::HALIntervalTimer leds_timer;
+/// Front Panel Buttons
+extern Pufferfish::HAL::HALDigitalInputBank<5> buttons_input;
+extern Pufferfish::Driver::Button::BankDebouncer<16> buttons;
+extern Pufferfish::HAL::HALIntervalTimer buttons_timer;
+/// Breathing Circuit Control Loop
+extern Pufferfish::Driver::BreathingCircuit::HFNCControlLoop hfnc;
+extern Pufferfish::Driver::BreathingCircuit::PCACControlLoop pcac;
+extern Pufferfish::HAL::HALIntervalTimer control_timer;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -65,6 +81,13 @@ extern UART_HandleTypeDef huart4;
 extern UART_HandleTypeDef huart7;
 extern UART_HandleTypeDef huart3;
 /* USER CODE BEGIN EV */
+extern SPI_HandleTypeDef hspi1;
+extern "C" DMA_HandleTypeDef hdma_spi1_rx;
+extern "C" DMA_HandleTypeDef hdma_spi1_tx;
+extern "C" DMA_HandleTypeDef hdma_adc3;
+extern I2C_HandleTypeDef hi2c1;
+extern I2C_HandleTypeDef hi2c2;
+extern I2C_HandleTypeDef hi2c4;
 
 /* USER CODE END EV */
 
@@ -248,5 +271,116 @@ void UART7_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles DMA1 stream0 global interrupt.
+  */
+void DMA1_Stream0_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_spi1_rx);
+}
+
+/**
+  * @brief This function handles DMA1 stream1 global interrupt.
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_spi1_tx);
+}
+
+/**
+  * @brief This function handles SPI1 global interrupt.
+  */
+void SPI1_IRQHandler(void)
+{
+  HAL_SPI_IRQHandler(&hspi1);
+}
+
+/**
+  * @brief This function handles BDMA channel0 global interrupt.
+  */
+void BDMA_Channel0_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_adc3);
+}
+
+/**
+  * @brief This function handles I2C1 event interrupt.
+  */
+void I2C1_EV_IRQHandler(void)
+{
+  HAL_I2C_EV_IRQHandler(&hi2c1);
+}
+
+/**
+  * @brief This function handles I2C1 error interrupt.
+  */
+void I2C1_ER_IRQHandler(void)
+{
+  HAL_I2C_ER_IRQHandler(&hi2c1);
+}
+
+/**
+  * @brief This function handles I2C2 event interrupt.
+  */
+void I2C2_EV_IRQHandler(void)
+{
+  HAL_I2C_EV_IRQHandler(&hi2c2);
+}
+
+/**
+  * @brief This function handles I2C2 error interrupt.
+  */
+void I2C2_ER_IRQHandler(void)
+{
+  HAL_I2C_ER_IRQHandler(&hi2c2);
+}
+
+/**
+  * @brief This function handles I2C4 event interrupt.
+  */
+void I2C4_EV_IRQHandler(void)
+{
+  HAL_I2C_EV_IRQHandler(&hi2c4);
+}
+
+/**
+  * @brief This function handles I2C4 error interrupt.
+  */
+void I2C4_ER_IRQHandler(void)
+{
+  HAL_I2C_ER_IRQHandler(&hi2c4);
+}
+
+/**
+  * @brief This function handles TIM6 global interrupt, DAC1_CH1 and DAC1_CH2 underrun error interrupts.
+  */
+void TIM6_DAC_IRQHandler(void)
+{
+  if (leds_timer.handle_irq() && !leds_reg.step()) {
+    leds_timer.stop();
+  }
+}
+
+/**
+  * @brief This function handles TIM7 global interrupt.
+  */
+void TIM7_IRQHandler(void)
+{
+  if (buttons_timer.handle_irq()) {
+    buttons.input(buttons_input.read());
+  }
+}
+
+/**
+  * @brief This function handles TIM8 update interrupt and TIM13 global interrupt.
+  */
+void TIM8_UP_TIM13_IRQHandler(void)
+{
+  if (control_timer.handle_irq()) {
+    hfnc.update(HAL_GetTick());
+    pcac.update(HAL_GetTick());
+  }
+}
+
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
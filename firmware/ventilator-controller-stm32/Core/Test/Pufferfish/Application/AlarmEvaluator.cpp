@@ -0,0 +1,205 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * AlarmEvaluator.cpp
+ *
+ * Unit tests to confirm that alarms are raised and cleared against the alarm
+ * limits with persistence and hysteresis, in order of priority
+ *
+ */
+
+#include "Pufferfish/Application/AlarmEvaluator.h"
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+using PF::Application::AlarmEvaluator;
+using PF::Application::AlarmTransition;
+
+namespace {
+
+AlarmLimits spo2_limits(uint32_t lower, uint32_t upper) {
+  AlarmLimits alarm_limits{};
+  alarm_limits.has_spo2 = true;
+  alarm_limits.spo2 = Range{lower, upper};
+  return alarm_limits;
+}
+
+SensorMeasurements spo2_measurement(float spo2) {
+  SensorMeasurements sensor_measurements{};
+  sensor_measurements.spo2 = spo2;
+  return sensor_measurements;
+}
+
+// Feeds the same SpO2 at every ms from start to end, inclusive
+void hold_spo2(AlarmEvaluator &evaluator, float spo2, uint32_t start, uint32_t end) {
+  for (uint32_t t = start; t <= end; ++t) {
+    evaluator.input(spo2_measurement(spo2));
+    evaluator.update(t);
+  }
+}
+
+}  // namespace
+
+SCENARIO("Alarms are only evaluated against set limits", "[AlarmEvaluator]") {
+  GIVEN("An evaluator without any limits set") {
+    AlarmEvaluator evaluator;
+
+    WHEN("the measurements stay at zero for a long time") {
+      SensorMeasurements sensor_measurements{};
+      CycleMeasurements cycle_measurements{};
+      for (uint32_t t = 0; t <= 20000; t += 10) {
+        evaluator.input(sensor_measurements);
+        evaluator.input(cycle_measurements);
+        evaluator.update(t);
+      }
+
+      THEN("no alarm is raised") {
+        AlarmTransition transition{};
+        REQUIRE_FALSE(evaluator.output(transition));
+        REQUIRE(evaluator.active() == 0);
+      }
+    }
+  }
+}
+
+SCENARIO("Alarms persist before they are raised", "[AlarmEvaluator]") {
+  GIVEN("An SpO2 lower limit of 90%") {
+    AlarmEvaluator evaluator;
+    evaluator.input(spo2_limits(90, 100));
+    hold_spo2(evaluator, 95, 0, 100);
+
+    WHEN("SpO2 drops below the limit and stays there") {
+      hold_spo2(evaluator, 85, 101, 101 + 5000 - 1);
+      AlarmTransition transition{};
+      bool raised_early = evaluator.output(transition);
+      hold_spo2(evaluator, 85, 101 + 5000, 101 + 5000);
+
+      THEN("the alarm is raised exactly once the persistence duration has passed") {
+        REQUIRE_FALSE(raised_early);
+        REQUIRE(evaluator.output(transition));
+        REQUIRE(transition.code == LogEventCode_spo2_too_low);
+        REQUIRE(transition.priority == PF::AlarmStatus::high_priority);
+        REQUIRE(transition.active);
+        REQUIRE_FALSE(evaluator.output(transition));
+      }
+    }
+
+    WHEN("SpO2 only dips below the limit for less than the persistence duration") {
+      hold_spo2(evaluator, 85, 101, 4000);
+      hold_spo2(evaluator, 95, 4001, 4001);
+      hold_spo2(evaluator, 85, 4002, 8000);
+
+      THEN("no alarm is raised, since the persistence timer restarted") {
+        AlarmTransition transition{};
+        REQUIRE_FALSE(evaluator.output(transition));
+        REQUIRE(evaluator.active() == 0);
+      }
+    }
+  }
+}
+
+SCENARIO("Alarms clear with hysteresis", "[AlarmEvaluator]") {
+  GIVEN("An active SpO2 alarm against a lower limit of 90%") {
+    AlarmEvaluator evaluator;
+    evaluator.input(spo2_limits(90, 100));
+    hold_spo2(evaluator, 85, 0, 5000);
+    LogEventCode code{};
+    REQUIRE(evaluator.highest(code));
+    REQUIRE(code == LogEventCode_spo2_too_low);
+
+    WHEN("SpO2 comes back to the limit, but not past the hysteresis") {
+      hold_spo2(evaluator, 90.5, 5001, 6000);
+
+      THEN("the alarm stays active") {
+        AlarmTransition transition{};
+        REQUIRE_FALSE(evaluator.output(transition));
+        REQUIRE(evaluator.active() != 0);
+      }
+    }
+
+    WHEN("SpO2 comes back past the hysteresis") {
+      hold_spo2(evaluator, 90.5, 5001, 6000);
+      hold_spo2(evaluator, 91, 6001, 6001);
+
+      THEN("the alarm is cleared at once") {
+        AlarmTransition transition{};
+        REQUIRE(evaluator.output(transition));
+        REQUIRE(transition.code == LogEventCode_spo2_too_low);
+        REQUIRE_FALSE(transition.active);
+        REQUIRE(evaluator.active() == 0);
+        REQUIRE_FALSE(evaluator.highest(code));
+      }
+    }
+
+    WHEN("the limit is unset") {
+      evaluator.input(AlarmLimits{});
+      evaluator.update(5001);
+
+      THEN("the alarm is cleared") {
+        AlarmTransition transition{};
+        REQUIRE(evaluator.output(transition));
+        REQUIRE(transition.code == LogEventCode_spo2_too_low);
+        REQUIRE_FALSE(transition.active);
+        REQUIRE(evaluator.active() == 0);
+      }
+    }
+  }
+}
+
+SCENARIO("Alarm transitions are ordered by priority", "[AlarmEvaluator]") {
+  GIVEN("Limits on FiO2, SpO2 and RR, with an active high FiO2 alarm") {
+    AlarmEvaluator evaluator;
+    AlarmLimits alarm_limits = spo2_limits(90, 100);
+    alarm_limits.has_fio2 = true;
+    alarm_limits.fio2 = Range{21, 60};
+    alarm_limits.has_rr = true;
+    alarm_limits.rr = Range{10, 30};
+    evaluator.input(alarm_limits);
+
+    SensorMeasurements sensor_measurements{};
+    sensor_measurements.fio2 = 70;
+    sensor_measurements.spo2 = 95;
+    CycleMeasurements cycle_measurements{};
+    cycle_measurements.rr = 20;
+    for (uint32_t t = 0; t <= 3000; ++t) {
+      evaluator.input(sensor_measurements);
+      evaluator.input(cycle_measurements);
+      evaluator.update(t);
+    }
+    AlarmTransition transition{};
+    REQUIRE(evaluator.output(transition));
+    REQUIRE(transition.code == LogEventCode_fio2_too_high);
+    REQUIRE(transition.priority == PF::AlarmStatus::low_priority);
+
+    WHEN("FiO2 recovers as SpO2 and RR both go too low at the same time") {
+      sensor_measurements.fio2 = 40;
+      sensor_measurements.spo2 = 80;
+      cycle_measurements.rr = 5;
+      for (uint32_t t = 3001; t <= 8001; ++t) {
+        evaluator.input(sensor_measurements);
+        evaluator.input(cycle_measurements);
+        evaluator.update(t);
+        if (t == 3001) {
+          REQUIRE(evaluator.output(transition));
+          REQUIRE(transition.code == LogEventCode_fio2_too_high);
+          REQUIRE_FALSE(transition.active);
+        }
+      }
+
+      THEN("the raised alarms are popped in order of decreasing priority") {
+        REQUIRE(evaluator.output(transition));
+        REQUIRE(transition.code == LogEventCode_spo2_too_low);
+        REQUIRE(transition.priority == PF::AlarmStatus::high_priority);
+        REQUIRE(evaluator.output(transition));
+        REQUIRE(transition.code == LogEventCode_rr_too_low);
+        REQUIRE(transition.priority == PF::AlarmStatus::medium_priority);
+        REQUIRE_FALSE(evaluator.output(transition));
+
+        LogEventCode code{};
+        REQUIRE(evaluator.highest(code));
+        REQUIRE(code == LogEventCode_spo2_too_low);
+      }
+    }
+  }
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * SettingsEvents.cpp
+ *
+ * Unit tests to confirm that changes of the settings are reported as log
+ * events with their old and new values
+ *
+ */
+
+#include "Pufferfish/Application/SettingsEvents.h"
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+using PF::Application::SettingsEvents;
+
+SCENARIO("Setting changes are reported as log events", "[SettingsEvents]") {
+  GIVEN("Settings restored at startup") {
+    SettingsEvents settings_events;
+    Parameters parameters{};
+    parameters.mode = VentilationMode_hfnc;
+    parameters.fio2 = 21;
+    parameters.flow = 30;
+    AlarmLimits alarm_limits{};
+    alarm_limits.has_spo2 = true;
+    alarm_limits.spo2 = Range{90, 100};
+    settings_events.input(0, parameters, alarm_limits);
+
+    WHEN("nothing changes") {
+      settings_events.input(10, parameters, alarm_limits);
+
+      THEN("nothing is reported, not even the restored settings") {
+        LogEvent event{};
+        REQUIRE_FALSE(settings_events.output(event));
+      }
+    }
+
+    WHEN("ventilation starts, and the FiO2 and SpO2 limits change twice") {
+      parameters.ventilating = true;
+      parameters.fio2 = 40;
+      alarm_limits.spo2 = Range{88, 100};
+      settings_events.input(10, parameters, alarm_limits);
+      parameters.fio2 = 60;
+      alarm_limits.spo2 = Range{85, 100};
+      settings_events.input(20, parameters, alarm_limits);
+
+      THEN("each setting is reported once, from its original value to its newest one") {
+        LogEvent event{};
+        REQUIRE(settings_events.output(event));
+        REQUIRE(event.code == LogEventCode_ventilation_operation_changed);
+        REQUIRE(event.type == LogEventType_control);
+        REQUIRE(event.time == 10);
+        REQUIRE_FALSE(event.old_bool);
+        REQUIRE(event.new_bool);
+
+        REQUIRE(settings_events.output(event));
+        REQUIRE(event.code == LogEventCode_fio2_setting_changed);
+        REQUIRE(event.time == 20);
+        REQUIRE(event.old_float == 21);
+        REQUIRE(event.new_float == 60);
+
+        REQUIRE(settings_events.output(event));
+        REQUIRE(event.code == LogEventCode_spo2_alarm_limits_changed);
+        REQUIRE(event.type == LogEventType_alarm_limits);
+        REQUIRE(event.has_old_range);
+        REQUIRE(event.old_range.lower == 90);
+        REQUIRE(event.has_new_range);
+        REQUIRE(event.new_range.lower == 85);
+
+        REQUIRE_FALSE(settings_events.output(event));
+      }
+    }
+
+    WHEN("the mode changes and an HR limit is set for the first time") {
+      parameters.mode = VentilationMode_pc_ac;
+      alarm_limits.has_hr = true;
+      alarm_limits.hr = Range{50, 120};
+      settings_events.input(10, parameters, alarm_limits);
+
+      THEN("the old mode and the missing old limit are reported") {
+        LogEvent event{};
+        REQUIRE(settings_events.output(event));
+        REQUIRE(event.code == LogEventCode_ventilation_mode_changed);
+        REQUIRE(event.old_mode == VentilationMode_hfnc);
+        REQUIRE(event.new_mode == VentilationMode_pc_ac);
+
+        REQUIRE(settings_events.output(event));
+        REQUIRE(event.code == LogEventCode_hr_alarm_limits_changed);
+        REQUIRE_FALSE(event.has_old_range);
+        REQUIRE(event.has_new_range);
+        REQUIRE(event.new_range.upper == 120);
+      }
+    }
+  }
+}
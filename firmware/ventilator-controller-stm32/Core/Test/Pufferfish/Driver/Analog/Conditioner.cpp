@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Conditioner.cpp
+ *
+ * Unit tests to confirm behavior of the multi-channel signal conditioning
+ *
+ */
+
+#include "Pufferfish/Driver/Analog/Conditioner.h"
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace Analog = PF::Driver::Analog;
+using Conditioner = Analog::Conditioner<2, 1, 5, 3>;
+
+SCENARIO("Channels are conditioned in one block per step", "[Conditioner]") {
+  GIVEN("A conditioner with a full pipeline on one channel and none on the other") {
+    Conditioner::ChannelConfig filtered;
+    filtered.max_step = 10;
+    filtered.max_rejections = 1;
+    filtered.median = true;
+    filtered.biquads = {Analog::lowpass_biquad(100, 1000)};
+    filtered.fir = Analog::lowpass_fir<5>(200, 1000);
+    Conditioner conditioner(Conditioner::Config{filtered, Conditioner::ChannelConfig{}});
+    Conditioner::Samples conditioned{};
+
+    WHEN("constant samples are input from the start") {
+      THEN("they are output without a transient") {
+        for (size_t i = 0; i < 50; ++i) {
+          conditioner.transform({20, -3}, conditioned);
+          REQUIRE(conditioned[0] == Approx(20));
+          REQUIRE(conditioned[1] == -3);
+        }
+      }
+    }
+
+    WHEN("a spike is input on both channels") {
+      conditioner.transform({20, 1}, conditioned);
+      conditioner.transform({80, 80}, conditioned);
+      float spiked_filtered = conditioned[0];
+      float spiked_unfiltered = conditioned[1];
+      for (size_t i = 0; i < 20; ++i) {
+        conditioner.transform({20, 1}, conditioned);
+        REQUIRE(conditioned[0] == Approx(20));
+      }
+
+      THEN("only the unconditioned channel passes it") {
+        REQUIRE(spiked_filtered == Approx(20));
+        REQUIRE(spiked_unfiltered == 80);
+        REQUIRE(conditioner.rejected(0) == 1);
+        REQUIRE(conditioner.rejected(1) == 0);
+        REQUIRE(conditioner.rejected(2) == 0);
+      }
+    }
+
+    WHEN("the conditioner is reset") {
+      conditioner.transform({20, 1}, conditioned);
+      conditioner.reset();
+      conditioner.transform({60, 1}, conditioned);
+
+      THEN("it is primed again by the next samples") {
+        REQUIRE(conditioned[0] == Approx(60));
+        REQUIRE(conditioner.rejected(0) == 0);
+      }
+    }
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Decimator.cpp
+ *
+ * Unit tests to confirm behavior of ADC scan decimation
+ *
+ */
+
+#include "Pufferfish/Driver/Analog/Decimator.h"
+
+#include <array>
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+using Decimator = PF::Driver::Analog::Decimator<2>;
+
+SCENARIO("ADC scan samples are decimated per channel", "[Decimator]") {
+  GIVEN("A decimator averaging 2 scans on the first channel and 4 on the second") {
+    Decimator decimator(Decimator::Decimations{2, 4});
+    uint32_t value = 0;
+
+    THEN("nothing is output before a window fills up") {
+      REQUIRE(decimator.output(0, value) == PF::ADCStatus::error);
+      REQUIRE(decimator.published(0) == 0);
+    }
+
+    WHEN("interleaved scans are input in blocks which split the windows") {
+      const std::array<uint16_t, 6> first{10, 100, 11, 200, 20, 300};
+      const std::array<uint16_t, 4> second{21, 401, 30, 500};
+      decimator.input(first.data(), 3);
+      decimator.input(second.data(), 2);
+
+      THEN("each channel publishes the rounded average of its own window") {
+        REQUIRE(decimator.published(0) == 2);
+        REQUIRE(decimator.output(0, value) == PF::ADCStatus::ok);
+        REQUIRE(value == 21);  // (20 + 21) / 2 rounded
+        REQUIRE(decimator.published(1) == 1);
+        REQUIRE(decimator.output(1, value) == PF::ADCStatus::ok);
+        REQUIRE(value == 250);  // (100 + 200 + 300 + 401) / 4 rounded
+      }
+    }
+
+    WHEN("a channel outside the scan is requested") {
+      THEN("it is rejected") {
+        REQUIRE(decimator.output(2, value) == PF::ADCStatus::error);
+        REQUIRE(decimator.published(2) == 0);
+      }
+    }
+  }
+
+  GIVEN("A decimation of 0") {
+    Decimator decimator(Decimator::Decimations{0, 1});
+
+    THEN("every scan is published") {
+      const std::array<uint16_t, 2> scan{65535, 7};
+      decimator.input(scan.data(), 1);
+      uint32_t value = 0;
+      REQUIRE(decimator.output(0, value) == PF::ADCStatus::ok);
+      REQUIRE(value == 65535);
+      REQUIRE(decimator.output(1, value) == PF::ADCStatus::ok);
+      REQUIRE(value == 7);
+    }
+  }
+}
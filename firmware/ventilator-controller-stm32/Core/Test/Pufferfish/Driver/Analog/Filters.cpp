@@ -0,0 +1,190 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Filters.cpp
+ *
+ * Unit tests to confirm behavior of the signal conditioning filters
+ *
+ */
+
+#include "Pufferfish/Driver/Analog/Filters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace Analog = PF::Driver::Analog;
+
+namespace {
+
+const float sample_rate = 1000;  // Hz
+const float pi = 3.14159265F;
+
+// Peak output amplitude of a filter, after settling, for a unit sine input
+template <typename Filter>
+float sine_gain(Filter &filter, float frequency) {
+  const size_t settling = 2000;
+  const size_t measured = 2000;
+  float peak = 0;
+  for (size_t i = 0; i < settling + measured; ++i) {
+    float output = filter.input(std::sin(2 * pi * frequency * static_cast<float>(i) / sample_rate));
+    if (i >= settling) {
+      peak = std::max(peak, std::abs(output));
+    }
+  }
+  return peak;
+}
+
+}  // namespace
+
+SCENARIO("Biquad cascades low-pass signals", "[Filters]") {
+  GIVEN("A cascade of two 50 Hz Butterworth sections at 1 kHz") {
+    auto section = Analog::lowpass_biquad(50, sample_rate);
+    Analog::BiquadCascade<2> filter({section, section});
+
+    THEN("the gain is unity at DC and well below it above the cutoff") {
+      REQUIRE(sine_gain(filter, 2) == Approx(1).margin(0.01));
+      REQUIRE(sine_gain(filter, 50) == Approx(0.5).margin(0.02));
+      REQUIRE(sine_gain(filter, 400) < 0.001);
+    }
+
+    WHEN("the filter is reset to a constant input") {
+      filter.reset(12.5);
+
+      THEN("that input is output without a transient") {
+        for (size_t i = 0; i < 100; ++i) {
+          REQUIRE(filter.input(12.5) == Approx(12.5));
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("FIR filters convolve their input with their taps", "[Filters]") {
+  GIVEN("A 21-tap low-pass filter at 50 Hz") {
+    auto taps = Analog::lowpass_fir<21>(50, sample_rate);
+    Analog::FIRFilter<21> filter(taps);
+
+    THEN("the taps are symmetric and sum to unity") {
+      float sum = 0;
+      for (size_t i = 0; i < taps.size(); ++i) {
+        REQUIRE(taps[i] == Approx(taps[taps.size() - 1 - i]));
+        sum += taps[i];
+      }
+      REQUIRE(sum == Approx(1));
+    }
+
+    THEN("its impulse response is its taps, repeatedly") {
+      for (size_t repeat = 0; repeat < 3; ++repeat) {
+        REQUIRE(filter.input(1) == Approx(taps[0]));
+        for (size_t i = 1; i < taps.size(); ++i) {
+          REQUIRE(filter.input(0) == Approx(taps[i]));
+        }
+      }
+    }
+
+    THEN("high frequencies are attenuated") {
+      REQUIRE(sine_gain(filter, 2) == Approx(1).margin(0.01));
+      REQUIRE(sine_gain(filter, 300) < 0.05);
+    }
+  }
+
+  GIVEN("An identity FIR filter") {
+    Analog::FIRFilter<4> filter(Analog::identity_fir<4>());
+
+    THEN("its output is its input") {
+      for (float sample : {3.0F, -1.0F, 7.5F, 0.0F, 2.0F}) {
+        REQUIRE(filter.input(sample) == sample);
+      }
+    }
+  }
+}
+
+SCENARIO("Median filters output the median of their window", "[Filters]") {
+  GIVEN("A median filter of 5 samples") {
+    Analog::MedianFilter<5> filter;
+    filter.reset(0);
+
+    WHEN("it is fed a pseudo-random sequence with many repeated values") {
+      std::srand(7);
+      std::vector<float> history(5, 0);
+      bool all_match = true;
+      for (size_t i = 0; i < 2000; ++i) {
+        float sample = static_cast<float>(std::rand() % 7);
+        float output = filter.input(sample);
+        history.push_back(sample);
+        std::vector<float> window(history.end() - 5, history.end());
+        std::nth_element(window.begin(), window.begin() + 2, window.end());
+        all_match = all_match && output == window[2];
+      }
+
+      THEN("each output matches the median computed from scratch") {
+        REQUIRE(all_match);
+      }
+    }
+
+    WHEN("an isolated outlier and then a step are input") {
+      std::vector<float> outputs;
+      for (float sample : {1.0F, 1.0F, 1.0F, 1.0F, 90.0F, 1.0F, 1.0F, 5.0F, 5.0F, 5.0F}) {
+        outputs.push_back(filter.input(sample));
+      }
+
+      THEN("the outlier is removed and the step passes unsmeared, 2 samples late") {
+        REQUIRE(outputs[4] == 1);
+        REQUIRE(outputs[6] == 1);
+        REQUIRE(outputs[7] == 1);
+        REQUIRE(outputs[8] == 5);
+        REQUIRE(outputs[9] == 5);
+      }
+    }
+  }
+}
+
+SCENARIO("Spike rejectors hold over brief jumps", "[Filters]") {
+  GIVEN("A spike rejector for steps above 10 which holds over at most 2 samples") {
+    Analog::SpikeRejector rejector(10, 2);
+    rejector.reset(0);
+
+    WHEN("a single sample jumps") {
+      float held = rejector.input(50);
+      float next = rejector.input(1);
+
+      THEN("it is replaced by the previous sample") {
+        REQUIRE(held == 0);
+        REQUIRE(next == 1);
+        REQUIRE(rejector.rejected() == 1);
+      }
+    }
+
+    WHEN("a jump persists") {
+      std::vector<float> outputs;
+      for (size_t i = 0; i < 4; ++i) {
+        outputs.push_back(rejector.input(50));
+      }
+
+      THEN("it is accepted after the maximum number of rejections") {
+        REQUIRE(outputs[0] == 0);
+        REQUIRE(outputs[1] == 0);
+        REQUIRE(outputs[2] == 50);
+        REQUIRE(outputs[3] == 50);
+        REQUIRE(rejector.rejected() == 2);
+      }
+    }
+
+    WHEN("a non-finite sample is input") {
+      float output = rejector.input(std::nanf(""));
+
+      THEN("it is always rejected") {
+        REQUIRE(output == 0);
+        REQUIRE(rejector.input(std::numeric_limits<float>::infinity()) == 0);
+        REQUIRE(rejector.input(std::numeric_limits<float>::infinity()) == 0);
+        REQUIRE(rejector.rejected() == 3);
+      }
+    }
+  }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * AlarmLimitsService.cpp
+ *
+ * Unit tests to confirm behavior of alarm limits request servicing
+ *
+ */
+
+#include "Pufferfish/Driver/BreathingCircuit/AlarmLimitsService.h"
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace BreathingCircuit = PF::Driver::BreathingCircuit;
+
+SCENARIO("Alarm limits requests are serviced for the active mode", "[AlarmLimitsService]") {
+  GIVEN("The default alarm limits") {
+    BreathingCircuit::AlarmLimitsServices services;
+    AlarmLimits alarm_limits = BreathingCircuit::AlarmLimitsServices::default_alarm_limits();
+    Parameters parameters{};
+    AlarmLimitsRequest request{};
+    request.has_spo2 = true;
+    request.spo2 = {90, 100};
+    request.has_rr = true;
+    request.rr = {10, 30};
+
+    WHEN("a request is serviced in PC-AC mode") {
+      parameters.mode = VentilationMode_pc_ac;
+      services.transform(parameters, request, alarm_limits);
+
+      THEN("the requested limits take effect and the others are kept") {
+        REQUIRE(alarm_limits.spo2.lower == 90);
+        REQUIRE(alarm_limits.spo2.upper == 100);
+        REQUIRE(alarm_limits.rr.lower == 10);
+        REQUIRE(alarm_limits.rr.upper == 30);
+        REQUIRE(alarm_limits.has_fio2);
+        REQUIRE(alarm_limits.fio2.lower == 21);
+        REQUIRE(alarm_limits.fio2.upper == 100);
+      }
+    }
+
+    WHEN("a request is serviced in HFNC mode") {
+      parameters.mode = VentilationMode_hfnc;
+      services.transform(parameters, request, alarm_limits);
+
+      THEN("only the limits which apply to HFNC take effect") {
+        REQUIRE(alarm_limits.spo2.lower == 90);
+        REQUIRE(alarm_limits.rr.lower == 0);
+        REQUIRE(alarm_limits.rr.upper == 100);
+      }
+    }
+
+    WHEN("a request lies outside of the allowed range or is inverted") {
+      parameters.mode = VentilationMode_pc_ac;
+      request.fio2 = {10, 100};
+      request.has_fio2 = true;
+      request.spo2 = {95, 90};
+      services.transform(parameters, request, alarm_limits);
+
+      THEN("the current limits are kept") {
+        REQUIRE(alarm_limits.fio2.lower == 21);
+        REQUIRE(alarm_limits.spo2.lower == 21);
+        REQUIRE(alarm_limits.spo2.upper == 100);
+      }
+    }
+
+    WHEN("a request is serviced in a mode without a service") {
+      parameters.mode = VentilationMode_vc_ac;
+      services.transform(parameters, request, alarm_limits);
+
+      THEN("the request is ignored") {
+        REQUIRE(alarm_limits.spo2.lower == 21);
+      }
+    }
+  }
+}
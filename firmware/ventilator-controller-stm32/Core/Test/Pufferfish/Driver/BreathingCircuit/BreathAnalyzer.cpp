@@ -0,0 +1,125 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * BreathAnalyzer.cpp
+ *
+ * Unit tests to confirm behavior of the streaming breath cycle measurements
+ *
+ */
+
+#include "Pufferfish/Driver/BreathingCircuit/BreathAnalyzer.h"
+
+#include <cmath>
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace BreathingCircuit = PF::Driver::BreathingCircuit;
+
+namespace {
+
+const uint32_t cycle_period = 3000;  // ms, for 20 b/min
+const uint32_t insp_period = 1000;   // ms
+const float insp_flow = 30;          // L/min, for 500 mL per breath
+const float pip = 25;                // cm H2O
+const float peep = 5;                // cm H2O
+
+// A pressure-controlled breath with a decaying expiratory flow, plus
+// deterministic noise smaller than the analyzer's flow thresholds
+void breath_sample(uint32_t time, float &flow, float &paw) {
+  uint32_t cycle_time = time % cycle_period;
+  float noise = 1.5F * std::sin(static_cast<float>(time) * 0.7F);
+  if (cycle_time < insp_period) {
+    flow = insp_flow + noise;
+    paw = pip;
+  } else {
+    flow = -2 * insp_flow * std::exp(-static_cast<float>(cycle_time - insp_period) / 300) + noise;
+    paw = peep + noise / 10;
+  }
+}
+
+// Feeds 1 ms samples from start to end and collects the measurements output
+std::vector<CycleMeasurements> run(
+    BreathingCircuit::BreathAnalyzer &analyzer, uint32_t start, uint32_t end) {
+  std::vector<CycleMeasurements> cycles;
+  for (uint32_t time = start; time < end; ++time) {
+    float flow = 0;
+    float paw = 0;
+    breath_sample(time, flow, paw);
+    analyzer.input(time, flow, paw);
+    CycleMeasurements cycle{};
+    if (analyzer.output(cycle)) {
+      cycles.push_back(cycle);
+    }
+  }
+  return cycles;
+}
+
+}  // namespace
+
+SCENARIO("The breath analyzer measures each breath of a noisy waveform", "[BreathAnalyzer]") {
+  GIVEN("A breath analyzer") {
+    BreathingCircuit::BreathAnalyzer analyzer;
+
+    WHEN("five breaths are input, starting partway through a breath") {
+      auto cycles = run(analyzer, 500, 5 * cycle_period + 1);
+
+      THEN("only the complete breaths are measured, at their boundaries") {
+        REQUIRE(cycles.size() == 4);
+        for (size_t i = 0; i < cycles.size(); ++i) {
+          REQUIRE(cycles[i].time == (i + 2) * cycle_period);
+        }
+      }
+
+      THEN("the measurements match the waveform") {
+        for (const CycleMeasurements &cycle : cycles) {
+          REQUIRE(cycle.vt == Approx(500).epsilon(0.02));
+          REQUIRE(cycle.rr == Approx(20));
+          REQUIRE(cycle.pip == Approx(pip).margin(0.2));
+          REQUIRE(cycle.peep == Approx(peep).margin(0.2));
+          REQUIRE(cycle.ip == Approx(pip).margin(0.1));
+          REQUIRE(cycle.ve == Approx(10).epsilon(0.02));
+        }
+      }
+
+      THEN("no measurements are output again until the next breath") {
+        CycleMeasurements cycle{};
+        REQUIRE_FALSE(analyzer.output(cycle));
+        REQUIRE(analyzer.phase() == BreathingCircuit::BreathAnalyzer::Phase::inspiratory);
+      }
+    }
+
+    WHEN("the flow briefly reverses early in inspiration") {
+      run(analyzer, 0, cycle_period + 10);
+      analyzer.input(cycle_period + 10, -10, pip);
+      auto cycles = run(analyzer, cycle_period + 11, 2 * cycle_period + 1);
+
+      THEN("the breath is not split") {
+        REQUIRE(cycles.size() == 1);
+        REQUIRE(cycles[0].rr == Approx(20));
+      }
+    }
+
+    WHEN("samples stop for longer than the maximum sample interval") {
+      run(analyzer, 0, cycle_period + 1500);
+      auto cycles = run(analyzer, cycle_period + 1500 + 200, 3 * cycle_period + 1);
+
+      THEN("the interrupted breath is discarded") {
+        REQUIRE(cycles.size() == 1);
+        REQUIRE(cycles[0].time == 3 * cycle_period);
+      }
+    }
+
+    WHEN("the analyzer is reset between breaths") {
+      run(analyzer, 0, 2 * cycle_period + 1);
+      analyzer.reset();
+      auto cycles = run(analyzer, 2 * cycle_period + 1, 3 * cycle_period + 1);
+
+      THEN("the breath in progress at the reset is not measured") {
+        REQUIRE(cycles.empty());
+        REQUIRE(analyzer.volume() == Approx(0).margin(1));
+      }
+    }
+  }
+}
@@ -0,0 +1,385 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Plant.cpp
+ *
+ * Unit tests to confirm behavior of the fixed-step breathing circuit models,
+ * and of the HFNC and PC-AC control loops closed through them
+ *
+ */
+
+#include "Pufferfish/Driver/BreathingCircuit/Plant.h"
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "Pufferfish/Application/States.h"
+#include "Pufferfish/Driver/BreathingCircuit/ControlLoop.h"
+#include "Pufferfish/Driver/I2C/HoneywellABP.h"
+#include "Pufferfish/Driver/I2C/SFM3019/Sensor.h"
+#include "Pufferfish/Driver/ValveBank.h"
+#include "Pufferfish/HAL/Mock/MockI2CDevice.h"
+#include "Pufferfish/HAL/Mock/MockPWM.h"
+#include "Pufferfish/HAL/Mock/MockPWMUpdateGate.h"
+#include "Pufferfish/HAL/Mock/MockSFM3019.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace BreathingCircuit = PF::Driver::BreathingCircuit;
+namespace SFM3019 = PF::Driver::I2C::SFM3019;
+
+namespace {
+
+const uint32_t valve_max_duty = 6400;
+
+// The firmware's HFNC control loop, closed through the plant model
+class ClosedLoop {
+ public:
+  ClosedLoop() {
+    valve_air_.set_max_duty_cycle(valve_max_duty);
+    valve_o2_.set_max_duty_cycle(valve_max_duty);
+    valves_.setup();
+  }
+
+  void run(const Parameters &parameters, uint32_t duration) {
+    for (uint32_t i = 0; i < duration; ++i) {
+      const auto current_time = static_cast<uint32_t>(plant.elapsed_us() / 1000);
+      time_.set_micros(static_cast<uint32_t>(plant.elapsed_us()));
+      time_.set_millis(current_time);
+      sfm3019_air_.setup();
+      sfm3019_o2_.setup();
+      hfnc_.input(parameters);
+      i2c_air_.set_flow(plant.vars().flow_air);
+      i2c_o2_.set_flow(plant.vars().flow_o2);
+      hfnc_.update(current_time);
+      plant.update(opening(valve_air_), opening(valve_o2_));
+    }
+  }
+
+  // Runs a calibration of both valves to completion, outside of any mode
+  void calibrate() {
+    hfnc_.calibrate();
+    while (hfnc_.calibrating()) {
+      run(Parameters{}, 1);
+    }
+  }
+
+  bool output(BreathingCircuit::ValveCharacterization &characterization) {
+    return hfnc_.output(characterization);
+  }
+
+  bool restore(const BreathingCircuit::ValveCharacterization &characterization) {
+    return hfnc_.restore(characterization);
+  }
+
+  [[nodiscard]] float air_opening() const { return opening(valve_air_); }
+  [[nodiscard]] float o2_opening() const { return opening(valve_o2_); }
+
+  BreathingCircuit::HFNCPlant plant;
+
+ private:
+  PF::HAL::MockTime time_;
+  PF::HAL::MockSFM3019 i2c_air_;
+  PF::HAL::MockSFM3019 i2c_o2_;
+  PF::HAL::MockI2CDevice global_air_;
+  PF::HAL::MockI2CDevice global_o2_;
+  SFM3019::Device dev_air_{i2c_air_, global_air_, SFM3019::GasType::air};
+  SFM3019::Device dev_o2_{i2c_o2_, global_o2_, SFM3019::GasType::o2};
+  SFM3019::Sensor sfm3019_air_{dev_air_, true, time_};
+  SFM3019::Sensor sfm3019_o2_{dev_o2_, true, time_};
+  PF::HAL::MockPWM valve_air_;
+  PF::HAL::MockPWM valve_o2_;
+  PF::HAL::MockPWMUpdateGate gate_;
+  PF::Driver::PWMValveBank<2> valves_{{{&valve_air_, &valve_o2_}}, gate_};
+  BreathingCircuit::HFNCControlLoop hfnc_{sfm3019_air_, sfm3019_o2_, valves_};
+
+  static float opening(const PF::HAL::MockPWM &pwm) {
+    return pwm.get_duty_cycle_raw() / static_cast<float>(valve_max_duty);
+  }
+};
+
+// The firmware's PC-AC control loop, closed through the PC-AC plant model
+class PCACClosedLoop {
+ public:
+  PCACClosedLoop() {
+    for (auto &valve : valves_pwm_) {
+      valve.set_max_duty_cycle(valve_max_duty);
+    }
+    valves_.setup();
+  }
+
+  // Runs the loop, keeping track of the airway pressure in each step
+  void run(const Parameters &parameters, uint32_t duration) {
+    for (uint32_t i = 0; i < duration; ++i) {
+      const auto current_time = static_cast<uint32_t>(plant.elapsed_us() / 1000);
+      time_.set_micros(static_cast<uint32_t>(plant.elapsed_us()));
+      time_.set_millis(current_time);
+      pcac_.input(parameters);
+      set_paw(plant.vars().paw);
+      pcac_.update(current_time);
+      plant.update(
+          opening(valves_pwm_[BreathingCircuit::PCACControlLoop::valve_inspiratory]),
+          opening(valves_pwm_[BreathingCircuit::PCACControlLoop::valve_expiratory]));
+      paw.push_back(plant.vars().paw);
+    }
+  }
+
+  [[nodiscard]] float opening(size_t valve) const { return opening(valves_pwm_.at(valve)); }
+
+  BreathingCircuit::PCACPlant plant;
+  std::vector<float> paw;
+
+ private:
+  static constexpr float cm_h2o_per_psi = 70.307;
+  static const uint16_t abp_output_min = 0x0666;
+  static const uint16_t abp_output_max = 0x399A;
+
+  PF::HAL::MockTime time_;
+  PF::HAL::MockI2CDevice i2c_paw_;
+  PF::Driver::I2C::HoneywellABP paw_sensor_{i2c_paw_, PF::Driver::I2C::abpxxxx001pg2a3};
+  std::array<PF::HAL::MockPWM, 4> valves_pwm_{};
+  PF::HAL::MockPWMUpdateGate gate_;
+  PF::Driver::PWMValveBank<4> valves_{
+      {{&valves_pwm_[0], &valves_pwm_[1], &valves_pwm_[2], &valves_pwm_[3]}}, gate_};
+  BreathingCircuit::PCACControlLoop pcac_{paw_sensor_, valves_, time_};
+
+  // Queues the ABP's 14-bit reading of a pressure within its 1 psi range
+  void set_paw(float paw) {
+    float fraction = std::fmin(std::fmax(paw / cm_h2o_per_psi, 0), 1);
+    auto output = static_cast<uint16_t>(
+        abp_output_min + std::lround(fraction * (abp_output_max - abp_output_min)));
+    std::array<uint8_t, 2> data{
+        {static_cast<uint8_t>(output >> 8U), static_cast<uint8_t>(output & 0xFFU)}};
+    i2c_paw_.add_read(data.data(), data.size());
+  }
+
+  static float opening(const PF::HAL::MockPWM &pwm) {
+    return pwm.get_duty_cycle_raw() / static_cast<float>(valve_max_duty);
+  }
+};
+
+Parameters hfnc_parameters(float flow, float fio2) {
+  Parameters parameters{};
+  parameters.mode = VentilationMode_hfnc;
+  parameters.ventilating = true;
+  parameters.flow = flow;
+  parameters.fio2 = fio2;
+  return parameters;
+}
+
+Parameters pcac_parameters(float rr, float ie, float pip, float peep) {
+  Parameters parameters{};
+  parameters.mode = VentilationMode_pc_ac;
+  parameters.ventilating = true;
+  parameters.rr = rr;
+  parameters.ie = ie;
+  parameters.pip = pip;
+  parameters.peep = peep;
+  return parameters;
+}
+
+}  // namespace
+
+SCENARIO("The HFNC plant model responds to its valves", "[BreathingCircuit]") {
+  GIVEN("A plant with default parameters and 1 ms steps") {
+    BreathingCircuit::PlantParameters parameters{};
+    BreathingCircuit::HFNCPlant plant(parameters, 1000);
+
+    WHEN("both valves stay below their cracking point for one second") {
+      for (size_t i = 0; i < 1000; ++i) {
+        plant.update(0.1, 0.1);
+      }
+
+      THEN("no gas flows and the circuit holds room air") {
+        REQUIRE(plant.elapsed_us() == 1000000);
+        REQUIRE(plant.vars().flow_air == 0);
+        REQUIRE(plant.vars().flow_o2 == 0);
+        REQUIRE(plant.vars().fio2 == Approx(21));
+      }
+    }
+
+    WHEN("only the O2 valve is held fully open for one second") {
+      for (size_t i = 0; i < 1000; ++i) {
+        plant.update(0, 1);
+      }
+
+      THEN("the O2 flow settles at the valve's maximum and flushes the circuit with O2") {
+        REQUIRE(plant.vars().flow_air == 0);
+        REQUIRE(plant.vars().flow_o2 == Approx(parameters.valve_max_flow));
+        REQUIRE(plant.vars().fio2 > 95);
+        REQUIRE(plant.vars().paw > 0);
+      }
+    }
+
+    WHEN("the air valve is opened halfway between its cracking point and fully open") {
+      plant.update(0.6, 0);
+
+      THEN("the flow starts rising with the valve's time constant") {
+        float response = 0.001 / (parameters.valve_time_constant + 0.001);
+        REQUIRE(plant.vars().flow_air == Approx(60 * response));
+      }
+    }
+
+    WHEN("the valves deliver less flow than the patient's peak inspiratory demand") {
+      float min_inspired_fio2 = 100;
+      for (size_t i = 0; i < 10000; ++i) {
+        plant.update(0.2, 0.3);
+        min_inspired_fio2 = std::fmin(min_inspired_fio2, plant.vars().inspired_fio2);
+      }
+
+      THEN("entrained room air dilutes the inspired gas during inspiration") {
+        REQUIRE(plant.vars().fio2 > 98);
+        REQUIRE(min_inspired_fio2 < 60);
+      }
+    }
+  }
+}
+
+SCENARIO("The HFNC control loop is simulated deterministically", "[BreathingCircuit]") {
+  GIVEN("The HFNC control loop closed through the plant model") {
+    ClosedLoop loop;
+
+    WHEN("it runs for 10 seconds at 40 L/min and 60% FiO2") {
+      loop.run(hfnc_parameters(40, 60), 10000);
+
+      THEN("the delivered flow and FiO2 track their setpoints") {
+        const BreathingCircuit::PlantVars &vars = loop.plant.vars();
+        REQUIRE(vars.flow_air + vars.flow_o2 == Approx(40).margin(0.1));
+        REQUIRE(vars.fio2 == Approx(60).margin(0.5));
+      }
+    }
+
+    WHEN("its valves are calibrated before a step to 40 L/min") {
+      ClosedLoop uncalibrated;
+      loop.calibrate();
+      BreathingCircuit::ValveCharacterization characterization{};
+      bool published = loop.output(characterization);
+      bool republished = loop.output(characterization);
+      loop.run(Parameters{}, 200);
+      float peak_flow = 0;
+      for (size_t i = 0; i < 100; ++i) {
+        loop.run(hfnc_parameters(40, 21), 1);
+        peak_flow = std::fmax(peak_flow, loop.plant.vars().flow_air);
+      }
+      uncalibrated.run(hfnc_parameters(40, 21), 100);
+
+      THEN("it is published once, and the flow settles within 100 ms without overshoot") {
+        REQUIRE(published);
+        REQUIRE_FALSE(republished);
+        REQUIRE(characterization.air[BreathingCircuit::ValveTable::point_count - 1] ==
+                Approx(120).margin(0.1));
+        REQUIRE(loop.plant.vars().flow_air == Approx(40).margin(1.5));
+        REQUIRE(peak_flow < 40.5);
+        REQUIRE(uncalibrated.plant.vars().flow_air < 38);
+      }
+    }
+
+    WHEN("tables from an earlier calibration are restored") {
+      ClosedLoop earlier;
+      earlier.calibrate();
+      BreathingCircuit::ValveCharacterization characterization{};
+      REQUIRE(earlier.output(characterization));
+      BreathingCircuit::ValveCharacterization flat{};
+      flat.air.fill(5);
+      flat.o2 = characterization.o2;
+
+      THEN("only tables which span enough flow are usable") {
+        REQUIRE(loop.restore(characterization));
+        REQUIRE_FALSE(loop.restore(flat));
+        REQUIRE_FALSE(loop.restore(BreathingCircuit::ValveCharacterization{}));
+      }
+    }
+
+    WHEN("the mode changes to PC-AC while flow is delivered") {
+      loop.run(hfnc_parameters(40, 60), 1000);
+      const float air_opening = loop.air_opening();
+      const float o2_opening = loop.o2_opening();
+      loop.run(pcac_parameters(20, 0.5, 20, 5), 1);
+
+      THEN("both valves are closed") {
+        REQUIRE(air_opening > 0);
+        REQUIRE(o2_opening > 0);
+        REQUIRE(loop.air_opening() == 0);
+        REQUIRE(loop.o2_opening() == 0);
+      }
+    }
+
+    WHEN("it runs twice with the same parameters") {
+      ClosedLoop other;
+      loop.run(hfnc_parameters(30, 90), 3000);
+      other.run(hfnc_parameters(30, 90), 3000);
+
+      THEN("both runs end in exactly the same state") {
+        REQUIRE(loop.plant.vars().flow_air == other.plant.vars().flow_air);
+        REQUIRE(loop.plant.vars().flow_o2 == other.plant.vars().flow_o2);
+        REQUIRE(loop.plant.vars().fio2 == other.plant.vars().fio2);
+      }
+    }
+  }
+}
+
+SCENARIO("The PC-AC control loop is simulated deterministically", "[BreathingCircuit]") {
+  GIVEN("The PC-AC control loop closed through the plant model") {
+    PCACClosedLoop loop;
+
+    WHEN("it runs 4 breaths at 20 b/min, I:E 1:2, PIP 20 cm H2O and PEEP 5 cm H2O") {
+      const float pip = 20;
+      const float peep = 5;
+      loop.run(pcac_parameters(20, 0.5, pip, peep), 12000);
+
+      // The last breath starts at 9 s, with 1 s of inspiration
+      const size_t breath_start = 9000;
+      const size_t inspiration_end = 9999;
+      const size_t breath_end = 11999;
+      size_t rise_start = breath_start;
+      size_t rise_end = breath_start;
+      float peak_paw = 0;
+      for (size_t i = breath_start; i <= inspiration_end; ++i) {
+        if (loop.paw[i] < peep + 0.1 * (pip - peep)) {
+          rise_start = i;
+        }
+        if (loop.paw[i] < peep + 0.9 * (pip - peep)) {
+          rise_end = i;
+        }
+        peak_paw = std::fmax(peak_paw, loop.paw[i]);
+      }
+
+      THEN("pressure rises within 150 ms, with little overshoot, and holds PIP") {
+        REQUIRE(rise_end - rise_start < 150);
+        REQUIRE(peak_paw < pip + 1);
+        REQUIRE(loop.paw[inspiration_end] == Approx(pip).margin(0.2));
+      }
+
+      THEN("PEEP is held at the end of expiration") {
+        REQUIRE(loop.paw[breath_end] == Approx(peep).margin(0.2));
+      }
+    }
+
+    WHEN("ventilation stops in the middle of an inspiration") {
+      loop.run(pcac_parameters(20, 0.5, 20, 5), 3500);
+      Parameters stopped = pcac_parameters(20, 0.5, 20, 5);
+      stopped.ventilating = false;
+      loop.run(stopped, 1000);
+
+      THEN("the airway is vented through the expiratory valve") {
+        REQUIRE(loop.paw[3499] > 15);
+        REQUIRE(loop.plant.vars().paw < 0.5);
+      }
+    }
+
+    WHEN("the mode changes to HFNC in the middle of an inspiration") {
+      loop.run(pcac_parameters(20, 0.5, 20, 5), 3500);
+      const float inspiratory_opening =
+          loop.opening(BreathingCircuit::PCACControlLoop::valve_inspiratory);
+      loop.run(hfnc_parameters(40, 21), 1);
+
+      THEN("both of its valves are closed") {
+        REQUIRE(inspiratory_opening > 0);
+        REQUIRE(loop.opening(BreathingCircuit::PCACControlLoop::valve_inspiratory) == 0);
+        REQUIRE(loop.opening(BreathingCircuit::PCACControlLoop::valve_expiratory) == 0);
+      }
+    }
+  }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Simulator.cpp
+ *
+ * Unit tests to confirm behavior of the breathing circuit simulators
+ *
+ */
+
+#include "Pufferfish/Driver/BreathingCircuit/Simulator.h"
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace BreathingCircuit = PF::Driver::BreathingCircuit;
+
+SCENARIO("The PC-AC simulator measures each simulated breath", "[Simulator]") {
+  GIVEN("The simulators, ventilating in PC-AC mode") {
+    BreathingCircuit::Simulators simulator;
+    Parameters parameters{};
+    parameters.mode = VentilationMode_pc_ac;
+    parameters.ventilating = true;
+    parameters.rr = 20;
+    parameters.ie = 0.5;
+    parameters.pip = 20;
+    parameters.peep = 5;
+    parameters.fio2 = 21;
+    BreathingCircuit::SensorVars sensor_vars{};
+    SensorMeasurements sensor_measurements{};
+    CycleMeasurements cycle_measurements{};
+
+    WHEN("a few breaths are simulated") {
+      for (uint32_t time = 1; time <= 10000; ++time) {
+        simulator.transform(
+            time, parameters, sensor_vars, sensor_measurements, cycle_measurements);
+      }
+
+      THEN("the cycle measurements follow the parameters of the breaths") {
+        REQUIRE(cycle_measurements.time > 6000);
+        REQUIRE(cycle_measurements.rr == Approx(20));
+        REQUIRE(cycle_measurements.pip == Approx(20));
+        REQUIRE(cycle_measurements.peep == Approx(5));
+      }
+    }
+
+    WHEN("ventilation is stopped") {
+      parameters.ventilating = false;
+      for (uint32_t time = 1; time <= 10000; ++time) {
+        simulator.transform(
+            time, parameters, sensor_vars, sensor_measurements, cycle_measurements);
+      }
+
+      THEN("the cycle measurements are left alone") {
+        REQUIRE(cycle_measurements.rr == 0);
+      }
+    }
+  }
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * ValveCharacterization.cpp
+ *
+ * Unit tests to confirm behavior of the valve tables, their calibration
+ * and their persistent format
+ *
+ */
+
+#include "Pufferfish/Driver/BreathingCircuit/ValveCharacterization.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "Pufferfish/Driver/BreathingCircuit/Controller.h"
+#include "Pufferfish/Driver/BreathingCircuit/Plant.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace BreathingCircuit = PF::Driver::BreathingCircuit;
+using BreathingCircuit::ValveTable;
+
+namespace {
+
+// The flow through a plant valve at each table opening, in steady state
+ValveTable::Flows plant_flows(const BreathingCircuit::PlantParameters &parameters) {
+  ValveTable::Flows flows{};
+  for (size_t i = 0; i < ValveTable::point_count; ++i) {
+    float opening = static_cast<float>(i) / (ValveTable::point_count - 1);
+    float above = opening - parameters.valve_cracking_opening;
+    flows[i] = above <= 0 ? 0
+                          : parameters.valve_max_flow * above /
+                                (1 - parameters.valve_cracking_opening);
+  }
+  return flows;
+}
+
+}  // namespace
+
+SCENARIO("Valve tables interpolate flows and openings", "[ValveCharacterization]") {
+  GIVEN("A table of a valve which cracks at 0.25 and passes 96 L/min fully open") {
+    ValveTable table;
+    ValveTable::Flows flows{};
+    for (size_t i = 4; i < ValveTable::point_count; ++i) {
+      flows[i] = 8 * static_cast<float>(i - 4);
+    }
+    REQUIRE(table.set(flows));
+
+    THEN("flows are interpolated between the points and clamped outside them") {
+      REQUIRE(table.flow(0.5) == Approx(32));
+      REQUIRE(table.flow(0.53125) == Approx(36));
+      REQUIRE(table.flow(-1) == 0);
+      REQUIRE(table.flow(2) == Approx(96));
+    }
+
+    THEN("openings are the inverse of flows above the cracking point") {
+      for (float flow : {0.5F, 8.0F, 36.0F, 61.7F, 95.9F}) {
+        REQUIRE(table.flow(table.opening(flow)) == Approx(flow));
+      }
+      REQUIRE(table.opening(36) == Approx(0.53125));
+    }
+
+    THEN("no flow maps to a closed valve, and too much flow to a fully open one") {
+      REQUIRE(table.opening(0) == 0);
+      REQUIRE(table.opening(-5) == 0);
+      REQUIRE(table.opening(200) == 1);
+    }
+  }
+
+  GIVEN("Noisy flows which dip and are not finite at some points") {
+    ValveTable table;
+    ValveTable::Flows flows{};
+    for (size_t i = 0; i < ValveTable::point_count; ++i) {
+      flows[i] = 5 * static_cast<float>(i);
+    }
+    flows[6] = 20;
+    flows[9] = std::numeric_limits<float>::quiet_NaN();
+    table.set(flows);
+
+    THEN("each dip is raised to the point before it, so flows never decrease") {
+      REQUIRE(table.flows()[6] == 25);
+      REQUIRE(table.flows()[9] == 40);
+      for (size_t i = 1; i < ValveTable::point_count; ++i) {
+        REQUIRE(table.flows()[i] >= table.flows()[i - 1]);
+      }
+    }
+
+    THEN("the smallest opening passing a flow on a flat region is its start") {
+      REQUIRE(table.opening(25) == Approx(5.0 / 16));
+      REQUIRE(table.opening(40) == Approx(8.0 / 16));
+    }
+  }
+
+  GIVEN("Flows of a valve which never opened") {
+    ValveTable table;
+    ValveTable::Flows flows{};
+    flows.fill(0.3);
+
+    THEN("the table is rejected and commands no opening") {
+      REQUIRE_FALSE(table.set(flows));
+      REQUIRE_FALSE(table.characterized());
+      REQUIRE(table.opening(30) == 0);
+    }
+  }
+}
+
+SCENARIO("Valve calibration measures the plant's valves", "[ValveCharacterization]") {
+  GIVEN("A calibration run against the plant model") {
+    BreathingCircuit::PlantParameters parameters{};
+    parameters.valve_max_flow = 100;
+    BreathingCircuit::HFNCPlant plant(parameters);
+    BreathingCircuit::ValveCalibration calibration;
+    BreathingCircuit::SensorVars sensor_vars{};
+    BreathingCircuit::ActuatorVars actuator_vars{};
+
+    WHEN("it runs to completion") {
+      calibration.start();
+      size_t steps = 0;
+      bool finished = false;
+      while (!finished && steps < 10000) {
+        sensor_vars.flow_air = plant.vars().flow_air;
+        sensor_vars.flow_o2 = plant.vars().flow_o2;
+        finished = calibration.transform(sensor_vars, actuator_vars);
+        plant.update(actuator_vars.valve_air_opening, actuator_vars.valve_o2_opening);
+        ++steps;
+      }
+
+      THEN("it took the documented number of steps and closed both valves") {
+        REQUIRE(finished);
+        REQUIRE_FALSE(calibration.running());
+        REQUIRE(
+            steps == ValveTable::point_count * (BreathingCircuit::ValveCalibration::settle_steps +
+                                                BreathingCircuit::ValveCalibration::average_steps));
+        REQUIRE(actuator_vars.valve_air_opening == 0);
+        REQUIRE(actuator_vars.valve_o2_opening == 0);
+      }
+
+      THEN("both tables match the steady-state flows of the valves") {
+        ValveTable::Flows expected = plant_flows(parameters);
+        for (size_t i = 0; i < ValveTable::point_count; ++i) {
+          REQUIRE(calibration.characterization().air[i] == Approx(expected[i]).margin(0.01));
+          REQUIRE(calibration.characterization().o2[i] == Approx(expected[i]).margin(0.01));
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Valve characterizations are persisted compactly", "[ValveCharacterization]") {
+  using Format = BreathingCircuit::ValveCharacterizationFormat;
+
+  GIVEN("A characterization of both valves") {
+    BreathingCircuit::ValveCharacterization characterization{};
+    for (size_t i = 0; i < ValveTable::point_count; ++i) {
+      characterization.air[i] = 7.5F * static_cast<float>(i);
+      characterization.o2[i] = 6.25F * static_cast<float>(i) + 0.01F;
+    }
+    std::array<uint8_t, Format::size> buffer{};
+    Format::write(characterization, buffer.data());
+
+    WHEN("it is read back") {
+      BreathingCircuit::ValveCharacterization read{};
+      bool ok = Format::read(buffer.data(), buffer.size(), read);
+
+      THEN("every flow is restored to within the format's resolution") {
+        REQUIRE(ok);
+        for (size_t i = 0; i < ValveTable::point_count; ++i) {
+          REQUIRE(read.air[i] == Approx(characterization.air[i]).margin(Format::flow_resolution));
+          REQUIRE(read.o2[i] == Approx(characterization.o2[i]).margin(Format::flow_resolution));
+        }
+      }
+    }
+
+    WHEN("its length or version doesn't match") {
+      BreathingCircuit::ValveCharacterization read{};
+      bool short_ok = Format::read(buffer.data(), buffer.size() - 1, read);
+      buffer[0] = Format::version + 1;
+      bool version_ok = Format::read(buffer.data(), buffer.size(), read);
+
+      THEN("it is rejected without being read") {
+        REQUIRE_FALSE(short_ok);
+        REQUIRE_FALSE(version_ok);
+        REQUIRE(read.air[ValveTable::point_count - 1] == 0);
+      }
+    }
+  }
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * BankDebouncer.cpp
+ *
+ * Unit tests to confirm behavior of the vertical-counter button bank debouncer
+ *
+ */
+
+#include "Pufferfish/Driver/Button/BankDebouncer.h"
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+using Debouncer = PF::Driver::Button::BankDebouncer<8>;
+
+void input_repeated(Debouncer &debouncer, uint32_t samples, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    debouncer.input(samples);
+  }
+}
+
+}  // namespace
+
+SCENARIO("The bank debouncer debounces all buttons together", "[BankDebouncer]") {
+  GIVEN("A bank debouncer with all buttons released") {
+    Debouncer debouncer;
+    const size_t debounce_samples = Debouncer::debounce_samples;
+    PF::Driver::Button::ButtonEvent event{};
+
+    REQUIRE(debouncer.state() == 0);
+    REQUIRE(debouncer.output(event) == PF::BufferStatus::empty);
+
+    WHEN("two buttons are pressed for one sample fewer than the debounce count") {
+      input_repeated(debouncer, 0b101, debounce_samples - 1);
+
+      THEN("neither button is pressed and no edge is queued") {
+        REQUIRE(debouncer.state() == 0);
+        REQUIRE(debouncer.output(event) == PF::BufferStatus::empty);
+      }
+    }
+
+    WHEN("two buttons are pressed for the debounce count") {
+      input_repeated(debouncer, 0b101, debounce_samples);
+
+      THEN("both buttons are pressed, with a rising edge queued for each in bit order") {
+        REQUIRE(debouncer.state() == 0b101);
+        REQUIRE(debouncer.pressed(0));
+        REQUIRE(!debouncer.pressed(1));
+        REQUIRE(debouncer.pressed(2));
+        REQUIRE(debouncer.output(event) == PF::BufferStatus::ok);
+        REQUIRE(event.button == 0);
+        REQUIRE(event.edge == PF::Driver::Button::EdgeState::rising_edge);
+        REQUIRE(debouncer.output(event) == PF::BufferStatus::ok);
+        REQUIRE(event.button == 2);
+        REQUIRE(event.edge == PF::Driver::Button::EdgeState::rising_edge);
+        REQUIRE(debouncer.output(event) == PF::BufferStatus::empty);
+      }
+    }
+
+    WHEN("a button bounces before it settles") {
+      input_repeated(debouncer, 0b10, debounce_samples - 1);
+      debouncer.input(0);
+      input_repeated(debouncer, 0b10, debounce_samples - 1);
+
+      THEN("the bounce restarts its count") {
+        REQUIRE(debouncer.state() == 0);
+        debouncer.input(0b10);
+        REQUIRE(debouncer.state() == 0b10);
+      }
+    }
+
+    WHEN("buttons settle at different times") {
+      debouncer.input(0b01);
+      debouncer.input(0b01);
+      input_repeated(debouncer, 0b11, debounce_samples - 2);
+
+      THEN("each button changes state after its own debounce count") {
+        REQUIRE(debouncer.state() == 0b01);
+        input_repeated(debouncer, 0b11, 2);
+        REQUIRE(debouncer.state() == 0b11);
+      }
+    }
+
+    WHEN("a pressed button is released") {
+      input_repeated(debouncer, 1UL << 31, debounce_samples);
+      REQUIRE(debouncer.output(event) == PF::BufferStatus::ok);
+      input_repeated(debouncer, 0, debounce_samples);
+
+      THEN("a falling edge is queued for it") {
+        REQUIRE(debouncer.state() == 0);
+        REQUIRE(debouncer.output(event) == PF::BufferStatus::ok);
+        REQUIRE(event.button == 31);
+        REQUIRE(event.edge == PF::Driver::Button::EdgeState::falling_edge);
+      }
+    }
+
+    WHEN("more edges occur than the queue holds before they are output") {
+      for (size_t i = 0; i < 5; ++i) {
+        input_repeated(debouncer, 0b11, debounce_samples);
+        input_repeated(debouncer, 0, debounce_samples);
+      }
+
+      THEN("the oldest edges are kept and the rest are counted as dropped") {
+        // A RingBuffer<8> holds 7 bytes
+        size_t count = 0;
+        while (debouncer.output(event) == PF::BufferStatus::ok) {
+          ++count;
+        }
+        REQUIRE(count == 7);
+        REQUIRE(debouncer.dropped() == 20 - 7);
+        REQUIRE(debouncer.state() == 0);
+      }
+    }
+  }
+}
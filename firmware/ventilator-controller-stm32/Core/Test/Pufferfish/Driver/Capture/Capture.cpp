@@ -0,0 +1,293 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Capture.cpp
+ *
+ * Unit tests to confirm behavior of UART and I2C traffic capture and replay
+ *
+ */
+
+#include "Pufferfish/Driver/Capture/Capture.h"
+
+#include <vector>
+
+#include "Pufferfish/Driver/Capture/Replay.h"
+#include "Pufferfish/HAL/Mock/MockBufferedUART.h"
+#include "Pufferfish/HAL/Mock/MockI2CDevice.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "Pufferfish/HAL/Mock/MockTraceOutput.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace Capture = PF::Driver::Capture;
+
+namespace {
+
+// Parses all records out of a capture stream
+std::vector<Capture::Record> parse(const std::vector<uint8_t> &stream) {
+  std::vector<Capture::Record> records;
+  Capture::RecordReceiver receiver;
+  for (uint8_t byte : stream) {
+    if (receiver.input(byte) != PF::Driver::Serial::Backend::FrameProps::InputStatus::output_ready) {
+      continue;
+    }
+    Capture::Record record{};
+    if (receiver.output(record) == Capture::RecordReceiver::Status::ok) {
+      records.push_back(record);
+    }
+  }
+  return records;
+}
+
+void set_time(PF::HAL::MockTime &time, uint32_t time_us) {
+  time.set_micros(time_us);
+  time.set_millis(time_us / 1000);
+}
+
+}  // namespace
+
+SCENARIO("Capture records are framed for a byte stream", "[Capture]") {
+  GIVEN("An I2C read record whose data contains zero bytes") {
+    Capture::Record record{};
+    record.time = 0x01000200;
+    record.channel = static_cast<uint8_t>(Capture::Channel::sfm3019_o2);
+    record.kind = Capture::RecordKind::i2c_read;
+    record.status = static_cast<uint8_t>(PF::I2CDeviceStatus::crc_check_failed);
+    record.size = 3;
+    record.data = {0x00, 0xab, 0x00};
+
+    WHEN("it is sent and received") {
+      Capture::RecordSender sender;
+      PF::Driver::Serial::Backend::FrameProps::ChunkBuffer frame;
+      REQUIRE(sender.transform(record, frame) == PF::IndexStatus::ok);
+      std::vector<uint8_t> stream(frame.buffer(), frame.buffer() + frame.size());
+      auto records = parse(stream);
+
+      THEN("the frame has no zero bytes before its delimiter, and the record is unchanged") {
+        for (size_t i = 0; i + 1 < frame.size(); ++i) {
+          REQUIRE(frame[i] != 0);
+        }
+        REQUIRE(frame[frame.size() - 1] == 0);
+        REQUIRE(records.size() == 1);
+        REQUIRE(records[0].time == record.time);
+        REQUIRE(records[0].channel == record.channel);
+        REQUIRE(records[0].kind == record.kind);
+        REQUIRE(records[0].status == record.status);
+        REQUIRE(records[0].size == 3);
+        REQUIRE(records[0].data == record.data);
+      }
+    }
+  }
+}
+
+SCENARIO("Captured UART traffic is batched into records", "[Capture]") {
+  GIVEN("A captured UART with a mock time") {
+    PF::HAL::MockTime time;
+    PF::HAL::MockReadOnlyBufferedUART uart;
+    Capture::RecordBuffer<8> records;
+    Capture::UARTCapture capture(Capture::Channel::nonin_oem, records, time);
+    Capture::CapturedUART captured(uart, capture);
+    Capture::Record record{};
+
+    WHEN("three bytes arrive within the batch window and are read out") {
+      for (uint8_t byte : {0x01, 0x80, 0xff}) {
+        uart.set_read(byte);
+      }
+      uint8_t byte = 0;
+      set_time(time, 100);
+      REQUIRE(captured.read(byte) == PF::BufferStatus::ok);
+      set_time(time, 600);
+      REQUIRE(captured.read(byte) == PF::BufferStatus::ok);
+      REQUIRE(captured.read(byte) == PF::BufferStatus::ok);
+      REQUIRE(captured.read(byte) == PF::BufferStatus::empty);
+
+      THEN("no record is output until the batch window has elapsed") {
+        capture.update();
+        REQUIRE(records.output(record) == PF::BufferStatus::empty);
+        set_time(time, 100 + Capture::UARTCapture::batch_window);
+        capture.update();
+        REQUIRE(records.output(record) == PF::BufferStatus::ok);
+        REQUIRE(record.time == 100);
+        REQUIRE(record.channel == static_cast<uint8_t>(Capture::Channel::nonin_oem));
+        REQUIRE(record.kind == Capture::RecordKind::uart_rx);
+        REQUIRE(record.size == 3);
+        REQUIRE(record.data[0] == 0x01);
+        REQUIRE(record.data[2] == 0xff);
+      }
+    }
+
+    WHEN("more bytes are read at once than fit in one record") {
+      for (size_t i = 0; i < Capture::Record::max_data_size + 1; ++i) {
+        uart.set_read(static_cast<uint8_t>(i));
+      }
+      uint8_t byte = 0;
+      while (captured.read(byte) == PF::BufferStatus::ok) {
+      }
+
+      THEN("a full record is output right away and the rest waits for the batch window") {
+        REQUIRE(records.output(record) == PF::BufferStatus::ok);
+        REQUIRE(record.size == Capture::Record::max_data_size);
+        REQUIRE(records.output(record) == PF::BufferStatus::empty);
+      }
+    }
+
+    WHEN("more records are closed than the buffer holds") {
+      for (size_t i = 0; i < 10; ++i) {
+        set_time(time, i * Capture::UARTCapture::batch_window);
+        uart.set_read(0);
+        uint8_t byte = 0;
+        REQUIRE(captured.read(byte) == PF::BufferStatus::ok);
+      }
+
+      THEN("the records which do not fit are dropped and counted") {
+        // One slot of the ring is always empty, and the newest record is still open
+        REQUIRE(records.dropped() == 2);
+      }
+    }
+  }
+}
+
+SCENARIO("Captured I2C transactions are recorded with their status", "[Capture]") {
+  GIVEN("A captured I2C device with one good and one failed response queued") {
+    PF::HAL::MockTime time;
+    PF::HAL::MockI2CDevice dev;
+    Capture::RecordBuffer<8> records;
+    Capture::CapturedI2CDevice captured(dev, Capture::Channel::sfm3019_air, records, time);
+    std::array<uint8_t, 3> response{{0x12, 0x34, 0x37}};
+    dev.add_read(response.data(), response.size());
+    dev.add_read(response.data(), response.size(), PF::I2CDeviceStatus::read_error);
+
+    WHEN("a command is written and both responses are read") {
+      std::array<uint8_t, 2> command{{0x36, 0x08}};
+      set_time(time, 10);
+      REQUIRE(captured.write(command.data(), command.size()) == PF::I2CDeviceStatus::ok);
+      std::array<uint8_t, 3> buffer{};
+      set_time(time, 20);
+      REQUIRE(captured.read(buffer.data(), buffer.size()) == PF::I2CDeviceStatus::ok);
+      set_time(time, 30);
+      REQUIRE(captured.read(buffer.data(), buffer.size()) == PF::I2CDeviceStatus::read_error);
+
+      THEN("each transaction is recorded, with data only for successful reads") {
+        Capture::Record record{};
+        REQUIRE(records.output(record) == PF::BufferStatus::ok);
+        REQUIRE(record.kind == Capture::RecordKind::i2c_write);
+        REQUIRE(record.time == 10);
+        REQUIRE(record.size == 2);
+        REQUIRE(record.data[0] == 0x36);
+        REQUIRE(records.output(record) == PF::BufferStatus::ok);
+        REQUIRE(record.kind == Capture::RecordKind::i2c_read);
+        REQUIRE(record.status == static_cast<uint8_t>(PF::I2CDeviceStatus::ok));
+        REQUIRE(record.size == 3);
+        REQUIRE(record.data[1] == 0x34);
+        REQUIRE(records.output(record) == PF::BufferStatus::ok);
+        REQUIRE(record.status == static_cast<uint8_t>(PF::I2CDeviceStatus::read_error));
+        REQUIRE(record.size == 0);
+      }
+    }
+  }
+}
+
+SCENARIO("Captured traffic is streamed to a trace output and replayed", "[Capture]") {
+  GIVEN("Captured UART and I2C traffic streamed by a trace writer") {
+    PF::HAL::MockTime time;
+    PF::HAL::MockReadOnlyBufferedUART uart;
+    PF::HAL::MockI2CDevice dev;
+    Capture::RecordBuffer<8> uart_records;
+    Capture::RecordBuffer<8> i2c_records;
+    Capture::UARTCapture uart_capture(Capture::Channel::nonin_oem, uart_records, time);
+    Capture::CapturedUART captured_uart(uart, uart_capture);
+    Capture::CapturedI2CDevice captured_dev(dev, Capture::Channel::sfm3019_air, i2c_records, time);
+    PF::HAL::MockTraceOutput output;
+    Capture::TraceWriter<2> writer({&uart_records, &i2c_records}, output);
+
+    std::array<uint8_t, 2> response{{0x60, 0x00}};
+    dev.add_read(response.data(), response.size());
+    uart.set_read(0x55);
+    uart.set_read(0x00);
+
+    set_time(time, 4000);
+    std::array<uint8_t, 2> buffer{};
+    REQUIRE(captured_dev.read(buffer.data(), buffer.size()) == PF::I2CDeviceStatus::ok);
+    set_time(time, 5000);
+    uint8_t byte = 0;
+    while (captured_uart.read(byte) == PF::BufferStatus::ok) {
+    }
+    set_time(time, 5000 + Capture::UARTCapture::batch_window);
+    uart_capture.update();
+
+    WHEN("the output is disabled") {
+      output.set_enabled(false);
+      writer.update();
+
+      THEN("queued records are discarded") {
+        Capture::Record record{};
+        REQUIRE(uart_records.output(record) == PF::BufferStatus::empty);
+        REQUIRE(i2c_records.output(record) == PF::BufferStatus::empty);
+        REQUIRE(output.written().empty());
+      }
+    }
+
+    WHEN("the output only takes a few bytes at a time") {
+      output.set_write_limit(5);
+      for (size_t i = 0; i < 20; ++i) {
+        writer.update();
+      }
+      auto records = parse(output.written());
+
+      THEN("all records still arrive whole") {
+        REQUIRE(records.size() == 2);
+      }
+    }
+
+    WHEN("the stream is replayed into fresh mocks") {
+      writer.update();
+      auto records = parse(output.written());
+      REQUIRE(records.size() == 2);
+
+      PF::HAL::MockTime replay_time;
+      PF::HAL::MockReadOnlyBufferedUART replay_uart;
+      PF::HAL::MockI2CDevice replay_dev;
+      Capture::UARTReplayTarget<PF::HAL::mock_read_only_uart_buffer_size, 1> uart_target(
+          replay_uart);
+      Capture::I2CReplayTarget dev_target(replay_dev);
+      Capture::Replayer replayer(replay_time);
+      replayer.attach(Capture::Channel::nonin_oem, uart_target);
+      replayer.attach(Capture::Channel::sfm3019_air, dev_target);
+
+      THEN("the mocks return the same traffic at the same times") {
+        // The trace writer takes from its sources in turn
+        replayer.input(records[0]);
+        REQUIRE(replay_time.micros() == 5000);
+        REQUIRE(replay_time.millis() == 5);
+        REQUIRE(replay_uart.read(byte) == PF::BufferStatus::ok);
+        REQUIRE(byte == 0x55);
+        REQUIRE(replay_uart.read(byte) == PF::BufferStatus::ok);
+        REQUIRE(byte == 0x00);
+
+        // Time never goes backwards
+        replayer.input(records[1]);
+        REQUIRE(replay_time.micros() == 5000);
+        buffer = {};
+        REQUIRE(replay_dev.read(buffer.data(), buffer.size()) == PF::I2CDeviceStatus::ok);
+        REQUIRE(buffer == response);
+        REQUIRE(replayer.unattached() == 0);
+      }
+    }
+  }
+}
+
+SCENARIO("Capture times are unwrapped to 64 bits", "[Capture]") {
+  GIVEN("A previous time just before a 32-bit wraparound") {
+    const uint64_t previous = 0xfffff000;
+
+    WHEN("times just after the wraparound and slightly before the previous time are unwrapped") {
+      uint64_t after = Capture::unwrap_time(previous, 0x00000100);
+      uint64_t before = Capture::unwrap_time(previous + 0x2000, 0xffffe000);
+
+      THEN("they are placed on the correct side of the wraparound") {
+        REQUIRE(after == 0x100000100);
+        REQUIRE(before == 0xffffe000);
+      }
+    }
+  }
+}
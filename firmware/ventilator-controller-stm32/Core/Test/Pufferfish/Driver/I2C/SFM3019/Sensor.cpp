@@ -0,0 +1,273 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Sensor.cpp
+ *
+ * Unit tests to confirm behavior of non-blocking SFM3019 sensor setup
+ *
+ */
+
+#include "Pufferfish/Driver/I2C/SFM3019/Sensor.h"
+
+#include <array>
+
+#include "Pufferfish/Driver/Initializer.h"
+#include "Pufferfish/HAL/CRCChecker.h"
+#include "Pufferfish/HAL/Mock/MockI2CDevice.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "Pufferfish/Util/Array.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace SFM3019 = PF::Driver::I2C::SFM3019;
+
+namespace {
+
+// Queues a read response of 16-bit words, each followed by its Sensirion CRC
+template <size_t size>
+void add_words(PF::HAL::MockI2CDevice &dev, const std::array<uint16_t, size> &words) {
+  static constexpr PF::HAL::CRC8Parameters crc_params = {0x31, 0xff, false, false, 0x00};
+  PF::HAL::SoftCRC8 crc8(crc_params);
+  std::array<uint8_t, 3 * size> buffer{};
+  for (size_t i = 0; i < size; ++i) {
+    buffer[3 * i] = static_cast<uint8_t>(words[i] >> 8U);
+    buffer[3 * i + 1] = static_cast<uint8_t>(words[i] & 0xffU);
+    buffer[3 * i + 2] = crc8.compute(buffer.data() + 3 * i, 2);
+  }
+  dev.add_read(buffer.data(), buffer.size());
+}
+
+// Queues the responses of a healthy sensor to all setup steps
+void add_setup_responses(PF::HAL::MockI2CDevice &dev, bool full_samples = false) {
+  add_words(dev, std::array<uint16_t, 2>{0x0402, 0x0611});  // product number
+  add_words(dev, std::array<uint16_t, 3>{170, static_cast<uint16_t>(-24576), 0x0148});
+  if (full_samples) {
+    add_words(dev, std::array<uint16_t, 3>{static_cast<uint16_t>(-24576 + 170 * 10), 5000, 0});
+  } else {
+    add_words(dev, std::array<uint16_t, 1>{static_cast<uint16_t>(-24576 + 170 * 10)});
+  }
+}
+
+// Steps setup of all sensors until it finishes, returning the time afterwards
+template <typename Initializer>
+uint32_t run_setup(Initializer &initializer, PF::HAL::MockTime &time) {
+  uint32_t current_time_us = 0;
+  PF::InitializableState state = PF::InitializableState::setup;
+  while (state == PF::InitializableState::setup && current_time_us < 1000000) {
+    time.set_micros(current_time_us);
+    time.set_millis(current_time_us / 1000);
+    state = initializer.update(current_time_us / 1000);
+    current_time_us += 100;
+  }
+  return current_time_us;
+}
+
+}  // namespace
+
+SCENARIO("SFM3019 sensors are set up without blocking", "[SFM3019]") {
+  GIVEN("Two healthy sensors on separate buses") {
+    PF::HAL::MockTime time;
+    PF::HAL::MockI2CDevice dev_air;
+    PF::HAL::MockI2CDevice global_air;
+    PF::HAL::MockI2CDevice dev_o2;
+    PF::HAL::MockI2CDevice global_o2;
+    SFM3019::Device device_air(dev_air, global_air, SFM3019::GasType::air);
+    SFM3019::Device device_o2(dev_o2, global_o2, SFM3019::GasType::o2);
+    SFM3019::Sensor sensor_air(device_air, true, time);
+    SFM3019::Sensor sensor_o2(device_o2, true, time);
+    add_setup_responses(dev_air);
+    add_setup_responses(dev_o2);
+
+    auto initializables = PF::Util::make_array<std::reference_wrapper<PF::Driver::Initializable>>(
+        sensor_air, sensor_o2);
+    PF::Driver::Initializer<initializables.size()> initializer(initializables);
+
+    WHEN("setup is run concurrently with time advancing in 100 us steps") {
+      uint32_t current_time_us = 0;
+      PF::InitializableState state = PF::InitializableState::setup;
+      while (state == PF::InitializableState::setup && current_time_us < 1000000) {
+        time.set_micros(current_time_us);
+        time.set_millis(current_time_us / 1000);
+        state = initializer.update(current_time_us / 1000);
+        current_time_us += 100;
+      }
+
+      THEN("both sensors finish in about the time one sensor needs") {
+        REQUIRE(state == PF::InitializableState::ok);
+        // 2 ms power-up and 30 ms warm-up, which would be 64 ms in sequence
+        REQUIRE(initializer.duration() >= 32);
+        REQUIRE(initializer.duration() < 40);
+        REQUIRE(initializer.duration(0) == initializer.duration(1));
+      }
+
+      AND_THEN("the sensors measure flow") {
+        float flow = 0;
+        add_words(dev_air, std::array<uint16_t, 1>{static_cast<uint16_t>(-24576 + 170 * 20)});
+        time.set_micros(current_time_us + 1000);
+        REQUIRE(sensor_air.output(flow) == PF::InitializableState::ok);
+        time.set_micros(current_time_us + 2000);
+        REQUIRE(sensor_air.output(flow) == PF::InitializableState::ok);
+        REQUIRE(flow == Approx(20));
+      }
+    }
+  }
+
+  GIVEN("A sensor which does not respond at first") {
+    PF::HAL::MockTime time;
+    PF::HAL::MockI2CDevice dev;
+    PF::HAL::MockI2CDevice global;
+    SFM3019::Device device(dev, global, SFM3019::GasType::air);
+    SFM3019::Sensor sensor(device, false, time);
+
+    WHEN("setup is stepped while the product number cannot be read") {
+      uint32_t current_time_us = 0;
+      size_t calls = 0;
+      PF::InitializableState state = PF::InitializableState::setup;
+      for (; current_time_us < 5000; current_time_us += 100) {
+        time.set_micros(current_time_us);
+        state = sensor.setup();
+        ++calls;
+      }
+
+      THEN("each call returns right away and retries are spaced out") {
+        REQUIRE(state == PF::InitializableState::setup);
+        REQUIRE(calls == 50);
+      }
+
+      AND_THEN("setup completes once the sensor responds") {
+        add_setup_responses(dev);
+        for (; current_time_us < 200000 && state == PF::InitializableState::setup;
+             current_time_us += 100) {
+          time.set_micros(current_time_us);
+          state = sensor.setup();
+        }
+        REQUIRE(state == PF::InitializableState::ok);
+      }
+    }
+
+    WHEN("the sensor never responds") {
+      PF::InitializableState state = PF::InitializableState::setup;
+      for (uint32_t current_time_us = 0; current_time_us < 1000000; current_time_us += 100) {
+        time.set_micros(current_time_us);
+        state = sensor.setup();
+        if (state != PF::InitializableState::setup) {
+          break;
+        }
+      }
+
+      THEN("setup fails after its retries are used up") {
+        REQUIRE(state == PF::InitializableState::failed);
+      }
+    }
+  }
+}
+
+SCENARIO("SFM3019 sensors on one bus measure synchronously", "[SFM3019]") {
+  GIVEN("Two sensors on a shared bus, started with a general call and reading full samples") {
+    PF::HAL::MockTime time;
+    PF::HAL::MockI2CDevice dev_first;
+    PF::HAL::MockI2CDevice dev_second;
+    PF::HAL::MockI2CDevice global;
+    SFM3019::Device device_first(dev_first, global, SFM3019::GasType::air);
+    SFM3019::Device device_second(dev_second, global, SFM3019::GasType::air);
+    SFM3019::Sensor sensor_first(device_first, true, time, true, true);
+    SFM3019::Sensor sensor_second(device_second, false, time, true, true);
+    add_setup_responses(dev_first, true);
+    add_setup_responses(dev_second, true);
+
+    auto initializables = PF::Util::make_array<std::reference_wrapper<PF::Driver::Initializable>>(
+        sensor_first, sensor_second);
+    PF::Driver::Initializer<initializables.size()> initializer(initializables);
+
+    WHEN("setup is run concurrently") {
+      uint32_t current_time_us = run_setup(initializer, time);
+
+      THEN("measurement is started on the whole bus by general calls after the reset") {
+        REQUIRE(initializer.update(current_time_us / 1000) == PF::InitializableState::ok);
+        std::array<uint8_t, 2> written{};
+        size_t count = 0;
+        global.get_write(written.data(), count);
+        REQUIRE(written[0] == 0x06);
+        for (size_t i = 0; i < 2; ++i) {
+          global.get_write(written.data(), count);
+          REQUIRE(count == 2);
+          REQUIRE(written[0] == 0x36);
+          REQUIRE(written[1] == 0x08);
+        }
+      }
+
+      AND_THEN("each sample has flow, temperature and status words with its read time") {
+        add_words(
+            dev_first, std::array<uint16_t, 3>{static_cast<uint16_t>(-24576 + 170 * 20), 5100, 0});
+        add_words(
+            dev_second, std::array<uint16_t, 3>{static_cast<uint16_t>(-24576 + 170 * 5), 5200, 0});
+        time.set_micros(current_time_us + 1000);
+        SFM3019::Sample first{};
+        SFM3019::Sample second{};
+        REQUIRE(sensor_first.output(first) == PF::InitializableState::ok);
+        REQUIRE(sensor_second.output(second) == PF::InitializableState::ok);
+        REQUIRE(sensor_first.output(first) == PF::InitializableState::ok);
+        REQUIRE(sensor_second.output(second) == PF::InitializableState::ok);
+        REQUIRE(first.flow == Approx(20));
+        REQUIRE(first.temperature == Approx(25.5));
+        REQUIRE(second.flow == Approx(5));
+        REQUIRE(second.temperature == Approx(26));
+        REQUIRE(first.time_us == current_time_us + 1000);
+        REQUIRE(second.time_us == first.time_us);
+      }
+    }
+
+    WHEN("a word of a full sample is corrupted") {
+      uint32_t current_time_us = run_setup(initializer, time);
+      std::array<uint8_t, 9> buffer{};
+      buffer[8] = 0xff;  // bad CRC on the status word
+      dev_first.add_read(buffer.data(), buffer.size());
+      time.set_micros(current_time_us + 1000);
+      SFM3019::Sample sample{};
+      REQUIRE(sensor_first.output(sample) == PF::InitializableState::ok);
+      REQUIRE(sensor_first.output(sample) == PF::InitializableState::ok);
+
+      THEN("the sample is rejected and the previous sample is kept") {
+        REQUIRE(sample.flow == Approx(10));
+        REQUIRE(sample.temperature == Approx(25));
+      }
+    }
+  }
+}
+
+SCENARIO("SFM3019 sensors produce a new sample at every control step", "[SFM3019]") {
+  GIVEN("A sensor which has been set up") {
+    PF::HAL::MockTime time;
+    PF::HAL::MockI2CDevice dev;
+    PF::HAL::MockI2CDevice global;
+    SFM3019::Device device(dev, global, SFM3019::GasType::air);
+    SFM3019::Sensor sensor(device, true, time, true, true);
+    add_setup_responses(dev, true);
+
+    auto initializables =
+        PF::Util::make_array<std::reference_wrapper<PF::Driver::Initializable>>(sensor);
+    PF::Driver::Initializer<initializables.size()> initializer(initializables);
+    uint32_t current_time_us = run_setup(initializer, time);
+    REQUIRE(initializer.update(current_time_us / 1000) == PF::InitializableState::ok);
+
+    WHEN("the sensor is output once per 1 ms step") {
+      static constexpr size_t num_steps = 5;
+      for (size_t i = 0; i < num_steps; ++i) {
+        add_words(
+            dev, std::array<uint16_t, 3>{static_cast<uint16_t>(-24576 + 170 * (20 + i)), 5000, 0});
+      }
+      std::array<SFM3019::Sample, num_steps + 1> samples{};
+      for (size_t i = 0; i <= num_steps; ++i) {
+        time.set_micros(current_time_us + 1000 * (i + 1));
+        REQUIRE(sensor.output(samples[i]) == PF::InitializableState::ok);
+      }
+
+      THEN("each step returns the sample read since the previous step") {
+        for (size_t i = 1; i <= num_steps; ++i) {
+          REQUIRE(samples[i].flow == Approx(20 + i - 1));
+          REQUIRE(samples[i].time_us == current_time_us + 1000 * i);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * AuditoryAlarm.cpp
+ *
+ * Unit tests to confirm behavior of the hardware-timed auditory alarm
+ *
+ */
+
+#include "Pufferfish/Driver/Indicators/AuditoryAlarm.h"
+
+#include "Pufferfish/HAL/Mock/MockDigitalOutput.h"
+#include "Pufferfish/HAL/Mock/MockPulseOutput.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+SCENARIO("TimedAuditoryAlarm programs its outputs only when the alarm changes", "[AuditoryAlarm]") {
+  GIVEN("A TimedAuditoryAlarm") {
+    PF::HAL::MockDigitalOutput reg_high;
+    PF::HAL::MockDigitalOutput reg_med;
+    PF::HAL::MockDigitalOutput reg_low;
+    PF::HAL::MockPulseOutput buzzer;
+    PF::Driver::Indicators::TimedAuditoryAlarm alarm(reg_high, reg_med, reg_low, buzzer);
+
+    WHEN("a medium priority alarm is set") {
+      REQUIRE(alarm.set_alarm(PF::AlarmStatus::medium_priority) == PF::AlarmManagerStatus::ok);
+
+      THEN("the regulatory outputs are written and the buzzer is held off") {
+        REQUIRE(!reg_high.get_write());
+        REQUIRE(reg_med.get_write());
+        REQUIRE(reg_low.get_write());
+        REQUIRE(!buzzer.get_write());
+        REQUIRE(buzzer.get_period() == 0);
+      }
+    }
+
+    WHEN("a technical alarm is set") {
+      REQUIRE(alarm.set_alarm(PF::AlarmStatus::technical1) == PF::AlarmManagerStatus::ok);
+
+      THEN("the buzzer pulses on its own, without any updates") {
+        REQUIRE(buzzer.get_period() == 2000);
+        REQUIRE(buzzer.get_duty() == 200);
+        REQUIRE(!reg_high.get_write());
+        REQUIRE(!reg_med.get_write());
+        REQUIRE(!reg_low.get_write());
+      }
+
+      AND_WHEN("the alarm is cleared") {
+        REQUIRE(alarm.set_alarm(PF::AlarmStatus::no_alarm) == PF::AlarmManagerStatus::ok);
+
+        THEN("the buzzer stops pulsing") {
+          REQUIRE(buzzer.get_period() == 0);
+          REQUIRE(!buzzer.get_write());
+        }
+      }
+    }
+
+    WHEN("an invalid alarm is set after a technical alarm") {
+      REQUIRE(alarm.set_alarm(PF::AlarmStatus::technical2) == PF::AlarmManagerStatus::ok);
+      auto invalid = static_cast<PF::AlarmStatus>(255);
+
+      THEN("it is rejected and the outputs are left unchanged") {
+        REQUIRE(alarm.set_alarm(invalid) == PF::AlarmManagerStatus::invalid_alarm);
+        REQUIRE(buzzer.get_period() == 4000);
+        REQUIRE(buzzer.get_duty() == 200);
+      }
+    }
+  }
+}
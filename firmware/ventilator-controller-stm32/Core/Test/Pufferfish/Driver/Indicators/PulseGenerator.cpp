@@ -12,6 +12,7 @@
 
 #include "Pufferfish/Driver/Indicators/PulseGenerator.h"
 
+#include "Pufferfish/HAL/Mock/MockPulseOutput.h"
 #include "catch2/catch.hpp"
 
 namespace PF = Pufferfish;
@@ -44,3 +45,21 @@ SCENARIO("PWMGenerator generates a PWM signal", "[PulseGenerator]") {
     }
   }
 }
+
+SCENARIO("PWMGenerator programs its signal into a pulse output", "[PulseGenerator]") {
+  GIVEN("A PWMGenerator and a pulse output") {
+    uint32_t pulse_period = 10;
+    uint32_t pulse_width = 1;
+    PF::Driver::Indicators::PWMGenerator pwm(pulse_period, pulse_width);
+    PF::HAL::MockPulseOutput output;
+
+    WHEN("generation starts on the pulse output") {
+      REQUIRE(pwm.start(output) == PF::TimerStatus::ok);
+
+      THEN("the pulse output repeats the pulse") {
+        REQUIRE(output.get_period() == pulse_period);
+        REQUIRE(output.get_duty() == pulse_width);
+      }
+    }
+  }
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * AsyncFlash.cpp
+ *
+ * Unit tests to confirm behavior of the non-blocking SPI flash engine
+ *
+ */
+
+#include "Pufferfish/Driver/SPI/AsyncFlash.h"
+
+#include <array>
+
+#include "Pufferfish/HAL/Mock/MockSPIFlash.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+using Flash = PF::HAL::MockSPIFlash<16 * 4096>;
+using Status = PF::Driver::SPI::AsyncFlash::Status;
+
+// Runs update() until the queue drains, returning the number of calls made
+size_t drain(PF::Driver::SPI::AsyncFlash &flash) {
+  size_t calls = 0;
+  while (!flash.idle() && calls < 1000) {
+    REQUIRE(flash.update() == Status::ok);
+    ++calls;
+  }
+  // One more call restores block protection
+  REQUIRE(flash.update() == Status::ok);
+  return calls;
+}
+
+}  // namespace
+
+SCENARIO("AsyncFlash programs and erases without waiting", "[AsyncFlash]") {
+  GIVEN("A flash chip which stays busy for a few polls after each operation") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    device.set_busy_polls(3);
+
+    std::array<uint8_t, 600> data{};
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+    const uint32_t address = 0x1080;
+
+    WHEN("a write spanning several pages is queued") {
+      REQUIRE(flash.program(address, data.data(), data.size()) == Status::ok);
+      const size_t queue_depth = PF::Driver::SPI::AsyncFlash::queue_depth;
+      REQUIRE(flash.available() == queue_depth - 3);
+
+      THEN("nothing is written until update is called") {
+        REQUIRE(device.program_count() == 0);
+        REQUIRE(device.memory()[address] == UINT8_MAX);
+      }
+
+      AND_THEN("each update call issues at most one page program") {
+        REQUIRE(flash.update() == Status::ok);  // sets WPS
+        for (size_t i = 0; i < 6; ++i) {
+          const uint32_t before = device.program_count();
+          REQUIRE(flash.update() == Status::ok);
+          REQUIRE(device.program_count() - before <= 1);
+        }
+      }
+
+      AND_THEN("the data lands once the queue drains") {
+        drain(flash);
+        REQUIRE(device.program_count() == 3);
+        for (size_t i = 0; i < data.size(); ++i) {
+          REQUIRE(device.memory()[address + i] == data[i]);
+        }
+      }
+
+      AND_THEN("block protection is set up once for the whole write") {
+        drain(flash);
+        REQUIRE(device.instruction_count(PF::SPIInstruction::write_status_register3) == 1);
+        REQUIRE(device.instruction_count(PF::SPIInstruction::unlock_block) == 1);
+        REQUIRE(device.instruction_count(PF::SPIInstruction::lock_block) == 1);
+        REQUIRE(device.block_locked(address));
+      }
+
+      AND_THEN("reads are refused until the queued write completes") {
+        std::array<uint8_t, 600> readback{};
+        REQUIRE(flash.read(address, readback.data(), readback.size()) == Status::busy);
+        REQUIRE(flash.flush() == Status::ok);
+        REQUIRE(flash.read(address, readback.data(), readback.size()) == Status::ok);
+        REQUIRE(readback == data);
+      }
+    }
+
+    WHEN("a written sector is erased") {
+      REQUIRE(flash.program(address, data.data(), data.size()) == Status::ok);
+      drain(flash);
+      REQUIRE(flash.erase_sector(address + 10) == Status::ok);
+      drain(flash);
+
+      THEN("the sector is blank again") {
+        REQUIRE(device.erase_count(1) == 1);
+        for (size_t i = 0; i < data.size(); ++i) {
+          REQUIRE(device.memory()[address + i] == UINT8_MAX);
+        }
+      }
+
+      AND_THEN("WPS is only written once") {
+        REQUIRE(device.instruction_count(PF::SPIInstruction::write_status_register3) == 1);
+        REQUIRE(device.block_locked(address));
+      }
+    }
+
+    WHEN("more is queued than the queue can hold") {
+      REQUIRE(flash.program(address, data.data(), data.size()) == Status::ok);
+      REQUIRE(flash.program(address + 0x1000, data.data(), data.size()) == Status::ok);
+
+      THEN("the write is refused as a whole until the queue drains") {
+        REQUIRE(flash.program(address + 0x2000, data.data(), data.size()) == Status::busy);
+        REQUIRE(flash.erase_sector(address + 0x3000) == Status::ok);
+        REQUIRE(flash.erase_sector(address + 0x3000) == Status::ok);
+        REQUIRE(flash.erase_sector(address + 0x3000) == Status::busy);
+        drain(flash);
+        REQUIRE(flash.program(address + 0x2000, data.data(), data.size()) == Status::ok);
+      }
+    }
+
+    WHEN("an invalid write is queued") {
+      THEN("it is rejected") {
+        REQUIRE(
+            flash.program(PF::Driver::SPI::SPIFlash::capacity - 1, data.data(), 2) ==
+            Status::invalid);
+        REQUIRE(flash.erase_sector(PF::Driver::SPI::SPIFlash::capacity) == Status::invalid);
+      }
+    }
+  }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * FlashReader.cpp
+ *
+ * Unit tests to confirm behavior of the streaming SPI flash reader
+ *
+ */
+
+#include "Pufferfish/Driver/SPI/FlashReader.h"
+
+#include <array>
+
+#include "Pufferfish/HAL/Mock/MockSPIFlash.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+SCENARIO("FlashReader streams a range in chunks", "[FlashReader]") {
+  GIVEN("A flash chip with data on it") {
+    PF::HAL::MockSPIFlash<4 * 4096> device;
+    for (size_t i = 0; i < 4 * 4096; ++i) {
+      device.memory()[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash flash(device, time);
+    PF::Driver::SPI::FlashReader reader(flash);
+
+    const uint32_t address = 0x1010;
+    const size_t length = 1000;
+    REQUIRE(reader.open(address, length) == PF::SPIDeviceStatus::ok);
+
+    WHEN("the range is read in chunks until it ends") {
+      std::array<uint8_t, 64> chunk{};
+      size_t total = 0;
+      size_t count = 0;
+      size_t chunks = 0;
+      bool matches = true;
+      do {
+        REQUIRE(reader.next(chunk.data(), chunk.size(), count) == PF::SPIDeviceStatus::ok);
+        for (size_t i = 0; i < count; ++i) {
+          matches = matches && chunk[i] == device.memory()[address + total + i];
+        }
+        total += count;
+        ++chunks;
+      } while (count > 0);
+      reader.close();
+
+      THEN("every byte is read once, in order") {
+        REQUIRE(matches);
+        REQUIRE(total == length);
+        REQUIRE(chunks == (length + chunk.size() - 1) / chunk.size() + 1);
+        REQUIRE(reader.remaining() == 0);
+        REQUIRE(reader.address() == address + length);
+      }
+
+      AND_THEN("the instruction and address are only sent once") {
+        REQUIRE(device.instruction_count(PF::SPIInstruction::fast_read) == 1);
+      }
+
+      AND_THEN("the flash can be used again once the reader is closed") {
+        std::array<uint8_t, 4> data{};
+        REQUIRE(flash.read(0, data.data(), data.size()) == PF::SPIDeviceStatus::ok);
+        REQUIRE(data[1] == device.memory()[1]);
+      }
+    }
+
+    WHEN("the flash is used while the reader is open") {
+      std::array<uint8_t, 4> data{};
+
+      THEN("reads are refused until the reader is closed") {
+        REQUIRE(flash.read(0, data.data(), data.size()) == PF::SPIDeviceStatus::busy);
+        reader.close();
+        REQUIRE(flash.read(0, data.data(), data.size()) == PF::SPIDeviceStatus::ok);
+      }
+    }
+
+    WHEN("a range past the end of the chip is opened") {
+      reader.close();
+
+      THEN("it is refused") {
+        REQUIRE(
+            reader.open(PF::Driver::SPI::SPIFlash::capacity - 4, 8) == PF::SPIDeviceStatus::error);
+        REQUIRE(!reader.is_open());
+      }
+    }
+  }
+}
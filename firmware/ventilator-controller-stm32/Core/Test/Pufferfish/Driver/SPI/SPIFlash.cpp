@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * SPIFlash.cpp
+ *
+ * Unit tests to confirm behavior of the SPI flash driver
+ *
+ */
+
+#include "Pufferfish/Driver/SPI/SPIFlash.h"
+
+#include <array>
+
+#include "Pufferfish/HAL/Mock/MockSPIFlash.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+using Flash = PF::HAL::MockSPIFlash<16 * 4096>;
+
+void fill_pattern(Flash &device) {
+  for (size_t i = 0; i < 16 * 4096; ++i) {
+    device.memory()[i] = static_cast<uint8_t>(i * 13 + (i >> 8U));
+  }
+}
+
+}  // namespace
+
+SCENARIO("SPIFlash reads with Fast Read", "[SPIFlash]") {
+  GIVEN("A flash chip with data on it") {
+    Flash device;
+    fill_pattern(device);
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash flash(device, time);
+
+    WHEN("a whole sector is read from an unaligned address") {
+      static std::array<uint8_t, 4096> data{};
+      const uint32_t address = 0x2345;
+      REQUIRE(flash.read(address, data.data(), data.size()) == PF::SPIDeviceStatus::ok);
+
+      THEN("the data matches memory") {
+        for (size_t i = 0; i < data.size(); ++i) {
+          REQUIRE(data[i] == device.memory()[address + i]);
+        }
+      }
+
+      AND_THEN("it takes a single Fast Read instruction") {
+        REQUIRE(device.instruction_count(PF::SPIInstruction::fast_read) == 1);
+        REQUIRE(device.instruction_count(PF::SPIInstruction::read_byte) == 0);
+      }
+    }
+
+    WHEN("a read is started in the background") {
+      std::array<uint8_t, 300> data{};
+      REQUIRE(flash.start_read(0x100, data.data(), data.size()) == PF::SPIDeviceStatus::ok);
+
+      THEN("other instructions wait until it is complete") {
+        uint16_t id = 0;
+        REQUIRE(flash.start_read(0, data.data(), 1) == PF::SPIDeviceStatus::busy);
+        REQUIRE(flash.read_status() == PF::SPIDeviceStatus::ok);
+        REQUIRE(flash.get_jedec_id(id) == PF::SPIDeviceStatus::ok);
+        REQUIRE(id == 0x4015);
+        for (size_t i = 0; i < data.size(); ++i) {
+          REQUIRE(data[i] == device.memory()[0x100 + i]);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Commands.cpp
+ *
+ * Unit tests to confirm behavior of FDO2 command parsing and writing
+ *
+ */
+
+#include "Pufferfish/Driver/Serial/FDO2/Commands.h"
+
+#include <cstring>
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace FDO2 = PF::Driver::Serial::FDO2;
+
+namespace {
+
+// Makes a response buffer as split from the UART, ending with the frame delimiter
+FDO2::Responses::ChunkBuffer make_response(const char *text) {
+  FDO2::Responses::ChunkBuffer buffer;
+  for (size_t i = 0; i < std::strlen(text); ++i) {
+    buffer.push_back(text[i]);
+  }
+  buffer.push_back('\r');
+  return buffer;
+}
+
+}  // namespace
+
+SCENARIO("FDO2 responses are parsed", "[FDO2]") {
+  GIVEN("An MRAW broadcast") {
+    auto buffer = make_response("#MRAW 209650 2512 0 -3020 201453 -1 101325 4500");
+
+    WHEN("it is transformed") {
+      FDO2::Response response{};
+      auto status = FDO2::CommandReceiver::transform(buffer, response);
+
+      THEN("all fields are parsed") {
+        REQUIRE(status == FDO2::CommandReceiver::Status::ok);
+        REQUIRE(response.tag == FDO2::CommandTypes::mraw);
+        const auto &mraw = response.value.mraw;
+        REQUIRE(mraw.po2 == 209650);
+        REQUIRE(mraw.temperature == 2512);
+        REQUIRE(mraw.status == 0);
+        REQUIRE(mraw.phase_shift == -3020);
+        REQUIRE(mraw.signal_intensity == 201453);
+        REQUIRE(mraw.ambient_light == -1);
+        REQUIRE(mraw.ambient_pressure == 101325);
+        REQUIRE(mraw.relative_humidity == 4500);
+      }
+    }
+  }
+
+  GIVEN("Malformed responses") {
+    FDO2::Responses::Mraw mraw{};
+    FDO2::Responses::Bcst bcst{};
+
+    THEN("they are rejected") {
+      REQUIRE(
+          FDO2::Responses::parse(make_response("#MRAW 1 2 3 4 5 6 7"), mraw) ==
+          FDO2::Responses::ParseStatus::missing_arg);
+      REQUIRE(
+          FDO2::Responses::parse(make_response("#BCST 100 1"), bcst) ==
+          FDO2::Responses::ParseStatus::unexpected_arg);
+      REQUIRE(
+          FDO2::Responses::parse(make_response("#BCST,100"), bcst) ==
+          FDO2::Responses::ParseStatus::invalid_arg_delimiter);
+      REQUIRE(
+          FDO2::Responses::parse(make_response("#BCST 70000"), bcst) ==
+          FDO2::Responses::ParseStatus::invalid_arg);
+
+      FDO2::Response response{};
+      REQUIRE(
+          FDO2::CommandReceiver::transform(make_response("#ERRO x"), response) ==
+          FDO2::CommandReceiver::Status::invalid_args);
+    }
+  }
+}
+
+SCENARIO("FDO2 requests are written", "[FDO2]") {
+  GIVEN("A BCST request") {
+    FDO2::Request request{};
+    request.set(FDO2::Requests::Bcst{250});
+
+    WHEN("it is transformed") {
+      FDO2::Requests::ChunkBuffer buffer;
+      auto status = FDO2::CommandSender::transform(request, buffer);
+
+      THEN("the interval is written in decimal after the header") {
+        REQUIRE(status == FDO2::CommandSender::Status::ok);
+        REQUIRE(buffer.size() == 9);
+        REQUIRE(std::strncmp(buffer.buffer(), "#BCST 250", buffer.size()) == 0);
+      }
+    }
+  }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Sensor.cpp
+ *
+ * Unit tests to confirm behavior of the FDO2 sensor driver
+ *
+ */
+
+#include "Pufferfish/Driver/Serial/FDO2/Sensor.h"
+
+#include <cstring>
+
+#include "Pufferfish/HAL/Mock/MockBufferedUART.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+namespace FDO2 = PF::Driver::Serial::FDO2;
+
+namespace {
+
+// Queues a response from the sensor into the UART
+void add_response(volatile PF::HAL::MockLargeBufferedUART &uart, const char *text) {
+  for (size_t i = 0; i < std::strlen(text); ++i) {
+    uart.set_read(static_cast<uint8_t>(text[i]));
+  }
+  uart.set_read(static_cast<uint8_t>(FDO2::frame_end));
+}
+
+// Steps setup while the sensor answers each request
+PF::InitializableState run_setup(
+    FDO2::Sensor &sensor,
+    volatile PF::HAL::MockLargeBufferedUART &uart,
+    PF::HAL::MockTime &time,
+    const char *bcst) {
+  PF::InitializableState state = PF::InitializableState::setup;
+  for (uint32_t current_time = 0; current_time < 100; ++current_time) {
+    time.set_millis(current_time);
+    state = sensor.setup();
+    if (current_time == 1) {
+      add_response(uart, "#VERS 8 1 341 15");
+    }
+    if (current_time == 3) {
+      add_response(uart, bcst);
+    }
+  }
+  return state;
+}
+
+}  // namespace
+
+SCENARIO("FDO2 sensor keeps the latest measurement", "[FDO2]") {
+  GIVEN("A sensor broadcasting every 50 ms") {
+    PF::HAL::MockTime time;
+    volatile PF::HAL::MockLargeBufferedUART uart;
+    FDO2::Device device(uart, 50);
+    FDO2::Sensor sensor(device, time);
+
+    THEN("setup completes once the sensor acknowledges the broadcast interval") {
+      REQUIRE(run_setup(sensor, uart, time, "#BCST 50") == PF::InitializableState::ok);
+    }
+
+    WHEN("several responses arrive between outputs") {
+      REQUIRE(run_setup(sensor, uart, time, "#BCST 50") == PF::InitializableState::ok);
+      uint32_t po2 = 0;
+      FDO2::Responses::Mraw mraw{};
+      uint32_t received_time = 0;
+      REQUIRE(sensor.output(po2) == PF::InitializableState::ok);
+      REQUIRE(po2 == 0);
+      REQUIRE(sensor.output(mraw, received_time) == PF::InitializableState::setup);
+
+      add_response(uart, "#MRAW 100 2500 0 0 0 0 101325 0");
+      add_response(uart, "#ERRO 4");
+      add_response(uart, "#MRAW 200 2500 0 0 0 0 101325 0");
+      add_response(uart, "#MRAW 300 2600 0 0 0 0 101325 0");
+      time.set_millis(150);
+      REQUIRE(sensor.output(po2) == PF::InitializableState::ok);
+
+      THEN("only the most recent measurement is kept, with its arrival time") {
+        REQUIRE(po2 == 300);
+        REQUIRE(sensor.output(mraw, received_time) == PF::InitializableState::ok);
+        REQUIRE(mraw.po2 == 300);
+        REQUIRE(mraw.temperature == 2600);
+        REQUIRE(received_time == 150);
+      }
+
+      AND_THEN("error responses are counted") {
+        REQUIRE(sensor.error_count() == 1);
+        REQUIRE(sensor.last_error() == 4);
+      }
+    }
+  }
+
+  GIVEN("A sensor which acknowledges a different broadcast interval") {
+    PF::HAL::MockTime time;
+    volatile PF::HAL::MockLargeBufferedUART uart;
+    FDO2::Device device(uart, 50);
+    FDO2::Sensor sensor(device, time);
+
+    THEN("setup does not complete") {
+      REQUIRE(run_setup(sensor, uart, time, "#BCST 100") == PF::InitializableState::setup);
+    }
+  }
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * ShiftRegister.cpp
+ *
+ * Unit tests to confirm behavior of the non-blocking shift register driver
+ *
+ */
+
+#include "Pufferfish/Driver/ShiftRegister.h"
+
+#include <vector>
+
+#include "Pufferfish/Driver/ShiftedOutput.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+// Simulates a 74HC595 with its shift stage, latch and clear line
+class Register {
+ public:
+  class Pin : public PF::HAL::DigitalOutput {
+   public:
+    Pin(Register &reg, bool Register::*level) : reg_(reg), level_(level) {}
+
+    void write(bool output) override {
+      bool rising = output && !(reg_.*level_);
+      reg_.*level_ = output;
+      ++reg_.edges;
+      if (rising) {
+        reg_.rise(level_);
+      }
+    }
+
+   private:
+    Register &reg_;
+    bool Register::*level_;
+  };
+
+  bool data = false;
+  bool clock = false;
+  bool latch = false;
+  bool clear = false;
+  uint8_t shift = 0;
+  uint8_t outputs = 0;
+  size_t edges = 0;
+
+ private:
+  void rise(bool Register::*level) {
+    if (level == &Register::clock) {
+      shift = static_cast<uint8_t>((shift << 1U) | (data ? 1U : 0U));
+    } else if (level == &Register::latch) {
+      outputs = shift;
+    }
+  }
+};
+
+// Steps the sequence to completion, as a timer interrupt would
+size_t run_steps(PF::Driver::ShiftRegister &shift_register) {
+  size_t steps = 0;
+  while (shift_register.step()) {
+    ++steps;
+  }
+  return steps + 1;
+}
+
+}  // namespace
+
+SCENARIO("The shift register is updated without blocking", "[ShiftRegister]") {
+  GIVEN("A shift register with two of its outputs set") {
+    Register reg;
+    Register::Pin data(reg, &Register::data);
+    Register::Pin clock(reg, &Register::clock);
+    Register::Pin latch(reg, &Register::latch);
+    Register::Pin clear(reg, &Register::clear);
+    PF::HAL::MockTime time;
+    PF::Driver::ShiftRegister shift_register(data, clock, latch, clear, time);
+    PF::Driver::ShiftedOutput led_first(shift_register, 0);
+    PF::Driver::ShiftedOutput led_last(shift_register, 7);
+    led_first.write(true);
+    led_last.write(true);
+
+    WHEN("an update is started") {
+      REQUIRE(shift_register.update());
+
+      THEN("nothing is written until the sequence is stepped") {
+        REQUIRE(reg.edges == 0);
+        REQUIRE(shift_register.busy());
+        REQUIRE_FALSE(shift_register.update());
+      }
+
+      AND_THEN("stepping shifts out every channel and latches them, one edge per step") {
+        REQUIRE(run_steps(shift_register) == 1 + 3 * 8 + 2);
+        REQUIRE(reg.outputs == 0x81);
+        REQUIRE_FALSE(shift_register.busy());
+      }
+    }
+
+    WHEN("the channels are unchanged after an update") {
+      REQUIRE(shift_register.update());
+      run_steps(shift_register);
+      led_first.write(true);
+
+      THEN("no new update is started") {
+        REQUIRE_FALSE(shift_register.update());
+      }
+    }
+
+    WHEN("a channel changes during an update") {
+      REQUIRE(shift_register.update());
+      shift_register.step();
+      led_first.write(false);
+      run_steps(shift_register);
+
+      THEN("the update in progress finishes with the old channels") {
+        REQUIRE(reg.outputs == 0x81);
+      }
+
+      AND_THEN("the next update shifts out the new channels") {
+        REQUIRE(shift_register.update());
+        run_steps(shift_register);
+        REQUIRE(reg.outputs == 0x80);
+      }
+    }
+  }
+}
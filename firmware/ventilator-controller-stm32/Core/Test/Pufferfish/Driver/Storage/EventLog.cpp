@@ -0,0 +1,344 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * EventLog.cpp
+ *
+ * Unit tests to confirm behavior of the persistent event log
+ *
+ */
+
+#include "Pufferfish/Driver/Storage/EventLog.h"
+
+#include <vector>
+
+#include "Pufferfish/HAL/CRCChecker.h"
+#include "Pufferfish/HAL/Mock/MockSPIFlash.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+const size_t sector_count = 8;
+using Flash = PF::HAL::MockSPIFlash<sector_count * 4096>;
+using Store = PF::Driver::Storage::LogStore<sector_count>;
+using EventLog = PF::Driver::Storage::EventLog<sector_count>;
+
+LogEvent make_event(uint32_t time) {
+  LogEvent event{};
+  event.time = time;
+  event.code = LogEventCode_spo2_too_low;
+  event.type = LogEventType_patient;
+  return event;
+}
+
+// Runs the main loop until every staged event is in the store
+void flush(Store &store, PF::Driver::SPI::AsyncFlash &flash, EventLog &log) {
+  while (log.flushed() != log.total()) {
+    REQUIRE(log.update() == Store::Status::ok);
+    REQUIRE(store.update() == Store::Status::ok);
+  }
+  REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+}
+
+// Reads every event of a query
+std::vector<LogEvent> read_all(EventLog &log, EventLog::Query &query) {
+  std::vector<LogEvent> events;
+  LogEvent event{};
+  EventLog::Status status = EventLog::Status::ok;
+  while ((status = log.next(query, event)) == EventLog::Status::ok) {
+    events.push_back(event);
+  }
+  REQUIRE(status == EventLog::Status::not_found);
+  return events;
+}
+
+// Calls serve() until its answer to a fetch request is complete
+NextLogEvents fetch(EventLog &log, uint32_t expected_id) {
+  ExpectedLogEvent expected{expected_id};
+  NextLogEvents next_events{};
+  next_events.next_expected = UINT32_MAX;
+  for (size_t i = 0; i < 1000; ++i) {
+    REQUIRE(log.serve(expected, next_events) == EventLog::Status::ok);
+  }
+  REQUIRE(next_events.next_expected != UINT32_MAX);
+  return next_events;
+}
+
+}  // namespace
+
+SCENARIO("EventLog keeps events across resets", "[EventLog]") {
+  GIVEN("An event log on a freshly formatted store") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, 0);
+    REQUIRE(store.format() == Store::Status::ok);
+    EventLog log(store);
+    REQUIRE(log.load() == Store::Status::ok);
+    REQUIRE(log.total() == 0);
+
+    WHEN("events with every kind of value are logged, and the chip is power-cycled") {
+      LogEvent mode_change = make_event(100);
+      mode_change.code = LogEventCode_ventilation_mode_changed;
+      mode_change.type = LogEventType_control;
+      mode_change.old_mode = VentilationMode_hfnc;
+      mode_change.new_mode = VentilationMode_pc_ac;
+      LogEvent fio2_change = make_event(200);
+      fio2_change.code = LogEventCode_fio2_setting_changed;
+      fio2_change.type = LogEventType_control;
+      fio2_change.old_float = 21;
+      fio2_change.new_float = 45.5;
+      fio2_change.old_bool = true;
+      LogEvent limits_change = make_event(300);
+      limits_change.code = LogEventCode_hr_alarm_limits_changed;
+      limits_change.type = LogEventType_alarm_limits;
+      limits_change.has_old_range = true;
+      limits_change.old_range = Range{60, 100};
+      limits_change.has_new_range = true;
+      limits_change.new_range = Range{50, 120};
+      limits_change.new_uint32 = 0xDEADBEEF;
+      REQUIRE(log.input(mode_change));
+      REQUIRE(log.input(fio2_change));
+      REQUIRE(log.input(limits_change));
+      flush(store, flash, log);
+
+      device.power_cycle();
+      Store remounted_store(flash, crc32c, 0);
+      REQUIRE(remounted_store.mount() == Store::Status::ok);
+      EventLog remounted(remounted_store);
+      REQUIRE(remounted.load() == Store::Status::ok);
+
+      THEN("every event is read back exactly, with consecutive ids") {
+        EventLog::Query query;
+        remounted.find(0, query);
+        std::vector<LogEvent> events = read_all(remounted, query);
+        REQUIRE(events.size() == 3);
+        for (uint32_t i = 0; i < 3; ++i) {
+          REQUIRE(events[i].id == i);
+        }
+        REQUIRE(events[0].time == 100);
+        REQUIRE(events[0].code == LogEventCode_ventilation_mode_changed);
+        REQUIRE(events[0].type == LogEventType_control);
+        REQUIRE(events[0].old_mode == VentilationMode_hfnc);
+        REQUIRE(events[0].new_mode == VentilationMode_pc_ac);
+        REQUIRE(events[1].old_float == 21);
+        REQUIRE(events[1].new_float == 45.5);
+        REQUIRE(events[1].old_bool);
+        REQUIRE_FALSE(events[1].new_bool);
+        REQUIRE(events[2].type == LogEventType_alarm_limits);
+        REQUIRE_FALSE(events[2].has_alarm_limits);
+        REQUIRE(events[2].has_old_range);
+        REQUIRE(events[2].old_range.lower == 60);
+        REQUIRE(events[2].old_range.upper == 100);
+        REQUIRE(events[2].has_new_range);
+        REQUIRE(events[2].new_range.lower == 50);
+        REQUIRE(events[2].new_range.upper == 120);
+        REQUIRE(events[2].new_uint32 == 0xDEADBEEF);
+      }
+
+      AND_THEN("ids continue after the stored events") {
+        REQUIRE(remounted.total() == 3);
+        REQUIRE(remounted.input(make_event(10)));
+        flush(remounted_store, flash, remounted);
+        EventLog::Query query;
+        remounted.find(3, query);
+        std::vector<LogEvent> events = read_all(remounted, query);
+        REQUIRE(events.size() == 1);
+        REQUIRE(events[0].id == 3);
+      }
+    }
+
+    WHEN("the flash is not serviced while many events are logged") {
+      size_t staged = 0;
+      for (uint32_t t = 0; t < EventLog::staging_slots + 8; ++t) {
+        staged += log.input(make_event(t)) ? 1 : 0;
+      }
+
+      THEN("logging never stalls, and only the events which don't fit are dropped") {
+        REQUIRE(staged == EventLog::staging_slots);
+        REQUIRE(log.dropped() == 8);
+        REQUIRE(log.total() == EventLog::staging_slots);
+        flush(store, flash, log);
+        EventLog::Query query;
+        log.find(0, query);
+        std::vector<LogEvent> events = read_all(log, query);
+        REQUIRE(events.size() == EventLog::staging_slots);
+        REQUIRE(events.back().id == EventLog::staging_slots - 1);
+        REQUIRE(events.back().time == EventLog::staging_slots - 1);
+      }
+    }
+  }
+}
+
+SCENARIO("EventLog answers range queries by id and by time", "[EventLog]") {
+  GIVEN("An event log with 300 events, 10 ms apart") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, 0);
+    REQUIRE(store.format() == Store::Status::ok);
+    EventLog log(store);
+    REQUIRE(log.load() == Store::Status::ok);
+    for (uint32_t i = 0; i < 300; ++i) {
+      REQUIRE(log.input(make_event(1000 + 10 * i)));
+      flush(store, flash, log);
+    }
+
+    WHEN("events are queried from an id") {
+      EventLog::Query query;
+      log.find(150, query);
+      std::vector<LogEvent> events = read_all(log, query);
+
+      THEN("exactly the events from that id on are returned, in order") {
+        REQUIRE(events.size() == 150);
+        for (size_t i = 0; i < events.size(); ++i) {
+          REQUIRE(events[i].id == 150 + i);
+        }
+      }
+    }
+
+    WHEN("events are queried from a time") {
+      EventLog::Query query;
+      log.find_time(2005, query);
+      LogEvent event{};
+      REQUIRE(log.next(query, event) == EventLog::Status::ok);
+
+      THEN("the first event returned is the first one at or after that time") {
+        REQUIRE(event.id == 101);
+        REQUIRE(event.time == 2010);
+      }
+    }
+
+    WHEN("the log is reloaded after a reset") {
+      flash.flush();
+      device.power_cycle();
+      Store remounted_store(flash, crc32c, 0);
+      REQUIRE(remounted_store.mount() == Store::Status::ok);
+      EventLog remounted(remounted_store);
+      REQUIRE(remounted.load() == Store::Status::ok);
+      REQUIRE(remounted.input(make_event(5)));
+      flush(remounted_store, flash, remounted);
+
+      THEN("queries by time only cover events since the reset") {
+        EventLog::Query query;
+        remounted.find_time(0, query);
+        std::vector<LogEvent> events = read_all(remounted, query);
+        REQUIRE(events.size() == 1);
+        REQUIRE(events[0].id == 300);
+        REQUIRE(events[0].time == 5);
+      }
+
+      AND_THEN("queries by id still find the events from before the reset") {
+        EventLog::Query query;
+        remounted.find(299, query);
+        std::vector<LogEvent> events = read_all(remounted, query);
+        REQUIRE(events.size() == 2);
+        REQUIRE(events[0].time == 3990);
+      }
+    }
+  }
+}
+
+SCENARIO("EventLog keeps the newest events when the store is full", "[EventLog]") {
+  GIVEN("An event log on a freshly formatted store") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, 0);
+    REQUIRE(store.format() == Store::Status::ok);
+    EventLog log(store);
+    REQUIRE(log.load() == Store::Status::ok);
+
+    WHEN("several times more events are logged than the store can hold") {
+      const uint32_t count = 4 * sector_count * EventLog::records_per_sector;
+      for (uint32_t i = 0; i < count; ++i) {
+        REQUIRE(log.input(make_event(i)));
+        flush(store, flash, log);
+      }
+
+      THEN("the oldest events are overwritten, and the rest can still be found by id") {
+        EventLog::Query query;
+        log.find(0, query);
+        std::vector<LogEvent> events = read_all(log, query);
+        REQUIRE(events.size() > 2 * EventLog::records_per_sector);
+        REQUIRE(events.front().id > 0);
+        for (size_t i = 1; i < events.size(); ++i) {
+          REQUIRE(events[i].id == events[i - 1].id + 1);
+        }
+        REQUIRE(events.back().id == count - 1);
+
+        log.find(count - 10, query);
+        events = read_all(log, query);
+        REQUIRE(events.size() == 10);
+        REQUIRE(events.front().id == count - 10);
+      }
+    }
+  }
+}
+
+SCENARIO("EventLog lets the backend fetch only the events it hasn't seen", "[EventLog]") {
+  GIVEN("An event log with 5 events") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, 0);
+    REQUIRE(store.format() == Store::Status::ok);
+    EventLog log(store);
+    REQUIRE(log.load() == Store::Status::ok);
+    for (uint32_t i = 0; i < 5; ++i) {
+      REQUIRE(log.input(make_event(i)));
+    }
+    flush(store, flash, log);
+
+    WHEN("the backend expects event 2") {
+      NextLogEvents next_events = fetch(log, 2);
+
+      THEN("the next events from 2 on are sent, with the number left after them") {
+        REQUIRE(next_events.elements_count == EventLog::max_served_events);
+        REQUIRE(next_events.elements[0].id == 2);
+        REQUIRE(next_events.elements[1].id == 3);
+        REQUIRE(next_events.next_expected == 4);
+        REQUIRE(next_events.total == 5);
+        REQUIRE(next_events.remaining == 1);
+      }
+    }
+
+    WHEN("the backend has seen every event, and then another one is logged") {
+      NextLogEvents caught_up = fetch(log, 5);
+      REQUIRE(log.input(make_event(5)));
+      flush(store, flash, log);
+      NextLogEvents next_events = fetch(log, 5);
+
+      THEN("nothing is sent until the new event is stored, and then only it is sent") {
+        REQUIRE(caught_up.elements_count == 0);
+        REQUIRE(caught_up.next_expected == 5);
+        REQUIRE(caught_up.remaining == 0);
+        REQUIRE(next_events.elements_count == 1);
+        REQUIRE(next_events.elements[0].id == 5);
+        REQUIRE(next_events.next_expected == 6);
+        REQUIRE(next_events.total == 6);
+        REQUIRE(next_events.remaining == 0);
+      }
+    }
+
+    WHEN("the backend expects an event beyond the log, as after a flash format") {
+      NextLogEvents next_events = fetch(log, 40);
+
+      THEN("it is told to start over from the number of stored events") {
+        REQUIRE(next_events.elements_count == 0);
+        REQUIRE(next_events.next_expected == 5);
+        REQUIRE(next_events.total == 5);
+      }
+    }
+  }
+}
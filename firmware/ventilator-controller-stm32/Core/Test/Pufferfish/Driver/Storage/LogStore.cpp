@@ -0,0 +1,281 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * LogStore.cpp
+ *
+ * Unit tests to confirm behavior of the log-structured flash record store
+ *
+ */
+
+#include "Pufferfish/Driver/Storage/LogStore.h"
+
+#include <algorithm>
+#include <array>
+
+#include "Pufferfish/HAL/CRCChecker.h"
+#include "Pufferfish/HAL/Mock/MockSPIFlash.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+const size_t flash_capacity = 12 * 4096;
+const size_t store_sectors = 8;
+const uint32_t store_base = 2 * 4096;
+
+using Flash = PF::HAL::MockSPIFlash<flash_capacity>;
+using Store = PF::Driver::Storage::LogStore<store_sectors>;
+
+// Keys from indexed_keys up are not indexed, so they behave like a ring log
+const uint8_t log_key = Store::indexed_keys;
+
+std::array<uint8_t, 4> make_payload(uint32_t value) {
+  return {
+      static_cast<uint8_t>(value >> 24U),
+      static_cast<uint8_t>(value >> 16U),
+      static_cast<uint8_t>(value >> 8U),
+      static_cast<uint8_t>(value)};
+}
+
+uint32_t read_value(Store &store, uint8_t key) {
+  std::array<uint8_t, 4> payload{};
+  size_t length = 0;
+  REQUIRE(store.read_latest(key, payload.data(), payload.size(), length) == Store::Status::ok);
+  REQUIRE(length == payload.size());
+  return (static_cast<uint32_t>(payload[0]) << 24U) | (static_cast<uint32_t>(payload[1]) << 16U) |
+         (static_cast<uint32_t>(payload[2]) << 8U) | payload[3];
+}
+
+}  // namespace
+
+SCENARIO("LogStore prepares a blank flash chip in the background", "[LogStore]") {
+  GIVEN("A blank flash chip") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, store_base);
+
+    WHEN("the store is mounted") {
+      REQUIRE(store.mount() == Store::Status::ok);
+
+      THEN("no sector is ready, so appends are refused") {
+        REQUIRE(store.free_sectors() == 0);
+        auto payload = make_payload(1);
+        REQUIRE(store.append(0, payload.data(), payload.size()) == Store::Status::full);
+      }
+
+      AND_THEN("update erases one sector at a time, after which appends succeed") {
+        for (size_t i = 0; i < store_sectors; ++i) {
+          REQUIRE(store.update() == Store::Status::ok);
+          REQUIRE(store.free_sectors() == i + 1);
+          REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+        }
+        auto payload = make_payload(1);
+        REQUIRE(store.append(0, payload.data(), payload.size()) == Store::Status::ok);
+        REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+        REQUIRE(read_value(store, 0) == 1);
+      }
+
+      AND_THEN("sectors outside the store are never erased") {
+        for (size_t i = 0; i < store_sectors; ++i) {
+          REQUIRE(store.update() == Store::Status::ok);
+          REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+        }
+        REQUIRE(device.erase_count(0) == 0);
+        REQUIRE(device.erase_count(1) == 0);
+        REQUIRE(device.erase_count(2) == 1);
+        REQUIRE(device.erase_count(flash_capacity / 4096 - 1) == 0);
+      }
+    }
+  }
+}
+
+SCENARIO("LogStore keeps records across remounts", "[LogStore]") {
+  GIVEN("A formatted store with some records") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, store_base);
+    REQUIRE(store.format() == Store::Status::ok);
+
+    for (uint32_t i = 0; i < 5; ++i) {
+      auto payload = make_payload(i);
+      REQUIRE(store.append(1, payload.data(), payload.size()) == Store::Status::ok);
+      payload = make_payload(100 + i);
+      REQUIRE(store.append(log_key, payload.data(), payload.size()) == Store::Status::ok);
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+    }
+
+    WHEN("the chip is power-cycled and the store is mounted again") {
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+      device.power_cycle();
+      Store remounted(flash, crc32c, store_base);
+      REQUIRE(remounted.mount() == Store::Status::ok);
+
+      THEN("the newest record of each indexed key is found") {
+        REQUIRE(read_value(remounted, 1) == 4);
+        std::array<uint8_t, 4> payload{};
+        size_t length = 0;
+        REQUIRE(
+            remounted.read_latest(2, payload.data(), payload.size(), length) ==
+            Store::Status::not_found);
+      }
+
+      AND_THEN("iteration visits all records in order") {
+        Store::Cursor cursor;
+        Store::Record record;
+        remounted.begin(cursor);
+        for (uint32_t i = 0; i < 5; ++i) {
+          std::array<uint8_t, 4> payload{};
+          REQUIRE(remounted.next(cursor, record) == Store::Status::ok);
+          REQUIRE(record.key == 1);
+          REQUIRE(remounted.read(record, payload.data(), payload.size()) == Store::Status::ok);
+          REQUIRE(payload == make_payload(i));
+          REQUIRE(remounted.next(cursor, record) == Store::Status::ok);
+          REQUIRE(record.key == log_key);
+          REQUIRE(remounted.read(record, payload.data(), payload.size()) == Store::Status::ok);
+          REQUIRE(payload == make_payload(100 + i));
+        }
+        REQUIRE(remounted.next(cursor, record) == Store::Status::not_found);
+      }
+
+      AND_THEN("new records are appended after the old ones") {
+        auto payload = make_payload(5);
+        REQUIRE(remounted.append(1, payload.data(), payload.size()) == Store::Status::ok);
+        REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+        REQUIRE(read_value(remounted, 1) == 5);
+      }
+    }
+
+    WHEN("invalid records are appended") {
+      std::array<uint8_t, Store::max_payload_size + 1> payload{};
+
+      THEN("they are rejected") {
+        REQUIRE(
+            store.append(Store::invalid_key, payload.data(), 1) == Store::Status::invalid);
+        REQUIRE(
+            store.append(0, payload.data(), payload.size()) == Store::Status::invalid);
+        REQUIRE(
+            store.append(0, payload.data(), Store::max_payload_size) == Store::Status::ok);
+      }
+    }
+  }
+}
+
+SCENARIO("LogStore survives a power failure during a record write", "[LogStore]") {
+  GIVEN("A formatted store with a committed record") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, store_base);
+    REQUIRE(store.format() == Store::Status::ok);
+    auto payload = make_payload(1);
+    REQUIRE(store.append(0, payload.data(), payload.size()) == Store::Status::ok);
+    REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+
+    WHEN("power fails part-way through the next record") {
+      device.tear_next_program(6);
+      payload = make_payload(2);
+      REQUIRE(store.append(0, payload.data(), payload.size()) == Store::Status::ok);
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+      device.power_cycle();
+
+      Store remounted(flash, crc32c, store_base);
+      REQUIRE(remounted.mount() == Store::Status::ok);
+
+      THEN("the committed record is kept and the torn one is ignored") {
+        REQUIRE(read_value(remounted, 0) == 1);
+      }
+
+      AND_THEN("later records go to a fresh sector and survive another remount") {
+        const size_t free_before = remounted.free_sectors();
+        payload = make_payload(3);
+        REQUIRE(remounted.append(0, payload.data(), payload.size()) == Store::Status::ok);
+        REQUIRE(remounted.free_sectors() == free_before - 1);
+
+        REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+        device.power_cycle();
+        Store again(flash, crc32c, store_base);
+        REQUIRE(again.mount() == Store::Status::ok);
+        REQUIRE(read_value(again, 0) == 3);
+      }
+    }
+  }
+}
+
+SCENARIO("LogStore compacts old sectors and levels wear", "[LogStore]") {
+  GIVEN("A formatted store with a persistent record") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, store_base);
+    REQUIRE(store.format() == Store::Status::ok);
+    auto setting = make_payload(42);
+    REQUIRE(store.append(3, setting.data(), setting.size()) == Store::Status::ok);
+
+    WHEN("many log records are appended while update runs in the background") {
+      std::array<uint8_t, 200> record{};
+      const size_t records = 400;
+      size_t appended = 0;
+      for (size_t i = 0; i < records * 4 && appended < records; ++i) {
+        record[0] = static_cast<uint8_t>(appended);
+        if (store.append(log_key + 1, record.data(), record.size()) ==
+            Store::Status::ok) {
+          ++appended;
+        }
+        REQUIRE(store.update() == Store::Status::ok);
+      }
+
+      THEN("appends are never starved") { REQUIRE(appended == records); }
+
+      AND_THEN("the persistent record is copied forward and survives a remount") {
+        REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+        REQUIRE(read_value(store, 3) == 42);
+        Store remounted(flash, crc32c, store_base);
+        REQUIRE(remounted.mount() == Store::Status::ok);
+        REQUIRE(read_value(remounted, 3) == 42);
+      }
+
+      AND_THEN("the newest log records are kept in order") {
+        REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+        Store::Cursor cursor;
+        Store::Record found;
+        store.begin(cursor);
+        size_t count = 0;
+        uint8_t last = 0;
+        while (store.next(cursor, found) == Store::Status::ok) {
+          if (found.key != log_key + 1) {
+            continue;
+          }
+          REQUIRE(store.read(found, record.data(), record.size()) == Store::Status::ok);
+          last = record[0];
+          ++count;
+        }
+        REQUIRE(count > 0);
+        REQUIRE(last == static_cast<uint8_t>(records - 1));
+      }
+
+      AND_THEN("erases are spread evenly over the sectors") {
+        uint32_t least = UINT32_MAX;
+        uint32_t most = 0;
+        for (size_t sector = store_base / 4096; sector < store_base / 4096 + store_sectors;
+             ++sector) {
+          least = std::min(least, device.erase_count(sector));
+          most = std::max(most, device.erase_count(sector));
+        }
+        REQUIRE(least > 1);
+        REQUIRE(most - least <= 1);
+      }
+    }
+  }
+}
@@ -0,0 +1,370 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Recorder.cpp
+ *
+ * Unit tests to confirm behavior of the black-box waveform recorder
+ *
+ */
+
+#include "Pufferfish/Driver/Storage/Recorder.h"
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "Pufferfish/HAL/CRCChecker.h"
+#include "Pufferfish/HAL/Mock/MockSPIFlash.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "Pufferfish/Util/Endian.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+const size_t sector_count = 8;
+using Flash = PF::HAL::MockSPIFlash<sector_count * 4096>;
+using Store = PF::Driver::Storage::LogStore<sector_count>;
+using Recorder = PF::Driver::Storage::Recorder<sector_count>;
+using Values = std::array<int32_t, Recorder::channel_count>;
+
+struct Entry {
+  uint32_t time = 0;
+  bool event = false;
+  uint32_t code = 0;
+  Values values{};
+};
+
+// Decodes a block following the layout documented in Recorder.h
+std::vector<Entry> decode(const uint8_t *data, size_t size) {
+  std::vector<Entry> entries;
+  const size_t header_size = Recorder::block_header_size;
+  REQUIRE(size >= header_size);
+  uint32_t time = 0;
+  PF::Util::read_ntoh(data + Recorder::first_time_offset, time);
+  Values values{};
+  size_t offset = header_size;
+  while (offset < size) {
+    uint32_t header = 0;
+    size_t read = PF::Util::read_varint(data + offset, size - offset, header);
+    REQUIRE(read > 0);
+    offset += read;
+
+    Entry entry;
+    time += header >> 1U;
+    entry.time = time;
+    entry.event = (header & 1U) != 0;
+    if (entry.event) {
+      read = PF::Util::read_varint(data + offset, size - offset, entry.code);
+      REQUIRE(read > 0);
+      offset += read;
+    } else {
+      for (size_t i = 0; i < Recorder::channel_count; ++i) {
+        uint32_t delta = 0;
+        read = PF::Util::read_varint(data + offset, size - offset, delta);
+        REQUIRE(read > 0);
+        offset += read;
+        values.at(i) += PF::Util::zigzag_decode(delta);
+      }
+      entry.values = values;
+    }
+    entries.push_back(entry);
+  }
+  return entries;
+}
+
+Recorder::Sample make_sample(uint32_t time) {
+  Recorder::Sample sample;
+  sample.time = time;
+  sample.flow_air = 30 + 10 * std::sin(static_cast<float>(time) / 300);
+  sample.flow_o2 = 12.34;
+  sample.paw = 5 + static_cast<float>(time % 100) / 50;
+  sample.fio2 = 45.6;
+  sample.valve_air_opening = 0.25;
+  sample.valve_o2_opening = static_cast<float>(time % 1000) / 1000;
+  return sample;
+}
+
+Values quantized(const Recorder::Sample &sample) {
+  const std::array<float, Recorder::channel_count> channels = {
+      sample.flow_air,
+      sample.flow_o2,
+      sample.paw,
+      sample.fio2,
+      sample.valve_air_opening,
+      sample.valve_o2_opening};
+  Values values{};
+  for (size_t i = 0; i < Recorder::channel_count; ++i) {
+    values.at(i) = static_cast<int32_t>(std::lround(channels.at(i) * Recorder::channel_scales.at(i)));
+  }
+  return values;
+}
+
+// Runs the main loop for one control step
+void step(Store &store, Recorder &recorder, uint32_t time) {
+  recorder.input(make_sample(time));
+  REQUIRE(recorder.update() == Store::Status::ok);
+  REQUIRE(store.update() == Store::Status::ok);
+}
+
+// Requests every block of a window in turn, returning all decoded entries
+std::vector<Entry> dump(Recorder &recorder, uint32_t start, uint32_t end, size_t &chunks) {
+  std::vector<Entry> entries;
+  RecorderChunkRequest request{start, end, 0};
+  RecorderChunk chunk{};
+  chunks = 0;
+  for (size_t calls = 0; calls < 10000; ++calls) {
+    REQUIRE(recorder.serve(request, chunk, 0) == Store::Status::ok);
+    if (chunk.start != start || chunk.end != end || chunk.index != request.index) {
+      continue;
+    }
+    if (chunk.last) {
+      return entries;
+    }
+    if (chunk.data.size == 0) {
+      continue;
+    }
+
+    std::vector<Entry> block = decode(chunk.data.bytes, chunk.data.size);
+    entries.insert(entries.end(), block.begin(), block.end());
+    ++chunks;
+    ++request.index;
+    chunk.data.size = 0;
+  }
+  FAIL("The dump did not finish");
+  return entries;
+}
+
+}  // namespace
+
+SCENARIO("Recorder keeps a compressed record of the waveforms", "[Recorder]") {
+  GIVEN("A recorder on a freshly formatted store") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, 0);
+    REQUIRE(store.format() == Store::Status::ok);
+    Recorder recorder(store);
+
+    WHEN("two seconds of samples and an event are recorded at the control rate") {
+      for (uint32_t t = 2; t <= 2000; t += 2) {
+        step(store, recorder, t);
+        if (t == 1000) {
+          recorder.input_event(t, 7);
+        }
+      }
+      recorder.seal();
+      for (size_t i = 0; i < 100; ++i) {
+        REQUIRE(recorder.update() == Store::Status::ok);
+        REQUIRE(store.update() == Store::Status::ok);
+      }
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+
+      THEN("nothing is dropped, and the data is much smaller than raw floats") {
+        REQUIRE(recorder.dropped() == 0);
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 0, UINT32_MAX, chunks);
+        REQUIRE(entries.size() == 1001);
+        const size_t raw_size = 1000 * sizeof(Recorder::Sample);
+        REQUIRE(chunks * Recorder::block_size < raw_size / 2);
+      }
+
+      AND_THEN("a window dump returns every entry in it, exactly") {
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 500, 1500, chunks);
+        REQUIRE(chunks > 1);
+
+        size_t samples = 0;
+        bool event_found = false;
+        for (const Entry &entry : entries) {
+          if (entry.event) {
+            REQUIRE(entry.time == 1000);
+            REQUIRE(entry.code == 7);
+            event_found = true;
+            continue;
+          }
+          REQUIRE(entry.values == quantized(make_sample(entry.time)));
+          if (entry.time >= 500 && entry.time <= 1500) {
+            ++samples;
+          }
+        }
+        REQUIRE(event_found);
+        REQUIRE(samples == 501);
+        // Only whole blocks overlapping the window are sent
+        REQUIRE(entries.front().time > 400);
+        REQUIRE(entries.back().time < 1600);
+      }
+
+      AND_THEN("a window with nothing in it returns an empty last chunk") {
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 5000, 6000, chunks);
+        REQUIRE(chunks == 0);
+        REQUIRE(entries.empty());
+      }
+    }
+
+    WHEN("samples are input more often than the control loop steps") {
+      for (uint32_t t = 0; t < 100; ++t) {
+        step(store, recorder, (t / 4) * 2);
+      }
+      recorder.seal();
+      REQUIRE(recorder.update() == Store::Status::ok);
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+
+      THEN("each control step is recorded once") {
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 0, UINT32_MAX, chunks);
+        REQUIRE(entries.size() == 25);
+      }
+    }
+
+    WHEN("sparse, steady samples are recorded without sealing") {
+      for (uint32_t t = 100; t <= 1500; t += 100) {
+        recorder.input(Recorder::Sample{t, 30, 12.34, 5, 45.6, 0.25, 0.5});
+        REQUIRE(recorder.update() == Store::Status::ok);
+        REQUIRE(store.update() == Store::Status::ok);
+      }
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+
+      THEN("blocks are sealed once they span a second, although they are not full") {
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 0, UINT32_MAX, chunks);
+        REQUIRE(chunks == 1);
+        REQUIRE(entries.front().time == 100);
+        REQUIRE(entries.back().time == 100 + Recorder::max_block_duration - 100);
+      }
+
+      AND_THEN("starting a dump stages the newest samples for the flash") {
+        RecorderChunkRequest request{0, UINT32_MAX, 0};
+        RecorderChunk chunk{};
+        REQUIRE(recorder.serve(request, chunk, 0) == Store::Status::ok);
+        REQUIRE(recorder.update() == Store::Status::ok);
+        REQUIRE(store.update() == Store::Status::ok);
+        REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 0, UINT32_MAX - 1, chunks);
+        REQUIRE(chunks == 2);
+        REQUIRE(entries.back().time == 1500);
+      }
+    }
+
+    WHEN("the flash is not serviced for a long time") {
+      for (uint32_t t = 2; t <= 20000; t += 2) {
+        recorder.input(make_sample(t));
+      }
+
+      THEN("recording never stalls, and only whole blocks are dropped") {
+        const uint32_t dropped = recorder.dropped();
+        REQUIRE(dropped > 0);
+        for (uint32_t t = 20002; t <= 22000; t += 2) {
+          step(store, recorder, t);
+        }
+        recorder.seal();
+        for (size_t i = 0; i < 100; ++i) {
+          REQUIRE(recorder.update() == Store::Status::ok);
+          REQUIRE(store.update() == Store::Status::ok);
+        }
+        REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+        REQUIRE(recorder.dropped() == dropped);
+
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 20002, 22000, chunks);
+        size_t samples = 0;
+        for (const Entry &entry : entries) {
+          REQUIRE(entry.values == quantized(make_sample(entry.time)));
+          if (entry.time >= 20002) {
+            ++samples;
+          }
+        }
+        REQUIRE(samples == 1000);
+      }
+    }
+
+    WHEN("more is recorded than the store can hold") {
+      uint32_t t = 2;
+      for (; t <= 300000; t += 2) {
+        step(store, recorder, t);
+      }
+      recorder.seal();
+      for (size_t i = 0; i < 100; ++i) {
+        REQUIRE(recorder.update() == Store::Status::ok);
+        REQUIRE(store.update() == Store::Status::ok);
+      }
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+
+      THEN("the oldest blocks are overwritten and the newest ones are kept") {
+        REQUIRE(recorder.dropped() == 0);
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 0, UINT32_MAX, chunks);
+        REQUIRE(!entries.empty());
+        REQUIRE(entries.front().time > 2);
+        REQUIRE(entries.back().time == t - 2);
+      }
+    }
+  }
+
+  GIVEN("A recorder which recorded a few seconds before a reset") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    {
+      Store store(flash, crc32c, 0);
+      REQUIRE(store.format() == Store::Status::ok);
+      Recorder recorder(store);
+      REQUIRE(recorder.load() == Store::Status::ok);
+      // Different waveforms at the same times as after the reset
+      for (uint32_t t = 2; t <= 5000; t += 2) {
+        Recorder::Sample sample = make_sample(t);
+        sample.flow_o2 = 0;
+        recorder.input(sample);
+        REQUIRE(recorder.update() == Store::Status::ok);
+        REQUIRE(store.update() == Store::Status::ok);
+      }
+      recorder.seal();
+      REQUIRE(recorder.update() == Store::Status::ok);
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+    }
+
+    WHEN("the store is mounted again and times restart from zero") {
+      Store store(flash, crc32c, 0);
+      REQUIRE(store.mount() == Store::Status::ok);
+      Recorder recorder(store);
+      REQUIRE(recorder.load() == Store::Status::ok);
+      for (uint32_t t = 2; t <= 2000; t += 2) {
+        step(store, recorder, t);
+      }
+      recorder.seal();
+      REQUIRE(recorder.update() == Store::Status::ok);
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+
+      THEN("a window dump returns the entries of the current boot only") {
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 1000, 1500, chunks);
+        REQUIRE(chunks > 0);
+        size_t samples = 0;
+        for (const Entry &entry : entries) {
+          REQUIRE(entry.time <= 2000);
+          REQUIRE(entry.values == quantized(make_sample(entry.time)));
+          if (entry.time >= 1000 && entry.time <= 1500) {
+            ++samples;
+          }
+        }
+        REQUIRE(samples == 251);
+      }
+
+      AND_THEN("a full dump returns every entry of the current boot") {
+        size_t chunks = 0;
+        std::vector<Entry> entries = dump(recorder, 0, UINT32_MAX, chunks);
+        REQUIRE(entries.size() == 1000);
+        REQUIRE(entries.front().time == 2);
+        REQUIRE(entries.back().time == 2000);
+      }
+    }
+  }
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * SettingsStore.cpp
+ *
+ * Unit tests to confirm behavior of the persistent settings store
+ *
+ */
+
+#include "Pufferfish/Driver/Storage/SettingsStore.h"
+
+#include <array>
+
+#include "Pufferfish/Driver/BreathingCircuit/AlarmLimitsService.h"
+#include "Pufferfish/HAL/CRCChecker.h"
+#include "Pufferfish/HAL/Mock/MockSPIFlash.h"
+#include "Pufferfish/HAL/Mock/MockTime.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+using Flash = PF::HAL::MockSPIFlash<8 * 4096>;
+using Store = PF::Driver::Storage::LogStore<4>;
+using Settings = PF::Driver::Storage::SettingsStore<4>;
+
+// Runs the main loop for a while, long enough for any commit to land
+void run(Store &store, Settings &settings, uint32_t &current_time, uint32_t duration) {
+  for (uint32_t end = current_time + duration; current_time < end; current_time += 10) {
+    REQUIRE(settings.update(current_time) == Store::Status::ok);
+    REQUIRE(store.update() == Store::Status::ok);
+  }
+}
+
+}  // namespace
+
+SCENARIO("SettingsStore keeps settings across a reset", "[SettingsStore]") {
+  GIVEN("A freshly formatted store and default settings") {
+    Flash device;
+    PF::HAL::MockTime time;
+    PF::Driver::SPI::SPIFlash chip(device, time);
+    PF::Driver::SPI::AsyncFlash flash(chip);
+    PF::HAL::SoftCRC32 crc32c(PF::HAL::crc32c_params);
+    Store store(flash, crc32c, 0);
+    REQUIRE(store.format() == Store::Status::ok);
+
+    PF::Application::States states{};
+    Settings settings(store, states);
+    REQUIRE(settings.restore() == Store::Status::ok);
+    uint32_t current_time = 0;
+
+    WHEN("nothing changes") {
+      const uint32_t programs = device.program_count();
+      run(store, settings, current_time, 5000);
+
+      THEN("nothing is written") {
+        REQUIRE(settings.committed());
+        REQUIRE(device.program_count() == programs);
+      }
+    }
+
+    WHEN("settings change, with changing timestamps, and the device resets") {
+      states.parameters().mode = VentilationMode_hfnc;
+      states.parameters().ventilating = true;
+      states.parameters().flow = 42;
+      states.parameters().fio2 = 60;
+      states.alarm_limits().has_spo2 = true;
+      states.alarm_limits().spo2.lower = 88;
+      states.alarm_limits().spo2.upper = 99;
+      const std::array<uint8_t, 5> calibration = {1, 2, 3, 4, 5};
+      REQUIRE(settings.set_calibration(calibration.data(), calibration.size()) == Store::Status::ok);
+      REQUIRE(!settings.committed());
+      run(store, settings, current_time, 2000);
+      REQUIRE(settings.committed());
+
+      const uint32_t programs = device.program_count();
+      for (uint32_t i = 0; i < 100; ++i) {
+        states.parameters().time = i;
+        states.alarm_limits().time = i;
+        run(store, settings, current_time, 10);
+      }
+      REQUIRE(device.program_count() == programs);
+
+      REQUIRE(flash.flush() == PF::Driver::SPI::AsyncFlash::Status::ok);
+      device.power_cycle();
+
+      PF::Driver::SPI::AsyncFlash flash_after(chip);
+      Store store_after(flash_after, crc32c, 0);
+      REQUIRE(store_after.mount() == Store::Status::ok);
+      PF::Application::States states_after{};
+      Settings settings_after(store_after, states_after);
+      REQUIRE(settings_after.restore() == Store::Status::ok);
+
+      THEN("the parameters and their request are restored") {
+        REQUIRE(states_after.parameters().mode == VentilationMode_hfnc);
+        REQUIRE(states_after.parameters().ventilating);
+        REQUIRE(states_after.parameters().flow == 42);
+        REQUIRE(states_after.parameters().fio2 == 60);
+        REQUIRE(states_after.parameters_request().mode == VentilationMode_hfnc);
+        REQUIRE(states_after.parameters_request().flow == 42);
+      }
+
+      AND_THEN("the alarm limits and their request are restored") {
+        REQUIRE(states_after.alarm_limits().has_spo2);
+        REQUIRE(states_after.alarm_limits().spo2.lower == 88);
+        REQUIRE(states_after.alarm_limits().spo2.upper == 99);
+        REQUIRE(states_after.alarm_limits_request().spo2.upper == 99);
+        REQUIRE(!states_after.alarm_limits().has_fio2);
+      }
+
+      AND_THEN("the calibration data is restored") {
+        std::array<uint8_t, 8> restored{};
+        size_t size = 0;
+        REQUIRE(
+            settings_after.calibration(restored.data(), restored.size(), size) ==
+            Store::Status::ok);
+        REQUIRE(size == calibration.size());
+        REQUIRE(restored[4] == 5);
+      }
+
+      AND_THEN("restored settings are not written again") {
+        REQUIRE(settings_after.committed());
+      }
+
+      AND_THEN("default alarm limits seeded before the restore are replaced") {
+        PF::Application::States states_seeded{};
+        states_seeded.alarm_limits() =
+            PF::Driver::BreathingCircuit::AlarmLimitsServices::default_alarm_limits();
+        Settings settings_seeded(store_after, states_seeded);
+        REQUIRE(settings_seeded.restore() == Store::Status::ok);
+        REQUIRE(states_seeded.alarm_limits().spo2.lower == 88);
+        REQUIRE(states_seeded.alarm_limits().spo2.upper == 99);
+        REQUIRE(!states_seeded.alarm_limits().has_fio2);
+        REQUIRE(settings_seeded.committed());
+      }
+    }
+
+    WHEN("a setting is adjusted step by step") {
+      const uint32_t programs = device.program_count();
+      states.parameters().mode = VentilationMode_hfnc;
+      for (uint32_t step = 1; step <= 50; ++step) {
+        states.parameters().flow = static_cast<float>(step);
+        run(store, settings, current_time, 20);
+      }
+      run(store, settings, current_time, 1000);
+
+      THEN("commits are rate-limited, and the final value is committed") {
+        REQUIRE(settings.committed());
+        REQUIRE(device.program_count() - programs <= 4);
+      }
+    }
+  }
+}
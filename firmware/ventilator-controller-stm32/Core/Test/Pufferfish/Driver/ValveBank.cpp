@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * ValveBank.cpp
+ *
+ * Unit tests to confirm behavior of the synchronized valve bank
+ *
+ */
+
+#include "Pufferfish/Driver/ValveBank.h"
+
+#include "Pufferfish/HAL/Mock/MockPWM.h"
+#include "Pufferfish/HAL/Mock/MockPWMUpdateGate.h"
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+// Records the duty cycle each valve had when the gate was released
+class Gate : public PF::HAL::MockPWMUpdateGate {
+ public:
+  explicit Gate(std::array<PF::HAL::MockPWM, 3> &pwms) : pwms_(pwms) {}
+
+  void release() override {
+    PF::HAL::MockPWMUpdateGate::release();
+    for (size_t i = 0; i < pwms_.size(); ++i) {
+      released[i] = static_cast<uint32_t>(pwms_[i].get_duty_cycle_raw());
+    }
+  }
+
+  std::array<uint32_t, 3> released{};
+
+ private:
+  std::array<PF::HAL::MockPWM, 3> &pwms_;
+};
+
+}  // namespace
+
+SCENARIO("The valve bank commits staged openings together", "[ValveBank]") {
+  GIVEN("A valve bank of three PWM channels with a maximum duty cycle of 6400") {
+    const uint32_t max_duty = 6400;
+    std::array<PF::HAL::MockPWM, 3> pwms;
+    for (auto &pwm : pwms) {
+      pwm.set_max_duty_cycle(max_duty);
+      pwm.set_duty_cycle_raw(1);
+    }
+    Gate gate(pwms);
+    PF::Driver::PWMValveBank<3> bank({{&pwms[0], &pwms[1], &pwms[2]}}, gate);
+
+    WHEN("the bank is set up") {
+      REQUIRE(bank.setup() == PF::PWMStatus::ok);
+
+      THEN("all valves are started closed and their periods are aligned") {
+        for (auto &pwm : pwms) {
+          REQUIRE(pwm.get_pwm_state());
+          REQUIRE(pwm.get_duty_cycle_raw() == 0);
+        }
+        REQUIRE(gate.synchronizations() == 1);
+      }
+    }
+
+    WHEN("openings are staged for two valves") {
+      REQUIRE(bank.setup() == PF::PWMStatus::ok);
+      REQUIRE(bank.stage(0, 0.5F) == PF::PWMStatus::ok);
+      REQUIRE(bank.stage(2, 1.0F) == PF::PWMStatus::ok);
+
+      THEN("no valve changes before the commit") {
+        for (auto &pwm : pwms) {
+          REQUIRE(pwm.get_duty_cycle_raw() == 0);
+        }
+        REQUIRE(gate.releases() == 0);
+      }
+
+      AND_WHEN("they are committed") {
+        bank.commit();
+
+        THEN("both valves change while the gate is held, and it is released once") {
+          REQUIRE(gate.releases() == 1);
+          REQUIRE(!gate.held());
+          REQUIRE(gate.released[0] == max_duty / 2);
+          REQUIRE(gate.released[1] == 0);
+          REQUIRE(gate.released[2] == max_duty);
+        }
+
+        AND_WHEN("the same openings are committed again") {
+          REQUIRE(bank.stage(0, 0.5F) == PF::PWMStatus::ok);
+          bank.commit();
+
+          THEN("the gate is left alone") { REQUIRE(gate.releases() == 1); }
+        }
+      }
+    }
+
+    WHEN("a fixed-point opening is staged") {
+      REQUIRE(bank.setup() == PF::PWMStatus::ok);
+      const uint32_t opening_one = PF::Driver::PWMValveBank<3>::opening_one;
+      REQUIRE(bank.stage_fixed(1, opening_one / 4) == PF::PWMStatus::ok);
+      bank.commit();
+
+      THEN("its compare value is scaled to the maximum duty cycle") {
+        REQUIRE(pwms[1].get_duty_cycle_raw() == max_duty / 4);
+      }
+    }
+
+    WHEN("invalid openings or valves are staged") {
+      REQUIRE(bank.setup() == PF::PWMStatus::ok);
+      const uint32_t opening_one = PF::Driver::PWMValveBank<3>::opening_one;
+
+      THEN("they are rejected without changing anything") {
+        REQUIRE(bank.stage(0, -0.1F) == PF::PWMStatus::invalid_duty_cycle);
+        REQUIRE(bank.stage(0, 1.1F) == PF::PWMStatus::invalid_duty_cycle);
+        REQUIRE(bank.stage(3, 0.5F) == PF::PWMStatus::invalid_duty_cycle);
+        REQUIRE(bank.stage_fixed(0, opening_one + 1) == PF::PWMStatus::invalid_duty_cycle);
+        bank.commit();
+        REQUIRE(gate.releases() == 0);
+      }
+    }
+
+    WHEN("a valve fails to start") {
+      pwms[1].set_return_status(PF::PWMStatus::hal_error);
+
+      THEN("setup reports the error") { REQUIRE(bank.setup() == PF::PWMStatus::hal_error); }
+    }
+  }
+}
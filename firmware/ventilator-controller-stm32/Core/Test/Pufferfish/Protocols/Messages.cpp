@@ -689,7 +689,7 @@ SCENARIO(
         "A body with an empty payload and 1 byte header whose value is not included in "
         "MessageTypes enum") {
       PF::Util::ByteVector<buffer_size> input_buffer;
-      push_status = input_buffer.push_back(0x08);
+      push_status = input_buffer.push_back(0x0B);
       REQUIRE(push_status == PF::IndexStatus::ok);
 
       auto parse_status = test_message.parse(input_buffer, BE::message_descriptors);
@@ -700,7 +700,7 @@ SCENARIO(
       THEN(
           "After the parse method is called, The value assigned to the type member is equal to the "
           "type field of the input_buffer body's header") {
-        REQUIRE(test_message.type == 8);
+        REQUIRE(test_message.type == 11);
       }
       THEN("The payload.tag field remains unchanged") {
         REQUIRE(test_message.payload.tag == PF::Application::MessageTypes::unknown);
@@ -1099,7 +1099,7 @@ SCENARIO(
         "A body with an empty payload and 1 byte header whose value is not included in "
         "MessageTypes enum") {
       PF::Util::ByteVector<buffer_size> input_buffer;
-      push_status = input_buffer.push_back(0x08);
+      push_status = input_buffer.push_back(0x0B);
       REQUIRE(push_status == PF::IndexStatus::ok);
 
       auto parse_status = test_message.parse(input_buffer, BE::message_descriptors);
@@ -1110,7 +1110,7 @@ SCENARIO(
       THEN(
           "After the parse method is called, The value assigned to the type member is equal to the "
           "type field of the input_buffer body's header") {
-        REQUIRE(test_message.type == 8);
+        REQUIRE(test_message.type == 11);
       }
       THEN("The payload.tag field remains unchanged") {
         REQUIRE(test_message.payload.tag == PF::Application::MessageTypes::parameters_request);
@@ -1310,7 +1310,7 @@ SCENARIO(
           BE::message_descriptors};
 
       PF::Util::ByteVector<buffer_size> input_buffer;
-      auto push_status = input_buffer.push_back(0x08);
+      auto push_status = input_buffer.push_back(0x0B);
       REQUIRE(push_status == PF::IndexStatus::ok);
 
       auto transform_status = receiver.transform(input_buffer, test_message);
@@ -1321,13 +1321,13 @@ SCENARIO(
       THEN(
           "After the transform method is called, The type member of the output message is set to "
           "the type field of the input_buffer body's header") {
-        REQUIRE(test_message.type == 8);
+        REQUIRE(test_message.type == 11);
       }
       THEN("The payload.tag field of the output message remains unchanged") {
         REQUIRE(test_message.payload.tag == PF::Application::MessageTypes::unknown);
       }
       THEN("The input buffer is unchanged after transform") {
-        auto expected = std::string("\x08"s);
+        auto expected = std::string("\x0B"s);
         REQUIRE(input_buffer == expected);
       }
     }
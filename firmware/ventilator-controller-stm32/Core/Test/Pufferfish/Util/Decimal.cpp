@@ -0,0 +1,86 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Decimal.cpp
+ *
+ * Unit tests to confirm behavior of decimal integer parsing and formatting
+ *
+ */
+
+#include "Pufferfish/Util/Decimal.h"
+
+#include <array>
+#include <cstring>
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+SCENARIO("Integers are read from decimal text", "[Decimal]") {
+  GIVEN("Numbers followed by other characters") {
+    const char *text = "-2147483648 42\r";
+    const char *end = text + std::strlen(text);
+
+    WHEN("the numbers are read in sequence") {
+      int32_t first = 0;
+      uint16_t second = 0;
+      const char *after_first = PF::Util::read_decimal(text, end, first);
+      const char *after_second = PF::Util::read_decimal(after_first + 1, end, second);
+
+      THEN("each read stops at the end of its number") {
+        REQUIRE(first == INT32_MIN);
+        REQUIRE(after_first == text + 11);
+        REQUIRE(second == 42);
+        REQUIRE(after_second == end - 1);
+      }
+    }
+  }
+
+  GIVEN("Text which is not a number in range") {
+    const std::array<const char *, 6> texts{{"", "-", " 1", "256", "-1", "x"}};
+
+    THEN("it is not read as a uint8_t") {
+      for (const char *text : texts) {
+        uint8_t value = 0;
+        REQUIRE(PF::Util::read_decimal(text, text + std::strlen(text), value) == text);
+      }
+    }
+  }
+
+  GIVEN("The limits of a signed type") {
+    THEN("numbers just past them are not read") {
+      const char *above = "2147483648";
+      const char *below = "-2147483649";
+      int32_t value = 0;
+      REQUIRE(PF::Util::read_decimal(above, above + std::strlen(above), value) == above);
+      REQUIRE(PF::Util::read_decimal(below, below + std::strlen(below), value) == below);
+    }
+  }
+}
+
+SCENARIO("Integers are written as decimal text", "[Decimal]") {
+  GIVEN("A buffer") {
+    std::array<char, 16> buffer{};
+
+    THEN("numbers are written without a terminator and round-trip") {
+      for (int32_t number : {0, 7, -7, 100, INT32_MAX, INT32_MIN}) {
+        buffer.fill('x');
+        size_t length = PF::Util::write_decimal(number, buffer.data(), buffer.size());
+        REQUIRE(length > 0);
+        REQUIRE(buffer[length] == 'x');
+
+        int32_t value = 0;
+        const char *end = buffer.data() + length;
+        REQUIRE(PF::Util::read_decimal(buffer.data(), end, value) == end);
+        REQUIRE(value == number);
+      }
+      REQUIRE(PF::Util::write_decimal(uint16_t(65535), buffer.data(), buffer.size()) == 5);
+      REQUIRE(std::strncmp(buffer.data(), "65535", 5) == 0);
+    }
+
+    THEN("numbers which do not fit are not written") {
+      REQUIRE(PF::Util::write_decimal(-100, buffer.data(), 3) == 0);
+      REQUIRE(PF::Util::write_decimal(-100, buffer.data(), 4) == 4);
+    }
+  }
+}
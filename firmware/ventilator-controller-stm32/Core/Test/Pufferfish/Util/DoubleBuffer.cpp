@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * DoubleBuffer.cpp
+ *
+ * Unit tests to confirm behavior of the lock-free double buffer
+ *
+ */
+
+#include "Pufferfish/Util/DoubleBuffer.h"
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+struct Telemetry {
+  uint32_t time;
+  float flow;
+};
+
+}  // namespace
+
+SCENARIO("Double buffers pass the latest value from writer to reader", "[DoubleBuffer]") {
+  GIVEN("An empty double buffer") {
+    PF::Util::DoubleBuffer<Telemetry> buffer;
+    Telemetry value{1, 1};
+
+    WHEN("it is read") {
+      buffer.read(value);
+
+      THEN("the value is default-initialized") {
+        REQUIRE(value.time == 0);
+        REQUIRE(value.flow == 0);
+        REQUIRE(buffer.writes() == 0);
+      }
+    }
+
+    WHEN("one value is written") {
+      buffer.write(Telemetry{10, 2.5F});
+
+      THEN("it is read back, as many times as it is read") {
+        buffer.read(value);
+        REQUIRE(value.time == 10);
+        REQUIRE(value.flow == 2.5F);
+        buffer.read(value);
+        REQUIRE(value.time == 10);
+        REQUIRE(buffer.writes() == 1);
+      }
+    }
+
+    WHEN("several values are written before a read") {
+      for (uint32_t i = 1; i <= 5; ++i) {
+        buffer.write(Telemetry{i, static_cast<float>(i) / 2});
+      }
+
+      THEN("only the most recent value is read") {
+        buffer.read(value);
+        REQUIRE(value.time == 5);
+        REQUIRE(value.flow == 2.5F);
+        REQUIRE(buffer.writes() == 5);
+      }
+    }
+  }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * ValueQueue.cpp
+ *
+ * Unit tests to confirm behavior of the lock-free value queue
+ *
+ */
+
+#include "Pufferfish/Util/ValueQueue.h"
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+namespace {
+
+struct Telemetry {
+  uint32_t time;
+  float flow;
+};
+
+}  // namespace
+
+SCENARIO("Value queues pass every value from writer to reader", "[ValueQueue]") {
+  GIVEN("An empty value queue with room for 3 values") {
+    PF::Util::ValueQueue<Telemetry, 4> queue;
+    Telemetry value{1, 1};
+
+    WHEN("it is read") {
+      THEN("it is empty and the value is left unchanged") {
+        REQUIRE(queue.read(value) == PF::BufferStatus::empty);
+        REQUIRE(value.time == 1);
+      }
+    }
+
+    WHEN("several values are written before a read") {
+      for (uint32_t i = 1; i <= 3; ++i) {
+        REQUIRE(queue.write(Telemetry{i, static_cast<float>(i) / 2}) == PF::BufferStatus::ok);
+      }
+
+      THEN("each value is read once, oldest first") {
+        for (uint32_t i = 1; i <= 3; ++i) {
+          REQUIRE(queue.read(value) == PF::BufferStatus::ok);
+          REQUIRE(value.time == i);
+          REQUIRE(value.flow == static_cast<float>(i) / 2);
+        }
+        REQUIRE(queue.read(value) == PF::BufferStatus::empty);
+      }
+    }
+
+    WHEN("more values are written than it can hold") {
+      for (uint32_t i = 1; i <= 5; ++i) {
+        queue.write(Telemetry{i, 0});
+      }
+
+      THEN("the newest values are dropped and counted") {
+        REQUIRE(queue.dropped() == 2);
+        for (uint32_t i = 1; i <= 3; ++i) {
+          REQUIRE(queue.read(value) == PF::BufferStatus::ok);
+          REQUIRE(value.time == i);
+        }
+        REQUIRE(queue.read(value) == PF::BufferStatus::empty);
+      }
+    }
+
+    WHEN("reads and writes alternate past the end of the buffer") {
+      for (uint32_t i = 1; i <= 10; ++i) {
+        REQUIRE(queue.write(Telemetry{i, 0}) == PF::BufferStatus::ok);
+        REQUIRE(queue.read(value) == PF::BufferStatus::ok);
+        REQUIRE(value.time == i);
+      }
+
+      THEN("nothing is dropped") { REQUIRE(queue.dropped() == 0); }
+    }
+  }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2020, the Pez Globo team and the Pufferfish project contributors
+ *
+ * Varint.cpp
+ *
+ * Unit tests to confirm behavior of varint and zigzag encoding
+ *
+ */
+
+#include "Pufferfish/Util/Varint.h"
+
+#include <array>
+
+#include "catch2/catch.hpp"
+
+namespace PF = Pufferfish;
+
+SCENARIO("Varints are encoded as in protobuf", "[Varint]") {
+  GIVEN("A buffer") {
+    std::array<uint8_t, PF::Util::varint_max_size> buffer{};
+
+    WHEN("small and large numbers are encoded") {
+      THEN("the encodings have the expected bytes and round-trip") {
+        REQUIRE(PF::Util::write_varint(1, buffer.data()) == 1);
+        REQUIRE(buffer[0] == 0x01);
+        REQUIRE(PF::Util::write_varint(300, buffer.data()) == 2);
+        REQUIRE(buffer[0] == 0xAC);
+        REQUIRE(buffer[1] == 0x02);
+        REQUIRE(PF::Util::write_varint(UINT32_MAX, buffer.data()) == 5);
+
+        uint32_t value = 0;
+        REQUIRE(PF::Util::read_varint(buffer.data(), buffer.size(), value) == 5);
+        REQUIRE(value == UINT32_MAX);
+      }
+    }
+
+    WHEN("a varint is cut short") {
+      PF::Util::write_varint(300, buffer.data());
+      uint32_t value = 0;
+
+      THEN("it is not decoded") {
+        REQUIRE(PF::Util::read_varint(buffer.data(), 1, value) == 0);
+      }
+    }
+  }
+
+  GIVEN("Signed numbers") {
+    THEN("zigzag encoding maps small magnitudes to small numbers and back") {
+      REQUIRE(PF::Util::zigzag_encode(0) == 0);
+      REQUIRE(PF::Util::zigzag_encode(-1) == 1);
+      REQUIRE(PF::Util::zigzag_encode(1) == 2);
+      REQUIRE(PF::Util::zigzag_encode(-2) == 3);
+      REQUIRE(PF::Util::zigzag_encode(INT32_MIN) == UINT32_MAX);
+      for (int32_t value : {0, 1, -1, 1000, -1000, INT32_MAX, INT32_MIN}) {
+        REQUIRE(PF::Util::zigzag_decode(PF::Util::zigzag_encode(value)) == value);
+      }
+    }
+  }
+}
@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""Per-module RAM/flash/stack usage report for the firmware build.
+
+Parses the GNU ld map file produced with -Wl,-Map and the .su files produced
+by -fstack-usage, then prints RAM, flash and largest stack frame for each
+source directory, the largest stack frames overall, and memory region usage.
+
+Usage: memory-report.py <map file> <build directory> [--top N]
+"""
+
+import argparse
+import collections
+import os
+import re
+import sys
+
+
+FLASH_OUTPUT_SECTIONS = {
+    '.isr_vector', '.text', '.rodata', '.ARM.extab', '.ARM', '.preinit_array',
+    '.init_array', '.fini_array'
+}
+RAM_OUTPUT_SECTIONS = {'.bss', '.dma_buffers', '._user_heap_stack'}
+# Initialized data occupies RAM at runtime and flash for its initial values
+RAM_AND_FLASH_OUTPUT_SECTIONS = {'.data'}
+
+OBJECT_DIR = re.compile(r'CMakeFiles/[^/]+\.dir/')
+ARCHIVE_MEMBER = re.compile(r'([^/]+\.a)\(.*\)$')
+REGION_LINE = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+OUTPUT_SECTION_LINE = re.compile(r'^(\.\S+)(\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+)?')
+INPUT_SECTION_LINE = re.compile(
+    r'^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$'
+)
+SECTION_NAME_ONLY_LINE = re.compile(r'^ (\.\S+)$')
+
+
+def module_of(path):
+    """Group an object file or .su file by the source directory it came from."""
+    archive = ARCHIVE_MEMBER.search(path)
+    if archive:
+        return archive.group(1)
+    match = OBJECT_DIR.search(path)
+    relative = path[match.end():] if match else path
+    for prefix in ('Core/Src/', 'Drivers/'):
+        if relative.startswith(prefix):
+            relative = relative[len(prefix):]
+            break
+    directory = os.path.dirname(relative)
+    return directory if directory else '(top level)'
+
+
+def parse_map(map_path):
+    """Return (regions, per-module {'ram': n, 'flash': n}) from a map file."""
+    regions = collections.OrderedDict()
+    modules = collections.defaultdict(lambda: {'ram': 0, 'flash': 0})
+    in_memory_config = False
+    in_memory_map = False
+    output_section = None
+    pending_name = None
+
+    with open(map_path) as map_file:
+        for raw_line in map_file:
+            line = raw_line.rstrip('\n')
+            if line.startswith('Memory Configuration'):
+                in_memory_config = True
+                continue
+            if line.startswith('Linker script and memory map'):
+                in_memory_config = False
+                in_memory_map = True
+                continue
+            if in_memory_config:
+                region = REGION_LINE.match(line)
+                if region and not region.group(1).startswith('*'):
+                    regions[region.group(1)] = {
+                        'origin': int(region.group(2), 16),
+                        'length': int(region.group(3), 16),
+                        'used': 0
+                    }
+                continue
+            if not in_memory_map:
+                continue
+
+            section = OUTPUT_SECTION_LINE.match(line)
+            if section:
+                output_section = section.group(1)
+                pending_name = None
+                continue
+            name_only = SECTION_NAME_ONLY_LINE.match(line)
+            if name_only:
+                # Long input section names wrap onto the next line
+                pending_name = name_only.group(1)
+                continue
+            entry = INPUT_SECTION_LINE.match(line)
+            if not entry:
+                pending_name = None
+                continue
+            name = entry.group(1) or pending_name
+            pending_name = None
+            if name is None or name == '*fill*':
+                continue
+            size = int(entry.group(3), 16)
+            if size == 0:
+                continue
+            module = module_of(entry.group(4).strip())
+            if output_section in FLASH_OUTPUT_SECTIONS:
+                modules[module]['flash'] += size
+            elif output_section in RAM_OUTPUT_SECTIONS:
+                modules[module]['ram'] += size
+            elif output_section in RAM_AND_FLASH_OUTPUT_SECTIONS:
+                modules[module]['ram'] += size
+                modules[module]['flash'] += size
+            else:
+                continue
+            address = int(entry.group(2), 16)
+            for region in regions.values():
+                if region['origin'] <= address < region['origin'] + region['length']:
+                    region['used'] += size
+                    if output_section in RAM_AND_FLASH_OUTPUT_SECTIONS:
+                        regions_flash = regions.get('FLASH')
+                        if regions_flash is not None:
+                            regions_flash['used'] += size
+                    break
+
+    return regions, modules
+
+
+def parse_stack_usage(build_dir):
+    """Return a list of (frame bytes, qualifiers, function, module) from .su files."""
+    frames = []
+    for root, _, files in os.walk(build_dir):
+        for filename in files:
+            if not filename.endswith('.su'):
+                continue
+            path = os.path.join(root, filename)
+            module = module_of(os.path.relpath(path, build_dir))
+            with open(path) as su_file:
+                for line in su_file:
+                    fields = line.rstrip('\n').split('\t')
+                    if len(fields) != 3:
+                        continue
+                    location, size, qualifiers = fields
+                    function = location.split(':', 3)[-1]
+                    frames.append((int(size), qualifiers, function, module))
+    return frames
+
+
+def print_report(regions, modules, frames, top):
+    """Print the report tables."""
+    module_frames = {}
+    for size, _, _, module in frames:
+        module_frames[module] = max(size, module_frames.get(module, 0))
+    names = set(modules) | set(module_frames)
+
+    print('{:<48} {:>10} {:>10} {:>12}'.format(
+        'Module', 'Flash (B)', 'RAM (B)', 'Max frame (B)'
+    ))
+    ordered = sorted(
+        names,
+        key=lambda name: (modules[name]['ram'] + modules[name]['flash']) if name in modules else 0,
+        reverse=True
+    )
+    total_flash = 0
+    total_ram = 0
+    for name in ordered:
+        usage = modules.get(name, {'ram': 0, 'flash': 0})
+        total_flash += usage['flash']
+        total_ram += usage['ram']
+        print('{:<48} {:>10} {:>10} {:>12}'.format(
+            name[-48:], usage['flash'], usage['ram'], module_frames.get(name, '-')
+        ))
+    print('{:<48} {:>10} {:>10}'.format('Total', total_flash, total_ram))
+
+    print()
+    print('Largest stack frames:')
+    for size, qualifiers, function, module in sorted(frames, reverse=True)[:top]:
+        print('{:>8} {:<8} {} [{}]'.format(size, qualifiers, function, module))
+
+    print()
+    print('Memory regions:')
+    for name, region in regions.items():
+        print('{:<12} {:>10} / {:>10} B ({:5.1f}%)'.format(
+            name, region['used'], region['length'],
+            100.0 * region['used'] / region['length']
+        ))
+
+
+def main():
+    """Parse arguments and print the report."""
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('map_file')
+    parser.add_argument('build_dir')
+    parser.add_argument('--top', type=int, default=20,
+                        help='number of largest stack frames to list')
+    args = parser.parse_args()
+
+    if not os.path.isfile(args.map_file):
+        print('Map file not found: {}'.format(args.map_file), file=sys.stderr)
+        return 1
+
+    regions, modules = parse_map(args.map_file)
+    frames = parse_stack_usage(args.build_dir)
+    print_report(regions, modules, frames, args.top)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())